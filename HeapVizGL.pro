@@ -11,6 +11,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = HeapVizGL
 TEMPLATE = app
 
+LIBS += -lgflags -lz -lzstd
+
 SOURCES += main.cpp \
     heapvizwindow.cpp \
     glheapdiagram.cpp \
@@ -28,7 +30,31 @@ SOURCES += main.cpp \
     addressdiagramlayer.cpp \
     glsl_simulation_functions.cpp \
     activeregionsdiagramlayer.cpp \
-    activeregioncache.cpp
+    activeregioncache.cpp \
+    livesetcheckpoints.cpp \
+    heapdiff.cpp \
+    freegapindex.cpp \
+    fragmentationtimeline.cpp \
+    fragmentationchartlayer.cpp \
+    tagaggregateindex.cpp \
+    tagchartlayer.cpp \
+    highlightquery.cpp \
+    addressreuseindex.cpp \
+    varint.cpp \
+    compressedblockstore.cpp \
+    traceindex.cpp \
+    traceevent.cpp \
+    traceinputstream.cpp \
+    traceshardmerger.cpp \
+    vertextiles.cpp \
+    residentblockset.cpp \
+    tilerenderer.cpp \
+    tilecachelayer.cpp \
+    hoverinspector.cpp \
+    frameprofiler.cpp \
+    glframetimers.cpp \
+    tagtable.cpp \
+    pagefile.cpp
 
 HEADERS  += heapvizwindow.h \
     glheapdiagram.h \
@@ -47,7 +73,31 @@ HEADERS  += heapvizwindow.h \
     addressdiagramlayer.h \
     glsl_simulation_functions.h \
     activeregionsdiagramlayer.h \
-    activeregioncache.h
+    activeregioncache.h \
+    livesetcheckpoints.h \
+    heapdiff.h \
+    freegapindex.h \
+    fragmentationtimeline.h \
+    fragmentationchartlayer.h \
+    tagaggregateindex.h \
+    tagchartlayer.h \
+    highlightquery.h \
+    addressreuseindex.h \
+    varint.h \
+    compressedblockstore.h \
+    traceindex.h \
+    traceevent.h \
+    traceinputstream.h \
+    traceshardmerger.h \
+    vertextiles.h \
+    residentblockset.h \
+    tilerenderer.h \
+    tilecachelayer.h \
+    hoverinspector.h \
+    frameprofiler.h \
+    glframetimers.h \
+    tagtable.h \
+    pagefile.h
 
 FORMS    += heapvizwindow.ui
 
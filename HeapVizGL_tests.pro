@@ -11,6 +11,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = HeapVizGL
 TEMPLATE = app
 
+LIBS += -lz -lzstd
+
 SOURCES += heapvizwindow.cpp \
     glheapdiagram.cpp \
     heapblock.cpp \
@@ -29,7 +31,51 @@ SOURCES += heapvizwindow.cpp \
     heapblockdiagramlayer.cpp \
     linearbrightnesscolorscale.cpp \
     testactiveregioncache.cpp \
-    activeregioncache.cpp
+    activeregioncache.cpp \
+    livesetcheckpoints.cpp \
+    heapdiff.cpp \
+    freegapindex.cpp \
+    testfreegapindex.cpp \
+    testlivesetcheckpoints.cpp \
+    fragmentationtimeline.cpp \
+    fragmentationchartlayer.cpp \
+    testfragmentationtimeline.cpp \
+    tagaggregateindex.cpp \
+    tagchartlayer.cpp \
+    testtagaggregateindex.cpp \
+    highlightquery.cpp \
+    testhighlightquery.cpp \
+    addressreuseindex.cpp \
+    testaddressreuseindex.cpp \
+    varint.cpp \
+    testvarint.cpp \
+    compressedblockstore.cpp \
+    testcompressedblockstore.cpp \
+    traceindex.cpp \
+    testtraceindex.cpp \
+    traceevent.cpp \
+    testtraceevent.cpp \
+    traceinputstream.cpp \
+    testtraceinputstream.cpp \
+    traceshardmerger.cpp \
+    testtraceshardmerger.cpp \
+    testmultipleheaps.cpp \
+    vertextiles.cpp \
+    testvertextiles.cpp \
+    testquadgeometry.cpp \
+    residentblockset.cpp \
+    testresidentblockset.cpp \
+    tilerenderer.cpp \
+    tilecachelayer.cpp \
+    testtilerenderer.cpp \
+    hoverinspector.cpp \
+    testhoverinspector.cpp \
+    frameprofiler.cpp \
+    glframetimers.cpp \
+    testframeprofiler.cpp \
+    testheapdiff.cpp \
+    tagtable.cpp \
+    pagefile.cpp
 
 HEADERS  += heapvizwindow.h \
     glheapdiagram.h \
@@ -52,7 +98,51 @@ HEADERS  += heapvizwindow.h \
     linearbrightnesscolorscale.h \
     ui_heapvizwindow.h \
     testactiveregioncache.h \
-    activeregioncache.h
+    activeregioncache.h \
+    livesetcheckpoints.h \
+    heapdiff.h \
+    freegapindex.h \
+    testfreegapindex.h \
+    testlivesetcheckpoints.h \
+    fragmentationtimeline.h \
+    fragmentationchartlayer.h \
+    testfragmentationtimeline.h \
+    tagaggregateindex.h \
+    tagchartlayer.h \
+    testtagaggregateindex.h \
+    highlightquery.h \
+    testhighlightquery.h \
+    addressreuseindex.h \
+    testaddressreuseindex.h \
+    varint.h \
+    testvarint.h \
+    compressedblockstore.h \
+    testcompressedblockstore.h \
+    traceindex.h \
+    testtraceindex.h \
+    traceevent.h \
+    testtraceevent.h \
+    traceinputstream.h \
+    testtraceinputstream.h \
+    traceshardmerger.h \
+    testtraceshardmerger.h \
+    testmultipleheaps.h \
+    vertextiles.h \
+    testvertextiles.h \
+    testquadgeometry.h \
+    residentblockset.h \
+    testresidentblockset.h \
+    tilerenderer.h \
+    tilecachelayer.h \
+    testtilerenderer.h \
+    hoverinspector.h \
+    testhoverinspector.h \
+    frameprofiler.h \
+    glframetimers.h \
+    testframeprofiler.h \
+    testheapdiff.h \
+    tagtable.h \
+    pagefile.h
 
 FORMS    += heapvizwindow.ui
 
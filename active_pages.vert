@@ -1,5 +1,5 @@
 #version 130
-in highp ivec3 position;
+in highp ivec4 position;
 in highp vec3 color;
 
 out vec4 vColor;
@@ -10,6 +10,7 @@ uniform int visible_heap_base_B;
 uniform int visible_heap_base_C;
 uniform int visible_tick_base_A;
 uniform int visible_tick_base_B;
+uniform int visible_tick_base_C;
 
 // =========================================================================
 // Everything below should be valid C++ and also valid GLSL! This code is
@@ -189,8 +190,8 @@ void main(void)
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -203,10 +204,11 @@ void main(void)
   ivec3 address_coordinate_translated = Sub96(address, heap_base);
 
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
 
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
   // Multiply the y coordinate with the y entry of the transformation matrix.
   // To avoid a degenerate matrix, C++ code supplies a matrix containing the
@@ -216,7 +218,7 @@ void main(void)
                                         scale_heap_to_screen[1][1]);
   float final_y = temp_y * scale_heap_to_screen[1][1];
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
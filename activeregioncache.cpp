@@ -5,16 +5,19 @@ ActiveRegionCache::ActiveRegionCache() {
 }
 
 ActiveRegionCache::ActiveRegionCache(uint64_t maximum_height,
-  const std::vector<HeapBlock>* blocks) {
+  const CompressedBlockStore& blocks) {
   uint64_t caches = calculateNumberOfCacheEntries(maximum_height);
   cached_regions_.resize(caches);
   printf("[!] Calculating active region caches...\n");
-  for (const HeapBlock& block : *blocks) {
-    for (uint64_t cache_index = 0; cache_index < caches; ++cache_index) {
-      insertRegionsForBlock(&cached_regions_[cache_index],
-        cacheIndexToSize(cache_index), block.address_, block.size_);
-    }
-  }
+  blocks.forEachBlockBetween(0, static_cast<uint32_t>(blocks.size()),
+    [this, caches](uint32_t, const CompressedBlockStore::DecodedChunk& chunk,
+      uint32_t offset) {
+      for (uint64_t cache_index = 0; cache_index < caches; ++cache_index) {
+        insertRegionsForBlock(&cached_regions_[cache_index],
+          cacheIndexToSize(cache_index), chunk.addresses_[offset],
+          chunk.sizes_[offset]);
+      }
+    });
   printf("[!] Coalescing active region caches...\n");
   fflush(stdout);
   for (uint64_t cache_index = 0; cache_index < caches; ++cache_index) {
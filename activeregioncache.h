@@ -4,7 +4,7 @@
 #include <map>
 #include <vector>
 
-#include "heapblock.h"
+#include "compressedblockstore.h"
 
 // An in-memory cache for "active regions" at different zoom levels,
 // from round_to_power_of_two(max_height / 100) down to 4k pages.
@@ -13,7 +13,7 @@ class ActiveRegionCache {
 public:
   ActiveRegionCache();
   ActiveRegionCache(uint64_t maximum_height,
-    const std::vector<HeapBlock>* blocks);
+    const CompressedBlockStore& blocks);
 
   const std::map<uint64_t, uint64_t>* getActiveRegions(
     uint64_t region_minsize, uint64_t* outsize) const;
@@ -1,7 +1,9 @@
 #include "activeregionsdiagramlayer.h"
 
 ActiveRegionsDiagramLayer::ActiveRegionsDiagramLayer() :
-  GLHeapDiagramLayer(":/active_pages.vert", ":/simple.frag", false) {
+  GLHeapDiagramLayer(":/active_pages.vert", ":/simple.frag", false,
+    ":/active_pages_int64.vert") {
+  is_quad_layer_ = true;
 }
 
 void ActiveRegionsDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history, bool) {
@@ -11,12 +13,14 @@ void ActiveRegionsDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& h
 }
 
 std::pair<vec4, vec4> ActiveRegionsDiagramLayer::vertexShaderSimulator(const HeapVertex& vertex) {
-  ivec3 position(vertex.getX(), vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+    vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
   int visible_heap_base_A = visible_heap_base_A_;
   int visible_heap_base_B = visible_heap_base_B_;
   int visible_heap_base_C = visible_heap_base_C_;
   int visible_tick_base_A = visible_tick_base_A_;
   int visible_tick_base_B = visible_tick_base_B_;
+  int visible_tick_base_C = visible_tick_base_C_;
   float scale_heap_x = vertex_to_screen_.data()[0];
   float scale_heap_y = vertex_to_screen_.data()[2];
   float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
@@ -29,8 +33,8 @@ std::pair<vec4, vec4> ActiveRegionsDiagramLayer::vertexShaderSimulator(const Hea
   // =========================================================================
 
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -43,10 +47,11 @@ std::pair<vec4, vec4> ActiveRegionsDiagramLayer::vertexShaderSimulator(const Hea
   ivec3 address_coordinate_translated = Sub96(address, heap_base);
 
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
 
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
   // Multiply the y coordinate with the y entry of the transformation matrix.
   // To avoid a degenerate matrix, C++ code supplies a matrix containing the
@@ -56,7 +61,7 @@ std::pair<vec4, vec4> ActiveRegionsDiagramLayer::vertexShaderSimulator(const Hea
                                         scale_heap_to_screen[1][1]);
   float final_y = temp_y * scale_heap_to_screen[1][1];
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
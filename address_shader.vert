@@ -1,5 +1,5 @@
 #version 130
-in highp ivec3 position;
+in highp ivec4 position;
 in highp vec3 color;
 
 out vec4 vColor;
@@ -10,6 +10,7 @@ uniform int visible_heap_base_B;
 uniform int visible_heap_base_C;
 uniform int visible_tick_base_A;
 uniform int visible_tick_base_B;
+uniform int visible_tick_base_C;
 
 // =========================================================================
 // Everything below should be valid C++ and also valid GLSL! This code is
@@ -190,7 +191,7 @@ void main(void)
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -2,7 +2,8 @@
 #include "heaphistory.h"
 
 AddressDiagramLayer::AddressDiagramLayer() :
-  GLHeapDiagramLayer(":/address_shader.vert", ":/simple.frag", true) {
+  GLHeapDiagramLayer(":/address_shader.vert", ":/simple.frag", true,
+    ":/address_shader_int64.vert") {
 }
 
 void AddressDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history, bool) {
@@ -12,12 +13,14 @@ void AddressDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history
 }
 
 std::pair<vec4, vec4> AddressDiagramLayer::vertexShaderSimulator(const HeapVertex& vertex) {
-  ivec3 position(vertex.getX(), vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+    vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
   int visible_heap_base_A = visible_heap_base_A_;
   int visible_heap_base_B = visible_heap_base_B_;
   int visible_heap_base_C = visible_heap_base_C_;
   int visible_tick_base_A = visible_tick_base_A_;
   int visible_tick_base_B = visible_tick_base_B_;
+  int visible_tick_base_C = visible_tick_base_C_;
   float *matrix_data = vertex_to_screen_.data();
   float scale_heap_x = matrix_data[0];
   float scale_heap_y = matrix_data[3];
@@ -26,6 +29,7 @@ std::pair<vec4, vec4> AddressDiagramLayer::vertexShaderSimulator(const HeapVerte
 
   Q_UNUSED(visible_tick_base_A);
   Q_UNUSED(visible_tick_base_B);
+  Q_UNUSED(visible_tick_base_C);
 
   // =========================================================================
   // Everything below should be valid C++ and also valid GLSL! This code is
@@ -34,7 +38,7 @@ std::pair<vec4, vec4> AddressDiagramLayer::vertexShaderSimulator(const HeapVerte
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
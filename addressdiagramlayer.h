@@ -8,6 +8,11 @@ public:
   virtual ~AddressDiagramLayer() = default;
   std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex& vertex) override;
   void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) override;
+protected:
+  // The address lines span the whole trace, so they only change with the data.
+  uint64_t getInputGeneration(const HeapHistory& history) const override {
+    return history.getDataGeneration();
+  }
 };
 
 #endif // ADDRESSDIAGRAMLAYER_H
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "addressreuseindex.h"
+
+constexpr uint32_t AddressReuseIndex::entries_per_partition;
+constexpr uint32_t AddressReuseIndex::staging_entries;
+
+// A staged block: its address and its index.
+static constexpr size_t staged_entry_size = sizeof(uint64_t) +
+  sizeof(uint32_t);
+
+template <typename T>
+static T load(const uint8_t* input) {
+  T value;
+  memcpy(&value, input, sizeof(value));
+  return value;
+}
+
+template <typename T>
+static void store(T value, uint8_t* output) {
+  memcpy(output, &value, sizeof(value));
+}
+
+static void unpackRun(const uint8_t* input, size_t size,
+  std::vector<std::pair<uint64_t, uint32_t>>* entries) {
+  for (size_t offset = 0; offset < size; offset += staged_entry_size) {
+    entries->emplace_back(load<uint64_t>(input + offset),
+      load<uint32_t>(input + offset + sizeof(uint64_t)));
+  }
+}
+
+AddressReuseIndex::AddressReuseIndex() = default;
+
+AddressReuseIndex::AddressReuseIndex(const CompressedBlockStore& blocks) :
+  partitions_(blocks.getPageFile()) {
+  printf("[!] Calculating address reuse chains...\n");
+  fflush(stdout);
+  size_t number_of_partitions = std::max(static_cast<size_t>(1),
+    (blocks.size() + entries_per_partition - 1) / entries_per_partition);
+
+  // First pass: stage the blocks of every partition, and move every full run
+  // of them into the page file.
+  PageSet runs(blocks.getPageFile());
+  std::vector<std::vector<size_t>> runs_of_partition(number_of_partitions);
+  std::vector<std::vector<uint8_t>> staged(number_of_partitions);
+  blocks.forEachBlockBetween(0, static_cast<uint32_t>(blocks.size()),
+    [&](uint32_t index, const CompressedBlockStore::DecodedChunk& chunk,
+      uint32_t offset) {
+      uint64_t address = chunk.addresses_[offset];
+      size_t partition = getPartition(address, number_of_partitions);
+      std::vector<uint8_t>& run = staged[partition];
+      run.resize(run.size() + staged_entry_size);
+      uint8_t* entry = run.data() + run.size() - staged_entry_size;
+      store(address, entry);
+      store(index, entry + sizeof(uint64_t));
+      if (run.size() == staging_entries * staged_entry_size) {
+        runs_of_partition[partition].push_back(runs.append(run));
+        run.clear();
+      }
+    });
+
+  // Second pass: sort the blocks of one partition at a time by address. The
+  // index is the second key, so every chain ends up in tick order.
+  std::vector<std::pair<uint64_t, uint32_t>> entries;
+  std::vector<uint8_t> page;
+  for (size_t partition = 0; partition < number_of_partitions; ++partition) {
+    entries.clear();
+    for (size_t run : runs_of_partition[partition]) {
+      std::shared_ptr<const std::vector<uint8_t>> data = runs.read(run);
+      if (data != nullptr) {
+        unpackRun(data->data(), data->size(), &entries);
+      }
+      runs.release(run);
+    }
+    unpackRun(staged[partition].data(), staged[partition].size(), &entries);
+    std::vector<uint8_t>().swap(staged[partition]);
+    std::sort(entries.begin(), entries.end());
+
+    size_t addresses = 0;
+    for (size_t entry = 0; entry < entries.size(); ++entry) {
+      if ((entry == 0) || (entries[entry].first != entries[entry - 1].first)) {
+        ++addresses;
+      }
+    }
+    number_of_addresses_ += addresses;
+    // The number of addresses, the addresses, the offsets of the chains and
+    // the chains.
+    page.assign(sizeof(uint64_t) * (1 + addresses) +
+      sizeof(uint32_t) * (addresses + 1 + entries.size()), 0);
+    uint8_t* address_output = page.data() + sizeof(uint64_t);
+    uint8_t* offset_output = address_output + sizeof(uint64_t) * addresses;
+    uint8_t* chain_output = offset_output + sizeof(uint32_t) * (addresses + 1);
+    store(static_cast<uint64_t>(addresses), page.data());
+    for (size_t entry = 0; entry < entries.size(); ++entry) {
+      if ((entry == 0) || (entries[entry].first != entries[entry - 1].first)) {
+        store(entries[entry].first, address_output);
+        store(static_cast<uint32_t>(entry), offset_output);
+        address_output += sizeof(uint64_t);
+        offset_output += sizeof(uint32_t);
+      }
+      store(entries[entry].second, chain_output);
+      chain_output += sizeof(uint32_t);
+    }
+    store(static_cast<uint32_t>(entries.size()), offset_output);
+    partitions_.append(page);
+  }
+  printf("[!] Done calculating reuse chains for %llu addresses.\n",
+    static_cast<unsigned long long>(number_of_addresses_));
+  fflush(stdout);
+}
+
+size_t AddressReuseIndex::getPartition(uint64_t address,
+  size_t number_of_partitions) {
+  // Addresses are multiples of the alignment, so they are mixed before
+  // taking the remainder.
+  return static_cast<size_t>((address * 0x9E3779B97F4A7C15ULL) >> 32) %
+    number_of_partitions;
+}
+
+bool AddressReuseIndex::getChain(uint64_t address,
+  std::vector<uint32_t>* chain) const {
+  chain->clear();
+  if (partitions_.size() == 0) {
+    return false;
+  }
+  std::shared_ptr<const std::vector<uint8_t>> page =
+    partitions_.read(getPartition(address, partitions_.size()));
+  if (page == nullptr) {
+    return false;
+  }
+  const uint8_t* data = page->data();
+  size_t addresses = static_cast<size_t>(load<uint64_t>(data));
+  const uint8_t* address_input = data + sizeof(uint64_t);
+  const uint8_t* offset_input = address_input + sizeof(uint64_t) * addresses;
+  const uint8_t* chain_input = offset_input +
+    sizeof(uint32_t) * (addresses + 1);
+
+  // Binary search for the address.
+  size_t low = 0, high = addresses;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (load<uint64_t>(address_input + sizeof(uint64_t) * middle) < address) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  if ((low == addresses) ||
+    (load<uint64_t>(address_input + sizeof(uint64_t) * low) != address)) {
+    return false;
+  }
+  uint32_t begin = load<uint32_t>(offset_input + sizeof(uint32_t) * low);
+  uint32_t end = load<uint32_t>(offset_input + sizeof(uint32_t) * (low + 1));
+  chain->resize(end - begin);
+  memcpy(chain->data(), chain_input + sizeof(uint32_t) * begin,
+    sizeof(uint32_t) * (end - begin));
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef ADDRESSREUSEINDEX_H
+#define ADDRESSREUSEINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "pagefile.h"
+
+// For every address at which a block was ever allocated, the indices of all
+// blocks that occupied it, in tick order ("reuse chain").
+//
+// The addresses are hashed into partitions of about entries_per_partition
+// blocks each, and every partition is a page in the page file of the store:
+// the sorted addresses of the partition, the offsets where their chains
+// start (CSR layout), and all chains back to back. A lookup only reads the
+// page of its partition.
+//
+// The build makes a single pass over the store, which only keeps one run of
+// up to staging_entries blocks per partition in memory: full runs go into the
+// page file. Afterwards, the runs of one partition at a time are sorted by
+// address into its page. Ties are broken by the block index, which is the
+// tick order, since the blocks of the store are sorted by tick.
+class AddressReuseIndex {
+public:
+  static constexpr uint32_t entries_per_partition = 65536;
+  static constexpr uint32_t staging_entries = 512;
+
+  AddressReuseIndex();
+  // The store needs to outlive the index, since the pages of the index are
+  // in its page file.
+  explicit AddressReuseIndex(const CompressedBlockStore& blocks);
+
+  // Fills |chain| with the indices of the blocks at |address|. Returns false
+  // (and an empty chain) if no block was ever allocated there.
+  bool getChain(uint64_t address, std::vector<uint32_t>* chain) const;
+
+  size_t getNumberOfAddresses() const { return number_of_addresses_; }
+
+private:
+  static size_t getPartition(uint64_t address, size_t number_of_partitions);
+
+  uint64_t number_of_addresses_ = 0;
+  PageSet partitions_;
+};
+
+#endif // ADDRESSREUSEINDEX_H
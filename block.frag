@@ -0,0 +1,19 @@
+#version 130
+in vec4 vColor;
+flat in uint vBlock;
+out vec4 fColor;
+
+// Set for the ID pass, which writes the index of the block plus one into
+// the four bytes of the pixel, lowest byte in red, instead of the color.
+// Keep in synch with HeapBlockDiagramLayer::decodeBlockId.
+uniform bool draw_block_ids;
+
+void main(void)
+{
+  if (draw_block_ids) {
+    fColor = vec4(float(vBlock & 0xFFu), float((vBlock >> 8u) & 0xFFu),
+      float((vBlock >> 16u) & 0xFFu), float(vBlock >> 24u)) / 255.0;
+  } else {
+    fColor = vColor;
+  }
+}
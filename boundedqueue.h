@@ -0,0 +1,77 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// A queue between one producer and one consumer thread that holds at most
+// |capacity| elements. The producer blocks while the queue is full, and the
+// consumer while it is empty.
+template <typename T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity)
+    : capacity_((capacity == 0) ? 1 : capacity) {}
+
+  // Returns false, without adding |value|, once the consumer has closed the
+  // queue.
+  bool push(T&& value) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_full_.wait(lock, [this]() {
+        return closed_ || (queue_.size() < capacity_);
+      });
+      if (closed_) {
+        return false;
+      }
+      queue_.push_back(std::move(value));
+    }
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Called by the producer after the last push.
+  void finish() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+    }
+    not_empty_.notify_all();
+  }
+
+  // Returns false once the producer has finished and the queue is empty.
+  bool pop(T* value) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this]() { return finished_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return false;
+      }
+      *value = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    not_full_.notify_one();
+    return true;
+  }
+
+  // Called by the consumer when it stops reading, to unblock the producer.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+  }
+
+private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> queue_;
+  bool finished_ = false;
+  bool closed_ = false;
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "compressedblockstore.h"
+#include "varint.h"
+
+static uint8_t byteWidth(uint64_t maximum) {
+  uint8_t width = 0;
+  while (maximum != 0) {
+    ++width;
+    maximum >>= 8;
+  }
+  return width;
+}
+
+static uint64_t zigzagEncode(uint64_t difference) {
+  return (difference << 1) ^
+    static_cast<uint64_t>(static_cast<int64_t>(difference) >> 63);
+}
+
+static uint64_t zigzagDecode(uint64_t value) {
+  return (value >> 1) ^ (0 - (value & 1));
+}
+
+static void appendColumn(const std::vector<uint64_t>& values, uint8_t width,
+  std::vector<uint8_t>* data) {
+  for (uint64_t value : values) {
+    for (uint8_t byte = 0; byte < width; ++byte) {
+      data->push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+  }
+}
+
+// Loads |count| values of |width| bytes each. The width is a template
+// parameter so that the stride is a constant and the loop vectorizes.
+template <int width>
+static void unpackColumn(const uint8_t* input, uint32_t count,
+  uint64_t* output) {
+  const uint64_t mask = (width == 8) ? std::numeric_limits<uint64_t>::max() :
+    ((static_cast<uint64_t>(1) << (8 * width)) - 1);
+  for (uint32_t index = 0; index < count; ++index) {
+    uint64_t value;
+    memcpy(&value, input + index * width, sizeof(value));
+    output[index] = value & mask;
+  }
+}
+
+static void unpackColumn(const uint8_t* input, uint8_t width, uint32_t count,
+  uint64_t* output) {
+  switch (width) {
+    case 0: std::fill(output, output + count, 0); break;
+    case 1: unpackColumn<1>(input, count, output); break;
+    case 2: unpackColumn<2>(input, count, output); break;
+    case 3: unpackColumn<3>(input, count, output); break;
+    case 4: unpackColumn<4>(input, count, output); break;
+    case 5: unpackColumn<5>(input, count, output); break;
+    case 6: unpackColumn<6>(input, count, output); break;
+    case 7: unpackColumn<7>(input, count, output); break;
+    default: unpackColumn<8>(input, count, output); break;
+  }
+}
+
+constexpr uint32_t CompressedBlockStore::default_blocks_per_chunk;
+constexpr uint32_t CompressedBlockStore::frees_per_log_chunk;
+constexpr size_t CompressedBlockStore::number_of_columns;
+
+HeapBlock CompressedBlockStore::DecodedChunk::getBlock(uint32_t offset) const {
+  HeapBlock block(start_ticks_[offset], end_ticks_[offset],
+    static_cast<uint32_t>(sizes_[offset]), addresses_[offset]);
+  block.heap_id_ = static_cast<uint8_t>(heap_ids_[offset]);
+  if (tags_ != nullptr) {
+    block.allocation_tag_ = tags_->getTag(
+      static_cast<uint32_t>(allocation_tags_[offset]));
+    block.free_tag_ = tags_->getTag(static_cast<uint32_t>(free_tags_[offset]));
+  }
+  return block;
+}
+
+CompressedBlockStore::CompressedBlockStore() :
+  CompressedBlockStore(nullptr) {}
+
+CompressedBlockStore::CompressedBlockStore(TagTable* tags,
+  uint32_t blocks_per_chunk, PageFile* pages) : tags_(tags),
+  blocks_per_chunk_(std::max((blocks_per_chunk + 31) / 32 * 32, 32u)),
+  own_pages_((pages == nullptr) ? new PageFile : nullptr),
+  pages_((pages == nullptr) ? own_pages_.get() : pages),
+  chunk_pages_(pages_), free_log_pages_(pages_) {}
+
+CompressedBlockStore::CompressedBlockStore(const std::vector<HeapBlock>& blocks,
+  TagTable* tags, uint32_t blocks_per_chunk, PageFile* pages) :
+  CompressedBlockStore(tags, blocks_per_chunk, pages) {
+  std::vector<uint32_t> freed;
+  for (const HeapBlock& block : blocks) {
+    uint32_t index = append(block);
+    if (block.wasFreed()) {
+      freed.push_back(index);
+    }
+  }
+  std::stable_sort(freed.begin(), freed.end(),
+    [&blocks](uint32_t left, uint32_t right) {
+      return blocks[left].end_tick_ < blocks[right].end_tick_;
+    });
+  for (uint32_t index : freed) {
+    free(index, blocks[index].end_tick_, blocks[index].free_tag_);
+  }
+  finish();
+}
+
+uint32_t CompressedBlockStore::append(const HeapBlock& block) {
+  if (finished_) {
+    reopen();
+  }
+  DecodedChunk& chunk = open_chunk_;
+  if (chunk.number_of_blocks_ == 0) {
+    chunk.first_index_ = static_cast<uint32_t>(number_of_blocks_);
+  }
+  chunk.start_ticks_.push_back(block.start_tick_);
+  chunk.end_ticks_.push_back(std::numeric_limits<uint64_t>::max());
+  chunk.addresses_.push_back(block.address_);
+  chunk.sizes_.push_back(block.size_);
+  chunk.allocation_tags_.push_back((tags_ == nullptr) ? 0 :
+    tags_->getId(block.allocation_tag_));
+  chunk.free_tags_.push_back(0);
+  chunk.heap_ids_.push_back(block.heap_id_);
+  ++chunk.number_of_blocks_;
+  if (chunk.number_of_blocks_ == blocks_per_chunk_) {
+    sealOpenChunk();
+  }
+  return static_cast<uint32_t>(number_of_blocks_++);
+}
+
+void CompressedBlockStore::free(uint32_t index, uint64_t tick,
+  const std::string* tag) {
+  if (finished_) {
+    reopen();
+  }
+  uint32_t tag_id = (tags_ == nullptr) ? 0 : tags_->getId(tag);
+  if ((open_chunk_.number_of_blocks_ != 0) &&
+    (index >= open_chunk_.first_index_)) {
+    uint32_t offset = index - open_chunk_.first_index_;
+    open_chunk_.end_ticks_[offset] = tick;
+    open_chunk_.free_tags_[offset] = tag_id;
+  } else {
+    size_t chunk = getChunkOfBlock(index);
+    std::vector<Patch>& patches = patches_[chunk];
+    patches.push_back({ index - chunks_[chunk].first_index_, tag_id, tick });
+    if (patches.size() * 8 >= chunks_[chunk].number_of_blocks_) {
+      DecodedChunk decoded;
+      decodeChunk(chunk, &decoded);
+      patches_.erase(chunk);
+      rewriteChunk(chunk, decoded);
+    }
+  }
+
+  // Append to the free log. Every chunk of it starts over at index 0.
+  if (free_log_pages_.size() == free_log_.size()) {
+    free_log_.emplace_back();
+    free_log_.back().first_tick_ = tick;
+    last_free_tick_ = tick;
+    last_free_index_ = 0;
+  }
+  FreeLogChunk& log_chunk = free_log_.back();
+  appendVarint(tick - last_free_tick_, &open_free_log_);
+  appendVarint(zigzagEncode(static_cast<uint64_t>(index) - last_free_index_),
+    &open_free_log_);
+  ++log_chunk.number_of_frees_;
+  last_free_tick_ = tick;
+  last_free_index_ = index;
+  ++number_of_frees_;
+  if (log_chunk.number_of_frees_ == frees_per_log_chunk) {
+    sealFreeLogChunk();
+  }
+}
+
+void CompressedBlockStore::finish() {
+  if (open_chunk_.number_of_blocks_ != 0) {
+    sealOpenChunk();
+  }
+  for (const auto& patches : patches_) {
+    DecodedChunk decoded;
+    decodeChunk(patches.first, &decoded);
+    rewriteChunk(patches.first, decoded);
+  }
+  patches_.clear();
+  if (free_log_pages_.size() < free_log_.size()) {
+    sealFreeLogChunk();
+  }
+  std::vector<uint8_t>().swap(open_free_log_);
+  finished_ = true;
+  printf("[!] Compressed %zu heap blocks into %zu bytes.\n",
+    number_of_blocks_, encoded_bytes_);
+  fflush(stdout);
+}
+
+void CompressedBlockStore::reopen() {
+  // New blocks need to go into the last chunk until it is full, so that
+  // getChunkOfBlock stays a division. The chunk keeps its page, which is
+  // rewritten once the chunk is sealed again.
+  if (!chunks_.empty() &&
+    (chunks_.back().number_of_blocks_ < blocks_per_chunk_)) {
+    decodeChunk(chunks_.size() - 1, &open_chunk_);
+    encoded_bytes_ -= getChunkDataSize(chunks_.back()) + sizeof(uint64_t);
+    chunks_.pop_back();
+  }
+  finished_ = false;
+}
+
+size_t CompressedBlockStore::getMemoryUsage() const {
+  size_t usage = chunks_.capacity() * sizeof(ChunkInfo) +
+    free_log_.capacity() * sizeof(FreeLogChunk) + open_free_log_.capacity() +
+    number_of_columns * open_chunk_.start_ticks_.capacity() *
+    sizeof(uint64_t);
+  for (const auto& patches : patches_) {
+    usage += patches.second.capacity() * sizeof(Patch);
+  }
+  if (!pages_->isOnDisk()) {
+    usage += encoded_bytes_;
+  }
+  return usage;
+}
+
+void CompressedBlockStore::sealOpenChunk() {
+  std::vector<uint8_t> data;
+  chunks_.emplace_back();
+  encodeChunk(open_chunk_, &chunks_.back(), &data);
+  encoded_bytes_ += data.size();
+  if (chunk_pages_.size() == chunks_.size()) {
+    // The chunk was reopened.
+    chunk_pages_.rewrite(chunks_.size() - 1, data);
+  } else {
+    chunk_pages_.append(data);
+  }
+  for (std::vector<uint64_t>* column : { &open_chunk_.start_ticks_,
+    &open_chunk_.end_ticks_, &open_chunk_.addresses_, &open_chunk_.sizes_,
+    &open_chunk_.allocation_tags_, &open_chunk_.free_tags_,
+    &open_chunk_.heap_ids_ }) {
+    column->clear();
+  }
+  open_chunk_.number_of_blocks_ = 0;
+}
+
+void CompressedBlockStore::rewriteChunk(size_t chunk,
+  const DecodedChunk& decoded) {
+  if (decoded.number_of_blocks_ == 0) {
+    // The chunk could not be read back.
+    return;
+  }
+  std::vector<uint8_t> data;
+  encoded_bytes_ -= getChunkDataSize(chunks_[chunk]) + sizeof(uint64_t);
+  encodeChunk(decoded, &chunks_[chunk], &data);
+  encoded_bytes_ += data.size();
+  chunk_pages_.rewrite(chunk, data);
+}
+
+void CompressedBlockStore::sealFreeLogChunk() {
+  free_log_pages_.append(open_free_log_);
+  encoded_bytes_ += open_free_log_.size();
+  open_free_log_.clear();
+}
+
+void CompressedBlockStore::encodeChunk(const DecodedChunk& blocks,
+  ChunkInfo* info, std::vector<uint8_t>* data) {
+  uint32_t count = blocks.number_of_blocks_;
+  *info = {};
+  info->first_index_ = blocks.first_index_;
+  info->number_of_blocks_ = count;
+  info->first_start_tick_ = blocks.start_ticks_[0];
+  info->first_address_ = blocks.addresses_[0];
+  info->minimum_start_tick_ = std::numeric_limits<uint64_t>::max();
+  info->minimum_address_ = std::numeric_limits<uint64_t>::max();
+
+  std::vector<uint64_t> columns[number_of_columns];
+  for (std::vector<uint64_t>& column : columns) {
+    column.reserve(count);
+  }
+  uint64_t previous_tick = info->first_start_tick_;
+  uint64_t previous_address = info->first_address_;
+  for (uint32_t offset = 0; offset < count; ++offset) {
+    uint64_t start_tick = blocks.start_ticks_[offset];
+    uint64_t end_tick = blocks.end_ticks_[offset];
+    uint64_t address = blocks.addresses_[offset];
+    uint64_t size = blocks.sizes_[offset];
+    columns[0].push_back(start_tick - previous_tick);
+    columns[1].push_back((end_tick == std::numeric_limits<uint64_t>::max()) ?
+      0 : end_tick - start_tick + 1);
+    columns[2].push_back(zigzagEncode(address - previous_address));
+    columns[3].push_back(size);
+    columns[4].push_back(blocks.allocation_tags_[offset]);
+    columns[5].push_back(blocks.free_tags_[offset]);
+    columns[6].push_back(blocks.heap_ids_[offset]);
+    previous_tick = start_tick;
+    previous_address = address;
+
+    info->minimum_start_tick_ = std::min(info->minimum_start_tick_,
+      start_tick);
+    info->maximum_end_tick_ = std::max(info->maximum_end_tick_, end_tick);
+    info->minimum_address_ = std::min(info->minimum_address_, address);
+    info->maximum_address_end_ = std::max(info->maximum_address_end_,
+      address + size);
+    info->maximum_size_ = std::max(info->maximum_size_,
+      static_cast<uint32_t>(size));
+  }
+  data->clear();
+  for (size_t column = 0; column < number_of_columns; ++column) {
+    info->widths_[column] = byteWidth(*std::max_element(
+      columns[column].begin(), columns[column].end()));
+    appendColumn(columns[column], info->widths_[column], data);
+  }
+  data->resize(data->size() + sizeof(uint64_t), 0);
+}
+
+void CompressedBlockStore::unpackFreeLogChunk(size_t log_chunk,
+  std::vector<std::pair<uint64_t, uint32_t>>* frees) const {
+  std::shared_ptr<const std::vector<uint8_t>> page;
+  const uint8_t* input = open_free_log_.data();
+  if (log_chunk < free_log_pages_.size()) {
+    page = free_log_pages_.read(log_chunk);
+    if (page == nullptr) {
+      return;
+    }
+    input = page->data();
+  }
+  const FreeLogChunk& chunk = free_log_[log_chunk];
+  uint64_t tick = chunk.first_tick_;
+  uint32_t index = 0;
+  for (uint32_t entry = 0; entry < chunk.number_of_frees_; ++entry) {
+    tick += readVarint(&input);
+    index += static_cast<uint32_t>(zigzagDecode(readVarint(&input)));
+    frees->emplace_back(tick, index);
+  }
+}
+
+HeapBlock CompressedBlockStore::getBlock(uint32_t index) const {
+  DecodedChunk chunk;
+  decodeChunk(getChunkOfBlock(index), &chunk);
+  if (chunk.number_of_blocks_ == 0) {
+    return HeapBlock();
+  }
+  return chunk.getBlock(index - chunk.first_index_);
+}
+
+uint32_t CompressedBlockStore::getFirstBlockAllocatedAfter(
+  uint64_t tick) const {
+  // The chunks, like the blocks, are sorted by start tick.
+  auto next = std::upper_bound(chunks_.begin(), chunks_.end(), tick,
+    [](uint64_t value, const ChunkInfo& info) {
+      return value < info.first_start_tick_;
+    });
+  if (next == chunks_.begin()) {
+    return 0;
+  }
+  DecodedChunk chunk;
+  decodeChunk(static_cast<size_t>(next - chunks_.begin()) - 1, &chunk);
+  auto end = chunk.start_ticks_.begin() + chunk.number_of_blocks_;
+  return chunk.first_index_ + static_cast<uint32_t>(
+    std::upper_bound(chunk.start_ticks_.begin(), end, tick) -
+    chunk.start_ticks_.begin());
+}
+
+size_t CompressedBlockStore::getChunkDataSize(const ChunkInfo& info) {
+  size_t width = 0;
+  for (uint8_t column_width : info.widths_) {
+    width += column_width;
+  }
+  return width * info.number_of_blocks_;
+}
+
+bool CompressedBlockStore::chunkMayBeActive(size_t chunk, uint64_t min_size,
+  uint64_t min_address, uint64_t max_address, uint64_t min_tick,
+  uint64_t max_tick) const {
+  const ChunkInfo& info = chunks_[chunk];
+  return (info.maximum_size_ >= min_size) &&
+    (info.minimum_address_ <= max_address) &&
+    (info.maximum_address_end_ >= min_address) &&
+    (info.maximum_end_tick_ >= min_tick) &&
+    (info.minimum_start_tick_ <= max_tick);
+}
+
+void CompressedBlockStore::decodeChunk(size_t chunk,
+  DecodedChunk* decoded) const {
+  const ChunkInfo& info = chunks_[chunk];
+  uint32_t count = info.number_of_blocks_;
+  decoded->first_index_ = info.first_index_;
+  decoded->number_of_blocks_ = count;
+  decoded->start_ticks_.resize(count);
+  decoded->end_ticks_.resize(count);
+  decoded->addresses_.resize(count);
+  decoded->sizes_.resize(count);
+  decoded->allocation_tags_.resize(count);
+  decoded->free_tags_.resize(count);
+  decoded->heap_ids_.resize(count);
+  decoded->tags_ = tags_;
+
+  std::shared_ptr<const std::vector<uint8_t>> data = chunk_pages_.read(chunk);
+  if (data == nullptr) {
+    decoded->number_of_blocks_ = 0;
+    return;
+  }
+  const uint8_t* input = data->data();
+  std::vector<uint64_t>* columns[number_of_columns] = {
+    &decoded->start_ticks_, &decoded->end_ticks_, &decoded->addresses_,
+    &decoded->sizes_, &decoded->allocation_tags_, &decoded->free_tags_,
+    &decoded->heap_ids_ };
+  for (size_t column = 0; column < number_of_columns; ++column) {
+    unpackColumn(input, info.widths_[column], count, columns[column]->data());
+    input += static_cast<size_t>(info.widths_[column]) * count;
+  }
+
+  // Undo the delta encoding with prefix sums, and turn the lifetimes back
+  // into end ticks.
+  uint64_t* start_ticks = decoded->start_ticks_.data();
+  uint64_t* end_ticks = decoded->end_ticks_.data();
+  uint64_t* addresses = decoded->addresses_.data();
+  uint64_t tick = info.first_start_tick_;
+  uint64_t address = info.first_address_;
+  for (uint32_t index = 0; index < count; ++index) {
+    tick += start_ticks[index];
+    start_ticks[index] = tick;
+    address += zigzagDecode(addresses[index]);
+    addresses[index] = address;
+  }
+  for (uint32_t index = 0; index < count; ++index) {
+    end_ticks[index] = (end_ticks[index] == 0) ?
+      std::numeric_limits<uint64_t>::max() :
+      start_ticks[index] + end_ticks[index] - 1;
+  }
+
+  // Apply the frees that the encoded chunk does not know about yet.
+  auto patches = patches_.find(chunk);
+  if (patches != patches_.end()) {
+    for (const Patch& patch : patches->second) {
+      end_ticks[patch.offset_] = patch.end_tick_;
+      decoded->free_tags_[patch.offset_] = patch.free_tag_;
+    }
+  }
+}
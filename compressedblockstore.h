@@ -0,0 +1,276 @@
+#ifndef COMPRESSEDBLOCKSTORE_H
+#define COMPRESSEDBLOCKSTORE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "heapblock.h"
+#include "pagefile.h"
+#include "tagtable.h"
+
+// The heap blocks of a history, sorted by start tick, in compressed form.
+// This is the only copy of the blocks: they are appended as the allocations
+// are recorded, and read back by decoding whole chunks.
+//
+// The blocks are split into chunks of a few thousand blocks. Within a chunk,
+// every field is stored as a separate column of fixed-width integers:
+//
+//   - the start tick as the difference to the previous start tick (which is
+//     small, since the blocks are sorted by start tick),
+//   - the lifetime end_tick_ - start_tick_ plus one, or 0 for blocks that
+//     are alive,
+//   - the address as the zigzag-encoded difference to the previous address,
+//   - the size,
+//   - the IDs of the allocation and the free tag (see TagTable),
+//   - the heap ID.
+//
+// Each column uses the smallest number of bytes (0 to 8) that holds its
+// largest value in the chunk. Since the width is fixed per column, decoding
+// is a strided load followed by a prefix sum, which the compiler vectorizes.
+// Each chunk also keeps the ranges of its ticks, addresses and sizes, so that
+// chunks that cannot contain a visible block are skipped without decoding.
+//
+// New blocks go into an open chunk that is encoded once it is full. A block
+// in an encoded chunk that gets freed is patched when the chunk is decoded,
+// and the chunk is encoded again once an eighth of its blocks have pending
+// patches. The store also keeps a log of all frees in tick order (which the
+// live set checkpoints replay), varint-packed in chunks of its own.
+//
+// The encoded chunks and the full chunks of the free log are pages of a
+// PageFile, which the indexes that are built from the store share. For
+// traces that do not fit into memory, the page file is on disk: chunks are
+// written to it as soon as they are encoded, and read on demand through its
+// cache, so only the chunk metadata, the open chunks and the pending patches
+// stay resident, and the culling only ever reads the chunks that intersect
+// the current window.
+class CompressedBlockStore {
+public:
+  static constexpr uint32_t default_blocks_per_chunk = 8192;
+  static constexpr uint32_t frees_per_log_chunk = 4096;
+  static constexpr size_t number_of_columns = 7;
+
+  struct ChunkInfo {
+    uint32_t first_index_;
+    uint32_t number_of_blocks_;
+    uint64_t first_start_tick_;
+    uint64_t first_address_;
+    // Ranges over all blocks in the chunk, for skipping.
+    uint64_t minimum_start_tick_;
+    uint64_t maximum_end_tick_;
+    uint64_t minimum_address_;
+    uint64_t maximum_address_end_;
+    uint32_t maximum_size_;
+    // The byte width of each column.
+    uint8_t widths_[number_of_columns];
+  };
+
+  // The fields of the blocks of one chunk after decoding.
+  struct DecodedChunk {
+    uint32_t first_index_ = 0;
+    uint32_t number_of_blocks_ = 0;
+    std::vector<uint64_t> start_ticks_;
+    std::vector<uint64_t> end_ticks_;
+    std::vector<uint64_t> addresses_;
+    std::vector<uint64_t> sizes_;
+    std::vector<uint64_t> allocation_tags_;
+    std::vector<uint64_t> free_tags_;
+    std::vector<uint64_t> heap_ids_;
+    // Resolves the tag IDs, or null if the store has no tags.
+    const TagTable* tags_ = nullptr;
+
+    // Returns block |offset| of the chunk.
+    HeapBlock getBlock(uint32_t offset) const;
+  };
+
+  CompressedBlockStore();
+  // The tags of the blocks are stored as their IDs in |tags|, or as 0 if
+  // |tags| is null; |tags| needs to outlive the store. The number of blocks
+  // per chunk is rounded up to a multiple of 32, so that every chunk starts
+  // at a word of a one-bit-per-block bitset. The chunks go into |pages|,
+  // which needs to outlive the store, or into a page file of the store's
+  // own (in memory) if |pages| is null.
+  explicit CompressedBlockStore(TagTable* tags,
+    uint32_t blocks_per_chunk = default_blocks_per_chunk,
+    PageFile* pages = nullptr);
+  // Stores |blocks|, which need to be sorted by start tick, and finishes.
+  CompressedBlockStore(const std::vector<HeapBlock>& blocks, TagTable* tags,
+    uint32_t blocks_per_chunk = default_blocks_per_chunk,
+    PageFile* pages = nullptr);
+  CompressedBlockStore(const CompressedBlockStore&) = delete;
+  CompressedBlockStore& operator=(const CompressedBlockStore&) = delete;
+
+  // Appends a block that is still alive and returns its index. The start
+  // tick must not be smaller than that of the previous block.
+  uint32_t append(const HeapBlock& block);
+  // Records that block |index| was freed at |tick|. Frees need to be
+  // recorded in tick order.
+  void free(uint32_t index, uint64_t tick, const std::string* tag);
+  // Encodes the open chunk and all pending patches. Needs to be called once
+  // all blocks have been appended and freed, before any block is read.
+  // Appending or freeing afterwards reopens the store.
+  void finish();
+
+  size_t size() const { return number_of_blocks_; }
+  size_t getNumberOfChunks() const { return chunks_.size(); }
+  const ChunkInfo& getChunkInfo(size_t chunk) const { return chunks_[chunk]; }
+  size_t getNumberOfFrees() const { return number_of_frees_; }
+  // The bytes that the store keeps in memory. Pages only count while the
+  // page file is in memory, since the cache of a page file on disk is
+  // shared with the indexes.
+  size_t getMemoryUsage() const;
+  // The page file of the chunks, which the indexes that are built from the
+  // store put their own pages into.
+  PageFile* getPageFile() const { return pages_; }
+
+  // Returns false if no block in the chunk can pass the filter of
+  // HeapHistory::isBlockActive with the same arguments.
+  bool chunkMayBeActive(size_t chunk, uint64_t min_size, uint64_t min_address,
+    uint64_t max_address, uint64_t min_tick, uint64_t max_tick) const;
+
+  // Leaves |decoded| empty if the chunk cannot be read from the page file.
+  // Can be called from several threads at once.
+  void decodeChunk(size_t chunk, DecodedChunk* decoded) const;
+  size_t getChunkOfBlock(uint32_t index) const {
+    return index / blocks_per_chunk_;
+  }
+
+  // Decodes the chunk of block |index| to return a single block. Use the
+  // visitors below for more than a handful of blocks.
+  HeapBlock getBlock(uint32_t index) const;
+  // Returns the index of the first block that was allocated after |tick|,
+  // or size() if there is none.
+  uint32_t getFirstBlockAllocatedAfter(uint64_t tick) const;
+
+  // Calls |visit| with the index, the decoded chunk and the offset in the
+  // chunk of every block in [first, last), in index order.
+  template <typename Visitor>
+  void forEachBlockBetween(uint32_t first, uint32_t last,
+    Visitor visit) const {
+    DecodedChunk chunk;
+    while (first < last) {
+      decodeChunk(getChunkOfBlock(first), &chunk);
+      if (chunk.number_of_blocks_ == 0) {
+        return;
+      }
+      uint32_t end = std::min(last,
+        chunk.first_index_ + chunk.number_of_blocks_);
+      for (; first < end; ++first) {
+        visit(first, chunk, first - chunk.first_index_);
+      }
+    }
+  }
+  // Like forEachBlockBetween, for the blocks in |indices|, which need to be
+  // sorted in ascending order. Every chunk is decoded at most once.
+  template <typename Visitor>
+  void forEachBlockIn(const std::vector<uint32_t>& indices,
+    Visitor visit) const {
+    DecodedChunk chunk;
+    for (auto index = indices.begin(); index != indices.end();) {
+      decodeChunk(getChunkOfBlock(*index), &chunk);
+      if (chunk.number_of_blocks_ == 0) {
+        return;
+      }
+      uint32_t end = chunk.first_index_ + chunk.number_of_blocks_;
+      for (; (index != indices.end()) && (*index < end); ++index) {
+        visit(*index, chunk, *index - chunk.first_index_);
+      }
+    }
+  }
+  // Calls |visit| with the index and the free tick of every block that was
+  // freed in the tick interval (low_tick, high_tick], in order of the free
+  // ticks.
+  template <typename Visitor>
+  void forEachFreeBetween(uint64_t low_tick, uint64_t high_tick,
+    Visitor visit) const {
+    size_t log_chunk = std::upper_bound(free_log_.begin(), free_log_.end(),
+      low_tick, [](uint64_t tick, const FreeLogChunk& chunk) {
+        return tick < chunk.first_tick_;
+      }) - free_log_.begin();
+    if (log_chunk != 0) {
+      --log_chunk;
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> frees;
+    for (; log_chunk < free_log_.size(); ++log_chunk) {
+      if (free_log_[log_chunk].first_tick_ > high_tick) {
+        return;
+      }
+      frees.clear();
+      unpackFreeLogChunk(log_chunk, &frees);
+      for (const auto& entry : frees) {
+        if (entry.first > high_tick) {
+          return;
+        }
+        if (entry.first > low_tick) {
+          visit(entry.second, entry.first);
+        }
+      }
+    }
+  }
+
+private:
+  // A run of up to frees_per_log_chunk entries of the free log. Each entry
+  // is the varint of the tick difference to the previous entry, followed by
+  // the varint of the zigzag-encoded index difference. The entries of chunk
+  // i are page i of free_log_pages_, or open_free_log_ for the last chunk
+  // until it is full.
+  struct FreeLogChunk {
+    uint64_t first_tick_ = 0;
+    uint32_t number_of_frees_ = 0;
+  };
+  // A free of a block in an encoded chunk that is not encoded yet.
+  struct Patch {
+    uint32_t offset_;
+    uint32_t free_tag_;
+    uint64_t end_tick_;
+  };
+
+  static size_t getChunkDataSize(const ChunkInfo& info);
+  // Encodes the blocks of |blocks| into |info| and |data|.
+  static void encodeChunk(const DecodedChunk& blocks, ChunkInfo* info,
+    std::vector<uint8_t>* data);
+  void unpackFreeLogChunk(size_t log_chunk,
+    std::vector<std::pair<uint64_t, uint32_t>>* frees) const;
+  // Encodes the open chunk as a new chunk, and starts a new open chunk.
+  void sealOpenChunk();
+  // Encodes |decoded| as chunk |chunk|, which needs to have a page.
+  void rewriteChunk(size_t chunk, const DecodedChunk& decoded);
+  // Moves the entries of the open chunk of the free log to a page.
+  void sealFreeLogChunk();
+  // Undoes finish() for more appends and frees.
+  void reopen();
+
+  TagTable* tags_ = nullptr;
+  uint32_t blocks_per_chunk_ = default_blocks_per_chunk;
+  size_t number_of_blocks_ = 0;
+
+  // Set if the store has a page file of its own. The page sets below need to
+  // be destroyed before it.
+  std::unique_ptr<PageFile> own_pages_;
+  PageFile* pages_ = nullptr;
+
+  std::vector<ChunkInfo> chunks_;
+  // Page i holds the columns of chunk i, followed by 8 bytes of padding so
+  // that decoding can always load 8 bytes at a time. Holds one more page
+  // than there are chunks while a reopened chunk is open.
+  PageSet chunk_pages_;
+  // The bytes of all pages of the store.
+  size_t encoded_bytes_ = 0;
+  // The blocks after the last encoded chunk.
+  DecodedChunk open_chunk_;
+  // Pending patches by chunk.
+  std::unordered_map<size_t, std::vector<Patch>> patches_;
+  bool finished_ = false;
+
+  std::vector<FreeLogChunk> free_log_;
+  PageSet free_log_pages_;
+  std::vector<uint8_t> open_free_log_;
+  size_t number_of_frees_ = 0;
+  uint64_t last_free_tick_ = 0;
+  uint32_t last_free_index_ = 0;
+};
+
+#endif // COMPRESSEDBLOCKSTORE_H
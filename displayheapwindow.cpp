@@ -6,8 +6,8 @@
 
 DisplayHeapWindow::DisplayHeapWindow() = default;
 
-DisplayHeapWindow::DisplayHeapWindow(const ivec2 &minimum_tick,
-  const ivec2 &maximum_tick,
+DisplayHeapWindow::DisplayHeapWindow(const ivec3 &minimum_tick,
+  const ivec3 &maximum_tick,
   const ivec3 &minimum_address,
   const ivec3 &maximum_address) {
   setMinAndMaxTick(minimum_tick, maximum_tick);
@@ -16,8 +16,12 @@ DisplayHeapWindow::DisplayHeapWindow(const ivec2 &minimum_tick,
 
 void DisplayHeapWindow::reset(const HeapWindow &global_window) {
   setMinAndMaxTick(
-    Load32BitLeftShiftedBy4Into64Bit(global_window.minimum_tick_),
-    Load32BitLeftShiftedBy4Into64Bit(global_window.maximum_tick_));
+    Load64BitLeftShiftedBy4Into96Bit(
+      global_window.minimum_tick_ & 0xFFFFFFFF,
+      global_window.minimum_tick_ >> 32u),
+    Load64BitLeftShiftedBy4Into96Bit(
+      global_window.maximum_tick_ & 0xFFFFFFFF,
+      global_window.maximum_tick_ >> 32u));
   setMinAndMaxAddress(
     Load64BitLeftShiftedBy4Into96Bit(
       global_window.minimum_address_ & 0xFFFFFFFF,
@@ -26,26 +30,26 @@ void DisplayHeapWindow::reset(const HeapWindow &global_window) {
       global_window.maximum_address_ & 0xFFFFFFFF,
       global_window.maximum_address_ >> 32u));
 
-  maximum_width_ = Sub64(maximum_tick_, minimum_tick_);
+  maximum_width_ = Sub96(maximum_tick_, minimum_tick_);
   maximum_height_ = Sub96(maximum_address_, minimum_address_);
 }
 
-void DisplayHeapWindow::checkHorizontalCenter(ivec2 *new_minimum_tick,
-                                              ivec2 *new_maximum_tick) const {
-  ivec2 width_64 = Sub64(*new_maximum_tick, *new_minimum_tick);
-  long double width = width_64.getUint64();
+void DisplayHeapWindow::checkHorizontalCenter(ivec3 *new_minimum_tick,
+                                              ivec3 *new_maximum_tick) const {
+  ivec3 width_96 = Sub96(*new_maximum_tick, *new_minimum_tick);
+  long double width = width_96.getLongDouble();
   long double half_width = width / 2;
-  ivec2 half_width_64 = LongDoubleTo64Bits(half_width);
-  ivec2 horizontal_center = Add64(*new_minimum_tick, half_width_64);
+  ivec3 half_width_96 = LongDoubleTo96Bits(half_width);
+  ivec3 horizontal_center = Add96(*new_minimum_tick, half_width_96);
 
   // The horizontal center should not fall below zero.
-  if (horizontal_center.y < 0) {
-    *new_minimum_tick = LongDoubleTo64Bits(-half_width);
-    *new_maximum_tick = LongDoubleTo64Bits(half_width);
-  } else if (horizontal_center.y > 0x17) {
-    ivec2 maximal_horizontal_center(0, 0x17);
-    *new_maximum_tick = Add64(maximal_horizontal_center, half_width_64);
-    *new_minimum_tick = Sub64(maximal_horizontal_center, half_width_64);
+  if (horizontal_center.z < 0) {
+    *new_minimum_tick = LongDoubleTo96Bits(-half_width);
+    *new_maximum_tick = LongDoubleTo96Bits(half_width);
+  } else if (horizontal_center.z > 0x17) {
+    ivec3 maximal_horizontal_center(0, 0, 0x17);
+    *new_maximum_tick = Add96(maximal_horizontal_center, half_width_96);
+    *new_minimum_tick = Sub96(maximal_horizontal_center, half_width_96);
   }
 }
 
@@ -74,10 +78,10 @@ void DisplayHeapWindow::pan(double dx, double dy) {
   long double width = getWidthAsLongDouble();
   long double pan_x = -dx * width;
   long double pan_y = dy * height;
-  ivec2 pan_x_64 = LongDoubleTo64Bits(pan_x);
-  ivec2 new_minimum_tick = Add64(minimum_tick_, pan_x_64);
+  ivec3 pan_x_96 = LongDoubleTo96Bits(pan_x);
+  ivec3 new_minimum_tick = Add96(minimum_tick_, pan_x_96);
 
-  ivec2 new_maximum_tick = Add64(maximum_tick_, pan_x_64);
+  ivec3 new_maximum_tick = Add96(maximum_tick_, pan_x_96);
   ivec3 pan_y_96 = LongDoubleTo96Bits(pan_y);
   ivec3 new_maximum_address = Add96(maximum_address_, pan_y_96);
   ivec3 new_minimum_address = Add96(minimum_address_, pan_y_96);
@@ -111,7 +115,7 @@ void DisplayHeapWindow::zoomToPoint(double dx, double dy, double how_much_x,
   if (target_width > maximum_width_.getLongDouble()) {
     target_width = maximum_width_.getLongDouble();
   }
-  double extra_width = target_width - width;
+  long double extra_width = target_width - width;
   long double extra_height = target_height - height;
 
   // Do not allow the height or width to be more than 2x total heap size.
@@ -138,10 +142,10 @@ void DisplayHeapWindow::zoomToPoint(double dx, double dy, double how_much_x,
       Add96(maximum_address_, LongDoubleTo96Bits(extra_height_top));
   ivec3 new_minimum_address =
       Sub96(minimum_address_, LongDoubleTo96Bits(extra_height_bottom));
-  ivec2 new_minimum_tick =
-      Sub64(minimum_tick_, LongDoubleTo64Bits(extra_width_left));
-  ivec2 new_maximum_tick =
-      Add64(maximum_tick_, LongDoubleTo64Bits(extra_width_right));
+  ivec3 new_minimum_tick =
+      Sub96(minimum_tick_, LongDoubleTo96Bits(extra_width_left));
+  ivec3 new_maximum_tick =
+      Add96(maximum_tick_, LongDoubleTo96Bits(extra_width_right));
 
   // Now ensure that the center is not outside of bounds.
   checkHorizontalCenter(&new_minimum_tick, &new_maximum_tick);
@@ -154,7 +158,7 @@ void DisplayHeapWindow::zoomToPoint(double dx, double dy, double how_much_x,
 // Map screen coordinates back to the heap, returns false if the coordinate
 // can't fall into the heap because it has a negative component.
 bool DisplayHeapWindow::mapDisplayCoordinateToHeap(double dx, double dy,
-                                                   uint32_t *tick,
+                                                   uint64_t *tick,
                                                    uint64_t *address) const {
   long double height = getHeightAsLongDouble();
   long double width = getWidthAsLongDouble();
@@ -163,33 +167,28 @@ bool DisplayHeapWindow::mapDisplayCoordinateToHeap(double dx, double dy,
 
   ivec3 tentative_address =
       Add96(LongDoubleTo96Bits(relative_y), minimum_address_);
-  int64_t tentative_tick = relative_x + minimum_tick_.getInt64();
+  ivec3 tentative_tick = Add96(LongDoubleTo96Bits(relative_x), minimum_tick_);
 
   // Check if the numbers are in bounds.
-  if ((tentative_tick < std::numeric_limits<uint32_t>::min()) ||
-      (tentative_tick > std::numeric_limits<uint32_t>::max()) ||
+  if ((tentative_tick.z > 0xF) || (tentative_tick.z < 0) ||
       (tentative_address.z > 0xF) || (tentative_address.z < 0)) {
     return false;
   }
   // Return the values.
-  uint64_t final_address = tentative_address.getLowUint64() >> 4u;
-  uint64_t tentative_address_z = tentative_address.z;
-  tentative_address_z = tentative_address_z << 60u;
-  final_address |= tentative_address_z;
-  *address = final_address;
-  *tick = static_cast<uint32_t>(tentative_tick) >> 4u;
+  *address = Convert96BitTo64BitRightShift(tentative_address);
+  *tick = Convert96BitTo64BitRightShift(tentative_tick);
   return true;
 }
 
-bool DisplayHeapWindow::setMinAndMaxTick(ivec2 min_tick, ivec2 max_tick) {
+bool DisplayHeapWindow::setMinAndMaxTick(ivec3 min_tick, ivec3 max_tick) {
   maximum_tick_ = max_tick;
   minimum_tick_ = min_tick;
-  if (min_tick.getUint64() & 0x8000000000000000L) {
+  if (min_tick.isNegative()) {
     printf("[Alert!] Setting min tock negative??\n");
     return false;
   }
-  uint64_t width = maximum_tick_.getUint64() - minimum_tick_.getUint64();
-  if (width & 0x8000000000000000L) {
+  ivec3 width = Sub96(maximum_tick_, minimum_tick_);
+  if (width.isNegative()) {
     printf("[Alert!] Invalid max/min tick combination!\n");
     return false;
   }
@@ -214,10 +213,10 @@ bool DisplayHeapWindow::setMinAndMaxAddress(ivec3 min_address, ivec3 max_address
 
 void DisplayHeapWindow::checkInternalValuesForSanity() const {
   // Is maximum_tick_ and minimum_tick_ positive?
-  if ((maximum_tick_.y < 0) || (minimum_tick_.y < 0)) {
+  if ((maximum_tick_.z < 0) || (minimum_tick_.z < 0)) {
     printf("[Alert!] Something is wrong with maximum_tick_ or minimum_tick_:\n"
       "%s and %s!\n",
-      ivec2ToHex(maximum_tick_).c_str(), ivec2ToHex(minimum_tick_).c_str());
+      ivec3ToHex(maximum_tick_).c_str(), ivec3ToHex(minimum_tick_).c_str());
   }
   // Is maximum_address_ and minimum_address_ positive?
   if ((maximum_address_.z < 0) || (minimum_address_.z < 0)) {
@@ -232,20 +231,16 @@ void DisplayHeapWindow::checkInternalValuesForSanity() const {
       "%s!\n", ivec3ToHex(height).c_str());
   }
   // Is maximum_address_ - minimum_address_ positive?
-  uint64_t width = maximum_tick_.getUint64() - minimum_tick_.getUint64();
-  if (width & 0x8000000000000000L) {
-    printf("[Alert!] Something is wrong with width:\n%" PRIx64 "\n", width);
+  ivec3 width = Sub96(maximum_tick_, minimum_tick_);
+  if (width.z < 0) {
+    printf("[Alert!] Something is wrong with width:\n"
+      "%s!\n", ivec3ToHex(width).c_str());
   }
 }
 
 long double DisplayHeapWindow::getXScalingHeapToScreen() const {
   checkInternalValuesForSanity();
-  ivec2 width = Sub64(maximum_tick_, minimum_tick_);
-  uint64_t shrinkage = width.getUint64();
-  long double factor =
-      static_cast<long double>(1.0) / static_cast<long double>(shrinkage);
-  long double result = sqrt(static_cast<long double>(factor));
-  return result;
+  return scalingForExtent(Sub96(maximum_tick_, minimum_tick_));
 }
 
 static int num_leading_zero_bits(uint32_t value) {
@@ -261,7 +256,13 @@ static int num_leading_zero_bits(uint32_t value) {
 // Scaling to map the heap Y to the interval [0, 1].
 long double DisplayHeapWindow::getYScalingHeapToScreen() const {
   checkInternalValuesForSanity();
-  ivec3 height = Sub96(maximum_address_, minimum_address_);
+  return scalingForExtent(Sub96(maximum_address_, minimum_address_));
+}
+
+// Both heap coordinates can exceed 64 bits once the fractional bits are
+// added, so the extent is shifted down if needed.
+long double DisplayHeapWindow::scalingForExtent(const ivec3 &extent) {
+  ivec3 height = extent;
   // If we are only dealing with a 64-bit height now, everything is easy.
   if (height.z == 0) {
     uint64_t shrinkage = height.getLowUint64();
@@ -289,28 +290,30 @@ long double DisplayHeapWindow::getHeightAsLongDouble() const {
 }
 
 long double DisplayHeapWindow::getWidthAsLongDouble() const {
-  return static_cast<long double>(maximum_tick_.getUint64() -
-                                  minimum_tick_.getUint64());
+  ivec3 width = Sub96(maximum_tick_, minimum_tick_);
+  return width.getLongDouble();
 }
 
 std::pair<float, float>
-DisplayHeapWindow::mapHeapCoordinateToDisplay(uint32_t tick,
+DisplayHeapWindow::mapHeapCoordinateToDisplay(uint64_t tick,
                                               uint64_t address) const {
-  ivec3 position(tick, address & 0xFFFFFFFF, address >> 32u);
+  ivec4 position(tick & 0xFFFFFFFF, tick >> 32u, address & 0xFFFFFFFF,
+                 address >> 32u);
 
   return internalMapHeapCoordinateToDisplay(
       position, minimum_address_.x, minimum_address_.y, minimum_address_.z,
-      minimum_tick_.x, minimum_tick_.y, getXScalingHeapToScreen(),
-      getYScalingHeapToScreen());
+      minimum_tick_.x, minimum_tick_.y, minimum_tick_.z,
+      getXScalingHeapToScreen(), getYScalingHeapToScreen());
 }
 
 void DisplayHeapWindow::debugDumpHeapVertex(const HeapVertex& vertex) const {
-  ivec3 position(vertex.getX(), vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+                 vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
 
   internalMapAddressCoordinateToDisplay(
       position, minimum_address_.x, minimum_address_.y, minimum_address_.z,
-      minimum_tick_.x, minimum_tick_.y, getXScalingHeapToScreen(),
-      getYScalingHeapToScreen());
+      minimum_tick_.x, minimum_tick_.y, minimum_tick_.z,
+      getXScalingHeapToScreen(), getYScalingHeapToScreen());
 }
 
 void DisplayHeapWindow::debugDumpHeapVerticesToAddressMapper(
@@ -328,12 +331,13 @@ void DisplayHeapWindow::debugDumpHeapVerticesToAddressMapper(
 // code can be tested here and then cut/pasted into the shader when it works
 // (since debugging GLSL is so horrible).
 void DisplayHeapWindow::internalMapAddressCoordinateToDisplay(
-  ivec3 position, int visible_heap_base_A, int visible_heap_base_B,
+  ivec4 position, int visible_heap_base_A, int visible_heap_base_B,
   int visible_heap_base_C, int visible_tick_base_A, int visible_tick_base_B,
-  float scale_heap_x, float scale_heap_y) const {
+  int visible_tick_base_C, float scale_heap_x, float scale_heap_y) const {
 
   Q_UNUSED(visible_tick_base_A);
   Q_UNUSED(visible_tick_base_B);
+  Q_UNUSED(visible_tick_base_C);
 
   float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
   // =========================================================================
@@ -343,7 +347,7 @@ void DisplayHeapWindow::internalMapAddressCoordinateToDisplay(
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -381,9 +385,9 @@ void DisplayHeapWindow::internalMapAddressCoordinateToDisplay(
 // code can be tested here and then cut/pasted into the shader when it works
 // (since debugging GLSL is so horrible).
 std::pair<float, float> DisplayHeapWindow::internalMapHeapCoordinateToDisplay(
-    ivec3 position, int visible_heap_base_A, int visible_heap_base_B,
+    ivec4 position, int visible_heap_base_A, int visible_heap_base_B,
     int visible_heap_base_C, int visible_tick_base_A, int visible_tick_base_B,
-    float scale_heap_x, float scale_heap_y) const {
+    int visible_tick_base_C, float scale_heap_x, float scale_heap_y) const {
   float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
 
   // =========================================================================
@@ -393,8 +397,8 @@ std::pair<float, float> DisplayHeapWindow::internalMapHeapCoordinateToDisplay(
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -407,10 +411,11 @@ std::pair<float, float> DisplayHeapWindow::internalMapHeapCoordinateToDisplay(
   ivec3 address_coordinate_translated = Sub96(address, heap_base);
 
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
 
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
   // Multiply the y coordinate with the y entry of the transformation matrix.
   // To avoid a degenerate matrix, C++ code supplies a matrix containing the
@@ -420,7 +425,7 @@ std::pair<float, float> DisplayHeapWindow::internalMapHeapCoordinateToDisplay(
                                         scale_heap_to_screen[1][1]);
   float final_y = temp_y * scale_heap_to_screen[1][1];
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
@@ -432,14 +437,15 @@ std::pair<float, float> DisplayHeapWindow::internalMapHeapCoordinateToDisplay(
   // XXX:DEBUG CODE
 
   if (debug_mode_) {
-    printf("[Debug]   (%08x%08x%08x, %08x%08x) -> (%f, %f)\n", address.z,
-      address.y, address.x, tick.y, tick.x, final_x, final_y);
-    printf("[Debug]   minimum_visible_tick: %08x%08x, heap_base: %08x%08x%08x\n",
-      minimum_visible_tick.y, minimum_visible_tick.x, heap_base.z,
-      heap_base.y, heap_base.x);
+    printf("[Debug]   (%08x%08x%08x, %08x%08x%08x) -> (%f, %f)\n", address.z,
+      address.y, address.x, tick.z, tick.y, tick.x, final_x, final_y);
+    printf("[Debug]   minimum_visible_tick: %08x%08x%08x, heap_base: "
+      "%08x%08x%08x\n", minimum_visible_tick.z, minimum_visible_tick.y,
+      minimum_visible_tick.x, heap_base.z, heap_base.y, heap_base.x);
     printf("[Debug] address_coordinate_translated is %08x%08x%08x, "
-      "tick_coordinate_translated is %08x%08x\n", address_coordinate_translated.z,
-      address_coordinate_translated.y, address_coordinate_translated.x,
+      "tick_coordinate_translated is %08x%08x%08x\n",
+      address_coordinate_translated.z, address_coordinate_translated.y,
+      address_coordinate_translated.x, tick_coordinate_translated.z,
       tick_coordinate_translated.y, tick_coordinate_translated.x);
     printf("[Debug]   temp_x is %f, temp_y is %f\n", temp_x, temp_y);
     printf("[Debug]   scale_heap_to_screen[0][0] is %f, "
@@ -10,45 +10,45 @@
 // integer increments need to be possible. Furthermore, negative numbers need
 // to be allowed as well.
 //
-// The x coordinates need to have a range of [-2^32, 2^33], the y coordinates
-// need to have a range of [-2^64, 2^65 ].
+// Both the x coordinates (ticks) and the y coordinates (addresses) need to
+// have a range of [-2^64, 2^65].
 //
 // Lastly, arithmetic on these coordinates needs to be possible on the GPU
 // which means that no doubles nor "true" uint64_t arithmetic - int32_t is all
 // we have, and everything else needs to be emulated.
 //
 // The "solution" to this is the following:
-// - Use 64-bit integers for the x coordinate. The lowest 4 bits are the frac-
+// - Use 96-bit integers for both coordinates. The lowest 4 bits are the frac-
 //   tional component.
-// - Use 96-bit integers for the y coordinate. Again, the lowest 4 bits are the
-//   fractional component.
 //
 class DisplayHeapWindow {
 public:
   DisplayHeapWindow();
-  DisplayHeapWindow(const ivec2 &minimum_tick, const ivec2 &maximum_tick,
+  DisplayHeapWindow(const ivec3 &minimum_tick, const ivec3 &maximum_tick,
                     const ivec3 &minimum_address, const ivec3 &maximum_address);
   void reset(const HeapWindow &global_window);
   void pan(double dx, double dy);
   void zoomToPoint(double dx, double dy, double how_much_x, double how_much_y,
                    long double max_height, long double max_width);
-  std::pair<float, float> mapHeapCoordinateToDisplay(uint32_t tick,
+  std::pair<float, float> mapHeapCoordinateToDisplay(uint64_t tick,
                                                      uint64_t address) const;
   // Map screen coordinates back to the heap, returns false if the coordinate
   // does not fall into the heap.
-  bool mapDisplayCoordinateToHeap(double dx, double dy, uint32_t *tick,
+  bool mapDisplayCoordinateToHeap(double dx, double dy, uint64_t *tick,
                                   uint64_t *address) const;
-  bool setMinAndMaxTick(ivec2 min_tick, ivec2 max_tick);
+  bool setMinAndMaxTick(ivec3 min_tick, ivec3 max_tick);
   bool setMinAndMaxAddress(ivec3 min_address, ivec3 max_address);
 
-  ivec2 getMinimumTick() const { return minimum_tick_; }
-  ivec2 getMaximumTick() const { return maximum_tick_; }
+  ivec3 getMinimumTick() const { return minimum_tick_; }
+  ivec3 getMaximumTick() const { return maximum_tick_; }
 
-  uint32_t getMinimumTickUint32() const {
+  uint64_t getMinimumTickUint64() const {
     return minimum_tick_.isNegative() ? 0 :
-      minimum_tick_.getUint64() >> 4u; }
-  uint32_t getMaximumTickUint32() const {
-    return maximum_tick_.getUint64() >> 4u; }
+      Convert96BitTo64BitRightShift(minimum_tick_);
+  }
+  uint64_t getMaximumTickUint64() const {
+    return Convert96BitTo64BitRightShift(maximum_tick_);
+  }
 
   ivec3 getMinimumAddress() const { return minimum_address_; }
   ivec3 getMaximumAddress() const { return maximum_address_; }
@@ -69,10 +69,10 @@ public:
   void checkInternalValuesForSanity() const;
   void setDebug(bool mode) const { debug_mode_ = mode; }
   // Debugging functions to help debug the GLSL shader code in C++.
-  void internalMapAddressCoordinateToDisplay(ivec3 position,
+  void internalMapAddressCoordinateToDisplay(ivec4 position,
     int visible_heap_base_A, int visible_heap_base_B,
     int visible_heap_base_C, int visible_tick_base_A, int visible_tick_base_B,
-    float scale_heap_x, float scale_heap_y) const;
+    int visible_tick_base_C, float scale_heap_x, float scale_heap_y) const;
   void debugDumpHeapVertex(const HeapVertex& vertex) const;
   void debugDumpHeapVerticesToAddressMapper(
     const std::vector<HeapVertex>* vertices) const;
@@ -87,19 +87,22 @@ private:
   // kept in a state so that it can be cut & pasted into the GLSL files with-
   // out much modification.
   std::pair<float, float> internalMapHeapCoordinateToDisplay(
-      ivec3 position, int visible_heap_base_A, int visible_heap_base_B,
+      ivec4 position, int visible_heap_base_A, int visible_heap_base_B,
       int visible_heap_base_C, int visible_tick_base_A, int visible_tick_base_B,
-      float squash_x, float squash_y) const;
+      int visible_tick_base_C, float squash_x, float squash_y) const;
+
+  // The square root of 1 / extent, for the heap-to-screen matrix.
+  static long double scalingForExtent(const ivec3 &extent);
 
-  void checkHorizontalCenter(ivec2 *new_minimum_tick, ivec2 *new_maximum_tick) const;
+  void checkHorizontalCenter(ivec3 *new_minimum_tick, ivec3 *new_maximum_tick) const;
   void checkVerticalCenter(ivec3 *new_minimum_address, ivec3 *new_maximum_address) const;
 
-  ivec2 minimum_tick_;
-  ivec2 maximum_tick_;
+  ivec3 minimum_tick_;
+  ivec3 maximum_tick_;
   ivec3 minimum_address_;
   ivec3 maximum_address_;
 
-  ivec2 maximum_width_;
+  ivec3 maximum_width_;
   ivec3 maximum_height_;
 
   //std::vector<GLHeapDiagramLayer*> registered_layers_;
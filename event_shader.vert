@@ -1,5 +1,5 @@
 #version 130
-in highp ivec3 position;
+in highp ivec4 position;
 in highp vec3 color;
 
 out vec4 vColor;
@@ -10,6 +10,7 @@ uniform int visible_heap_base_B;
 uniform int visible_heap_base_C;
 uniform int visible_tick_base_A;
 uniform int visible_tick_base_B;
+uniform int visible_tick_base_C;
 
 // =========================================================================
 // Everything below should be valid C++ and also valid GLSL! This code is
@@ -190,18 +191,19 @@ void main(void)
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
   float final_y = -1.0;
-  if (position.y != 0) {
+  if (position.z != 0) {
     final_y = 1.0;
   }
   final_x = 2 * final_x - 1;
@@ -1,7 +1,8 @@
 #include "eventdiagramlayer.h"
 
 EventDiagramLayer::EventDiagramLayer() :
-  GLHeapDiagramLayer(":/event_shader.vert", ":/simple.frag", true) {
+  GLHeapDiagramLayer(":/event_shader.vert", ":/simple.frag", true,
+    ":/event_shader_int64.vert") {
 }
 
 void EventDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history, bool) {
@@ -11,12 +12,14 @@ void EventDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history,
 }
 
 std::pair<vec4, vec4> EventDiagramLayer::vertexShaderSimulator(const HeapVertex& vertex) {
-  ivec3 position(vertex.getX(), vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+    vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
   int visible_heap_base_A = visible_heap_base_A_;
   int visible_heap_base_B = visible_heap_base_B_;
   int visible_heap_base_C = visible_heap_base_C_;
   int visible_tick_base_A = visible_tick_base_A_;
   int visible_tick_base_B = visible_tick_base_B_;
+  int visible_tick_base_C = visible_tick_base_C_;
   float scale_heap_x = vertex_to_screen_.data()[0];
   float scale_heap_y = vertex_to_screen_.data()[2];
   float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
@@ -33,18 +36,19 @@ std::pair<vec4, vec4> EventDiagramLayer::vertexShaderSimulator(const HeapVertex&
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                           scale_heap_to_screen[0][0]);
 
   float final_x = temp_x * scale_heap_to_screen[0][0];
   float final_y = -1.0;
-  if (position.y != 0) {
+  if (position.z != 0) {
     final_y = 1.0;
   }
   final_x = 2 * final_x - 1;
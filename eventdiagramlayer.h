@@ -9,6 +9,11 @@ public:
   virtual ~EventDiagramLayer() = default;
   std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex& vertex) override;
   void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) override;
+protected:
+  // The event lines span the whole trace, so they only change with the data.
+  uint64_t getInputGeneration(const HeapHistory& history) const override {
+    return history.getDataGeneration();
+  }
 };
 
 #endif // EVENTDIAGRAMLAYER_H
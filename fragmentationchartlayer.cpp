@@ -0,0 +1,55 @@
+#include "fragmentationchartlayer.h"
+
+FragmentationChartLayer::FragmentationChartLayer() :
+  GLHeapDiagramLayer(":/chart_shader.vert", ":/simple.frag", true) {
+}
+
+void FragmentationChartLayer::loadVerticesFromHeapHistory(
+  const HeapHistory& history, bool) {
+  std::vector<HeapVertex> *vertices = getVertexVector();
+  vertices->clear();
+  history.fragmentationChartToVertices(vertices);
+}
+
+std::pair<vec4, vec4> FragmentationChartLayer::vertexShaderSimulator(
+  const HeapVertex& vertex) {
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+    vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  int visible_tick_base_A = visible_tick_base_A_;
+  int visible_tick_base_B = visible_tick_base_B_;
+  int visible_tick_base_C = visible_tick_base_C_;
+  float scale_heap_x = vertex_to_screen_.data()[0];
+  float scale_heap_y = vertex_to_screen_.data()[2];
+  float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
+  vec3 color(vertex.getColor().x(), vertex.getColor().y(), vertex.getColor().z());
+
+  // =========================================================================
+  // Everything below should be valid C++ and also valid GLSL! This code is
+  // shared between fragmentationchartlayer.cpp and chart_shader.vert, so make
+  // sure it always stays in synch!!
+  // =========================================================================
+  //
+  // Read the X (tick) and Y (address) coordinate of the current point.
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  // Lowest 4 bit represent fractional component, again.
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
+  // Translate the x / tick coordinate to be aligned with 0.
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
+
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
+                                        scale_heap_to_screen[0][0]);
+  float final_x = temp_x * scale_heap_to_screen[0][0];
+
+  // The y coordinate is the charted value scaled to [0, 0xFFFF], and gets
+  // drawn into the bottom quarter of the screen.
+  float final_y = -1.0 + 0.5 * (float(position.z) / float(0xFFFF));
+  final_x = 2 * final_x - 1;
+  // ==========================================================================
+  // End of mandatory valid GLSL part.
+  // ==========================================================================
+
+  vec4 gl_Position = vec4(final_x, final_y, 0.0, 1.0);
+  vec4 vColor = vec4(color, 0.8);
+  return std::make_pair(gl_Position, vColor);
+}
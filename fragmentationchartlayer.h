@@ -0,0 +1,16 @@
+#ifndef FRAGMENTATIONCHARTLAYER_H
+#define FRAGMENTATIONCHARTLAYER_H
+#include "glheapdiagramlayer.h"
+
+// Draws the fragmentation timeline (live bytes, live blocks, address span and
+// fragmentation ratio) as a line chart at the bottom of the diagram.
+class FragmentationChartLayer : public GLHeapDiagramLayer
+{
+public:
+  FragmentationChartLayer();
+  virtual ~FragmentationChartLayer() = default;
+  std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex& vertex) override;
+  void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) override;
+};
+
+#endif // FRAGMENTATIONCHARTLAYER_H
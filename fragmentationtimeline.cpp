@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "fragmentationtimeline.h"
+
+FragmentationTimeline::FragmentationTimeline(uint32_t maximum_buckets)
+  : maximum_buckets_(std::max(maximum_buckets, static_cast<uint32_t>(2))) {
+  for (auto& series : minimum_) {
+    series.reserve(maximum_buckets_);
+  }
+  for (auto& series : maximum_) {
+    series.reserve(maximum_buckets_);
+  }
+}
+
+// Halves the number of buckets by merging adjacent pairs.
+void FragmentationTimeline::mergeBuckets() {
+  for (int metric = 0; metric < NumberOfMetrics; ++metric) {
+    std::vector<uint64_t>& minimum = minimum_[metric];
+    std::vector<uint64_t>& maximum = maximum_[metric];
+    size_t merged = 0;
+    for (size_t index = 0; index < minimum.size(); index += 2, ++merged) {
+      minimum[merged] = minimum[index];
+      maximum[merged] = maximum[index];
+      if (index + 1 < minimum.size()) {
+        minimum[merged] = std::min(minimum[merged], minimum[index + 1]);
+        maximum[merged] = std::max(maximum[merged], maximum[index + 1]);
+      }
+    }
+    minimum.resize(merged);
+    maximum.resize(merged);
+  }
+  bucket_width_ *= 2;
+}
+
+// Makes sure the bucket for |tick| exists. Buckets without events hold the
+// last recorded state; the bucket for |tick| itself starts out with |values|
+// if the previous state ended before the bucket started.
+void FragmentationTimeline::extendTo(uint64_t tick, const uint64_t* values) {
+  while (tick / bucket_width_ >= maximum_buckets_) {
+    mergeBuckets();
+  }
+  size_t bucket = tick / bucket_width_;
+  while (getNumberOfBuckets() <= bucket) {
+    bool starts_at_tick = (getNumberOfBuckets() == bucket) &&
+      (tick % bucket_width_ == 0);
+    const uint64_t* initial = starts_at_tick ? values : current_;
+    for (int metric = 0; metric < NumberOfMetrics; ++metric) {
+      minimum_[metric].push_back(initial[metric]);
+      maximum_[metric].push_back(initial[metric]);
+    }
+  }
+}
+
+void FragmentationTimeline::recordEvent(uint64_t tick, uint64_t live_bytes,
+  uint64_t live_blocks, uint64_t address_span) {
+  uint64_t values[NumberOfMetrics];
+  values[LiveBytes] = live_bytes;
+  values[LiveBlocks] = live_blocks;
+  values[AddressSpan] = address_span;
+  values[Fragmentation] = (address_span == 0) ? 0 :
+    fragmentation_scale - std::min(fragmentation_scale,
+      static_cast<uint64_t>(static_cast<double>(live_bytes) /
+        address_span * fragmentation_scale));
+
+  extendTo(tick, values);
+  size_t bucket = tick / bucket_width_;
+  for (int metric = 0; metric < NumberOfMetrics; ++metric) {
+    minimum_[metric][bucket] = std::min(minimum_[metric][bucket],
+      values[metric]);
+    maximum_[metric][bucket] = std::max(maximum_[metric][bucket],
+      values[metric]);
+    global_maximum_[metric] = std::max(global_maximum_[metric],
+      values[metric]);
+    current_[metric] = values[metric];
+  }
+}
+
+void FragmentationTimeline::finish(uint64_t maximum_tick) {
+  extendTo(maximum_tick, current_);
+}
+
+void FragmentationTimeline::getDecimated(Metric metric, uint64_t low_tick,
+  uint64_t high_tick, uint32_t columns,
+  std::vector<TimelineColumn>* result) const {
+  const std::vector<uint64_t>& minimum = minimum_[metric];
+  const std::vector<uint64_t>& maximum = maximum_[metric];
+  uint64_t end_tick = std::min(high_tick,
+    static_cast<uint64_t>(minimum.size()) * bucket_width_);
+  if ((columns == 0) || (low_tick >= end_tick)) {
+    return;
+  }
+  // Columns are never narrower than a bucket.
+  uint64_t column_width = std::max((end_tick - low_tick + columns - 1) /
+    columns, bucket_width_);
+
+  for (uint64_t tick = low_tick; tick < end_tick; tick += column_width) {
+    size_t first = tick / bucket_width_;
+    size_t last = std::min((tick + column_width - 1) / bucket_width_,
+      static_cast<uint64_t>(minimum.size() - 1));
+    uint64_t column_minimum = minimum[first];
+    uint64_t column_maximum = maximum[first];
+    for (size_t bucket = first + 1; bucket <= last; ++bucket) {
+      column_minimum = std::min(column_minimum, minimum[bucket]);
+      column_maximum = std::max(column_maximum, maximum[bucket]);
+    }
+    result->emplace_back(tick, column_minimum,
+      column_maximum);
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef FRAGMENTATIONTIMELINE_H
+#define FRAGMENTATIONTIMELINE_H
+
+#include <cstdint>
+#include <vector>
+
+// A column of a decimated timeline: the minimum and maximum value of a metric
+// over the ticks [tick_, next column's tick_).
+class TimelineColumn {
+public:
+  TimelineColumn(uint64_t tick, uint64_t minimum, uint64_t maximum) :
+    tick_(tick), minimum_(minimum), maximum_(maximum) {}
+  uint64_t tick_;
+  uint64_t minimum_;
+  uint64_t maximum_;
+};
+
+// Time series of heap metrics, built in a single streaming pass while the
+// allocations and frees are recorded.
+//
+// The series are kept as compact arrays of per-bucket minima and maxima.
+// Since the number of ticks is not known while streaming, the buckets start
+// out one tick wide; whenever the maximum number of buckets is reached, pairs
+// of adjacent buckets are merged and the bucket width doubles. Recording an
+// event is therefore amortized O(1).
+class FragmentationTimeline {
+public:
+  enum Metric {
+    LiveBytes = 0,
+    LiveBlocks,
+    // Distance between the lowest and highest live address.
+    AddressSpan,
+    // External fragmentation: the fraction of the address span that is not
+    // occupied by live blocks, in units of 1 / fragmentation_scale.
+    Fragmentation,
+    NumberOfMetrics
+  };
+  static constexpr uint64_t fragmentation_scale = 0x10000;
+
+  explicit FragmentationTimeline(uint32_t maximum_buckets = 0x10000);
+
+  // Records the state of the heap after the event at |tick|. Ticks have to be
+  // passed in ascending order.
+  void recordEvent(uint64_t tick, uint64_t live_bytes, uint64_t live_blocks,
+    uint64_t address_span);
+  // Extends the series with the last recorded state up to |maximum_tick|.
+  void finish(uint64_t maximum_tick);
+
+  uint64_t getBucketWidth() const { return bucket_width_; }
+  size_t getNumberOfBuckets() const { return minimum_[LiveBytes].size(); }
+  const std::vector<uint64_t>& getMinimum(Metric metric) const {
+    return minimum_[metric];
+  }
+  const std::vector<uint64_t>& getMaximum(Metric metric) const {
+    return maximum_[metric];
+  }
+  // The largest value the metric ever had.
+  uint64_t getGlobalMaximum(Metric metric) const {
+    return global_maximum_[metric];
+  }
+
+  // Min/max decimation of the ticks [low_tick, high_tick) into at most
+  // |columns| columns, appended to |result|. The cost is proportional to the
+  // number of buckets in the tick range plus the number of columns.
+  void getDecimated(Metric metric, uint64_t low_tick, uint64_t high_tick,
+    uint32_t columns, std::vector<TimelineColumn>* result) const;
+
+private:
+  void extendTo(uint64_t tick, const uint64_t* values);
+  void mergeBuckets();
+
+  uint64_t maximum_buckets_;
+  uint64_t bucket_width_ = 1;
+
+  std::vector<uint64_t> minimum_[NumberOfMetrics];
+  std::vector<uint64_t> maximum_[NumberOfMetrics];
+  uint64_t global_maximum_[NumberOfMetrics] = {};
+
+  // The values after the last recorded event.
+  uint64_t current_[NumberOfMetrics] = {};
+};
+
+#endif // FRAGMENTATIONTIMELINE_H
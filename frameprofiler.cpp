@@ -0,0 +1,169 @@
+#include <cinttypes>
+#include <cstdio>
+#include <utility>
+
+#include "frameprofiler.h"
+
+constexpr size_t FrameProfiler::history_size;
+
+FrameProfiler::Scope::Scope(FrameProfiler* profiler, const char* name) :
+  profiler_((profiler != nullptr) && profiler->isFrameRunning() ?
+    profiler : nullptr), name_(name) {
+  if (profiler_ != nullptr) {
+    start_ = profiler_->now();
+  }
+}
+
+FrameProfiler::Scope::~Scope() {
+  if (profiler_ != nullptr) {
+    profiler_->addCpuSection(name_, start_, profiler_->now() - start_);
+  }
+}
+
+FrameProfiler::FrameProfiler() : origin_(std::chrono::steady_clock::now()) {}
+
+uint64_t FrameProfiler::now() const {
+  return static_cast<uint64_t>(std::chrono::duration_cast<
+    std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+    origin_).count());
+}
+
+uint64_t FrameProfiler::beginFrame() {
+  if (!enabled_) {
+    return 0;
+  }
+  if (frame_running_) {
+    endFrame();
+  }
+  if (frames_.size() >= history_size) {
+    frames_.pop_front();
+  }
+  frames_.emplace_back();
+  frames_.back().number_ = next_frame_++;
+  frames_.back().start_ = now();
+  frame_running_ = true;
+  return frames_.back().number_;
+}
+
+void FrameProfiler::endFrame() {
+  if (!frame_running_) {
+    return;
+  }
+  frames_.back().duration_ = now() - frames_.back().start_;
+  frame_running_ = false;
+}
+
+uint64_t FrameProfiler::getCurrentFrame() const {
+  return frame_running_ ? frames_.back().number_ : 0;
+}
+
+void FrameProfiler::addCpuSection(const char* name, uint64_t start,
+  uint64_t duration) {
+  if (!frame_running_) {
+    return;
+  }
+  Section section;
+  section.name_ = name;
+  section.start_ = start;
+  section.duration_ = duration;
+  frames_.back().sections_.push_back(std::move(section));
+}
+
+void FrameProfiler::addGpuSection(uint64_t frame, const std::string& name,
+  uint64_t start, uint64_t duration) {
+  // Frame numbers are consecutive, so the frame is found by its distance
+  // from the oldest one.
+  if (frames_.empty() || (frame < frames_.front().number_) ||
+    (frame > frames_.back().number_)) {
+    return;
+  }
+  Section section;
+  section.name_ = name;
+  section.gpu_ = true;
+  section.start_ = start;
+  section.duration_ = duration;
+  frames_[frame - frames_.front().number_].sections_.push_back(
+    std::move(section));
+}
+
+std::vector<FrameProfiler::Average> FrameProfiler::getAverages(
+  size_t frames) const {
+  std::vector<Average> averages(1);
+  averages[0].name_ = "frame";
+  size_t end = frames_.size() - (frame_running_ ? 1 : 0);
+  size_t begin = (end > frames) ? end - frames : 0;
+  if (begin == end) {
+    return averages;
+  }
+  for (size_t index = begin; index < end; ++index) {
+    const Frame& frame = frames_[index];
+    averages[0].milliseconds_ += frame.duration_ / 1e6;
+    for (const Section& section : frame.sections_) {
+      size_t average = 1;
+      while ((average < averages.size()) &&
+        ((averages[average].name_ != section.name_) ||
+          (averages[average].gpu_ != section.gpu_))) {
+        ++average;
+      }
+      if (average == averages.size()) {
+        averages.emplace_back();
+        averages.back().name_ = section.name_;
+        averages.back().gpu_ = section.gpu_;
+      }
+      averages[average].milliseconds_ += section.duration_ / 1e6;
+    }
+  }
+  for (Average& average : averages) {
+    average.milliseconds_ /= static_cast<double>(end - begin);
+  }
+  return averages;
+}
+
+static void writeJSONString(std::ostream& out, const std::string& text) {
+  out << '"';
+  for (char character : text) {
+    if ((character == '"') || (character == '\\')) {
+      out << '\\' << character;
+    } else if (static_cast<unsigned char>(character) < 0x20) {
+      char buf[8];
+      sprintf(buf, "\\u%04x", character);
+      out << buf;
+    } else {
+      out << character;
+    }
+  }
+  out << '"';
+}
+
+// Writes a complete ("X") event. The trace format counts in microseconds.
+static void writeTraceEvent(std::ostream& out, const std::string& name,
+  const char* category, int thread, uint64_t start, uint64_t duration) {
+  char buf[256];
+  out << ",\n{\"name\":";
+  writeJSONString(out, name);
+  sprintf(buf, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+    "\"ts\":%" PRIu64 ".%03" PRIu64 ",\"dur\":%" PRIu64 ".%03" PRIu64 "}",
+    category, thread, start / 1000, start % 1000, duration / 1000,
+    duration % 1000);
+  out << buf;
+}
+
+void FrameProfiler::writeChromeTrace(std::ostream& out) const {
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+    "\"args\":{\"name\":\"CPU\"}},\n"
+    "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,"
+    "\"args\":{\"name\":\"GPU\"}}";
+  for (const Frame& frame : frames_) {
+    if (frame_running_ && (&frame == &frames_.back())) {
+      break;
+    }
+    writeTraceEvent(out, "frame " + std::to_string(frame.number_), "frame", 1,
+      frame.start_, frame.duration_);
+    for (const Section& section : frame.sections_) {
+      writeTraceEvent(out, section.name_, section.gpu_ ? "gpu" : "cpu",
+        section.gpu_ ? 2 : 1, section.start_, section.duration_);
+    }
+  }
+  out << "\n]}\n";
+}
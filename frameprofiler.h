@@ -0,0 +1,102 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records where the time of every frame goes, for the frame HUD and for
+// offline analysis as a Chrome trace (chrome://tracing or Perfetto).
+//
+// A frame is a list of named sections. CPU sections are timed by a Scope
+// around the code in question and may nest. GPU sections come from timer
+// queries that only finish a few frames later (see GLFrameTimers), so they
+// are added to the frame that issued them after the fact. Only the last
+// history_size frames are kept.
+class FrameProfiler {
+public:
+  static constexpr size_t history_size = 600;
+
+  struct Section {
+    std::string name_;
+    bool gpu_ = false;
+    // Nanoseconds since the profiler was created. Timer queries only measure
+    // durations, so GPU sections start when they were issued on the CPU.
+    uint64_t start_ = 0;
+    uint64_t duration_ = 0;
+  };
+  struct Frame {
+    uint64_t number_ = 0;
+    uint64_t start_ = 0;
+    uint64_t duration_ = 0;
+    std::vector<Section> sections_;
+  };
+  // The time that a section takes per frame, on average.
+  struct Average {
+    std::string name_;
+    bool gpu_ = false;
+    double milliseconds_ = 0.0;
+  };
+
+  // Times the code from its construction to the end of its scope as a CPU
+  // section of the current frame. Does nothing if |profiler| is null or
+  // disabled, or if no frame is running; |name| needs to outlive the scope.
+  class Scope {
+  public:
+    Scope(FrameProfiler* profiler, const char* name);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    FrameProfiler* profiler_;
+    const char* name_;
+    uint64_t start_ = 0;
+  };
+
+  FrameProfiler();
+
+  void setEnabled(bool enabled) { enabled_ = enabled; }
+  bool isEnabled() const { return enabled_; }
+  // True between beginFrame() and endFrame() of an enabled profiler.
+  bool isFrameRunning() const { return frame_running_; }
+
+  // Starts a new frame and returns its number, which is never 0. Returns 0
+  // and does nothing if the profiler is disabled.
+  uint64_t beginFrame();
+  void endFrame();
+  // The number of the running frame, or 0.
+  uint64_t getCurrentFrame() const;
+
+  // Nanoseconds since the profiler was created.
+  uint64_t now() const;
+  // Adds a CPU section to the running frame.
+  void addCpuSection(const char* name, uint64_t start, uint64_t duration);
+  // Adds a GPU section to frame |frame|, unless it was dropped already.
+  void addGpuSection(uint64_t frame, const std::string& name, uint64_t start,
+    uint64_t duration);
+
+  // The kept frames, oldest first; the last one may still be running.
+  const std::deque<Frame>& getFrames() const { return frames_; }
+  // The average time per frame of the whole frame (as "frame") and of every
+  // section over the last |frames| finished frames, in the order in which
+  // the sections first appear. A section that is missing from a frame
+  // counts as taking no time there.
+  std::vector<Average> getAverages(size_t frames) const;
+
+  // Writes the kept frames as a Chrome trace in JSON, with the CPU sections
+  // on one thread and the GPU sections on another.
+  void writeChromeTrace(std::ostream& out) const;
+
+private:
+  std::chrono::steady_clock::time_point origin_;
+  std::deque<Frame> frames_;
+  uint64_t next_frame_ = 1;
+  bool enabled_ = false;
+  bool frame_running_ = false;
+};
+
+#endif // FRAMEPROFILER_H
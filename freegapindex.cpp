@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#include "freegapindex.h"
+
+// The largest-gap curve has at most this many buckets.
+static constexpr uint64_t maximum_curve_buckets = 4096;
+
+//============================================================================
+// FreeIntervalSet
+
+FreeIntervalSet::FreeIntervalSet(uint64_t low, uint64_t high)
+  : low_(low), high_(high) {
+  insertFree(low, high);
+}
+
+std::map<uint64_t, uint64_t>::iterator FreeIntervalSet::eraseFree(
+  std::map<uint64_t, uint64_t>::iterator interval) {
+  gap_sizes_.erase(gap_sizes_.find(interval->second - interval->first));
+  return free_.erase(interval);
+}
+
+// Inserts a free interval, merging it with adjacent free intervals.
+void FreeIntervalSet::insertFree(uint64_t start, uint64_t end) {
+  if (start >= end) {
+    return;
+  }
+  auto next = free_.lower_bound(start);
+  if (next != free_.begin()) {
+    auto previous = std::prev(next);
+    if (previous->second >= start) {
+      start = previous->first;
+      end = std::max(end, previous->second);
+      eraseFree(previous);
+    }
+  }
+  while ((next != free_.end()) && (next->first <= end)) {
+    end = std::max(end, next->second);
+    next = eraseFree(next);
+  }
+  free_[start] = end;
+  gap_sizes_.insert(end - start);
+}
+
+void FreeIntervalSet::allocate(uint64_t address, uint64_t end) {
+  allocated_.emplace(address, end);
+  address = std::max(address, low_);
+  end = std::min(end, high_);
+  if (address >= end) {
+    return;
+  }
+  // Find the first free interval that ends after the allocated address.
+  auto interval = free_.upper_bound(address);
+  if ((interval != free_.begin()) && (std::prev(interval)->second > address)) {
+    --interval;
+  }
+  // Carve the allocation out of all free intervals it overlaps.
+  while ((interval != free_.end()) && (interval->first < end)) {
+    uint64_t free_start = interval->first;
+    uint64_t free_end = interval->second;
+    interval = eraseFree(interval);
+    if (free_start < address) {
+      free_[free_start] = address;
+      gap_sizes_.insert(address - free_start);
+    }
+    if (free_end > end) {
+      interval = free_.emplace(end, free_end).first;
+      gap_sizes_.insert(free_end - end);
+      break;
+    }
+  }
+}
+
+void FreeIntervalSet::release(uint64_t address, uint64_t end) {
+  auto range = allocated_.equal_range(address);
+  for (auto block = range.first; block != range.second; ++block) {
+    if (block->second == end) {
+      allocated_.erase(block);
+      break;
+    }
+  }
+
+  // Do not release memory that is still covered by the closest allocated
+  // interval below the released one.
+  uint64_t start = std::max(address, low_);
+  auto next = allocated_.lower_bound(address);
+  if (next != allocated_.begin()) {
+    start = std::max(start, std::prev(next)->second);
+  }
+  end = std::min(end, high_);
+  // Nor memory that is covered by allocations inside the released interval.
+  while ((next != allocated_.end()) && (next->first < end)) {
+    insertFree(start, std::min(next->first, end));
+    start = std::max(start, next->second);
+    ++next;
+  }
+  insertFree(start, end);
+}
+
+void FreeIntervalSet::getGaps(uint64_t minimum_size, uint64_t low,
+  uint64_t high, std::vector<std::pair<uint64_t, uint64_t>>* gaps) const {
+  auto interval = free_.upper_bound(low);
+  if (interval != free_.begin()) {
+    --interval;
+  }
+  for (; (interval != free_.end()) && (interval->first < high); ++interval) {
+    uint64_t start = std::max(interval->first, low);
+    uint64_t end = std::min(interval->second, high);
+    if ((end > start) && (end - start >= minimum_size)) {
+      gaps->emplace_back(start, end);
+    }
+  }
+}
+
+//============================================================================
+// FreeGapIndex
+
+FreeGapIndex::FreeGapIndex() = default;
+
+FreeGapIndex::FreeGapIndex(uint64_t maximum_tick, uint64_t minimum_address,
+  uint64_t maximum_address, const CompressedBlockStore* blocks,
+  const LiveSetCheckpoints* checkpoints)
+  : minimum_address_(minimum_address), maximum_address_(maximum_address),
+    blocks_(blocks), checkpoints_(checkpoints) {
+  printf("[!] Calculating largest free gap curve...\n");
+  fflush(stdout);
+  calculateLargestGapCurve(maximum_tick);
+  printf("[!] Done calculating largest free gap curve.\n");
+  fflush(stdout);
+}
+
+void FreeGapIndex::applyAllocation(Sweep* sweep, uint32_t index,
+  uint64_t address, uint64_t size) {
+  sweep->intervals_.allocate(address, address + size);
+  sweep->live_.emplace(index, std::make_pair(address, address + size));
+}
+
+void FreeGapIndex::applyFree(Sweep* sweep, uint32_t index) {
+  auto block = sweep->live_.find(index);
+  if (block == sweep->live_.end()) {
+    return;
+  }
+  sweep->intervals_.release(block->second.first, block->second.second);
+  sweep->live_.erase(block);
+}
+
+// Sweeps once over all events in tick order, and samples the largest free
+// gap at the end of every bucket.
+void FreeGapIndex::calculateLargestGapCurve(uint64_t maximum_tick) {
+  uint64_t buckets = std::max(std::min(maximum_tick, maximum_curve_buckets),
+    static_cast<uint64_t>(1));
+  curve_bucket_width_ = (maximum_tick + buckets - 1) / buckets;
+  curve_bucket_width_ = std::max(curve_bucket_width_, static_cast<uint64_t>(1));
+  largest_gap_curve_.clear();
+  largest_gap_curve_.reserve(buckets);
+
+  Sweep sweep(minimum_address_, maximum_address_);
+  // Records all samples that lie before the given tick.
+  auto sampleUpTo = [&](uint64_t tick) {
+    while ((largest_gap_curve_.size() < buckets) &&
+      ((largest_gap_curve_.size() + 1) * curve_bucket_width_ <
+        tick)) {
+      largest_gap_curve_.push_back(sweep.intervals_.getLargestGap());
+    }
+  };
+  checkpoints_->replayEventsBetween(0, maximum_tick,
+    [&](uint32_t index, const HeapBlock& block) {
+      sampleUpTo(block.start_tick_);
+      applyAllocation(&sweep, index, block.address_, block.size_);
+    },
+    [&](uint32_t index, uint64_t tick) {
+      sampleUpTo(tick);
+      applyFree(&sweep, index);
+    });
+  sampleUpTo(std::numeric_limits<uint64_t>::max());
+}
+
+// Brings sweep_ to the state at the given tick. Replays forward from the last
+// query if that is cheaper than starting over from a checkpoint.
+void FreeGapIndex::seekToTick(uint64_t tick) {
+  uint64_t interval = checkpoints_->getCheckpointInterval();
+  uint64_t checkpoint_tick = tick - (tick % interval);
+  if (!sweep_ || (sweep_tick_ > tick) || (sweep_tick_ < checkpoint_tick)) {
+    sweep_.reset(new Sweep(minimum_address_, maximum_address_));
+    std::vector<uint32_t> live;
+    checkpoints_->getLiveBlocksAtTick(checkpoint_tick, &live);
+    blocks_->forEachBlockIn(live, [this](uint32_t index,
+      const CompressedBlockStore::DecodedChunk& chunk, uint32_t offset) {
+      applyAllocation(sweep_.get(), index, chunk.addresses_[offset],
+        chunk.sizes_[offset]);
+    });
+    sweep_tick_ = checkpoint_tick;
+  }
+  checkpoints_->replayEventsBetween(sweep_tick_, tick,
+    [this](uint32_t index, const HeapBlock& block) {
+      applyAllocation(sweep_.get(), index, block.address_, block.size_);
+    },
+    [this](uint32_t index, uint64_t) { applyFree(sweep_.get(), index); });
+  sweep_tick_ = tick;
+}
+
+void FreeGapIndex::getFreeGapsAtTick(uint64_t tick, uint64_t minimum_size,
+  uint64_t low, uint64_t high,
+  std::vector<std::pair<uint64_t, uint64_t>>* gaps) {
+  if (checkpoints_ == nullptr) {
+    return;
+  }
+  seekToTick(tick);
+  // The query range is inclusive, the free intervals are not.
+  uint64_t end = (high == std::numeric_limits<uint64_t>::max()) ?
+    high : high + 1;
+  sweep_->intervals_.getGaps(minimum_size, low, end, gaps);
+}
@@ -0,0 +1,113 @@
+#ifndef FREEGAPINDEX_H
+#define FREEGAPINDEX_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "livesetcheckpoints.h"
+
+// An ordered set of the free intervals [start, end) in a fixed address range,
+// which is updated as blocks get allocated and released. Keeps a multiset of
+// the interval sizes so the largest free interval is available in O(1).
+class FreeIntervalSet {
+public:
+  // Initially, the entire range [low, high) is free.
+  FreeIntervalSet(uint64_t low, uint64_t high);
+
+  void allocate(uint64_t address, uint64_t end);
+  void release(uint64_t address, uint64_t end);
+
+  uint64_t getLargestGap() const {
+    return gap_sizes_.empty() ? 0 : *gap_sizes_.rbegin();
+  }
+  size_t getNumberOfGaps() const { return free_.size(); }
+
+  // Appends all free intervals of at least |minimum_size| bytes, clipped to
+  // [low, high), to |gaps|, in ascending order of address.
+  void getGaps(uint64_t minimum_size, uint64_t low, uint64_t high,
+    std::vector<std::pair<uint64_t, uint64_t>>* gaps) const;
+
+private:
+  void insertFree(uint64_t start, uint64_t end);
+  std::map<uint64_t, uint64_t>::iterator eraseFree(
+    std::map<uint64_t, uint64_t>::iterator interval);
+
+  uint64_t low_;
+  uint64_t high_;
+
+  // Free intervals, mapping start to end.
+  std::map<uint64_t, uint64_t> free_;
+  std::multiset<uint64_t> gap_sizes_;
+
+  // The currently allocated intervals, used to avoid freeing memory that is
+  // still covered by another (conflicting) block. Only the closest lower
+  // neighbour and the blocks starting inside a released range are checked,
+  // which is exact unless several live blocks overlap each other.
+  std::multimap<uint64_t, uint64_t> allocated_;
+};
+
+// Answers "which free gaps of at least S bytes exist in [low, high] at tick
+// T" for the heap history, and provides the size of the largest free gap over
+// time.
+//
+// Queries start from the live set at the closest checkpoint and replay the
+// events up to the requested tick. The resulting free interval set is kept
+// around, so that queries for nearby later ticks (e.g. when scrubbing
+// forward through the history) only replay the events in between. Replayed
+// frees only carry the index of the block, so every sweep keeps the address
+// range of each of its live blocks.
+class FreeGapIndex {
+public:
+  FreeGapIndex();
+  FreeGapIndex(uint64_t maximum_tick, uint64_t minimum_address,
+    uint64_t maximum_address, const CompressedBlockStore* blocks,
+    const LiveSetCheckpoints* checkpoints);
+
+  void getFreeGapsAtTick(uint64_t tick, uint64_t minimum_size, uint64_t low,
+    uint64_t high, std::vector<std::pair<uint64_t, uint64_t>>* gaps);
+
+  // The size of the largest free gap at the end of each bucket of
+  // getCurveBucketWidth() ticks, computed in a single pass over all events.
+  const std::vector<uint64_t>& getLargestGapCurve() const {
+    return largest_gap_curve_;
+  }
+  uint64_t getCurveBucketWidth() const { return curve_bucket_width_; }
+
+private:
+  // Makes the test class a friend to permit testing private functions.
+  friend class TestFreeGapIndex;
+
+  // The free intervals at some tick, and the address range [start, end) of
+  // every block that is live at that tick.
+  struct Sweep {
+    Sweep(uint64_t low, uint64_t high) : intervals_(low, high) {}
+    FreeIntervalSet intervals_;
+    std::unordered_map<uint32_t, std::pair<uint64_t, uint64_t>> live_;
+  };
+
+  void seekToTick(uint64_t tick);
+  static void applyAllocation(Sweep* sweep, uint32_t index,
+    uint64_t address, uint64_t size);
+  static void applyFree(Sweep* sweep, uint32_t index);
+  void calculateLargestGapCurve(uint64_t maximum_tick);
+
+  uint64_t minimum_address_ = 0;
+  uint64_t maximum_address_ = 0;
+  const CompressedBlockStore* blocks_ = nullptr;
+  const LiveSetCheckpoints* checkpoints_ = nullptr;
+
+  // The sweep at tick sweep_tick_ from the last query.
+  std::unique_ptr<Sweep> sweep_;
+  uint64_t sweep_tick_ = 0;
+
+  std::vector<uint64_t> largest_gap_curve_;
+  uint64_t curve_bucket_width_ = 1;
+};
+
+#endif // FREEGAPINDEX_H
@@ -0,0 +1,66 @@
+#include <cstdio>
+#include <utility>
+
+#include "glframetimers.h"
+
+constexpr size_t GLFrameTimers::maximum_pending_queries;
+
+void GLFrameTimers::begin(FrameProfiler* profiler, const std::string& name) {
+  if (!supported_ || is_running_ || !profiler->isFrameRunning()) {
+    return;
+  }
+  if (unused_.empty()) {
+    std::unique_ptr<QOpenGLTimerQuery> query(new QOpenGLTimerQuery());
+    if (!query->create()) {
+      printf("[!] No GL timer queries, the GPU times are not recorded\n");
+      supported_ = false;
+      return;
+    }
+    unused_.push_back(std::move(query));
+  }
+  running_.query_ = std::move(unused_.back());
+  unused_.pop_back();
+  running_.frame_ = profiler->getCurrentFrame();
+  running_.name_ = name;
+  running_.start_ = profiler->now();
+  running_.query_->begin();
+  is_running_ = true;
+}
+
+void GLFrameTimers::end() {
+  if (!is_running_) {
+    return;
+  }
+  running_.query_->end();
+  is_running_ = false;
+  if (pending_.size() >= maximum_pending_queries) {
+    unused_.push_back(std::move(pending_.front().query_));
+    pending_.pop_front();
+  }
+  pending_.push_back(std::move(running_));
+}
+
+void GLFrameTimers::collect(FrameProfiler* profiler) {
+  // The GPU finishes the queries in order.
+  while (!pending_.empty() && pending_.front().query_->isResultAvailable()) {
+    Query& query = pending_.front();
+    profiler->addGpuSection(query.frame_, query.name_, query.start_,
+      query.query_->waitForResult());
+    unused_.push_back(std::move(query.query_));
+    pending_.pop_front();
+  }
+}
+
+void GLFrameTimers::clear() {
+  if (is_running_) {
+    end();
+  }
+  for (Query& query : pending_) {
+    query.query_->destroy();
+  }
+  for (auto& query : unused_) {
+    query->destroy();
+  }
+  pending_.clear();
+  unused_.clear();
+}
@@ -0,0 +1,52 @@
+#ifndef GLFRAMETIMERS_H
+#define GLFRAMETIMERS_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QOpenGLTimerQuery>
+
+#include "frameprofiler.h"
+
+// Times sections of a frame on the GPU with timer queries, and hands the
+// results to a FrameProfiler once the GPU got to them. Waiting for a result
+// right away would stall the pipeline, so the queries are only collected a
+// few frames later, and reused afterwards.
+//
+// Elapsed-time queries can not nest, so only one section can be timed at a
+// time. Does nothing if the context has no timer queries.
+class GLFrameTimers {
+public:
+  // At most this many queries wait for their results; older ones are
+  // dropped if the GPU falls behind further than that.
+  static constexpr size_t maximum_pending_queries = 64;
+
+  // Starts timing |name| in the running frame of |profiler|.
+  void begin(FrameProfiler* profiler, const std::string& name);
+  void end();
+  // Passes the results that the GPU has ready to |profiler|.
+  void collect(FrameProfiler* profiler);
+  // Destroys all queries; needs to be called while the GL context is
+  // current, before the timers go away.
+  void clear();
+
+private:
+  struct Query {
+    std::unique_ptr<QOpenGLTimerQuery> query_;
+    uint64_t frame_ = 0;
+    std::string name_;
+    uint64_t start_ = 0;
+  };
+
+  bool supported_ = true;
+  bool is_running_ = false;
+  Query running_;
+  // The ended queries, oldest first.
+  std::deque<Query> pending_;
+  std::vector<std::unique_ptr<QOpenGLTimerQuery>> unused_;
+};
+
+#endif // GLFRAMETIMERS_H
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <iostream>
 #include <fstream>
@@ -7,12 +9,15 @@
 #include <QtGlobal>
 #include <QOpenGLShaderProgram>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
 #include <QWindow>
 
 #include "addressdiagramlayer.h"
 #include "eventdiagramlayer.h"
 #include "heapblock.h"
 #include "heapblockdiagramlayer.h"
+#include "traceinputstream.h"
 #include "vertex.h"
 #include "glheapdiagram.h"
 
@@ -23,18 +28,92 @@ GLHeapDiagram::GLHeapDiagram(QWidget *parent)
       block_layer_(new HeapBlockDiagramLayer()),
       event_layer_(new EventDiagramLayer()),
       address_layer_(new AddressDiagramLayer()),
-      pages_layer_(new ActiveRegionsDiagramLayer()) {
+      pages_layer_(new ActiveRegionsDiagramLayer()),
+      chart_layer_(new FragmentationChartLayer()),
+      tag_chart_layer_(new TagChartLayer()),
+      hover_inspector_(new HoverInspector(&heap_history_)) {
+  // The answers arrive on the worker thread.
+  hover_inspector_->setResultCallback(
+      [this](uint64_t serial, const std::string &description) {
+        QString text = QString::fromStdString(description);
+        QMetaObject::invokeMethod(this, [this, serial, text]() {
+          showHoverDescription(serial, text);
+        }, Qt::QueuedConnection);
+      });
+  block_layer_->setProfiler(&profiler_, "blocks");
+  event_layer_->setProfiler(&profiler_, "events");
+  address_layer_->setProfiler(&profiler_, "addresses");
+  pages_layer_->setProfiler(&profiler_, "pages");
+  chart_layer_->setProfiler(&profiler_, "fragmentation_chart");
+  tag_chart_layer_->setProfiler(&profiler_, "tag_chart");
 
   //  QObject::connect(this, SIGNAL(blockClicked), parent->parent(),
   //  SLOT(blockClicked));
 }
 
+void GLHeapDiagram::setAllowNative64BitShaders(bool allow) {
+  block_layer_->setAllowNative64BitShader(allow);
+  event_layer_->setAllowNative64BitShader(allow);
+  address_layer_->setAllowNative64BitShader(allow);
+  pages_layer_->setAllowNative64BitShader(allow);
+}
+
+void GLHeapDiagram::setTileRelativeVertices(bool use) {
+  block_layer_->setUseTileRelativeVertices(use);
+}
+
+void GLHeapDiagram::setShowFrameHUD(bool show) {
+  show_frame_hud_ = show;
+  profiler_.setEnabled(show_frame_hud_ || !frame_trace_file_.empty());
+}
+
+void GLHeapDiagram::setFrameTraceFile(const std::string& trace_file) {
+  frame_trace_file_ = trace_file;
+  profiler_.setEnabled(show_frame_hud_ || !frame_trace_file_.empty());
+}
+
 void GLHeapDiagram::loadFileInternal() {
   if (is_GL_initialized_) {
+    // The workers must not read the blocks while they are replaced.
+    if (tile_renderer_) {
+      tile_renderer_->cancel();
+    }
+    hover_inspector_->cancel();
+    hideHoverDescription();
     // Load the heap history.
-    if (!file_to_load_.empty()) {
-      std::ifstream ifs(file_to_load_, std::fstream::in);
-      heap_history_.LoadFromJSONStream(ifs);
+    if (trace_shards_.size() > 1) {
+      std::vector<std::unique_ptr<TraceInputStream>> inputs;
+      std::vector<std::istream*> shards;
+      for (const std::string& shard : trace_shards_) {
+        inputs.emplace_back(new TraceInputStream(shard));
+        if (inputs.back()->fail()) {
+          printf("[!] Failed to open trace shard %s\n", shard.c_str());
+          continue;
+        }
+        shards.push_back(inputs.back().get());
+      }
+      heap_history_.LoadFromTraceShards(shards);
+    } else if (!file_to_load_.empty()) {
+      // Compressed traces are decompressed on the fly.
+      TraceInputStream ifs(file_to_load_);
+      std::ifstream index_in;
+      if (!trace_index_file_.empty()) {
+        index_in.open(trace_index_file_, std::fstream::in | std::fstream::binary);
+      }
+      if (index_in.is_open()) {
+        if ((last_tick_to_load_ == 0) ||
+            !heap_history_.LoadTickRangeFromJSONStream(ifs, index_in,
+              first_tick_to_load_, last_tick_to_load_)) {
+          heap_history_.LoadFromJSONStream(ifs);
+        }
+      } else if (!trace_index_file_.empty()) {
+        std::ofstream index_out(trace_index_file_,
+          std::fstream::out | std::fstream::binary);
+        TraceIndexWriter index(&index_out);
+        heap_history_.LoadFromJSONStream(ifs, &index);
+      } else {
+        heap_history_.LoadFromJSONStream(ifs);
+      }
     }
     heap_history_.setCurrentWindowToGlobal();
 
@@ -50,6 +129,11 @@ void GLHeapDiagram::loadFileInternal() {
     // Initialize the active pages layer.
     pages_layer_->initializeGLStructures(heap_history_, this);
 
+    // Initialize the fragmentation chart layer.
+    chart_layer_->initializeGLStructures(heap_history_, this);
+
+    // Initialize the per-tag chart layer.
+    tag_chart_layer_->initializeGLStructures(heap_history_, this);
   }
 }
 
@@ -61,6 +145,16 @@ void GLHeapDiagram::initializeGL() {
 
   is_GL_initialized_ = true;
 
+  if (use_tile_cache_) {
+    tile_renderer_.reset(new TileRenderer(&heap_history_));
+    // Repaint on the GUI thread whenever a tile is ready.
+    tile_renderer_->setTileReadyCallback([this]() {
+      QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    });
+    tile_layer_.reset(new TileCacheLayer(tile_renderer_.get()));
+    tile_layer_->initializeGLStructures();
+  }
+
   loadFileInternal();
 }
 
@@ -74,7 +168,111 @@ void GLHeapDiagram::setFileToDisplay(const QString& filename) {
 void GLHeapDiagram::setSizeToHighlight(uint32_t size) {
   size_to_highlight_ = size;
   heap_history_.highlightBySize(size);
-  refresh_all_vertices_ = true;
+  update();
+}
+
+void GLHeapDiagram::setTicksToDiff(uint64_t from_tick, uint64_t to_tick) {
+  size_t changes = heap_history_.highlightChangesBetween(from_tick, to_tick);
+  char buf[1024];
+  sprintf(buf, "%zu blocks changed between tick %" PRIu64 " and tick %" PRIu64,
+          changes,
+          from_tick, to_tick);
+  emit showMessage(std::string(buf));
+  update();
+}
+
+void GLHeapDiagram::setHighlightQuery(QString query) {
+  std::string error;
+  size_t count = 0;
+  if (!heap_history_.highlightByQuery(query.toStdString(), &error, &count)) {
+    emit showMessage(error);
+    return;
+  }
+  char buf[1024];
+  sprintf(buf, "%zu blocks match the query", count);
+  emit showMessage(std::string(buf));
+  update();
+}
+
+// Reports the free gaps of a given minimum size in the currently visible
+// address range at the given tick.
+void GLHeapDiagram::findFreeGaps(uint64_t tick, uint32_t minimum_size) {
+  const DisplayHeapWindow &heap_window = heap_history_.getCurrentWindow();
+  std::vector<std::pair<uint64_t, uint64_t>> gaps;
+  heap_history_.getFreeGapsAtTick(tick, minimum_size,
+                                  heap_window.getMinimumAddressUint64(),
+                                  heap_window.getMaximumAddressUint64(),
+                                  &gaps);
+  char buf[1024];
+  if (gaps.empty()) {
+    sprintf(buf, "No free gaps of at least %u bytes at tick %" PRIu64,
+            minimum_size, tick);
+  } else {
+    auto largest = std::max_element(gaps.begin(), gaps.end(),
+      [](const std::pair<uint64_t, uint64_t> &left,
+         const std::pair<uint64_t, uint64_t> &right) {
+        return (left.second - left.first) < (right.second - right.first);
+      });
+    sprintf(buf, "%zu free gaps of at least %u bytes at tick %" PRIu64
+            ", first at %16.16" PRIx64 ", largest at %16.16" PRIx64 " (%"
+            PRIu64 " bytes)",
+            gaps.size(), minimum_size, tick, gaps.front().first,
+            largest->first, largest->second - largest->first);
+  }
+  emit showMessage(std::string(buf));
+}
+
+void GLHeapDiagram::setShowFragmentationChart(bool show) {
+  show_fragmentation_chart_ = show;
+  update();
+}
+
+void GLHeapDiagram::setHighlightReuseOnClick(bool highlight) {
+  highlight_reuse_on_click_ = highlight;
+}
+
+void GLHeapDiagram::setShowTagChart(bool show) {
+  show_tag_chart_ = show;
+  update();
+}
+
+void GLHeapDiagram::showBytesHeldByTag(QString tag, uint64_t from_tick,
+                                       uint64_t to_tick) {
+  const TagAggregateIndex &index = heap_history_.getTagAggregateIndex();
+  uint32_t tag_id;
+  if (!index.getTagId(tag.toStdString(), &tag_id)) {
+    emit showMessage("No blocks with tag " + tag.toStdString());
+    return;
+  }
+  uint64_t low = std::min(from_tick, to_tick);
+  uint64_t high = std::max(from_tick, to_tick);
+  char buf[1024];
+  sprintf(buf, "Tag held %" PRIu64 " bytes on average between tick %" PRIu64
+          " and tick %" PRIu64 " (%" PRIu64 " allocated, %" PRIu64 " freed, %"
+          PRIu64 " live at the end), precision %" PRIu64 " ticks",
+          index.getAverageLiveBytesBetween(tag_id, low, high), low, high,
+          index.getBytesAllocatedBetween(tag_id, low, high),
+          index.getBytesFreedBetween(tag_id, low, high),
+          index.getLiveBytesAtTick(tag_id, high), index.getBucketWidth());
+  emit showMessage(std::string(buf));
+}
+
+// Only changes the visible heap bits that the block shader reads, so no
+// vertices need to be regenerated.
+void GLHeapDiagram::setVisibleHeaps(QString heaps) {
+  std::string error;
+  if (!heap_history_.setVisibleHeaps(heaps.toStdString(), &error)) {
+    emit showMessage(error);
+    return;
+  }
+  size_t visible = 0;
+  for (uint8_t heap_id : heap_history_.getHeapIds()) {
+    visible += heap_history_.isHeapVisible(heap_id) ? 1 : 0;
+  }
+  char buf[1024];
+  sprintf(buf, "Showing %zu of %zu heaps", visible,
+          heap_history_.getHeapIds().size());
+  emit showMessage(std::string(buf));
   update();
 }
 
@@ -98,13 +296,53 @@ void GLHeapDiagram::getScaleFromHeapToScreen(double *scale_x, double *scale_y) {
   *scale_y = y_scaling;
 }
 
-bool GLHeapDiagram::screenToHeap(double x, double y, uint32_t *tick,
+bool GLHeapDiagram::screenToHeap(double x, double y, uint64_t *tick,
                                  uint64_t *address) {
   return heap_history_.getCurrentWindow().mapDisplayCoordinateToHeap(x, y, tick,
                                                                      address);
 }
 
+bool GLHeapDiagram::pickBlockAt(int x, int y, uint32_t *index) {
+  if (!is_GL_initialized_ || (x < 0) || (y < 0) || (x >= width()) ||
+      (y >= height())) {
+    return false;
+  }
+  makeCurrent();
+  if (!pick_framebuffer_ ||
+      (pick_framebuffer_->size() != QSize(width(), height()))) {
+    pick_framebuffer_.reset(new QOpenGLFramebufferObject(width(), height()));
+    pick_framebuffer_valid_ = false;
+  }
+  pick_framebuffer_->bind();
+  uint64_t view_generation = heap_history_.getViewGeneration();
+  if (!pick_framebuffer_valid_ ||
+      (view_generation != picked_view_generation_)) {
+    glViewport(0, 0, width(), height());
+    // The block indices must not be blended.
+    glDisable(GL_BLEND);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    updateHeapToScreenMap();
+    const DisplayHeapWindow &heap_window = heap_history_.getCurrentWindow();
+    block_layer_->refreshVertices(heap_history_, true);
+    block_layer_->paintBlockIds(heap_window.getMinimumTick(),
+                                heap_window.getMinimumAddress(),
+                                heap_to_screen_matrix_);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glEnable(GL_BLEND);
+    picked_view_generation_ = view_generation;
+    pick_framebuffer_valid_ = true;
+  }
+  // The framebuffer has its origin in the lower left corner.
+  uint8_t rgba[4] = { 0, 0, 0, 0 };
+  glReadPixels(x, height() - 1 - y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+  pick_framebuffer_->release();
+  doneCurrent();
+  return HeapBlockDiagramLayer::decodeBlockId(rgba, index);
+}
+
 void GLHeapDiagram::paintGL() {
+  profiler_.beginFrame();
   glClear(GL_COLOR_BUFFER_BIT);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -114,41 +352,162 @@ void GLHeapDiagram::paintGL() {
   // Enable for verbose output of the simulated shaders.
   heap_window.setDebug(false);
 
-  pages_layer_->refreshVertices(heap_history_, true, refresh_all_vertices_);
-  pages_layer_->paintLayer(heap_window.getMinimumTick(),
-                           heap_window.getMinimumAddress(),
-                           heap_to_screen_matrix_);
+  // Only rebuild the layers if the window, the highlights or the data changed
+  // since the last frame. Other repaints (resizes, exposes) draw the buffers
+  // that are already on the GPU.
+  uint64_t view_generation = heap_history_.getViewGeneration();
+  if (refresh_all_vertices_ || (view_generation != painted_view_generation_)) {
+    pages_layer_->refreshVertices(heap_history_, true, refresh_all_vertices_);
+    painted_view_generation_ = view_generation;
+  }
+  paintDiagramLayer(pages_layer_.get());
+
+  // The tiles show the blocks with their highlights, but do not depend on
+  // the window.
+  bool drew_tiles = false;
+  if (tile_layer_) {
+    uint64_t tile_generation =
+        static_cast<uint64_t>(heap_history_.getDataGeneration()) +
+        heap_history_.getHighlightGeneration();
+    if (tile_generation != tile_generation_) {
+      tile_renderer_->reset();
+      tile_layer_->clear();
+      tile_generation_ = tile_generation;
+    }
+    if (!refresh_all_vertices_) {
+      FrameProfiler::Scope scope(&profiler_, "tiles.paint");
+      gpu_timers_.begin(&profiler_, "tiles.paint");
+      drew_tiles = tile_layer_->paintLayer(heap_history_, width(), height());
+      gpu_timers_.end();
+    }
+  }
+
+  if (!drew_tiles) {
+    // The block layer only reloads what changed since it was last drawn.
+    block_layer_->refreshVertices(heap_history_, true, refresh_all_vertices_);
 
-  block_layer_->refreshVertices(heap_history_, true, refresh_all_vertices_);
-  // Draw the contents of the blocks.
-  block_layer_->paintLayer(heap_window.getMinimumTick(),
-                           heap_window.getMinimumAddress(),
-                           heap_to_screen_matrix_);
+    // Draw the contents of the blocks. When benchmarking, wait for the GPU
+    // before and after, so that only the block shaders are timed.
+    std::chrono::steady_clock::time_point benchmark_start;
+    if (benchmark_frames_ > 0) {
+      glFinish();
+      benchmark_start = std::chrono::steady_clock::now();
+    }
+    paintDiagramLayer(block_layer_.get());
+    if (benchmark_frames_ > 0) {
+      glFinish();
+      recordBenchmarkFrame(std::chrono::steady_clock::now() - benchmark_start);
+    }
+  }
 
   glLineWidth(2.0f);
-  event_layer_->paintLayer(heap_window.getMinimumTick(),
-                           heap_window.getMinimumAddress(),
-                           heap_to_screen_matrix_);
+  paintDiagramLayer(event_layer_.get());
+  paintDiagramLayer(address_layer_.get());
 
-  address_layer_->paintLayer(heap_window.getMinimumTick(),
-                             heap_window.getMinimumAddress(),
-                             heap_to_screen_matrix_);
+  if (show_tag_chart_) {
+    tag_chart_layer_->refreshVertices(heap_history_, true);
+    paintDiagramLayer(tag_chart_layer_.get());
+  }
+
+  if (show_fragmentation_chart_) {
+    chart_layer_->refreshVertices(heap_history_, true);
+    paintDiagramLayer(chart_layer_.get());
+  }
   refresh_all_vertices_ = false;
+
+  gpu_timers_.collect(&profiler_);
+  profiler_.endFrame();
+  if (show_frame_hud_) {
+    paintFrameHUD();
+  }
+}
+
+void GLHeapDiagram::paintDiagramLayer(GLHeapDiagramLayer *layer) {
+  const DisplayHeapWindow &heap_window = heap_history_.getCurrentWindow();
+  gpu_timers_.begin(&profiler_, layer->getPaintSectionName());
+  layer->paintLayer(heap_window.getMinimumTick(),
+                    heap_window.getMinimumAddress(), heap_to_screen_matrix_);
+  gpu_timers_.end();
+}
+
+void GLHeapDiagram::paintFrameHUD() {
+  // About the last second at 60 frames per second.
+  std::vector<FrameProfiler::Average> averages = profiler_.getAverages(60);
+  constexpr int line_height = 16;
+  QPainter painter(this);
+  painter.fillRect(4, 4, 300,
+                   static_cast<int>(averages.size()) * line_height + 8,
+                   QColor(0, 0, 0, 160));
+  painter.setPen(QColor(255, 255, 255));
+  for (size_t line = 0; line < averages.size(); ++line) {
+    const FrameProfiler::Average &average = averages[line];
+    char buf[64];
+    sprintf(buf, "%s %8.3f ms", average.gpu_ ? "GPU" : "CPU",
+            average.milliseconds_);
+    int y = 4 + line_height * static_cast<int>(line + 1);
+    painter.drawText(10, y, QString::fromStdString(average.name_));
+    painter.drawText(180, y, QString(buf));
+  }
+  painter.end();
+  // QPainter leaves the GL state at its defaults.
+  glEnable(GL_BLEND);
+  glEnable(GL_CULL_FACE);
+}
+
+void GLHeapDiagram::recordBenchmarkFrame(
+    std::chrono::steady_clock::duration duration) {
+  benchmarked_nanoseconds_ +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  benchmarked_vertices_ += block_layer_->getVertexVector()->size();
+  ++benchmarked_frames_;
+  if (--benchmark_frames_ > 0) {
+    // Keep drawing until all frames are done.
+    QOpenGLWidget::update();
+    return;
+  }
+  double seconds = benchmarked_nanoseconds_ / 1e9;
+  printf("[!] Block shader benchmark (%s): %u frames, "
+         "%" PRIu64 " vertices per frame, %.3f ms per frame, %.1f million "
+         "vertices per second\n",
+         block_layer_->getActiveVertexShaderName().c_str(),
+         benchmarked_frames_, benchmarked_vertices_ / benchmarked_frames_,
+         seconds * 1000 / benchmarked_frames_,
+         (seconds > 0) ? benchmarked_vertices_ / seconds / 1e6 : 0.0);
+  fflush(stdout);
 }
 
 void GLHeapDiagram::update() {
-  printf("Update called\n");
   QOpenGLWidget::update();
 }
 
 void GLHeapDiagram::resizeGL(int w, int h) { printf("Resize GL was called w: %d h: %d\n", w, h); }
 
-GLHeapDiagram::~GLHeapDiagram() = default;
+GLHeapDiagram::~GLHeapDiagram() {
+  if (is_GL_initialized_) {
+    // Pick up the GPU times of the last frames before the queries go.
+    makeCurrent();
+    glFinish();
+    gpu_timers_.collect(&profiler_);
+    gpu_timers_.clear();
+    doneCurrent();
+  }
+  if (!frame_trace_file_.empty()) {
+    std::ofstream trace(frame_trace_file_);
+    profiler_.writeChromeTrace(trace);
+    if (trace) {
+      printf("[!] Wrote %zu frames to %s\n", profiler_.getFrames().size(),
+             frame_trace_file_.c_str());
+    } else {
+      printf("[!] Failed to write the frame trace to %s\n",
+             frame_trace_file_.c_str());
+    }
+  }
+}
 
 void GLHeapDiagram::mousePressEvent(QMouseEvent *event) {
   double x = static_cast<double>(event->x()) / this->width();
   double y = static_cast<double>(event->y()) / this->height();
-  uint32_t tick;
+  uint64_t tick;
   uint64_t address;
   last_mouse_position_ = event->pos();
   if (!screenToHeap(x, y, &tick, &address)) {
@@ -158,22 +517,38 @@ void GLHeapDiagram::mousePressEvent(QMouseEvent *event) {
   HeapBlock current_block;
   uint32_t index;
 
-  printf("clicked at tick %d and address %" PRIx64 "\n", tick, address);
+  printf("clicked at tick %" PRIu64 " and address %" PRIx64 "\n", tick,
+         address);
   fflush(stdout);
 
-  if (!heap_history_.getBlockAtSlow(address, tick, &current_block, &index)) {
+  bool found;
+  if (use_gpu_picking_) {
+    found = pickBlockAt(event->x(), event->y(), &index);
+    if (found) {
+      current_block = heap_history_.getBlock(index);
+    }
+  } else {
+    found = heap_history_.getBlockAtSlow(address, tick, &current_block, &index);
+  }
+  if (!found) {
     // No block here. Perhaps an event?
     std::string eventstring;
     if (heap_history_.getEventAtTick(tick, &eventstring)) {
       char buf[1024];
-      sprintf(buf, "Event at tick %8.8x: ", tick);
+      sprintf(buf, "Event at tick %16.16" PRIx64 ": ", tick);
       emit showMessage(std::string(buf) + eventstring);
     } else {
       char buf[1024];
-      sprintf(buf, "Nothing here at tick %8.8x and address %16.16" PRIx64, tick,
-              address);
+      sprintf(buf, "Nothing here at tick %16.16" PRIx64 " and address %16.16"
+              PRIx64, tick, address);
       emit showMessage(std::string(buf));
     }
+  } else if (highlight_reuse_on_click_) {
+    size_t chain_length = heap_history_.highlightReuseChain(index);
+    char buf[1024];
+    sprintf(buf, " Address used by %zu blocks", chain_length);
+    emit showMessage(getBlockInformationAsString(current_block) + buf);
+    update();
   } else {
     emit blockClicked(true, current_block);
   }
@@ -184,17 +559,60 @@ void GLHeapDiagram::mouseMoveEvent(QMouseEvent *event) {
   double dy = event->y() - last_mouse_position_.y();
 
   if (event->buttons() & Qt::LeftButton) {
+    hideHoverDescription();
     heap_history_.panCurrentWindow(dx / this->width(), dy / this->height());
 
     QOpenGLWidget::update();
   } else if (event->buttons() & Qt::RightButton) {
     QOpenGLWidget::update();
+  } else if (event->buttons() == Qt::NoButton) {
+    // Ask the worker what is under the mouse; the tooltip follows once the
+    // mouse rests.
+    double x = static_cast<double>(event->x()) / this->width();
+    double y = static_cast<double>(event->y()) / this->height();
+    uint64_t tick;
+    uint64_t address;
+    if (screenToHeap(x, y, &tick, &address)) {
+      hover_position_ = event->pos();
+      if (use_gpu_picking_) {
+        // The ID pass is only redrawn after the view changed, so most mouse
+        // moves cost a one-pixel readback.
+        uint32_t index;
+        bool found = pickBlockAt(event->x(), event->y(), &index);
+        hover_serial_ = hover_inspector_->inspectPicked(tick, found, index);
+      } else {
+        hover_serial_ = hover_inspector_->inspect(tick, address,
+            heap_history_.getMinimumBlockSize());
+      }
+    } else {
+      hideHoverDescription();
+    }
   }
 
   last_mouse_position_ = event->pos();
 }
 
+void GLHeapDiagram::showHoverDescription(uint64_t serial,
+                                         const QString &description) {
+  if (serial != hover_serial_) {
+    return;
+  }
+  if (description.isEmpty()) {
+    QToolTip::hideText();
+  } else {
+    QToolTip::showText(mapToGlobal(hover_position_), description, this);
+  }
+}
+
+void GLHeapDiagram::hideHoverDescription() {
+  // Serial numbers start at 1.
+  hover_serial_ = 0;
+  QToolTip::hideText();
+}
+
 void GLHeapDiagram::wheelEvent(QWheelEvent *event) {
+  // The answer would describe what was under the mouse before the zoom.
+  hideHoverDescription();
   float movement_quantity = event->angleDelta().y() / 500.0;
   double how_much_y = 1.0;
   double how_much_x = 1.0;
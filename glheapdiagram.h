@@ -1,10 +1,12 @@
 #ifndef GLHEAPDIAGRAM_H
 #define GLHEAPDIAGRAM_H
 
+#include <chrono>
 #include <memory>
 
 #include <QOpenGLWidget>
 #include <QOpenGLBuffer>
+#include <QOpenGLFramebufferObject>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
@@ -13,9 +15,16 @@
 #include "activeregionsdiagramlayer.h"
 #include "addressdiagramlayer.h"
 #include "eventdiagramlayer.h"
+#include "fragmentationchartlayer.h"
+#include "frameprofiler.h"
+#include "glframetimers.h"
 #include "glheapdiagramlayer.h"
 #include "heapblockdiagramlayer.h"
 #include "heaphistory.h"
+#include "hoverinspector.h"
+#include "tagchartlayer.h"
+#include "tilecachelayer.h"
+#include "tilerenderer.h"
 #include "transform3d.h"
 
 class OpenGLShaderProgram;
@@ -27,6 +36,48 @@ public:
   QSize sizeHint() const override;
   QSize minimumSizeHint() const override;
 
+  // See HeapHistory::setBlockPaging.
+  void setBlockPaging(const std::string& page_file, size_t cache_budget) {
+    heap_history_.setBlockPaging(page_file, cache_budget);
+  }
+  // If |index_file| exists, only the ticks from |first_tick| to |last_tick|
+  // are loaded (unless |last_tick| is 0), starting at the closest checkpoint
+  // in the index. Otherwise, the trace is loaded in full and the index is
+  // written to |index_file|.
+  // If more than one shard is given, the shards are loaded and merged by
+  // timestamp instead of the file to display.
+  void setTraceShards(const std::vector<std::string>& shards) {
+    trace_shards_ = shards;
+  }
+  // Lets the layers use their vertex shaders with native 64-bit integers if
+  // the GPU supports them. Needs to be called before the widget is shown.
+  void setAllowNative64BitShaders(bool allow);
+  // Lets the block layer upload its vertices relative to tile origins (see
+  // VertexTiles). Needs to be called before the widget is shown.
+  void setTileRelativeVertices(bool use);
+  // Draws the heap blocks from pre-rendered tiles when they are ready (see
+  // TileCacheLayer). Needs to be called before the widget is shown.
+  void setUseTileCache(bool use) { use_tile_cache_ = use; }
+  // Finds the block under the mouse by drawing the block indices into an
+  // offscreen framebuffer and reading back one pixel, instead of searching
+  // the blocks on the CPU.
+  void setUseGPUPicking(bool use) { use_gpu_picking_ = use; }
+  // Times the drawing of the heap blocks over the next |frames| frames, and
+  // prints the vertex throughput.
+  void setBenchmarkFrames(uint32_t frames) { benchmark_frames_ = frames; }
+  // Shows the average CPU and GPU time of the parts of a frame over the
+  // widget (see FrameProfiler).
+  void setShowFrameHUD(bool show);
+  // Writes the last frames as a Chrome trace to |trace_file| when the widget
+  // goes away.
+  void setFrameTraceFile(const std::string& trace_file);
+  void setTraceIndex(const std::string& index_file, uint64_t first_tick,
+                     uint64_t last_tick) {
+    trace_index_file_ = index_file;
+    first_tick_to_load_ = first_tick;
+    last_tick_to_load_ = last_tick;
+  }
+
 signals:
   void frameSwapped();
   void blockClicked(bool, HeapBlock);
@@ -35,6 +86,14 @@ signals:
 public slots:
   void setFileToDisplay(const QString& filename);
   void setSizeToHighlight(uint32_t size);
+  void setTicksToDiff(uint64_t from_tick, uint64_t to_tick);
+  void setHighlightQuery(QString query);
+  void findFreeGaps(uint64_t tick, uint32_t minimum_size);
+  void setShowFragmentationChart(bool show);
+  void setShowTagChart(bool show);
+  void setHighlightReuseOnClick(bool highlight);
+  void showBytesHeldByTag(QString tag, uint64_t from_tick, uint64_t to_tick);
+  void setVisibleHeaps(QString heaps);
 
 protected slots:
   void update();
@@ -62,18 +121,63 @@ private:
 
   void getScaleFromHeapToScreen(double* scale_x, double* scale_y);
   void getScaleFromScreenToHeap(double* scale_x, double* scale_y);
-  bool screenToHeap(double, double, uint32_t* tick, uint64_t* address);
-  //void heapToScreen(uint32_t tick, uint64_t address, double*, double*);
+  bool screenToHeap(double, double, uint64_t* tick, uint64_t* address);
+  // Sets |index| to the block drawn at widget pixel (x, y). Returns false if
+  // there is none. The ID pass is only redrawn when the view changed.
+  bool pickBlockAt(int x, int y, uint32_t* index);
+  //void heapToScreen(uint64_t tick, uint64_t address, double*, double*);
   void loadFileInternal();
 
+  // Shows the answer to hover question |serial| as a tooltip, unless the
+  // mouse moved on since.
+  void showHoverDescription(uint64_t serial, const QString& description);
+  // Hides the tooltip and ignores the answers that are still on their way.
+  void hideHoverDescription();
+
+  // Draws |layer| in the current window, and times it on the GPU.
+  void paintDiagramLayer(GLHeapDiagramLayer* layer);
+  void paintFrameHUD();
+
   void setHeapBaseUniforms();
   void setTickBaseUniforms();
+  // Adds the time the block layer took to draw to the benchmark totals.
+  void recordBenchmarkFrame(std::chrono::steady_clock::duration duration);
 
   std::string file_to_load_;
+  std::string trace_index_file_;
+  std::vector<std::string> trace_shards_;
+  uint64_t first_tick_to_load_ = 0;
+  uint64_t last_tick_to_load_ = 0;
 
   // Blocks of this size will be highlighted.
   uint32_t size_to_highlight_ = 0;
   bool refresh_all_vertices_ = false;
+  // The view generation of the heap history (see getViewGeneration) that
+  // the pages and block layers were last refreshed for.
+  uint64_t painted_view_generation_ = 0;
+  // The data and highlight generations that the cached tiles show.
+  uint64_t tile_generation_ = 0;
+  bool use_tile_cache_ = false;
+  bool use_gpu_picking_ = false;
+  // The view generation that the ID pass in pick_framebuffer_ shows.
+  bool pick_framebuffer_valid_ = false;
+  uint64_t picked_view_generation_ = 0;
+  bool show_fragmentation_chart_ = false;
+  bool show_tag_chart_ = false;
+  // Clicking a block highlights all blocks that occupied its address.
+  bool highlight_reuse_on_click_ = false;
+
+  // The number of frames left to benchmark, and the totals so far.
+  uint32_t benchmark_frames_ = 0;
+  uint32_t benchmarked_frames_ = 0;
+  uint64_t benchmarked_vertices_ = 0;
+  uint64_t benchmarked_nanoseconds_ = 0;
+
+  // Where the time of the frames goes, if the HUD or the trace is on.
+  FrameProfiler profiler_;
+  GLFrameTimers gpu_timers_;
+  bool show_frame_hud_ = false;
+  std::string frame_trace_file_;
 
   // Gets set to true after the initializeGL() method runs.
   bool is_GL_initialized_;
@@ -88,9 +192,20 @@ private:
   std::unique_ptr<EventDiagramLayer> event_layer_;
   std::unique_ptr<AddressDiagramLayer> address_layer_;
   std::unique_ptr<ActiveRegionsDiagramLayer> pages_layer_;
+  std::unique_ptr<FragmentationChartLayer> chart_layer_;
+  std::unique_ptr<TagChartLayer> tag_chart_layer_;
+  std::unique_ptr<TileCacheLayer> tile_layer_;
+  std::unique_ptr<QOpenGLFramebufferObject> pick_framebuffer_;
 
   // The heap history.
   HeapHistory heap_history_;
+  // Reads the heap history on its worker thread, so it needs to go away
+  // before the history does.
+  std::unique_ptr<TileRenderer> tile_renderer_;
+  // Answers what lies under the resting mouse.
+  std::unique_ptr<HoverInspector> hover_inspector_;
+  uint64_t hover_serial_ = 0;
+  QPoint hover_position_;
 
   // Last mouse position for dragging and selecting.
   QPoint last_mouse_position_;
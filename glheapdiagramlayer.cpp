@@ -4,22 +4,30 @@
 // but call different shaders with different geometry, most of the base case is
 // handled in this class.
 
+#include <QOpenGLContext>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions>
 
+#include <algorithm>
 #include <cinttypes>
 #include <utility>
 
 #include "glheapdiagramlayer.h"
 
+std::weak_ptr<GLHeapDiagramLayer::QuadIndexBuffer>
+  GLHeapDiagramLayer::shared_quad_indices_;
+
 // Users of this class need to provide a vertex and fragment shader program, and
 // indicate if the layer is a lines-only layer or of actual triangles / rectangles
 // ought to be drawn.
 GLHeapDiagramLayer::GLHeapDiagramLayer(
     std::string vertex_shader_name,
-    std::string fragment_shader_name, bool is_line_layer)
+    std::string fragment_shader_name, bool is_line_layer,
+    std::string native_64bit_vertex_shader_name)
     : vertex_shader_name_(std::move(vertex_shader_name)),
       fragment_shader_name_(std::move(fragment_shader_name)),
+      native_64bit_vertex_shader_name_(
+        std::move(native_64bit_vertex_shader_name)),
       is_line_layer_(is_line_layer),
       layer_shader_program_(new QOpenGLShaderProgram()) {}
 
@@ -30,27 +38,117 @@ GLHeapDiagramLayer::~GLHeapDiagramLayer() {
   }
 }
 
+// Native 64-bit integers need GLSL 4.00 and the extension.
+bool GLHeapDiagramLayer::contextSupportsNative64BitShaders() {
+  QOpenGLContext *context = QOpenGLContext::currentContext();
+  return (context != nullptr) && !context->isOpenGLES() &&
+    (context->format().majorVersion() >= 4) &&
+    context->hasExtension("GL_ARB_gpu_shader_int64");
+}
+
 void GLHeapDiagramLayer::refreshGLBuffer(bool bind) {
   if (bind) {
     layer_vertex_buffer_.bind();
   }
 
-  int needed_size = static_cast<int>((layer_vertices_.size() * sizeof(HeapVertex)));
+  int needed_size = static_cast<int>(getVertexBufferSize());
+  std::vector<std::pair<size_t, size_t>> ranges;
   if (layer_vertex_buffer_.size() < needed_size) {
-    layer_vertex_buffer_.allocate(needed_size);
+    // Leave room to grow, so that layers that append a few vertices at a
+    // time do not reallocate (and rewrite) the buffer every time.
+    layer_vertex_buffer_.allocate(needed_size + needed_size / 4);
+    ranges.emplace_back(0, needed_size);
+  } else if (!getChangedVertexBufferRanges(&ranges)) {
+    ranges.assign(1, std::make_pair(0, needed_size));
   }
-  if(!layer_vertices_.empty()) {
-      layer_vertex_buffer_.write(0, &layer_vertices_[0],
-                                 needed_size);
+  const auto* data = static_cast<const char*>(getVertexBufferData());
+  for (const auto& range : ranges) {
+    if (range.second > 0) {
+      layer_vertex_buffer_.write(static_cast<int>(range.first),
+        data + range.first, static_cast<int>(range.second));
+    }
   }
   if (bind) {
     layer_vertex_buffer_.release();
   }
 }
 
+const void* GLHeapDiagramLayer::getVertexBufferData() const {
+  return layer_vertices_.data();
+}
+
+size_t GLHeapDiagramLayer::getVertexBufferSize() const {
+  return layer_vertices_.size() * sizeof(HeapVertex);
+}
+
+void GLHeapDiagramLayer::setupVertexAttributes() {
+  layer_shader_program_->setAttributeBuffer(
+      0, GL_FLOAT, HeapVertex::positionOffset(), HeapVertex::PositionTupleSize,
+      HeapVertex::stride());
+  // setAttributeBuffer normalizes integer attributes, so the shaders see the
+  // packed color as floats in [0, 1].
+  layer_shader_program_->setAttributeBuffer(
+      1, GL_UNSIGNED_BYTE, HeapVertex::colorOffset(),
+      HeapVertex::ColorTupleSize, HeapVertex::stride());
+}
+
+void GLHeapDiagramLayer::bindQuadIndices(uint32_t quads) {
+  if (!quad_indices_) {
+    quad_indices_ = shared_quad_indices_.lock();
+    if (!quad_indices_) {
+      quad_indices_ = std::make_shared<QuadIndexBuffer>();
+      quad_indices_->buffer_.create();
+      quad_indices_->buffer_.setUsagePattern(QOpenGLBuffer::StaticDraw);
+      shared_quad_indices_ = quad_indices_;
+    }
+  }
+  // The binding is part of the VAO state, so the buffer stays bound.
+  quad_indices_->buffer_.bind();
+  if (quad_indices_->quads_ < quads) {
+    // Grow in powers of two, so that the indices are rarely rewritten.
+    uint32_t capacity = std::max(quad_indices_->quads_, 1024u);
+    while (capacity < quads) {
+      capacity *= 2;
+    }
+    std::vector<uint32_t> indices;
+    appendQuadIndices(0, capacity, &indices);
+    quad_indices_->buffer_.allocate(indices.data(),
+      static_cast<int>(indices.size() * sizeof(uint32_t)));
+    quad_indices_->quads_ = capacity;
+  }
+}
+
+uint64_t GLHeapDiagramLayer::getInputGeneration(
+  const HeapHistory& history) const {
+  return static_cast<uint64_t>(history.getDataGeneration()) +
+    history.getWindowGeneration();
+}
+
+void GLHeapDiagramLayer::setProfiler(FrameProfiler* profiler,
+  const std::string& name) {
+  profiler_ = profiler;
+  vertices_section_ = name + ".vertices";
+  upload_section_ = name + ".upload";
+  paint_section_ = name + ".paint";
+}
+
 void GLHeapDiagramLayer::refreshVertices(const HeapHistory& heap_history, bool bind, bool all) {
-  loadVerticesFromHeapHistory(heap_history, all);
-  refreshGLBuffer(bind);
+  uint64_t generation = getInputGeneration(heap_history);
+  if (!vertices_loaded_ || (vertices_generation_ != generation) ||
+    (vertices_loaded_all_ != all)) {
+    {
+      FrameProfiler::Scope scope(profiler_, vertices_section_.c_str());
+      loadVerticesFromHeapHistory(heap_history, all);
+    }
+    {
+      FrameProfiler::Scope scope(profiler_, upload_section_.c_str());
+      refreshGLBuffer(bind);
+    }
+    vertices_loaded_ = true;
+    vertices_loaded_all_ = all;
+    vertices_generation_ = generation;
+  }
+  refreshLayerState(heap_history);
 }
 
 // Mostly boilerplate code for OpenGL -- load the shaders, link and bind them,
@@ -58,12 +156,29 @@ void GLHeapDiagramLayer::refreshVertices(const HeapHistory& heap_history, bool b
 void GLHeapDiagramLayer::initializeGLStructures(
   const HeapHistory& heap_history, QOpenGLFunctions *parent) {
   if (!is_initialized_) {
-    // Load the shaders.
-    layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Vertex,
-                                                 vertex_shader_name_.c_str());
-    layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Fragment,
-                                                 fragment_shader_name_.c_str());
-    layer_shader_program_->link();
+    // Both shader variants need the attributes at the same locations.
+    layer_shader_program_->bindAttributeLocation("position", 0);
+    layer_shader_program_->bindAttributeLocation("color", 1);
+    // Load the shaders. Prefer the variant with native 64-bit integers, and
+    // fall back to the GLSL 1.30 one with emulated 96-bit arithmetic.
+    uses_native_64bit_shader_ = allow_native_64bit_shader_ &&
+      !native_64bit_vertex_shader_name_.empty() &&
+      contextSupportsNative64BitShaders() &&
+      layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Vertex,
+        native_64bit_vertex_shader_name_.c_str()) &&
+      layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Fragment,
+        fragment_shader_name_.c_str()) &&
+      layer_shader_program_->link();
+    if (!uses_native_64bit_shader_) {
+      layer_shader_program_->removeAllShaders();
+      layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Vertex,
+                                                   vertex_shader_name_.c_str());
+      layer_shader_program_->addShaderFromSourceFile(QOpenGLShader::Fragment,
+                                                   fragment_shader_name_.c_str());
+      layer_shader_program_->link();
+    }
+    printf("[!] Using vertex shader %s\n",
+      getActiveVertexShaderName().c_str());
     layer_shader_program_->bind();
 
     // Create the heap block vertex buffer.
@@ -76,6 +191,7 @@ void GLHeapDiagramLayer::initializeGLStructures(
 
   if (!is_initialized_) {
     setupStandardUniforms();
+    setupLayerUniforms();
 
     // Create the vertex array object.
     layer_vao_.create();
@@ -84,12 +200,7 @@ void GLHeapDiagramLayer::initializeGLStructures(
     // Register attribute arrays with stride for the vertex attributes.
     layer_shader_program_->enableAttributeArray(0);
     layer_shader_program_->enableAttributeArray(1);
-    layer_shader_program_->setAttributeBuffer(
-        0, GL_FLOAT, HeapVertex::positionOffset(), HeapVertex::PositionTupleSize,
-        HeapVertex::stride());
-    layer_shader_program_->setAttributeBuffer(
-        1, GL_FLOAT, HeapVertex::colorOffset(), HeapVertex::ColorTupleSize,
-        HeapVertex::stride());
+    setupVertexAttributes();
     parent->glBindAttribLocation(layer_shader_program_->programId(), 0,
                                  "position");
     parent->glBindAttribLocation(layer_shader_program_->programId(), 1, "color");
@@ -116,11 +227,14 @@ void GLHeapDiagramLayer::setupStandardUniforms() {
       layer_shader_program_->uniformLocation("visible_heap_base_B");
   uniform_visible_heap_base_C_ =
       layer_shader_program_->uniformLocation("visible_heap_base_C");
-  // The lowest visible tick is passed as 64 bits (e.g. two 32-bit numbers).
+  // Ticks are 64-bit as well, so the lowest visible tick needs three numbers
+  // for the same reason.
   uniform_visible_tick_base_A_ =
       layer_shader_program_->uniformLocation("visible_tick_base_A");
   uniform_visible_tick_base_B_ =
       layer_shader_program_->uniformLocation("visible_tick_base_B");
+  uniform_visible_tick_base_C_ =
+      layer_shader_program_->uniformLocation("visible_tick_base_C");
 }
 
 // Set the heap base.
@@ -142,27 +256,40 @@ void GLHeapDiagramLayer::setHeapToScreenMatrix(
                                          heap_to_screen);
 }
 
-void GLHeapDiagramLayer::paintLayer(ivec2 tick, ivec3 address,
+void GLHeapDiagramLayer::paintLayer(ivec3 tick, ivec3 address,
                                     const QMatrix2x2 &heap_to_screen) {
+  FrameProfiler::Scope scope(profiler_, paint_section_.c_str());
   layer_shader_program_->bind();
   setHeapToScreenMatrix(heap_to_screen);
   setHeapBaseUniforms(address.x, address.y, address.z);
-  setTickBaseUniforms(tick.x, tick.y);
+  setTickBaseUniforms(tick.x, tick.y, tick.z);
 
   {
     layer_vao_.bind();
-    auto count = static_cast<uint32_t>((layer_vertices_.size() * sizeof(HeapVertex)));
-    glDrawArrays(is_line_layer_ ? GL_LINES : GL_TRIANGLES, 0, count);
+    bindLayerState();
+    auto count = static_cast<uint32_t>(layer_vertices_.size());
+    if (is_quad_layer_) {
+      uint32_t quads = count / vertices_per_quad;
+      bindQuadIndices(quads);
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(quads *
+        indices_per_quad), GL_UNSIGNED_INT, nullptr);
+    } else {
+      glDrawArrays(is_line_layer_ ? GL_LINES : GL_TRIANGLES, 0, count);
+    }
+    releaseLayerState();
     layer_vao_.release();
   }
   layer_shader_program_->release();
 }
 
-void GLHeapDiagramLayer::setTickBaseUniforms(int32_t x, int32_t y) {
+void GLHeapDiagramLayer::setTickBaseUniforms(int32_t x, int32_t y,
+                                             int32_t z) {
   visible_tick_base_A_ = x;
   visible_tick_base_B_ = y;
+  visible_tick_base_C_ = z;
   layer_shader_program_->setUniformValue(uniform_visible_tick_base_A_, x);
   layer_shader_program_->setUniformValue(uniform_visible_tick_base_B_, y);
+  layer_shader_program_->setUniformValue(uniform_visible_tick_base_C_, z);
 }
 
 void GLHeapDiagramLayer::debugDumpVertexTransformation() {
@@ -171,7 +298,7 @@ void GLHeapDiagramLayer::debugDumpVertexTransformation() {
   for (size_t index = 0; index < layer_vertices_.size(); ++index) {
     const HeapVertex& vertex = layer_vertices_[index];
     std::pair<vec4, vec4> result = vertexShaderSimulator(vertex);
-    printf("%08x.%08x.%08x (%d, %" PRIx64 ", Color %f.%f.%f) --> ", visible_heap_base_C_, visible_heap_base_B_, visible_heap_base_A_, vertex.getX(), vertex.getY(),
+    printf("%08x.%08x.%08x (%" PRIx64 ", %" PRIx64 ", Color %f.%f.%f) --> ", visible_heap_base_C_, visible_heap_base_B_, visible_heap_base_A_, vertex.getX(), vertex.getY(),
       vertex.getColor().x(), vertex.getColor().y(), vertex.getColor().z());
     printf("(%f, %f, %f, %f), (%f, %f, %f, %f)\n", result.first.w_, result.first.x_,
       result.first.y_, result.first.z_, result.second.w_, result.second.x_,
@@ -181,9 +308,12 @@ void GLHeapDiagramLayer::debugDumpVertexTransformation() {
         printf("\n");
         fflush(stdout);
       }
-    } else if ((index % 3) == 2) {
-      printf("\n");
-      fflush(stdout);
+    } else {
+      size_t group = is_quad_layer_ ? vertices_per_quad : 3;
+      if ((index % group) == group - 1) {
+        printf("\n");
+        fflush(stdout);
+      }
     }
   }
   printf("[Debug] End of layer dump.\n");
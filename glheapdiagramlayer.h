@@ -8,6 +8,7 @@
 #include <QOpenGLShaderProgram>
 
 #include "displayheapwindow.h"
+#include "frameprofiler.h"
 #include "heaphistory.h"
 #include "vertex.h"
 
@@ -15,13 +16,16 @@
 // allows easy drawing of an extra layer of the heap diagram.
 class GLHeapDiagramLayer {
 public:
+  // If |native_64bit_vertex_shader_name| is given, that vertex shader is
+  // used instead of |vertex_shader_name| on GPUs with native 64-bit integers
+  // (GL_ARB_gpu_shader_int64).
   GLHeapDiagramLayer(std::string vertex_shader_name,
     std::string fragment_shader_name,
-    bool is_line_layer);
+    bool is_line_layer, std::string native_64bit_vertex_shader_name = "");
   ~GLHeapDiagramLayer();
   void initializeGLStructures(
     const HeapHistory& heap_history, QOpenGLFunctions *parent);
-  void paintLayer(ivec2 minimum_tick, ivec3 maximum_tick,
+  void paintLayer(ivec3 minimum_tick, ivec3 minimum_address,
                   const QMatrix2x2 &heap_to_screen);
 
   // Get a pointer to the HeapVertex vector so it can be filled.
@@ -34,26 +38,88 @@ public:
   virtual std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex&
     vertex) = 0;
 
+  // Reloads the vertices and uploads them, but only if the inputs of the
+  // layer changed since the last load (or |all| differs); otherwise the
+  // vertex buffer on the GPU is reused as it is.
   void refreshVertices(const HeapHistory& heap_history, bool bind, bool all = false);
 
   void debugDumpVertexTransformation();
   void setDebug(bool value) { dump_debug_ = value; }
+
+  // Records the time that building, uploading and drawing the vertices take
+  // in |profiler| as the sections |name|.vertices, |name|.upload and
+  // |name|.paint.
+  void setProfiler(FrameProfiler* profiler, const std::string& name);
+  const std::string& getPaintSectionName() const { return paint_section_; }
+
+  // Allows or forbids the native 64-bit vertex shader. Needs to be called
+  // before initializeGLStructures.
+  void setAllowNative64BitShader(bool allow) {
+    allow_native_64bit_shader_ = allow;
+  }
+  bool usesNative64BitShader() const { return uses_native_64bit_shader_; }
+  // The vertex shader that the layer uses once it is initialized.
+  const std::string& getActiveVertexShaderName() const {
+    return uses_native_64bit_shader_ ? native_64bit_vertex_shader_name_ :
+      vertex_shader_name_;
+  }
 protected:
   void setupStandardUniforms();
   virtual void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) = 0;
+  // The generation of the inputs the vertices are built from. By default,
+  // these are the data and the current window.
+  virtual uint64_t getInputGeneration(const HeapHistory& history) const;
+  // Called on every refresh, also when the vertices are up to date, for
+  // state that is cheaper to update than the vertices (e.g. textures).
+  virtual void refreshLayerState(const HeapHistory&) {}
+  // Hooks for layers that need more than the standard uniforms, e.g. to bind
+  // textures before drawing.
+  virtual void setupLayerUniforms() {}
+  virtual void bindLayerState() {}
+  virtual void releaseLayerState() {}
+  // The contents and the layout of the vertex buffer. By default, the buffer
+  // holds layer_vertices_ as they are.
+  virtual const void* getVertexBufferData() const;
+  virtual size_t getVertexBufferSize() const;
+  virtual void setupVertexAttributes();
+  // Sets |ranges| to the (offset, size) byte ranges of the vertex buffer that
+  // changed since the last upload and returns true, or returns false if the
+  // whole buffer needs to be written.
+  virtual bool getChangedVertexBufferRanges(
+    std::vector<std::pair<size_t, size_t>>*) const { return false; }
   void refreshGLBuffer(bool bind);
+  // Binds the shared quad index buffer to the bound VAO, and makes sure that
+  // it holds the indices for at least |quads| quads.
+  void bindQuadIndices(uint32_t quads);
+  static bool contextSupportsNative64BitShaders();
 
   // Helper functions to set the uniforms for the shaders.
-  void setTickBaseUniforms(int32_t x, int32_t y);
+  void setTickBaseUniforms(int32_t x, int32_t y, int32_t z);
   void setHeapBaseUniforms(int32_t x, int32_t y, int32_t z);
   void setHeapToScreenMatrix(const QMatrix2x2 &heap_to_screen);
 
   std::string vertex_shader_name_;
   std::string fragment_shader_name_;
+  std::string native_64bit_vertex_shader_name_;
+  bool allow_native_64bit_shader_ = true;
+  bool uses_native_64bit_shader_ = false;
   bool is_initialized_ = false;
   bool is_line_layer_ = false;
+  // Triangle layers whose vertices are quads (see vertex.h) are drawn with
+  // the quad index buffer.
+  bool is_quad_layer_ = false;
   bool dump_debug_ = false;
 
+  FrameProfiler* profiler_ = nullptr;
+  std::string vertices_section_;
+  std::string upload_section_;
+  std::string paint_section_;
+
+  // The input generation and the |all| flag of the last load.
+  bool vertices_loaded_ = false;
+  bool vertices_loaded_all_ = false;
+  uint64_t vertices_generation_ = 0;
+
   // The vertices for this layer.
   std::vector<HeapVertex> layer_vertices_;
 
@@ -69,13 +135,15 @@ protected:
   int32_t visible_heap_base_B_ = 0;
   int32_t visible_heap_base_C_ = 0;
 
-  // The minimum tick is provided as ivec2.
+  // The minimum tick is provided as ivec3, like the base address.
   int uniform_visible_tick_base_A_ = 0;
   int uniform_visible_tick_base_B_ = 0;
+  int uniform_visible_tick_base_C_ = 0;
 
   // The actual values that were last set.
   int32_t visible_tick_base_A_ = 0;
   int32_t visible_tick_base_B_ = 0;
+  int32_t visible_tick_base_C_ = 0;
 
   // The matrix to project heap vertices to the screen.
   int uniform_vertex_to_screen_ = 0;
@@ -86,6 +154,16 @@ protected:
   // VAO, VBO and shader for this layer.
   QOpenGLBuffer layer_vertex_buffer_;
   QOpenGLVertexArrayObject layer_vao_;
+
+  // The indices of the triangles of the quads are the same for every quad
+  // layer, so all of them share one index buffer that grows as needed.
+  struct QuadIndexBuffer {
+    ~QuadIndexBuffer() { buffer_.destroy(); }
+    QOpenGLBuffer buffer_{ QOpenGLBuffer::IndexBuffer };
+    uint32_t quads_ = 0;
+  };
+  static std::weak_ptr<QuadIndexBuffer> shared_quad_indices_;
+  std::shared_ptr<QuadIndexBuffer> quad_indices_;
   std::unique_ptr<QOpenGLShaderProgram> layer_shader_program_;
 };
 
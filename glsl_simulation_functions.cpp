@@ -155,6 +155,37 @@ ivec2 Load32BitLeftShiftedBy4Into64Bit(int low) {
   int c2 = TopNibble(low);
   return ivec2(c1, c2);
 }
+
+// Subtracts a 96-bit base with 4 fractional bits (see
+// Load64BitLeftShiftedBy4Into96Bit) from a 64-bit integer, and returns the
+// difference in sixteenths as a float. This replaces Sub96 followed by
+// Multiply96BitWithFloat, but needs native 64-bit integers, so in GLSL it is
+// only available with GL_ARB_gpu_shader_int64.
+// Function must be valid C++ and valid GLSL!
+float Sub96FromUint64(uint64_t value, ivec3 base) {
+  // Split the base into the low 64 bits of its integer part, the remaining
+  // 28 high bits (with the sign), and the fraction.
+  uint64_t mask_32 = 0xFFFFFFFFul;
+  uint64_t base_low = (uint64_t(base.z) << 60) |
+    ((uint64_t(base.y) & mask_32) << 28) | ((uint64_t(base.x) & mask_32) >> 4);
+  int base_high = base.z >> 4;
+  uint64_t low = value - base_low;
+  int borrow = 0;
+  if (value < base_low) {
+    borrow = 1;
+  }
+  int high = 0 - base_high - borrow;
+  // Differences that fit into 64 bits (all visible ones) are converted
+  // exactly; the others are far outside of the screen anyway.
+  float result;
+  if (((high == 0) && ((low >> 63) == 0ul)) ||
+      ((high == -1) && ((low >> 63) == 1ul))) {
+    result = float(int64_t(low));
+  } else {
+    result = float(high) * 18446744073709551616.0 + float(low);
+  }
+  return result * 16.0 - float(base.x & 0xF);
+}
 // =========================================================================
 // End of valid C++ and valid GLSL part. The following are convenience
 // functions for C++.
@@ -93,6 +93,9 @@ public:
     y = val >> 32u;
   }
   uint32_t getUpper32() const { return z; }
+  bool operator==(const ivec3& other) const {
+    return (x == other.x) && (y == other.y) && (z == other.z);
+  }
 
   // Convert the 96-bit integer to a long double.
   long double getLongDouble() const {
@@ -134,6 +137,28 @@ public:
   };
 };
 
+// The vertex position as passed to the shaders: the tick and the address,
+// each as two 32-bit halves (lower half first).
+class ivec4 {
+public:
+  ivec4() {
+    x = 0;
+    y = 0;
+    z = 0;
+    w = 0;
+  }
+  ivec4(int32_t a, int32_t b, int32_t c, int32_t d) {
+    x = a;
+    y = b;
+    z = c;
+    w = d;
+  }
+  int32_t x;
+  int32_t y;
+  int32_t z;
+  int32_t w;
+};
+
 class vec3 {
 public:
   vec3() : x_(0.0), y_(0.0), z_(0.0) {};
@@ -165,6 +190,7 @@ int TopNibble(int value);
 ivec3 LongDoubleTo96Bits(long double value);
 ivec3 Load64BitLeftShiftedBy4Into96Bit(int low, int high);
 ivec2 Load32BitLeftShiftedBy4Into64Bit(int low);
+float Sub96FromUint64(uint64_t value, ivec3 base);
 
 // Functions that are not necessarily needed in GLSL.
 uint64_t Convert96BitTo64BitRightShift(ivec3 input);
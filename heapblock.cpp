@@ -5,41 +5,38 @@
 
 HeapBlock::HeapBlock() = default;
 
-HeapBlock::HeapBlock(uint32_t start_tick, uint32_t size, uint64_t address,
+HeapBlock::HeapBlock(uint64_t start_tick, uint32_t size, uint64_t address,
                      const std::string *alloctag = nullptr)
-    : start_tick_(start_tick), end_tick_(std::numeric_limits<uint32_t>::max()),
-      size_(size), address_(address), highlighted_(false), allocation_tag_(alloctag),
+    : start_tick_(start_tick), end_tick_(std::numeric_limits<uint64_t>::max()),
+      size_(size), address_(address), allocation_tag_(alloctag),
       free_tag_(nullptr) {}
 
-HeapBlock::HeapBlock(uint32_t start_tick, uint32_t end_tick, uint32_t size,
+HeapBlock::HeapBlock(uint64_t start_tick, uint64_t end_tick, uint32_t size,
                      uint64_t address)
     : start_tick_(start_tick), end_tick_(end_tick), size_(size),
-      address_(address), highlighted_(false) {}
+      address_(address) {}
 
-void HeapBlock::toVertices(uint32_t max_tick, std::vector<HeapVertex> *vertices,
+void HeapBlock::toVertices(uint64_t max_tick, std::vector<HeapVertex> *vertices,
                            bool debug) const {
 
+  // Highlighting is applied by the shader, see simple.vert.
   std::pair<QVector3D, QVector3D> colors =
-    highlighted_ ?
-    LinearBrightnessColorScale::highlightedColorsFromTick(start_tick_, end_tick_, max_tick)
-    : LinearBrightnessColorScale::colorsFromTick(start_tick_, end_tick_, max_tick);
+    LinearBrightnessColorScale::colorsFromTick(start_tick_, end_tick_, max_tick);
 
-  uint32_t lower_left_x = start_tick_;
+  uint64_t lower_left_x = start_tick_;
   uint64_t lower_left_y = address_;
-  uint32_t lower_right_x = end_tick_;
+  uint64_t lower_right_x = end_tick_;
 
   uint64_t lower_right_y = lower_left_y;
-  uint32_t upper_right_x = lower_right_x;
+  uint64_t upper_right_x = lower_right_x;
   uint64_t upper_right_y = address_ + size_;
-  uint32_t upper_left_x = lower_left_x;
+  uint64_t upper_left_x = lower_left_x;
   uint64_t upper_left_y = upper_right_y;
 
-  // Create new vertices.
+  // Create new vertices, in the quad order of vertex.h.
   if (!debug) {
     vertices->push_back(HeapVertex(lower_left_x, lower_left_y, colors.second));
     vertices->push_back(HeapVertex(lower_right_x, lower_right_y, colors.second));
-    vertices->push_back(HeapVertex(upper_left_x, upper_left_y, colors.first));
-    vertices->push_back(HeapVertex(lower_right_x, lower_right_y, colors.second));
     vertices->push_back(
         HeapVertex(upper_right_x, upper_right_y, colors.first));
     vertices->push_back(HeapVertex(upper_left_x, upper_left_y, colors.first));
@@ -50,6 +47,7 @@ void HeapBlock::toVertices(uint32_t max_tick, std::vector<HeapVertex> *vertices,
     static const QVector3D color_C(1.0, 1.0, 1.0);
     vertices->push_back(HeapVertex(lower_left_x, lower_left_y, color_A));
     vertices->push_back(HeapVertex(lower_right_x, lower_right_y, color_B));
+    vertices->push_back(HeapVertex(upper_right_x, upper_right_y, color_A));
     vertices->push_back(HeapVertex(upper_left_x, upper_left_y, color_C));
   }
 }
@@ -59,11 +57,14 @@ std::string getBlockInformationAsString(const HeapBlock &block) {
   stringstream << " Block address: " << std::hex << block.address_;
   stringstream << " Size: " << block.size_ << std::dec << "(" << block.size_
                << ")";
+  if (block.heap_id_ != 0) {
+    stringstream << " Heap: " << static_cast<uint32_t>(block.heap_id_);
+  }
   stringstream << " AllocationTick: " << block.start_tick_;
   if (block.allocation_tag_ != nullptr) {
     stringstream << " AllocationTag: " << *block.allocation_tag_;
   }
-  if (block.end_tick_ == std::numeric_limits<uint32_t>::max()) {
+  if (!block.wasFreed()) {
     stringstream << " [Currently Alive] ";
   } else {
     stringstream << " FreeTick: " << block.end_tick_;
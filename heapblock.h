@@ -12,30 +12,28 @@ class HeapBlock {
 public:
   HeapBlock();
   // Constructor for the most common case: Well-defined start, unknown end.
-  HeapBlock(uint32_t start_tick, uint32_t size, uint64_t address, const std::string* alloctag);
+  HeapBlock(uint64_t start_tick, uint32_t size, uint64_t address, const std::string* alloctag);
   // Constructor for the case that the end is known.
-  HeapBlock(uint32_t start_tick, uint32_t end_tick, uint32_t size,
+  HeapBlock(uint64_t start_tick, uint64_t end_tick, uint32_t size,
             uint64_t address);
-  // Create vertices for the block. Since the block consists of 2 triangles with
-  // 3 vertices each, and since the third dimension will be set by the shader,
-  // this function will write 6 floats to output_vertices. The correction term
-  // will be subtracted from the address value before writing the vertices to
-  // align the lowest recorded allocation with uint64_t 0. This should
-  // hopefully help reduce rounding errors / issues.
-  void toVertices(uint32_t max_tick, std::vector<HeapVertex> *output_vertices,
+  // Create vertices for the block. The block is drawn as a quad (see
+  // vertex.h), and since the third dimension will be set by the shader,
+  // this function will write 4 vertices to output_vertices.
+  void toVertices(uint64_t max_tick, std::vector<HeapVertex> *output_vertices,
                   bool debug = false) const;
   // Check if a given point is inside the current block.
-  bool contains(uint32_t tick, uint64_t address) {
+  bool contains(uint64_t tick, uint64_t address) {
     return (tick >= start_tick_) && (tick <= end_tick_) &&
            (address >= address_) && (address <= address_ + size_);
   }
-  bool wasFreed() const { return end_tick_ != std::numeric_limits<uint32_t>::max(); }
+  bool wasFreed() const { return end_tick_ != std::numeric_limits<uint64_t>::max(); }
 
-  uint32_t start_tick_ = 0;
-  uint32_t end_tick_ = 0;
+  uint64_t start_tick_ = 0;
+  uint64_t end_tick_ = 0;
   uint32_t size_ = 0;
+  // The heap the block was allocated on (see HeapHistory::recordMalloc).
+  uint8_t heap_id_ = 0;
   uint64_t address_ = 0;
-  bool highlighted_ = false;
   const std::string* allocation_tag_ = nullptr;
   const std::string* free_tag_ = nullptr;
 };
@@ -1,23 +1,332 @@
+#include <algorithm>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
 #include "heapblockdiagramlayer.h"
 
 HeapBlockDiagramLayer::HeapBlockDiagramLayer() :
-  GLHeapDiagramLayer(":/simple.vert", ":/simple.frag", false) {
+  GLHeapDiagramLayer(":/simple.vert", ":/block.frag", false,
+    ":/simple_int64.vert") {
+  is_quad_layer_ = true;
+  setUseTileRelativeVertices(true);
+}
+
+HeapBlockDiagramLayer::~HeapBlockDiagramLayer() {
+  if (block_index_texture_) {
+    block_index_texture_->destroy();
+  }
+  if (highlight_texture_) {
+    highlight_texture_->destroy();
+  }
+  if (heap_id_texture_) {
+    heap_id_texture_->destroy();
+  }
+  if (tile_origin_texture_) {
+    tile_origin_texture_->destroy();
+  }
+}
+
+void HeapBlockDiagramLayer::setUseTileRelativeVertices(bool use) {
+  use_tiles_ = use;
+  // The tile-relative shader does not need 64-bit integers.
+  vertex_shader_name_ = use ? ":/simple_tiled.vert" : ":/simple.vert";
+  native_64bit_vertex_shader_name_ = use ? "" : ":/simple_int64.vert";
+}
+
+// Uploads a vector of uint32_t into a single-channel integer texture that is
+// texture_width wide, re-creating the texture if it is too small.
+void HeapBlockDiagramLayer::uploadIntegerTexture(
+  const std::vector<uint32_t>& data, std::unique_ptr<QOpenGLTexture>* texture) {
+  int height = std::max(static_cast<int>(
+    (data.size() + texture_width - 1) / texture_width), 1);
+  if (!*texture || ((*texture)->height() < height)) {
+    if (*texture) {
+      (*texture)->destroy();
+    }
+    texture->reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+    (*texture)->setFormat(QOpenGLTexture::R32U);
+    (*texture)->setSize(texture_width, height);
+    (*texture)->setMinMagFilters(QOpenGLTexture::Nearest,
+      QOpenGLTexture::Nearest);
+    (*texture)->allocateStorage(QOpenGLTexture::Red_Integer,
+      QOpenGLTexture::UInt32);
+  }
+  // The texture has to be filled entirely.
+  std::vector<uint32_t> padded(data);
+  padded.resize(static_cast<size_t>(texture_width) * (*texture)->height(), 0);
+  (*texture)->setData(QOpenGLTexture::Red_Integer, QOpenGLTexture::UInt32,
+    padded.data());
+}
+
+// Writes the rows of |texture| that cover the given ranges of |data| with
+// glTexSubImage2D, since Qt 5.12 cannot update part of a texture. The texture
+// needs to have been created by uploadIntegerTexture for data of this size.
+void HeapBlockDiagramLayer::uploadIntegerTextureRows(
+  const std::vector<uint32_t>& data,
+  const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+  QOpenGLTexture* texture) {
+  QOpenGLFunctions* functions = QOpenGLContext::currentContext()->functions();
+  functions->glBindTexture(GL_TEXTURE_2D, texture->textureId());
+  std::vector<uint32_t> row(texture_width);
+  size_t next_row = 0;
+  for (const auto& range : ranges) {
+    // Neighbouring ranges often share a row, which only needs to be written
+    // once.
+    size_t first_row = std::max(static_cast<size_t>(range.first) /
+      texture_width, next_row);
+    size_t end_row = (static_cast<size_t>(range.second) + texture_width - 1) /
+      texture_width;
+    for (size_t index = first_row; index < end_row; ++index) {
+      size_t begin = index * texture_width;
+      size_t end = std::min(begin + texture_width, data.size());
+      const uint32_t* pixels = data.data() + begin;
+      if (end - begin < static_cast<size_t>(texture_width)) {
+        // The last row is only partially covered by the data.
+        std::fill(std::copy(data.begin() + begin, data.begin() + end,
+          row.begin()), row.end(), 0);
+        pixels = row.data();
+      }
+      functions->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<int>(index),
+        texture_width, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, pixels);
+    }
+    next_row = std::max(next_row, end_row);
+  }
+  functions->glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Translates the tile origins by the current window bases and uploads them
+// into a two-channel float texture that is texture_width wide.
+void HeapBlockDiagramLayer::uploadTileOrigins() {
+  ivec3 tick_base(visible_tick_base_A_, visible_tick_base_B_,
+    visible_tick_base_C_);
+  ivec3 address_base(visible_heap_base_A_, visible_heap_base_B_,
+    visible_heap_base_C_);
+  if (tile_origins_valid_ && (tick_base == tile_origins_tick_base_) &&
+    (address_base == tile_origins_address_base_)) {
+    return;
+  }
+  tiles_.getTileOrigins(tick_base, address_base, &tile_origins_);
+  int height = std::max(static_cast<int>(
+    (tiles_.size() + texture_width - 1) / texture_width), 1);
+  if (!tile_origin_texture_ || (tile_origin_texture_->height() < height)) {
+    if (tile_origin_texture_) {
+      tile_origin_texture_->destroy();
+    }
+    tile_origin_texture_.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+    tile_origin_texture_->setFormat(QOpenGLTexture::RG32F);
+    tile_origin_texture_->setSize(texture_width, height);
+    tile_origin_texture_->setMinMagFilters(QOpenGLTexture::Nearest,
+      QOpenGLTexture::Nearest);
+    tile_origin_texture_->allocateStorage(QOpenGLTexture::RG,
+      QOpenGLTexture::Float32);
+  }
+  tile_origins_.resize(2 * static_cast<size_t>(texture_width) *
+    tile_origin_texture_->height(), 0.0f);
+  tile_origin_texture_->setData(QOpenGLTexture::RG, QOpenGLTexture::Float32,
+    tile_origins_.data());
+  tile_origins_valid_ = true;
+  tile_origins_tick_base_ = tick_base;
+  tile_origins_address_base_ = address_base;
 }
 
 void HeapBlockDiagramLayer::loadVerticesFromHeapHistory(const HeapHistory& history, bool all) {
   std::vector<HeapVertex> *vertices = getVertexVector();
-  vertices->clear();
+  if (all) {
+    // Drawing all blocks bypasses the resident set.
+    resident_blocks_.clear();
+    vertices->clear();
+    block_indices_.clear();
+    block_heaps_.clear();
+    history.heapBlockVerticesForActiveWindow(vertices, true, &block_indices_,
+      &block_heaps_);
+    all_slots_changed_ = true;
+  } else {
+    // Culls the blocks that left the window, and builds the quads of the
+    // ones that entered it.
+    FrameProfiler::Scope scope(profiler_, "blocks.cull");
+    all_slots_changed_ = resident_blocks_.update(history, vertices,
+      &block_indices_);
+    if (!all_slots_changed_ && resident_blocks_.getChangedSlots().empty()) {
+      return;
+    }
+    // The heap IDs go with the slots, like the block indices.
+    block_heaps_.resize(block_indices_.size());
+    if (all_slots_changed_) {
+      for (uint32_t slot = 0; slot < block_heaps_.size(); ++slot) {
+        block_heaps_[slot] = resident_blocks_.getHeapId(slot);
+      }
+    } else {
+      for (const auto& range : resident_blocks_.getChangedSlots()) {
+        for (uint32_t slot = range.first; slot < range.second; ++slot) {
+          block_heaps_[slot] = resident_blocks_.getHeapId(slot);
+        }
+      }
+    }
+  }
+  {
+    FrameProfiler::Scope scope(profiler_, "blocks.index_upload");
+    int height = static_cast<int>((block_indices_.size() + texture_width - 1) /
+      texture_width);
+    if (all_slots_changed_ || !block_index_texture_ ||
+      (block_index_texture_->height() < height)) {
+      uploadIntegerTexture(block_indices_, &block_index_texture_);
+      uploadIntegerTexture(block_heaps_, &heap_id_texture_);
+    } else {
+      uploadIntegerTextureRows(block_indices_,
+        resident_blocks_.getChangedSlots(), block_index_texture_.get());
+      uploadIntegerTextureRows(block_heaps_,
+        resident_blocks_.getChangedSlots(), heap_id_texture_.get());
+    }
+  }
+
+  if (use_tiles_) {
+    FrameProfiler::Scope scope(profiler_, "blocks.tile_vertices");
+    if (all_slots_changed_) {
+      tiles_.clear();
+      tile_vertices_.clear();
+      tile_vertices_.reserve(vertices->size());
+      for (const HeapVertex& vertex : *vertices) {
+        tile_vertices_.push_back(tiles_.toTileVertex(vertex));
+      }
+      tile_origins_valid_ = false;
+      return;
+    }
+    // New slots are only ever appended, so the ranges either overwrite
+    // tile vertices or continue at the end.
+    size_t number_of_tiles = tiles_.size();
+    for (const auto& range : resident_blocks_.getChangedSlots()) {
+      for (size_t index = range.first * vertices_per_quad;
+        index < range.second * vertices_per_quad; ++index) {
+        TileVertex vertex = tiles_.toTileVertex((*vertices)[index]);
+        if (index < tile_vertices_.size()) {
+          tile_vertices_[index] = vertex;
+        } else {
+          tile_vertices_.push_back(vertex);
+        }
+      }
+    }
+    if (tiles_.size() != number_of_tiles) {
+      tile_origins_valid_ = false;
+    }
+  }
+}
+
+bool HeapBlockDiagramLayer::getChangedVertexBufferRanges(
+  std::vector<std::pair<size_t, size_t>>* ranges) const {
+  if (all_slots_changed_) {
+    return false;
+  }
+  size_t quad_size = vertices_per_quad *
+    (use_tiles_ ? sizeof(TileVertex) : sizeof(HeapVertex));
+  for (const auto& range : resident_blocks_.getChangedSlots()) {
+    ranges->emplace_back(range.first * quad_size,
+      (range.second - range.first) * quad_size);
+  }
+  return true;
+}
+
+// Highlights and hidden heaps do not change the vertices, so they are
+// refreshed even when the vertices are not.
+void HeapBlockDiagramLayer::refreshLayerState(const HeapHistory& history) {
+  if (!highlight_texture_ ||
+    (highlight_generation_ != history.getHighlightGeneration())) {
+    uploadIntegerTexture(history.getHighlightBits(), &highlight_texture_);
+    highlight_generation_ = history.getHighlightGeneration();
+  }
+  visible_heap_bits_ = history.getVisibleHeapBits();
+}
+
+const void* HeapBlockDiagramLayer::getVertexBufferData() const {
+  if (!use_tiles_) {
+    return GLHeapDiagramLayer::getVertexBufferData();
+  }
+  return tile_vertices_.data();
+}
 
-  history.heapBlockVerticesForActiveWindow(vertices, all);
+size_t HeapBlockDiagramLayer::getVertexBufferSize() const {
+  if (!use_tiles_) {
+    return GLHeapDiagramLayer::getVertexBufferSize();
+  }
+  return tile_vertices_.size() * sizeof(TileVertex);
+}
+
+void HeapBlockDiagramLayer::setupVertexAttributes() {
+  if (!use_tiles_) {
+    GLHeapDiagramLayer::setupVertexAttributes();
+    return;
+  }
+  layer_shader_program_->setAttributeBuffer(
+      0, GL_FLOAT, TileVertex::positionOffset(), TileVertex::PositionTupleSize,
+      TileVertex::stride());
+  layer_shader_program_->setAttributeBuffer(
+      1, GL_UNSIGNED_BYTE, TileVertex::colorOffset(),
+      TileVertex::ColorTupleSize,
+      TileVertex::stride());
+}
+
+void HeapBlockDiagramLayer::setupLayerUniforms() {
+  uniform_block_indices_ =
+      layer_shader_program_->uniformLocation("block_indices");
+  uniform_highlight_bits_ =
+      layer_shader_program_->uniformLocation("highlight_bits");
+  uniform_block_heaps_ =
+      layer_shader_program_->uniformLocation("block_heaps");
+  uniform_visible_heaps_ =
+      layer_shader_program_->uniformLocation("visible_heaps");
+  uniform_tile_origins_ =
+      layer_shader_program_->uniformLocation("tile_origins");
+  uniform_draw_block_ids_ =
+      layer_shader_program_->uniformLocation("draw_block_ids");
+}
+
+void HeapBlockDiagramLayer::bindLayerState() {
+  block_index_texture_->bind(0);
+  highlight_texture_->bind(1);
+  heap_id_texture_->bind(2);
+  layer_shader_program_->setUniformValue(uniform_block_indices_, 0);
+  layer_shader_program_->setUniformValue(uniform_highlight_bits_, 1);
+  layer_shader_program_->setUniformValue(uniform_block_heaps_, 2);
+  layer_shader_program_->setUniformValueArray(uniform_visible_heaps_,
+    visible_heap_bits_.data(), static_cast<int>(visible_heap_bits_.size()));
+  layer_shader_program_->setUniformValue(uniform_draw_block_ids_,
+    static_cast<GLint>(draw_block_ids_ ? 1 : 0));
+  if (use_tiles_) {
+    // The window bases were just set by paintLayer.
+    uploadTileOrigins();
+    tile_origin_texture_->bind(3);
+    layer_shader_program_->setUniformValue(uniform_tile_origins_, 3);
+  }
+}
+
+void HeapBlockDiagramLayer::releaseLayerState() {
+  if (use_tiles_) {
+    tile_origin_texture_->release(3);
+  }
+  heap_id_texture_->release(2);
+  highlight_texture_->release(1);
+  block_index_texture_->release(0);
+}
+
+void HeapBlockDiagramLayer::paintBlockIds(ivec3 minimum_tick,
+  ivec3 minimum_address, const QMatrix2x2 &heap_to_screen) {
+  draw_block_ids_ = true;
+  paintLayer(minimum_tick, minimum_address, heap_to_screen);
+  draw_block_ids_ = false;
 }
 
 std::pair<vec4, vec4> HeapBlockDiagramLayer::vertexShaderSimulator(const HeapVertex& vertex) {
-  ivec3 position(vertex.getX(), vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
+  if (use_tiles_) {
+    return tiledVertexShaderSimulator(vertex);
+  }
+  ivec4 position(vertex.getX() & 0xFFFFFFFF, vertex.getX() >> 32u,
+    vertex.getY() & 0xFFFFFFFF, vertex.getY() >> 32u);
   int visible_heap_base_A = visible_heap_base_A_;
   int visible_heap_base_B = visible_heap_base_B_;
   int visible_heap_base_C = visible_heap_base_C_;
   int visible_tick_base_A = visible_tick_base_A_;
   int visible_tick_base_B = visible_tick_base_B_;
+  int visible_tick_base_C = visible_tick_base_C_;
   float scale_heap_x = vertex_to_screen_.data()[0];
   float scale_heap_y = vertex_to_screen_.data()[2];
   float scale_heap_to_screen[2][2] = {{scale_heap_x, 0.0}, {0.0, scale_heap_y}};
@@ -30,8 +339,8 @@ std::pair<vec4, vec4> HeapBlockDiagramLayer::vertexShaderSimulator(const HeapVer
   // =========================================================================
 
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -44,10 +353,11 @@ std::pair<vec4, vec4> HeapBlockDiagramLayer::vertexShaderSimulator(const HeapVer
   ivec3 address_coordinate_translated = Sub96(address, heap_base);
 
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
 
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
   // Multiply the y coordinate with the y entry of the transformation matrix.
   // To avoid a degenerate matrix, C++ code supplies a matrix containing the
@@ -57,7 +367,7 @@ std::pair<vec4, vec4> HeapBlockDiagramLayer::vertexShaderSimulator(const HeapVer
                                         scale_heap_to_screen[1][1]);
   float final_y = temp_y * scale_heap_to_screen[1][1];
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
@@ -80,3 +390,29 @@ std::pair<vec4, vec4> HeapBlockDiagramLayer::vertexShaderSimulator(const HeapVer
 
   return std::make_pair(gl_Position, vColor);
 }
+
+std::pair<vec4, vec4> HeapBlockDiagramLayer::tiledVertexShaderSimulator(
+  const HeapVertex& vertex) {
+  // A single tile for the vertex gives the same offset and origin as the
+  // tiles of the layer.
+  VertexTiles tiles;
+  TileVertex tile_vertex = tiles.toTileVertex(vertex);
+  std::vector<float> origins;
+  tiles.getTileOrigins(ivec3(visible_tick_base_A_, visible_tick_base_B_,
+    visible_tick_base_C_), ivec3(visible_heap_base_A_, visible_heap_base_B_,
+    visible_heap_base_C_), &origins);
+  float scale_heap_x = vertex_to_screen_.data()[0];
+  float scale_heap_y = vertex_to_screen_.data()[2];
+
+  float final_x = VertexTiles::getTranslatedCoordinate(origins[0],
+    tile_vertex.getX()) * scale_heap_x;
+  final_x = final_x * scale_heap_x;
+  float final_y = VertexTiles::getTranslatedCoordinate(origins[1],
+    tile_vertex.getY()) * scale_heap_y;
+  final_y = final_y * scale_heap_y;
+  final_y = 2 * final_y - 1;
+  final_x = 2 * final_x - 1;
+
+  vec3 color(vertex.getColor().x(), vertex.getColor().y(), vertex.getColor().z());
+  return std::make_pair(vec4(final_x, final_y, 0.0, 1.0), vec4(color, 1.0));
+}
@@ -1,13 +1,118 @@
 #ifndef HEAPBLOCKDIAGRAMLAYER_H
 #define HEAPBLOCKDIAGRAMLAYER_H
+#include <array>
+
+#include <QOpenGLTexture>
+
 #include "glheapdiagramlayer.h"
+#include "residentblockset.h"
+#include "vertextiles.h"
 
+// Draws the heap blocks. Which blocks are highlighted is not part of the
+// vertices: the shader looks up the block index of each vertex and the
+// highlight bit of the block in two integer textures, so a new highlight only
+// needs to upload the highlight bitset. The same goes for hiding heaps: the
+// shader looks up the heap ID of the slot in a third texture, which is
+// written along with the block indices, and drops the blocks of heaps whose
+// bit in a uniform is not set.
+//
+// By default, the vertices are uploaded relative to the origin of their tile
+// (see VertexTiles), and the tile origins relative to the displayed window go
+// into a float texture that is refreshed whenever the window moves.
+//
+// For picking, the layer can also draw the index of every block instead of
+// its color (see paintBlockIds), so that the block under a pixel is one
+// readback away.
+//
+// The layer holds the blocks of a guard band around the window (see
+// ResidentBlockSet), so that panning only writes the quads of the blocks that
+// enter or leave the band into the vertex buffer.
 class HeapBlockDiagramLayer : public GLHeapDiagramLayer {
 public:
   HeapBlockDiagramLayer();
-  virtual ~HeapBlockDiagramLayer() = default;
+  virtual ~HeapBlockDiagramLayer();
   std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex& vertex) override;
   void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) override;
+
+  // Chooses between tile-relative vertices and the 64-bit vertices with
+  // 96-bit arithmetic in the shader. Needs to be called before
+  // initializeGLStructures.
+  void setUseTileRelativeVertices(bool use);
+  bool usesTileRelativeVertices() const { return use_tiles_; }
+
+  // Draws the index of every block plus one into the four bytes of its
+  // pixels, lowest byte first, instead of its color. Blending needs to be
+  // off, and the target needs to be cleared to zero.
+  void paintBlockIds(ivec3 minimum_tick, ivec3 minimum_address,
+                     const QMatrix2x2 &heap_to_screen);
+  // Decodes a pixel drawn by paintBlockIds. Returns false if no block was
+  // drawn there.
+  static bool decodeBlockId(const uint8_t rgba[4], uint32_t* index) {
+    uint32_t id = rgba[0] | (rgba[1] << 8u) | (rgba[2] << 16u) |
+      (static_cast<uint32_t>(rgba[3]) << 24u);
+    if (id == 0) {
+      return false;
+    }
+    *index = id - 1;
+    return true;
+  }
+
+  // Width of the integer textures; they are as high as necessary.
+  static constexpr int texture_width = 4096;
+protected:
+  void setupLayerUniforms() override;
+  void bindLayerState() override;
+  void releaseLayerState() override;
+  void refreshLayerState(const HeapHistory& history) override;
+  const void* getVertexBufferData() const override;
+  size_t getVertexBufferSize() const override;
+  void setupVertexAttributes() override;
+  bool getChangedVertexBufferRanges(
+    std::vector<std::pair<size_t, size_t>>* ranges) const override;
+
+private:
+  static void uploadIntegerTexture(const std::vector<uint32_t>& data,
+    std::unique_ptr<QOpenGLTexture>* texture);
+  static void uploadIntegerTextureRows(const std::vector<uint32_t>& data,
+    const std::vector<std::pair<uint32_t, uint32_t>>& ranges,
+    QOpenGLTexture* texture);
+  void uploadTileOrigins();
+  std::pair<vec4, vec4> tiledVertexShaderSimulator(const HeapVertex& vertex);
+
+  // The blocks around the window, which panning only updates piecewise.
+  // Every slot of the set holds one quad and one block index.
+  ResidentBlockSet resident_blocks_;
+  // Set if the last load rewrote all slots, not just the changed ones.
+  bool all_slots_changed_ = true;
+  // The index into the block vector for every block that has vertices, and
+  // its heap ID.
+  std::vector<uint32_t> block_indices_;
+  std::vector<uint32_t> block_heaps_;
+  std::unique_ptr<QOpenGLTexture> block_index_texture_;
+  std::unique_ptr<QOpenGLTexture> highlight_texture_;
+  std::unique_ptr<QOpenGLTexture> heap_id_texture_;
+  std::array<uint32_t, 8> visible_heap_bits_ = {};
+  // The highlight generation of the heap history that was last uploaded.
+  uint32_t highlight_generation_ = 0;
+
+  bool use_tiles_ = false;
+  VertexTiles tiles_;
+  std::vector<TileVertex> tile_vertices_;
+  std::vector<float> tile_origins_;
+  std::unique_ptr<QOpenGLTexture> tile_origin_texture_;
+  // The window bases the tile origins were last translated by. Cleared when
+  // the tiles change.
+  bool tile_origins_valid_ = false;
+  ivec3 tile_origins_tick_base_;
+  ivec3 tile_origins_address_base_;
+
+  int uniform_block_indices_ = 0;
+  int uniform_highlight_bits_ = 0;
+  int uniform_block_heaps_ = 0;
+  int uniform_visible_heaps_ = 0;
+  int uniform_tile_origins_ = 0;
+  int uniform_draw_block_ids_ = 0;
+  bool draw_block_ids_ = false;
 };
 
 #endif // HEAPBLOCKDIAGRAMLAYER_H
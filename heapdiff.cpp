@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <iterator>
+
+#include "heapdiff.h"
+
+HeapDiff::HeapDiff(const LiveSetCheckpoints& checkpoints,
+  const CompressedBlockStore* blocks, uint64_t from_tick, uint64_t to_tick,
+  bool include_survivors) : from_tick_(std::min(from_tick, to_tick)),
+  to_tick_(std::max(from_tick, to_tick)) {
+
+  // Blocks allocated in the interval form a contiguous range of the block
+  // store, since it is sorted by allocation tick.
+  uint32_t first, last;
+  checkpoints.getBlocksAllocatedBetween(from_tick_, to_tick_, &first, &last);
+  blocks->forEachBlockBetween(first, last, [this](uint32_t index,
+    const CompressedBlockStore::DecodedChunk& chunk, uint32_t offset) {
+    if (chunk.end_ticks_[offset] > to_tick_) {
+      allocated_.push_back(index);
+    }
+  });
+
+  // Blocks freed in the interval either existed before, or are transient.
+  std::vector<uint32_t> freed_in_interval;
+  checkpoints.getBlocksFreedBetween(from_tick_, to_tick_, &freed_in_interval);
+  std::sort(freed_in_interval.begin(), freed_in_interval.end());
+  for (uint32_t index : freed_in_interval) {
+    if (index < first) {
+      freed_.push_back(index);
+    } else {
+      transient_.push_back(index);
+    }
+  }
+
+  if (include_survivors) {
+    std::vector<uint32_t> live_at_start;
+    checkpoints.getLiveBlocksAtTick(from_tick_, &live_at_start);
+    std::set_difference(live_at_start.begin(), live_at_start.end(),
+      freed_.begin(), freed_.end(), std::back_inserter(survived_));
+  }
+}
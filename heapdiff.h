@@ -0,0 +1,41 @@
+#ifndef HEAPDIFF_H
+#define HEAPDIFF_H
+
+#include <cstdint>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "livesetcheckpoints.h"
+
+// The difference between the state of the heap at two ticks. All sets are
+// indices into the block store of the heap history, sorted in ascending
+// order.
+//
+// The allocated, freed and transient sets are computed from the start-tick
+// order of the block store and from its free log, so their cost scales with
+// the number of events between the two ticks. The set of survivors is as
+// large as the live set, and is only computed on request.
+class HeapDiff {
+public:
+  HeapDiff(const LiveSetCheckpoints& checkpoints,
+    const CompressedBlockStore* blocks, uint64_t from_tick,
+    uint64_t to_tick, bool include_survivors = false);
+
+  // Number of blocks that changed state between the two ticks.
+  size_t numberOfChanges() const {
+    return allocated_.size() + freed_.size() + transient_.size();
+  }
+
+  uint64_t from_tick_;
+  uint64_t to_tick_;
+  // Blocks allocated in (from_tick_, to_tick_] and still alive at to_tick_.
+  std::vector<uint32_t> allocated_;
+  // Blocks alive at from_tick_ that were freed by to_tick_.
+  std::vector<uint32_t> freed_;
+  // Blocks that were both allocated and freed in (from_tick_, to_tick_].
+  std::vector<uint32_t> transient_;
+  // Blocks alive at both from_tick_ and to_tick_.
+  std::vector<uint32_t> survived_;
+};
+
+#endif // HEAPDIFF_H
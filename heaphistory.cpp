@@ -1,116 +1,252 @@
 #include <algorithm>
+#include <cctype>
 #include <limits>
+#include <thread>
 
 #include "json.hpp"
 // using json = json;
 
 #include "heaphistory.h"
 
-#include <cinttypes>
 
 // Constructors for helper classes.
 
-HeapConflict::HeapConflict(uint32_t tick, uint64_t address, bool alloc)
+HeapConflict::HeapConflict(uint64_t tick, uint64_t address, bool alloc)
     : tick_(tick), address_(address), allocation_or_free_(alloc) {}
 
 // The code for the heap history.
 HeapHistory::HeapHistory()
     : current_tick_(0),
-      global_area_(std::numeric_limits<uint64_t>::max(), 0, 0, 1) {
+      global_area_(std::numeric_limits<uint64_t>::max(), 0, 0, 1),
+      compressed_blocks_(&tags_, CompressedBlockStore::default_blocks_per_chunk,
+        &page_file_) {
   setCurrentWindowToGlobal();
 }
 
-bool HeapHistory::hasMandatoryJSONElementFields(
-    const nlohmann::json &json_element) {
-  static std::map<std::string, std::vector<std::string>> mandatory_fields = {
-      {"alloc", {"address", "size"}},
-      {"free", {"address"}},
-      {"filterrange", {"low", "high"}},
-      {"event", {}},
-      {"rangefree", {"low", "high"}},
-      {"address", {"address"}}};
-  if (json_element.find("type") == json_element.end()) {
-    std::cout << "[E] Failed to find type field" << std::endl;
-    return false;
+void HeapHistory::LoadFromJSONStream(std::istream &jsondata,
+                                     TraceIndexWriter *index) {
+  // Skip leading whitespace to tell a JSON array from newline-delimited JSON.
+  std::streambuf *buffer = jsondata.rdbuf();
+  uint64_t offset = 0;
+  while (isspace(buffer->sgetc())) {
+    buffer->sbumpc();
+    ++offset;
   }
-  std::string type = json_element["type"].get<std::string>();
-  std::vector<std::string> mandatory = mandatory_fields[type];
-  for (const std::string &field : mandatory) {
-    if (json_element.find(field) == json_element.end()) {
-      std::cout << "[E] Failed to find mandatory field " << field
-                << " for type " << type << std::endl;
-      return false;
+  if (buffer->sgetc() == '{') {
+    // One element per line: parse a window of lines in parallel, record the
+    // parsed events in order, then read the next window. Only one window of
+    // the trace is in memory at a time.
+    NDJSONWindowReader reader(&jsondata, offset);
+    std::string window;
+    std::vector<TraceEventChunk> chunks;
+    while (reader.next(&window, &offset)) {
+      parseNDJSON(window, offset, 0, &chunks);
+      for (const TraceEventChunk &chunk : chunks) {
+        recordTraceEvents(chunk, index);
+      }
+    }
+  } else {
+    JSONElementReader reader(&jsondata, offset);
+    TraceEventChunk chunk;
+    std::string element;
+    while (reader.next(&element, &offset)) {
+      chunk.clear();
+      parseTraceEvent(element, offset, &chunk);
+      recordTraceEvents(chunk, index);
     }
   }
-  return true;
+  if (index != nullptr) {
+    index->finish();
+  }
+  finishLoading();
 }
 
-void HeapHistory::LoadFromJSONStream(std::istream &jsondata) {
-  nlohmann::json incoming_data;
-  incoming_data << jsondata;
-
-  for (const auto &json_element : incoming_data) {
-    if (!hasMandatoryJSONElementFields(json_element)) {
-      printf("OH NOES MANDATORY ELEMENT MISSING\n");
-      continue;
-    }
-    // The "type" field is mandatory for every event.
-    std::string type = json_element["type"].get<std::string>();
-    std::string tag;
-    if (json_element.find("tag") != json_element.end()) {
-      tag = json_element["tag"].get<std::string>();
+// Restores the state at the last index checkpoint at or before first_tick,
+// and replays the trace from there up to last_tick.
+bool HeapHistory::LoadTickRangeFromJSONStream(std::istream &jsondata,
+                                              std::istream &index_data,
+                                              uint64_t first_tick,
+                                              uint64_t last_tick) {
+  TraceIndexReader index;
+  TraceIndexCheckpoint checkpoint;
+  if (!index.open(&index_data) ||
+      !index.readCheckpoint(first_tick, &checkpoint)) {
+    printf("[!] Failed to read the trace index\n");
+    return false;
+  }
+  // Filter ranges and address labels that precede the checkpoint.
+  TraceEventChunk chunk;
+  for (const auto &element : index.getVerbatimElements()) {
+    if (element.first < checkpoint.trace_offset_) {
+      parseTraceEvent(element.second, element.first, &chunk);
     }
-    // A not-too-intrusive gray by default.
-    std::string color = "#B0B0B0";
-    if (json_element.find("color") != json_element.end()) {
-      color = json_element["color"].get<std::string>();
+  }
+  recordTraceEvents(chunk);
+
+  // Materialize the blocks that are alive at the checkpoint, keeping the
+  // block store sorted by allocation tick.
+  std::stable_sort(checkpoint.live_.begin(), checkpoint.live_.end(),
+    [](const HeapBlock &left, const HeapBlock &right) {
+      return left.start_tick_ < right.start_tick_;
+    });
+  for (HeapBlock &block : checkpoint.live_) {
+    if (block.allocation_tag_ != nullptr) {
+      block.allocation_tag_ = tags_.intern(*block.allocation_tag_);
     }
+    uint32_t index = compressed_blocks_.append(block);
+    recordHeapId(block.heap_id_);
+    live_blocks_[block.heap_id_][block.address_] = { index, block.size_,
+      block.start_tick_, block.allocation_tag_ };
+    ++live_block_count_;
+    live_bytes_ += block.size_;
+    global_area_.maximum_address_ =
+        std::max(block.address_ + block.size_, global_area_.maximum_address_);
+    global_area_.minimum_address_ =
+        std::min(block.address_, global_area_.minimum_address_);
+  }
+  current_tick_ = checkpoint.tick_;
+  global_area_.maximum_tick_ = current_tick_ + (current_tick_ / 20) + 1;
+
+  jsondata.clear();
+  jsondata.seekg(static_cast<std::streamoff>(checkpoint.trace_offset_));
+  JSONElementReader reader(&jsondata, checkpoint.trace_offset_);
+  std::string element;
+  uint64_t offset;
+  while ((current_tick_ < last_tick) && reader.next(&element, &offset)) {
+    chunk.clear();
+    parseTraceEvent(element, offset, &chunk);
+    recordTraceEvents(chunk);
+  }
+  global_area_.minimum_tick_ = checkpoint.tick_;
+  finishLoading();
+  return true;
+}
 
-    auto ret = alloc_or_free_tags_.insert(tag);
-    const std::string *de_duped_tag = &*(ret.first);
-
-    if (type == "alloc") {
-      recordMalloc(json_element["address"].get<uint64_t>(),
-                   json_element["size"].get<uint32_t>(), de_duped_tag, 0);
-    } else if (type == "free") {
-      recordFree(json_element["address"].get<uint64_t>(), de_duped_tag, 0);
-    } else if (type == "event") {
-      recordEvent(tag, color);
-    } else if (type == "rangefree") {
-      auto low = json_element["low"].get<uint64_t>();
-      auto high = json_element["high"].get<uint64_t>();
-      recordFreeRange(low, high, de_duped_tag, 0);
-    } else if (type == "address") {
-      recordAddress(json_element["address"].get<uint64_t>(), tag, color);
-    } else if (type == "filterrange") {
-      auto low = json_element["low"].get<uint64_t>();
-      auto high = json_element["high"].get<uint64_t>();
-      recordFilterRange(low, high);
-    }
+void HeapHistory::LoadFromTraceShards(
+    const std::vector<std::istream *> &shards) {
+  TraceShardMerger merger(shards);
+  const TraceEvent *event;
+  const TraceEventChunk *chunk;
+  while (merger.next(&event, &chunk)) {
+    // Every shard has its own batch of strings, and the merger keeps a tag
+    // cache for each.
+    recordTraceEvent(*event, *chunk, merger.getStringCache());
+  }
+  fflush(stdout);
+  finishLoading();
+}
 
-    fflush(stdout);
+void HeapHistory::recordTraceEvents(const TraceEventChunk &chunk,
+                                    TraceIndexWriter *index) {
+  // The strings are de-duplicated within the chunk, so every tag only needs
+  // to be looked up once.
+  std::vector<const std::string *> tags(chunk.strings_.size(), nullptr);
+  for (const TraceEvent &event : chunk.events_) {
+    recordTraceEvent(event, chunk, &tags, index);
   }
-  printf("heap_blocks_.size() is %zu\n", heap_blocks_.size());
-  // Sweep through the existing blocks and dump out the non-freed ones.:w
-  for (const auto& block : heap_blocks_) {
-    if (!block.wasFreed()) {
-      printf("Alive block:\n%s\n", getBlockInformationAsString(block).c_str());
-    } else {
-      printf("Freed block:\n%s\n", getBlockInformationAsString(block).c_str());
+  fflush(stdout);
+}
+
+void HeapHistory::recordTraceEvent(const TraceEvent &event,
+                                   const TraceEventChunk &chunk,
+                                   std::vector<const std::string *> *tags,
+                                   TraceIndexWriter *index) {
+  if (event.type_ == TraceEvent::INVALID) {
+    return;
+  }
+  if ((index != nullptr) && index->isCheckpointDue(current_tick_)) {
+    std::vector<HeapBlock> live;
+    live.reserve(live_block_count_);
+    for (uint8_t heap_id : heap_ids_) {
+      for (const auto &live_block : live_blocks_[heap_id]) {
+        live.emplace_back(live_block.second.start_tick_,
+          live_block.second.size_, live_block.first,
+          live_block.second.allocation_tag_);
+        live.back().heap_id_ = heap_id;
+      }
     }
+    // Every heap is sorted by address on its own.
+    if (heap_ids_.size() > 1) {
+      std::stable_sort(live.begin(), live.end(),
+        [](const HeapBlock &left, const HeapBlock &right) {
+          return left.address_ < right.address_;
+        });
+    }
+    index->writeCheckpoint(current_tick_, event.offset_, live);
   }
-  fflush(stdout);
+  if ((*tags)[event.tag_] == nullptr) {
+    (*tags)[event.tag_] = tags_.intern(chunk.strings_[event.tag_]);
+  }
+  const std::string *tag = (*tags)[event.tag_];
+  const std::string &color = chunk.strings_[event.color_];
+
+  switch (event.type_) {
+    case TraceEvent::ALLOC:
+      recordMalloc(event.address_, event.size_or_high_, tag, event.heap_id_);
+      break;
+    case TraceEvent::FREE:
+      recordFree(event.address_, tag, event.heap_id_);
+      break;
+    case TraceEvent::EVENT:
+      recordEvent(*tag, color);
+      break;
+    case TraceEvent::RANGEFREE:
+      recordFreeRange(event.address_, event.size_or_high_, tag,
+        event.heap_id_);
+      break;
+    case TraceEvent::ADDRESS:
+      recordAddress(event.address_, *tag, color);
+      break;
+    case TraceEvent::FILTERRANGE:
+      recordFilterRange(event.address_, event.size_or_high_);
+      break;
+    default:
+      break;
+  }
+  // Elements that do not advance the tick are kept verbatim in the index.
+  if ((index != nullptr) && ((event.type_ == TraceEvent::ADDRESS) ||
+                             (event.type_ == TraceEvent::FILTERRANGE))) {
+    index->recordVerbatimElement(event.offset_, chunk.strings_[event.text_]);
+  }
+}
 
-  // Initialize the internal caches.
+void HeapHistory::finishLoading() {
+  compressed_blocks_.finish();
+
+  // Initialize the internal caches. They only read the block store, so the
+  // independent ones are built in parallel; the free gap index depends on
+  // the checkpoints built before it on the same thread.
+  fragmentation_timeline_.finish(current_tick_);
   uint64_t height = global_area_.maximum_address_
     - global_area_.minimum_address_;
-  active_region_cache_ = ActiveRegionCache(height,
-    &heap_blocks_);
-
+  std::vector<std::thread> builders;
+  builders.emplace_back([this, height]() {
+    active_region_cache_ = ActiveRegionCache(height, compressed_blocks_);
+  });
+  builders.emplace_back([this]() {
+    live_set_checkpoints_ = LiveSetCheckpoints(current_tick_,
+      &compressed_blocks_);
+    free_gap_index_ = FreeGapIndex(current_tick_,
+      global_area_.minimum_address_, global_area_.maximum_address_,
+      &compressed_blocks_, &live_set_checkpoints_);
+  });
+  builders.emplace_back([this]() {
+    tag_aggregate_index_ = TagAggregateIndex(current_tick_,
+      compressed_blocks_, tags_);
+  });
+  builders.emplace_back([this]() {
+    address_reuse_index_ = AddressReuseIndex(compressed_blocks_);
+  });
+  for (std::thread &builder : builders) {
+    builder.join();
+  }
+  highlight_bits_.assign((compressed_blocks_.size() + 31) / 32, 0);
+  ++highlight_generation_;
+  ++data_generation_;
 }
 
 // Decide whether a block is worth sending to the graphics card.
-inline bool HeapHistory::isBlockActive(const HeapBlock &block,
+bool HeapHistory::isBlockActive(const HeapBlock &block,
   uint64_t min_size, uint64_t min_address, uint64_t max_address,
   uint64_t min_tick, uint64_t max_tick) const {
 
@@ -132,6 +268,7 @@ inline bool HeapHistory::isBlockActive(const HeapBlock &block,
 
 void HeapHistory::setCurrentWindow(const HeapWindow &new_window) {
   current_window_.reset(new_window);
+  ++window_generation_;
 }
 
 bool HeapHistory::isEventFiltered(uint64_t address) {
@@ -154,74 +291,95 @@ void HeapHistory::recordMalloc(uint64_t address, size_t size,
   }
 
   // Check if there is already a live block at this address.
-  if (live_blocks_.find(std::make_pair(address, heap_id)) !=
-      live_blocks_.end()) {
+  std::map<uint64_t, LiveBlock> &live_blocks = live_blocks_[heap_id];
+  if (live_blocks.find(address) != live_blocks.end()) {
     // Record a conflict.
     recordMallocConflict(address, size, heap_id);
     return;
   }
   assert(size <= std::numeric_limits<uint32_t>::max());
-  heap_blocks_.emplace_back(current_tick_, static_cast<uint32_t>(size), address, tag);
-  this->cached_blocks_sorted_by_address_.clear();
+  HeapBlock block(current_tick_, static_cast<uint32_t>(size), address, tag);
+  block.heap_id_ = heap_id;
+  uint32_t index = compressed_blocks_.append(block);
 
-  live_blocks_[std::make_pair(address, heap_id)] = heap_blocks_.size() - 1;
+  recordHeapId(heap_id);
+  live_blocks[address] = { index, block.size_, current_tick_, tag };
+  ++live_block_count_;
+  live_bytes_ += size;
+  recordFragmentationSample();
 
   global_area_.maximum_address_ =
       std::max(address + size, global_area_.maximum_address_);
   global_area_.minimum_address_ =
       std::min(address, global_area_.minimum_address_);
   // Make room for 5% more on the right hand side.
-  global_area_.maximum_tick_ =
-      (static_cast<double>(current_tick_) * 1.05) + 1.0;
+  global_area_.maximum_tick_ = current_tick_ + (current_tick_ / 20) + 1;
   global_area_.minimum_tick_ = 0;
 }
 
 void HeapHistory::recordFree(uint64_t address, const std::string *tag,
                              uint8_t heap_id) {
-  // Any event has to clear the sorted HeapBlock cache.
   ++current_tick_;
   if (isEventFiltered(address)) {
     return;
   }
-  auto current_block =
-      live_blocks_.find(std::make_pair(address, heap_id));
-  if (current_block == live_blocks_.end()) {
+  std::map<uint64_t, LiveBlock> &live_blocks = live_blocks_[heap_id];
+  auto current_block = live_blocks.find(address);
+  if (current_block == live_blocks.end()) {
     recordFreeConflict(address, heap_id);
     return;
   }
-  size_t index = current_block->second;
-  heap_blocks_[index].end_tick_ = current_tick_;
-  heap_blocks_[index].free_tag_ = tag;
-  live_blocks_.erase(current_block);
+  compressed_blocks_.free(current_block->second.index_, current_tick_, tag);
+  --live_block_count_;
+  live_bytes_ -= current_block->second.size_;
+  live_blocks.erase(current_block);
+  recordFragmentationSample();
 
   // Set the max tick 5% higher than strictly necessary.
-  global_area_.maximum_tick_ =
-      (static_cast<double>(current_tick_) * 1.05) + 1.0;
+  global_area_.maximum_tick_ = current_tick_ + (current_tick_ / 20) + 1;
 }
 
 void HeapHistory::recordFreeRange(uint64_t low_end, uint64_t high_end,
                                   const std::string *tag, uint8_t heap_id) {
-  // Find the lower boundary.
-  auto start_block =
-      live_blocks_.lower_bound(std::make_pair(low_end, heap_id));
-  auto end_block =
-      live_blocks_.upper_bound(std::make_pair(high_end, heap_id));
-  std::vector<std::pair<uint64_t, uint8_t>> blocks_to_free;
-
-  while ((start_block != end_block) && (start_block != live_blocks_.end())) {
-    uint64_t block_address = start_block->first.first;
-    uint8_t block_heap_id = start_block->first.second;
-    // We cannot call recordFree inside the loop because modifying the
-    // live_block_ map would invalidate our
-    // iterators.
-    if ((block_heap_id == heap_id) && (block_address >= low_end) &&
-        (block_address <= high_end)) {
-      blocks_to_free.emplace_back(block_address, heap_id);
+  // Only the blocks of the given heap are freed.
+  const std::map<uint64_t, LiveBlock> &live_blocks = live_blocks_[heap_id];
+  auto start_block = live_blocks.lower_bound(low_end);
+  auto end_block = live_blocks.upper_bound(high_end);
+  std::vector<uint64_t> blocks_to_free;
+
+  // We cannot call recordFree inside the loop because modifying the
+  // live_block_ map would invalidate our iterators.
+  for (; start_block != end_block; ++start_block) {
+    blocks_to_free.push_back(start_block->first);
+  }
+  for (uint64_t block_address : blocks_to_free) {
+    recordFree(block_address, tag, heap_id);
+  }
+}
+
+void HeapHistory::recordFragmentationSample() {
+  // The live maps are ordered by address, so the span is available in O(1)
+  // per heap.
+  uint64_t lowest = std::numeric_limits<uint64_t>::max();
+  uint64_t highest = 0;
+  for (uint8_t heap_id : heap_ids_) {
+    const std::map<uint64_t, LiveBlock> &live_blocks = live_blocks_[heap_id];
+    if (!live_blocks.empty()) {
+      const auto &last = *live_blocks.rbegin();
+      lowest = std::min(lowest, live_blocks.begin()->first);
+      highest = std::max(highest, last.first + last.second.size_);
     }
-    ++start_block;
   }
-  for (const auto &block : blocks_to_free) {
-    recordFree(block.first, tag, block.second);
+  uint64_t span = (highest > lowest) ? highest - lowest : 0;
+  fragmentation_timeline_.recordEvent(current_tick_, live_bytes_,
+    live_block_count_, span);
+}
+
+void HeapHistory::recordHeapId(uint8_t heap_id) {
+  auto position = std::lower_bound(heap_ids_.begin(), heap_ids_.end(),
+    heap_id);
+  if ((position == heap_ids_.end()) || (*position != heap_id)) {
+    heap_ids_.insert(position, heap_id);
   }
 }
 
@@ -244,11 +402,9 @@ void HeapHistory::recordMallocConflict(uint64_t address, size_t size,
 void HeapHistory::recordRealloc(uint64_t old_address, uint64_t new_address,
                                 size_t size, uint8_t heap_id) {
   // How should realloc relations be visualized?
-  auto ret = alloc_or_free_tags_.insert("Free'd on reallocation");
-  recordFree(old_address, &*(ret.first), heap_id);
+  recordFree(old_address, tags_.intern("Free'd on reallocation"), heap_id);
   // Should the address perhaps be remembered here?
-  ret = alloc_or_free_tags_.insert("Reallocated block");
-  recordMalloc(new_address, size, &*(ret.first), heap_id);
+  recordMalloc(new_address, size, tags_.intern("Reallocated block"), heap_id);
 }
 
 void HeapHistory::recordEvent(const std::string &event_label,
@@ -314,10 +470,6 @@ void HeapHistory::getActiveRegions(std::map<uint64_t, uint64_t>* regions,
   long double minimum_size = ((1.0/3.0) / yscaling);
   auto uint_minsize = static_cast<uint64_t>(minimum_size);
 
-  printf("YScaling is %Le, XScaling is %Le\n", current_window_.getYScalingHeapToScreen(),
-    current_window_.getXScalingHeapToScreen());
-  fflush(stdout);
-
   const std::map<uint64_t, uint64_t>* current_regions =
     active_region_cache_.getActiveRegions(uint_minsize, out_size);
   *regions = *current_regions;
@@ -331,179 +483,458 @@ void HeapHistory::activeRegionsToVertices(std::vector<HeapVertex> *vertices)
   uint64_t region_size;
   // Determine the correct active regions on this zoom level.
   getActiveRegions(&address_ranges, &region_size);
-  printf("Got %" PRIu64 " ranges at granularity %" PRIx64 "\n", uint64_t(address_ranges.size()),
-    region_size);
 
   QVector3D color = QVector3D(0.0f, 0.7f, 0.0f);
-  uint32_t lower_left_x = 0; // Minimum Tick.
-  uint32_t lower_right_x = getMaximumTick();
+  uint64_t lower_left_x = 0; // Minimum Tick.
+  uint64_t lower_right_x = getMaximumTick();
   for (std::pair<uint64_t, uint64_t> range : address_ranges) {
     uint64_t lower_left_y = range.first;
     uint64_t lower_right_y = lower_left_y;
-    uint32_t upper_right_x = lower_right_x;
+    uint64_t upper_right_x = lower_right_x;
     uint64_t upper_right_y = range.second;
-    uint32_t upper_left_x = lower_left_x;
+    uint64_t upper_left_x = lower_left_x;
     uint64_t upper_left_y = upper_right_y;
 
     vertices->push_back(HeapVertex(lower_left_x, lower_left_y, color));
     vertices->push_back(HeapVertex(lower_right_x, lower_right_y, color));
-    vertices->push_back(HeapVertex(upper_left_x, upper_left_y, color));
-    vertices->push_back(HeapVertex(lower_right_x, lower_right_y, color));
     vertices->push_back(
       HeapVertex(upper_right_x, upper_right_y, color));
     vertices->push_back(HeapVertex(upper_left_x, upper_left_y, color));
   }
 }
 
-// Write out 6 vertices (for two triangles) into the buffer.
-void HeapHistory::HeapBlockToVertices(const HeapBlock &block,
-                                      std::vector<HeapVertex> *vertices) const {
+// Draws the min/max-decimated fragmentation timeline for the visible ticks as
+// lines. The y coordinate of each vertex holds the value scaled to
+// [0, chart_resolution]; the chart shader places it at the bottom of the
+// screen.
+void HeapHistory::fragmentationChartToVertices(
+  std::vector<HeapVertex> *vertices) const {
+  static constexpr uint32_t chart_columns = 2048;
+  static constexpr uint64_t chart_resolution = 0xFFFF;
+  static const QVector3D colors[FragmentationTimeline::NumberOfMetrics] = {
+    QVector3D(0.0f, 0.0f, 0.8f), QVector3D(0.0f, 0.6f, 0.0f),
+    QVector3D(0.6f, 0.6f, 0.6f), QVector3D(0.8f, 0.0f, 0.0f) };
+
+  uint64_t low_tick = current_window_.getMinimumTickUint64();
+  uint64_t high_tick = current_window_.getMaximumTickUint64();
+  std::vector<TimelineColumn> columns;
+  for (int index = 0; index < FragmentationTimeline::NumberOfMetrics;
+    ++index) {
+    auto metric = static_cast<FragmentationTimeline::Metric>(index);
+    // The fragmentation is a ratio, all other series are scaled to their
+    // maximum.
+    uint64_t scale = (metric == FragmentationTimeline::Fragmentation) ?
+      FragmentationTimeline::fragmentation_scale :
+      fragmentation_timeline_.getGlobalMaximum(metric);
+    if (scale == 0) {
+      continue;
+    }
+    auto toChart = [scale](uint64_t value) {
+      return static_cast<uint64_t>(static_cast<long double>(value) /
+        scale * chart_resolution);
+    };
+    columns.clear();
+    fragmentation_timeline_.getDecimated(metric, low_tick, high_tick + 1,
+      chart_columns, &columns);
+    const QVector3D& color = colors[index];
+    for (size_t column = 0; column < columns.size(); ++column) {
+      const TimelineColumn& current = columns[column];
+      vertices->push_back(HeapVertex(current.tick_,
+        toChart(current.minimum_), color));
+      vertices->push_back(HeapVertex(current.tick_,
+        toChart(current.maximum_), color));
+      if (column == 0) {
+        continue;
+      }
+      // Connect to the previous column through the closest values.
+      const TimelineColumn& previous = columns[column - 1];
+      uint64_t from, to;
+      if (current.minimum_ > previous.maximum_) {
+        from = previous.maximum_;
+        to = current.minimum_;
+      } else if (current.maximum_ < previous.minimum_) {
+        from = previous.minimum_;
+        to = current.maximum_;
+      } else {
+        from = to = std::max(previous.minimum_, current.minimum_);
+      }
+      vertices->push_back(HeapVertex(previous.tick_, toChart(from), color));
+      vertices->push_back(HeapVertex(current.tick_, toChart(to), color));
+    }
+  }
+}
+
+// Draws a stacked area chart of the live bytes of the largest tags (and all
+// other tags combined) for the visible ticks, using the same y encoding as the
+// fragmentation chart. Each column shows the average over its ticks.
+void HeapHistory::tagChartToVertices(std::vector<HeapVertex> *vertices) const {
+  static constexpr uint32_t chart_columns = 512;
+  static constexpr size_t charted_tags = 15;
+  static constexpr uint64_t chart_resolution = 0xFFFF;
+  static const QVector3D colors[] = {
+    QVector3D(0.12f, 0.47f, 0.71f), QVector3D(1.0f, 0.5f, 0.05f),
+    QVector3D(0.17f, 0.63f, 0.17f), QVector3D(0.84f, 0.15f, 0.16f),
+    QVector3D(0.58f, 0.4f, 0.74f), QVector3D(0.55f, 0.34f, 0.29f),
+    QVector3D(0.89f, 0.47f, 0.76f), QVector3D(0.74f, 0.74f, 0.13f),
+    QVector3D(0.09f, 0.75f, 0.81f), QVector3D(0.68f, 0.78f, 0.91f),
+    QVector3D(1.0f, 0.73f, 0.47f), QVector3D(0.6f, 0.87f, 0.54f),
+    QVector3D(1.0f, 0.6f, 0.59f), QVector3D(0.77f, 0.69f, 0.84f),
+    QVector3D(0.77f, 0.61f, 0.58f), QVector3D(0.5f, 0.5f, 0.5f) };
+
+  const TagAggregateIndex& index = tag_aggregate_index_;
+  uint64_t scale = fragmentation_timeline_.getGlobalMaximum(
+    FragmentationTimeline::LiveBytes);
+  if ((scale == 0) || (index.getNumberOfTags() == 0)) {
+    return;
+  }
+  uint64_t low_tick = current_window_.getMinimumTickUint64();
+  uint64_t high_tick = std::min(current_window_.getMaximumTickUint64(),
+    current_tick_);
+  if (high_tick <= low_tick) {
+    return;
+  }
+  uint64_t column_width = std::max(index.getBucketWidth(),
+    (high_tick - low_tick + chart_columns - 1) / chart_columns);
+
+  // Cumulative (stacked) live bytes per column, updated tag by tag.
+  std::vector<uint64_t> ticks;
+  for (uint64_t tick = low_tick; tick <= high_tick; tick += column_width) {
+    ticks.push_back(tick);
+  }
+  std::vector<uint64_t> lower(ticks.size(), 0);
+  std::vector<uint64_t> upper(ticks.size(), 0);
+  const std::vector<uint32_t>& tags = index.getTagsBySize();
+  auto toChart = [scale](uint64_t value) {
+    return static_cast<uint64_t>(static_cast<long double>(value) / scale *
+      chart_resolution);
+  };
+  for (size_t rank = 0; rank <= charted_tags; ++rank) {
+    lower = upper;
+    // The last layer combines all remaining tags.
+    size_t first_tag = rank;
+    size_t last_tag = (rank == charted_tags) ? tags.size() : rank + 1;
+    if (first_tag >= tags.size()) {
+      break;
+    }
+    for (size_t column = 0; column < ticks.size(); ++column) {
+      for (size_t tag = first_tag; tag < last_tag; ++tag) {
+        upper[column] += index.getAverageLiveBytesBetween(tags[tag],
+          ticks[column], ticks[column] + column_width);
+      }
+    }
+    const QVector3D& color = colors[rank];
+    for (size_t column = 0; column + 1 < ticks.size(); ++column) {
+      HeapVertex lower_left(ticks[column], toChart(lower[column]), color);
+      HeapVertex lower_right(ticks[column + 1], toChart(lower[column + 1]),
+        color);
+      HeapVertex upper_left(ticks[column], toChart(upper[column]), color);
+      HeapVertex upper_right(ticks[column + 1], toChart(upper[column + 1]),
+        color);
+      vertices->push_back(lower_left);
+      vertices->push_back(lower_right);
+      vertices->push_back(upper_left);
+      vertices->push_back(lower_right);
+      vertices->push_back(upper_right);
+      vertices->push_back(upper_left);
+    }
+  }
+}
+
+void HeapHistory::blockToVertices(const HeapBlock &block,
+  std::vector<HeapVertex> *vertices) const {
   block.toVertices(current_tick_, vertices);
 }
 
-inline uint64_t HeapHistory::getMinimumBlockSize() const {
+void HeapHistory::blockToVertices(uint32_t index,
+  std::vector<HeapVertex> *vertices) const {
+  blockToVertices(getBlock(index), vertices);
+}
+
+uint64_t HeapHistory::getMinimumBlockSize() const {
   long double yscaling = current_window_.getYScalingHeapToScreen();
   long double minimum_size = ((1.0/1000.0) / yscaling);
   auto uint_min_size = static_cast<uint64_t>(minimum_size);
   return uint_min_size;
 }
 
-void HeapHistory::highlightBySize(uint32_t highlight_size) {
-  for (HeapBlock& block : heap_blocks_) {
-    block.highlighted_ = false;
-    if (block.size_ == highlight_size) {
-      block.highlighted_ = true;
+size_t HeapHistory::highlightBySize(uint32_t highlight_size) {
+  HighlightQuery query;
+  query.setSizeRange(highlight_size, highlight_size);
+  return highlight(query);
+}
+
+bool HeapHistory::highlightByQuery(const std::string& query,
+  std::string* error, size_t* count) {
+  HighlightQuery compiled;
+  if (!HighlightQuery::compile(query, tag_aggregate_index_, &compiled,
+    error)) {
+    return false;
+  }
+  *count = highlight(compiled);
+  return true;
+}
+
+size_t HeapHistory::highlight(const HighlightQuery& query) {
+  size_t count = query.evaluate(compressed_blocks_, current_tick_,
+    &highlight_bits_);
+  ++highlight_generation_;
+  return count;
+}
+
+size_t HeapHistory::highlightChangesBetween(uint64_t from_tick,
+  uint64_t to_tick) {
+  HeapDiff diff = diffBetweenTicks(from_tick, to_tick);
+  highlight_bits_.assign((compressed_blocks_.size() + 31) / 32, 0);
+  for (const std::vector<uint32_t>* changes :
+    { &diff.allocated_, &diff.freed_, &diff.transient_ }) {
+    for (uint32_t index : *changes) {
+      highlight_bits_[index / 32] |= 1u << (index % 32);
+    }
+  }
+  ++highlight_generation_;
+  return diff.numberOfChanges();
+}
+
+size_t HeapHistory::highlightReuseChain(uint32_t index) {
+  std::vector<uint32_t> chain;
+  highlight_bits_.assign((compressed_blocks_.size() + 31) / 32, 0);
+  getReuseChain(getBlock(index).address_, &chain);
+  for (uint32_t block : chain) {
+    highlight_bits_[block / 32] |= 1u << (block % 32);
+  }
+  ++highlight_generation_;
+  return chain.size();
+}
+
+// Parses a comma-separated list of heap IDs and ranges of heap IDs.
+bool HeapHistory::setVisibleHeaps(const std::string& heaps,
+  std::string* error) {
+  std::array<uint32_t, 8> visible = {};
+  size_t position = 0;
+  auto parseHeapId = [&](uint32_t* heap_id) {
+    while ((position < heaps.size()) && isspace(heaps[position])) {
+      ++position;
+    }
+    size_t start = position;
+    uint32_t value = 0;
+    while ((position < heaps.size()) && isdigit(heaps[position]) &&
+      (value <= std::numeric_limits<uint8_t>::max())) {
+      value = 10 * value + static_cast<uint32_t>(heaps[position] - '0');
+      ++position;
+    }
+    bool valid = (position > start) &&
+      (value <= std::numeric_limits<uint8_t>::max());
+    while ((position < heaps.size()) && isspace(heaps[position])) {
+      ++position;
+    }
+    *heap_id = value;
+    return valid;
+  };
+
+  if (heaps.find_first_not_of(" \t") == std::string::npos) {
+    visible.fill(std::numeric_limits<uint32_t>::max());
+  } else {
+    while (true) {
+      uint32_t first, last;
+      if (!parseHeapId(&first)) {
+        *error = "Expected a heap ID between 0 and 255 at position " +
+          std::to_string(position);
+        return false;
+      }
+      last = first;
+      if ((position < heaps.size()) && (heaps[position] == '-')) {
+        ++position;
+        if (!parseHeapId(&last) || (last < first)) {
+          *error = "Invalid heap range ending at position " +
+            std::to_string(position);
+          return false;
+        }
+      }
+      for (uint32_t heap_id = first; heap_id <= last; ++heap_id) {
+        visible[heap_id / 32] |= 1u << (heap_id % 32);
+      }
+      if (position == heaps.size()) {
+        break;
+      }
+      if (heaps[position] != ',') {
+        *error = "Expected ',' at position " + std::to_string(position);
+        return false;
+      }
+      ++position;
     }
   }
+  visible_heap_bits_ = visible;
+  ++highlight_generation_;
+  return true;
 }
 
 // Converts the vector of heap blocks in the current heap history to
 // heap vertices. Filters out elements that are too small to be rendered
 // or fall outside of the current screen, unless all is "true".
-size_t HeapHistory::heapBlockVerticesForActiveWindow(
-    std::vector<HeapVertex> *vertices, bool all) const {
-  uint64_t uint_min_size = getMinimumBlockSize();
-  uint64_t minimum_address = current_window_.getMinimumAddressUint64();
-  uint64_t maximum_address = current_window_.getMaximumAddressUint64();
-  uint64_t minimum_tick = current_window_.getMinimumTickUint32();
-  uint64_t maximum_tick = current_window_.getMaximumTickUint32();
-
-  size_t active_block_count = 0;
-  for (const auto & heap_block : heap_blocks_) {
-    bool active = isBlockActive(heap_block, uint_min_size, minimum_address,
-      maximum_address, minimum_tick, maximum_tick) || all;
-
-    if (active) {
-      HeapBlockToVertices(heap_block, vertices);
-      ++active_block_count;
+//
+// Streams over the compressed block store, and skips chunks whose ranges
+// show that none of their blocks can be visible without decoding them.
+// Calls |visit| with the index and the block of every block that passes
+// isBlockActive (or of every block if |all| is set), in index order.
+template <typename Visitor>
+void HeapHistory::forEachActiveBlock(uint64_t min_size, uint64_t min_address,
+  uint64_t max_address, uint64_t min_tick, uint64_t max_tick, bool all,
+  Visitor visit) const {
+  CompressedBlockStore::DecodedChunk chunk;
+  for (size_t number = 0; number < compressed_blocks_.getNumberOfChunks();
+    ++number) {
+    if (!all && !compressed_blocks_.chunkMayBeActive(number, min_size,
+      min_address, max_address, min_tick, max_tick)) {
+      continue;
+    }
+    compressed_blocks_.decodeChunk(number, &chunk);
+    for (uint32_t offset = 0; offset < chunk.number_of_blocks_; ++offset) {
+      HeapBlock heap_block = chunk.getBlock(offset);
+      bool active = isBlockActive(heap_block, min_size, min_address,
+        max_address, min_tick, max_tick) || all;
+
+      if (active) {
+        visit(chunk.first_index_ + offset, heap_block);
+      }
     }
   }
+}
 
+size_t HeapHistory::heapBlockVerticesForActiveWindow(
+    std::vector<HeapVertex> *vertices, bool all,
+    std::vector<uint32_t> *block_indices,
+    std::vector<uint32_t> *heap_ids) const {
+  size_t active_block_count = 0;
+  forEachActiveBlock(getMinimumBlockSize(),
+    current_window_.getMinimumAddressUint64(),
+    current_window_.getMaximumAddressUint64(),
+    current_window_.getMinimumTickUint64(),
+    current_window_.getMaximumTickUint64(), all,
+    [&](uint32_t index, const HeapBlock& heap_block) {
+      blockToVertices(heap_block, vertices);
+      if (block_indices != nullptr) {
+        block_indices->push_back(index);
+      }
+      if (heap_ids != nullptr) {
+        heap_ids->push_back(heap_block.heap_id_);
+      }
+      ++active_block_count;
+    });
   return active_block_count;
 }
 
+void HeapHistory::getActiveBlockIndices(uint64_t min_size,
+  uint64_t min_address, uint64_t max_address, uint64_t min_tick,
+  uint64_t max_tick, std::vector<uint32_t> *indices) const {
+  forEachActiveBlock(min_size, min_address, max_address, min_tick, max_tick,
+    false, [indices](uint32_t index, const HeapBlock&) {
+      indices->push_back(index);
+    });
+}
+
+void HeapHistory::visitActiveBlocks(uint64_t min_size, uint64_t min_address,
+  uint64_t max_address, uint64_t min_tick, uint64_t max_tick,
+  const std::function<void(uint32_t, const HeapBlock&)>& visit) const {
+  forEachActiveBlock(min_size, min_address, max_address, min_tick, max_tick,
+    false, visit);
+}
+
 
-bool HeapHistory::getEventAtTick(uint32_t tick, std::string *eventstring) {
+bool HeapHistory::getEventAtTick(uint64_t tick,
+  std::string *eventstring) const {
   const auto iterator = tick_to_event_strings_.find(tick);
   if (iterator == tick_to_event_strings_.end()) {
     // Try an approximate search.
-    auto iterator_approx = tick_to_event_strings_.lower_bound(tick-300);
-    uint32_t minimum = std::numeric_limits<uint32_t>::max();
+    auto iterator_approx = tick_to_event_strings_.lower_bound(
+      (tick > 300) ? tick - 300 : 0);
+    uint64_t minimum = std::numeric_limits<uint64_t>::max();
 
     while ((iterator_approx != tick_to_event_strings_.end() &&
-           (abs(static_cast<int32_t>(iterator_approx->first - tick)) < 300))) {
+           (iterator_approx->first < tick + 300))) {
 
-      uint32_t distance = abs(static_cast<int32_t>(iterator_approx->first - tick));
+      uint64_t distance = (iterator_approx->first > tick) ?
+        iterator_approx->first - tick : tick - iterator_approx->first;
       if (distance <= minimum) {
         minimum = distance;
         *eventstring = iterator_approx->second.second;
       }
       ++iterator_approx;
     }
-    return minimum != std::numeric_limits<uint32_t>::max();
+    return minimum != std::numeric_limits<uint64_t>::max();
   } else {
     *eventstring = iterator->second.second;
     return true;
   }
 }
 
+void HeapHistory::getLiveBlocksAtTick(uint64_t tick,
+  std::vector<uint32_t>* indices) const {
+  live_set_checkpoints_.getLiveBlocksAtTick(tick, indices);
+}
+
+void HeapHistory::getFreeGapsAtTick(uint64_t tick, uint64_t minimum_size,
+  uint64_t low, uint64_t high,
+  std::vector<std::pair<uint64_t, uint64_t>>* gaps) {
+  free_gap_index_.getFreeGapsAtTick(tick, minimum_size, low, high, gaps);
+}
+
+HeapDiff HeapHistory::diffBetweenTicks(uint64_t from_tick, uint64_t to_tick,
+  bool include_survivors) const {
+  return HeapDiff(live_set_checkpoints_, &compressed_blocks_, from_tick,
+    to_tick, include_survivors);
+}
 
 // Extremely slow O(n) version of testing if a given point lies within any
 // block.
-bool HeapHistory::getBlockAtSlow(uint64_t address, uint32_t tick,
-                                 HeapBlock *result, uint32_t *index) {
-  for (auto iter = heap_blocks_.begin();
-       iter != heap_blocks_.end(); ++iter) {
-    if (iter->contains(tick, address)) {
-      *result = *iter;
-      *index = iter - heap_blocks_.begin();
-      return true;
+bool HeapHistory::getBlockAtSlow(uint64_t address, uint64_t tick,
+                                 HeapBlock *result, uint32_t *index) const {
+  CompressedBlockStore::DecodedChunk chunk;
+  for (size_t number = 0; number < compressed_blocks_.getNumberOfChunks();
+       ++number) {
+    compressed_blocks_.decodeChunk(number, &chunk);
+    for (uint32_t offset = 0; offset < chunk.number_of_blocks_; ++offset) {
+      HeapBlock block = chunk.getBlock(offset);
+      if (block.contains(tick, address)) {
+        *result = block;
+        *index = chunk.first_index_ + offset;
+        return true;
+      }
     }
   }
   return false;
 }
 
-void HeapHistory::updateCachedSortedIterators() {
-  // Makes sure there is a sorted iterator array.
-  if (cached_blocks_sorted_by_address_.empty()) {
-    // Fill the iterator cache.
-    for (auto iter = heap_blocks_.begin();
-         iter != heap_blocks_.end(); ++iter) {
-      cached_blocks_sorted_by_address_.push_back(iter);
-    }
-    auto comparison = [](const std::vector<HeapBlock>::iterator &left,
-                         const std::vector<HeapBlock>::iterator &right) {
-      // Sort blocks in descending order by address, then tick.
-      return (left->address_ > right->address_) ||
-             (left->start_tick_ > right->start_tick_);
-    };
-    std::sort(cached_blocks_sorted_by_address_.begin(),
-              cached_blocks_sorted_by_address_.end(), comparison);
-  }
-}
-
 // Attempts to find a block on the heap at a given address and tick.
 // If successful, the provided pointer is filled, and an index into
-// the internal heap block vector is provided (this is useful for
-// calculating vertex ranges).
-//
-// XXX: This code is still buggy, and does not seem to find all blocks.
-// TODO(thomasdullien): Debug and fix.
-bool HeapHistory::getBlockAt(uint64_t address, uint32_t tick, HeapBlock *result,
-                             uint32_t *index) {
-  updateCachedSortedIterators();
-  std::pair<uint64_t, uint32_t> val(address, tick);
-
-  // Find the block whose lower left corner is the first (by address, then by
-  // tick, descending) to come after the requested point.
-  const std::vector<std::vector<HeapBlock>::iterator>::iterator candidate =
-      std::lower_bound(cached_blocks_sorted_by_address_.begin(),
-                       cached_blocks_sorted_by_address_.end(), val,
-                       [](const std::vector<HeapBlock>::iterator &iterator,
-                              const std::pair<uint64_t, uint32_t> &pair) {
-                         fflush(stdout);
-                         return (pair.first < iterator->address_) ||
-                                (pair.second < iterator->start_tick_);
-                       });
-  if (candidate == cached_blocks_sorted_by_address_.end()) {
-    return false;
-  }
-  // Check that the point lies within the candidate block.
-  auto block = *candidate;
-  if ((address > (block->address_ + block->size_)) ||
-      (address < block->address_) || (tick > block->end_tick_) ||
-      (tick < block->start_tick_)) {
-    return false;
+// the block store is provided (this is useful for calculating vertex
+// ranges). Only the chunks whose ranges contain the point are decoded.
+bool HeapHistory::getBlockAt(uint64_t address, uint64_t tick, HeapBlock *result,
+                             uint32_t *index) const {
+  CompressedBlockStore::DecodedChunk chunk;
+  for (size_t number = 0; number < compressed_blocks_.getNumberOfChunks();
+       ++number) {
+    if (!compressed_blocks_.chunkMayBeActive(number, 0, address, address,
+        tick, tick)) {
+      continue;
+    }
+    compressed_blocks_.decodeChunk(number, &chunk);
+    for (uint32_t offset = 0; offset < chunk.number_of_blocks_; ++offset) {
+      HeapBlock block = chunk.getBlock(offset);
+      if (block.contains(tick, address)) {
+        *result = block;
+        *index = chunk.first_index_ + offset;
+        return true;
+      }
+    }
   }
-  *result = *block;
-  *index = *candidate - heap_blocks_.begin();
-  return true;
+  return false;
 }
 
 // Provided a displacement (percentage of size of the current window in x and y
 // direction), pan the window accordingly.
 void HeapHistory::panCurrentWindow(double dx, double dy) {
   current_window_.pan(dx, dy);
+  ++window_generation_;
 }
 
 // Zoom toward a given point on the screen. The point is given in relative
@@ -513,5 +944,6 @@ void HeapHistory::zoomToPoint(double dx, double dy, double how_much_x,
                               long double max_width) {
   current_window_.zoomToPoint(dx, dy, how_much_x, how_much_y, max_height,
                               max_width);
+  ++window_generation_;
 }
 
@@ -1,10 +1,11 @@
 #ifndef HEAPHISTORY_H
 #define HEAPHISTORY_H
 
+#include <array>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <map>
-#include <set>
 #include <vector>
 
 #include <QVector3D>
@@ -12,15 +13,28 @@
 #include "json.hpp"
 
 #include "activeregioncache.h"
+#include "addressreuseindex.h"
+#include "compressedblockstore.h"
 #include "displayheapwindow.h"
+#include "fragmentationtimeline.h"
+#include "freegapindex.h"
+#include "heapdiff.h"
 #include "heapblock.h"
 #include "heapwindow.h"
+#include "highlightquery.h"
+#include "livesetcheckpoints.h"
+#include "pagefile.h"
+#include "tagaggregateindex.h"
+#include "tagtable.h"
+#include "traceevent.h"
+#include "traceindex.h"
+#include "traceshardmerger.h"
 #include "vertex.h"
 
 class HeapConflict {
 public:
-  HeapConflict(uint32_t tick, uint64_t address, bool alloc);
-  uint32_t tick_;
+  HeapConflict(uint64_t tick, uint64_t address, bool alloc);
+  uint64_t tick_;
   uint64_t address_;
   bool allocation_or_free_;
 };
@@ -29,17 +43,49 @@ class HeapHistory {
 public:
   HeapHistory();
   void setCurrentWindow(const HeapWindow &new_window);
-  void setCurrentWindowToGlobal() { current_window_.reset(global_area_); }
+  void setCurrentWindowToGlobal() {
+    current_window_.reset(global_area_);
+    ++window_generation_;
+  }
 
   const DisplayHeapWindow &getCurrentWindow() const {
     return current_window_;
   }
 
-  // Read and parse a JSON stream.
-  void LoadFromJSONStream(std::istream &jsondata);
+  // Read and parse a JSON stream, either a single array or one element per
+  // line. The latter is parsed on all cores. If |index| is given, a seekable index of
+  // the trace is written to it along the way (see traceindex.h).
+  void LoadFromJSONStream(std::istream &jsondata,
+                          TraceIndexWriter *index = nullptr);
+  // Loads only the ticks up to |last_tick|, starting at the last index
+  // checkpoint at or before |first_tick|. The blocks alive at the checkpoint
+  // keep their original allocation ticks. Returns false, without loading
+  // anything, if the index cannot be read.
+  bool LoadTickRangeFromJSONStream(std::istream &jsondata,
+                                   std::istream &index_data,
+                                   uint64_t first_tick, uint64_t last_tick);
+  // Reads one trace per shard (e.g. per thread of the traced program), and
+  // records the events of all shards in the order of their "timestamp"
+  // fields. See TraceShardMerger.
+  void LoadFromTraceShards(const std::vector<std::istream *> &shards);
+
+  // If |page_file| is not empty, the blocks and the indexes that grow with
+  // the number of blocks are paged out to a new file there (see
+  // PageFile::open), and at most |cache_budget| bytes of them are kept in
+  // memory. Should be called before
+  // LoadFromJSONStream, so that the blocks go to the file while they are
+  // recorded; a later call moves them there after the fact.
+  void setBlockPaging(const std::string& page_file, size_t cache_budget) {
+    if (!page_file.empty()) {
+      page_file_.open(page_file, cache_budget);
+    }
+  }
+  // The pages of the blocks and of the indexes.
+  const PageFile& getPageFile() const { return page_file_; }
 
   // Record a memory allocation event. The code supports up to 256 different
-  // heaps.
+  // heaps, each with its own set of live blocks, so the same address can be
+  // live on several heaps at once.
   void recordMalloc(uint64_t address, size_t size, const std::string* alloc_tag, uint8_t heap_id = 0);
   void recordFree(uint64_t address, const std::string* tag, uint8_t heap_id = 0);
   void recordRealloc(uint64_t old_address, uint64_t new_address, size_t size,
@@ -47,43 +93,168 @@ public:
   void recordEvent(const std::string& event_label, const std::string& color);
   void recordAddress(uint64_t address, const std::string& label, const std::string& color);
 
-  // Attempts to find a block at a given address and tick. Currently broken,
-  // hence the two implementations (slow works).
-  // TODO(thomasdullien): Debug and fix the fast version.
-  bool getBlockAt(uint64_t address, uint32_t tick, HeapBlock *result,
-                  uint32_t *index);
-  bool getBlockAtSlow(uint64_t address, uint32_t tick, HeapBlock *result,
-                      uint32_t *index);
-  bool getEventAtTick(uint32_t tick, std::string* eventstring);
+  // Attempts to find a block at a given address and tick. Both versions
+  // return the block with the lowest index; the slow one decodes every chunk,
+  // the fast one skips the chunks that cannot contain the point.
+  bool getBlockAt(uint64_t address, uint64_t tick, HeapBlock *result,
+                  uint32_t *index) const;
+  bool getBlockAtSlow(uint64_t address, uint64_t tick, HeapBlock *result,
+                      uint32_t *index) const;
+  bool getEventAtTick(uint64_t tick, std::string* eventstring) const;
+
+  // Fills |indices| with the indices of all blocks that were alive at the
+  // given tick, in order of allocation. Uses the live set checkpoints, so the
+  // cost does not depend on the total number of blocks in the history.
+  void getLiveBlocksAtTick(uint64_t tick, std::vector<uint32_t>* indices) const;
+  // Decodes a single block. Use visitActiveBlocks for more than a handful.
+  HeapBlock getBlock(uint32_t index) const {
+    return compressed_blocks_.getBlock(index);
+  }
+  size_t getNumberOfBlocks() const { return compressed_blocks_.size(); }
+
+  // Fills |gaps| with all free intervals [start, end) of at least
+  // |minimum_size| bytes within the address range [low, high] at the given
+  // tick. Memory outside of the range of recorded addresses is not counted.
+  void getFreeGapsAtTick(uint64_t tick, uint64_t minimum_size, uint64_t low,
+    uint64_t high, std::vector<std::pair<uint64_t, uint64_t>>* gaps);
+  const std::vector<uint64_t>& getLargestFreeGapCurve() const {
+    return free_gap_index_.getLargestGapCurve();
+  }
+  uint64_t getLargestFreeGapCurveBucketWidth() const {
+    return free_gap_index_.getCurveBucketWidth();
+  }
+
+  // Per-bucket live bytes, live blocks, address span and fragmentation,
+  // collected while the events are recorded.
+  const FragmentationTimeline& getFragmentationTimeline() const {
+    return fragmentation_timeline_;
+  }
+
+  const TagTable& getTags() const { return tags_; }
+
+  // Per-tag prefix sums of allocated and freed bytes.
+  const TagAggregateIndex& getTagAggregateIndex() const {
+    return tag_aggregate_index_;
+  }
+
+  // Fills |chain| with the indices of all blocks that were ever allocated
+  // at |address|, in tick order.
+  bool getReuseChain(uint64_t address, std::vector<uint32_t>* chain) const {
+    return address_reuse_index_.getChain(address, chain);
+  }
+
+  // Computes which blocks were allocated and freed between two ticks.
+  HeapDiff diffBetweenTicks(uint64_t from_tick, uint64_t to_tick,
+    bool include_survivors = false) const;
+
+  // The IDs of all heaps that blocks were allocated on, in ascending order.
+  const std::vector<uint8_t>& getHeapIds() const { return heap_ids_; }
 
   uint64_t getMinimumAddress() const { return global_area_.minimum_address_; }
   uint64_t getMaximumAddress() const { return global_area_.maximum_address_; }
-  uint32_t getMinimumTick() const { return global_area_.minimum_tick_; }
-  uint32_t getMaximumTick() const { return global_area_.maximum_tick_; }
-
-  // Dump out triangles for the current window of heap events.
-  size_t heapBlockVerticesForActiveWindow(std::vector<HeapVertex> *vertices, bool all=false) const;
+  uint64_t getMinimumTick() const { return global_area_.minimum_tick_; }
+  uint64_t getMaximumTick() const { return global_area_.maximum_tick_; }
+
+  // Dump out quads for the current window of heap events.
+  // If |block_indices| is given, the index of every block that was written
+  // out is appended to it, in the order of the vertices; likewise the heap
+  // ID of every block to |heap_ids|.
+  size_t heapBlockVerticesForActiveWindow(std::vector<HeapVertex> *vertices,
+    bool all=false, std::vector<uint32_t> *block_indices = nullptr,
+    std::vector<uint32_t> *heap_ids = nullptr) const;
+  // Appends the index of every block of at least |min_size| bytes that
+  // touches the given (inclusive) ranges to |indices|, in index order.
+  void getActiveBlockIndices(uint64_t min_size, uint64_t min_address,
+    uint64_t max_address, uint64_t min_tick, uint64_t max_tick,
+    std::vector<uint32_t> *indices) const;
+  // Calls |visit| with the index and the block of the same blocks.
+  void visitActiveBlocks(uint64_t min_size, uint64_t min_address,
+    uint64_t max_address, uint64_t min_tick, uint64_t max_tick,
+    const std::function<void(uint32_t, const HeapBlock&)>& visit) const;
+  bool isBlockActive(const HeapBlock &block,
+    uint64_t min_size, uint64_t min_address, uint64_t max_address,
+    uint64_t min_tick, uint64_t max_tick) const;
+  // Return the minimum size a block needs to have to be visible on screen.
+  uint64_t getMinimumBlockSize() const;
+  // Dumps the 4 vertices of the quad for block |index|.
+  void blockToVertices(uint32_t index, std::vector<HeapVertex> *vertices) const;
+  void blockToVertices(const HeapBlock &block,
+    std::vector<HeapVertex> *vertices) const;
   void eventsToVertices(std::vector<HeapVertex> *vertices) const;
   void addressesToVertices(std::vector<HeapVertex> *vertices) const;
   void activeRegionsToVertices(std::vector<HeapVertex> *vertices) const;
+  void fragmentationChartToVertices(std::vector<HeapVertex> *vertices) const;
+  void tagChartToVertices(std::vector<HeapVertex> *vertices) const;
+
+  // Incremented whenever the current window moves, and whenever a trace is
+  // loaded, respectively.
+  uint32_t getWindowGeneration() const { return window_generation_; }
+  uint32_t getDataGeneration() const { return data_generation_; }
+  // Changes whenever anything that is drawn changes: the window, the
+  // highlights or the data. Since the generations only ever grow, so does
+  // their sum.
+  uint64_t getViewGeneration() const {
+    return static_cast<uint64_t>(window_generation_) + data_generation_ +
+      highlight_generation_;
+  }
 
   // Functions for moving the currently visible window around.
   void panCurrentWindow(double dx, double dy);
   void zoomToPoint(double dx, double dy, double how_much_x, double how_much_y,
     long double max_height, long double max_width);
 
-  // Functions for highlighting blocks.
-  void highlightBySize(uint32_t highlight_size);
+  // Functions for highlighting blocks. Highlighting only changes the
+  // highlight bitset (one bit per block), which the block shader reads, so
+  // no vertices need to be regenerated.
+  size_t highlightBySize(uint32_t highlight_size);
+  // Compiles and evaluates a highlight query (see highlightquery.h). Returns
+  // false and sets |error| if the query does not compile.
+  bool highlightByQuery(const std::string& query, std::string* error,
+    size_t* count);
+  size_t highlight(const HighlightQuery& query);
+  bool isHighlighted(uint32_t index) const {
+    return (index / 32 < highlight_bits_.size()) &&
+      ((highlight_bits_[index / 32] >> (index % 32)) & 1);
+  }
+  const std::vector<uint32_t>& getHighlightBits() const {
+    return highlight_bits_;
+  }
+  // Incremented whenever the highlight bitset or the visible heaps change.
+  uint32_t getHighlightGeneration() const { return highlight_generation_; }
+  // Highlights all blocks that were allocated or freed between the two ticks,
+  // returns the number of highlighted blocks.
+  size_t highlightChangesBetween(uint64_t from_tick, uint64_t to_tick);
+  // Highlights all blocks that occupied the address of the given block,
+  // returns the length of the chain.
+  size_t highlightReuseChain(uint32_t index);
+
+  // Shows only the heaps in |heaps|, a comma-separated list of heap IDs and
+  // ranges such as "0,2-5"; an empty list shows all heaps. Like highlights,
+  // this only changes a bitset that the block shader reads. Returns false
+  // and sets |error| if the list does not parse.
+  bool setVisibleHeaps(const std::string& heaps, std::string* error);
+  bool isHeapVisible(uint8_t heap_id) const {
+    return (visible_heap_bits_[heap_id / 32] >> (heap_id % 32)) & 1;
+  }
+  // One bit per heap ID, set if the heap is visible.
+  const std::array<uint32_t, 8>& getVisibleHeapBits() const {
+    return visible_heap_bits_;
+  }
 private:
   void recordMallocConflict(uint64_t address, size_t size, uint8_t heap_id);
   void recordFreeConflict(uint64_t address, uint8_t heap_id);
   void recordFreeRange(uint64_t low_end, uint64_t high_end, const std::string *tag, uint8_t heap_id);
   void recordFilterRange(uint64_t low, uint64_t high);
+  // Adds the current state of the live set to the fragmentation timeline.
+  void recordFragmentationSample();
+  // Adds |heap_id| to heap_ids_ if it is not in there yet.
+  void recordHeapId(uint8_t heap_id);
 
   bool isEventFiltered(uint64_t address);
-  bool isBlockActive(const HeapBlock &block,
-    uint64_t min_size, uint64_t min_address, uint64_t max_address,
-    uint64_t min_tick, uint64_t max_tick) const;
+  template <typename Visitor>
+  void forEachActiveBlock(uint64_t min_size, uint64_t min_address,
+    uint64_t max_address, uint64_t min_tick, uint64_t max_tick, bool all,
+    Visitor visit) const;
 
   // Returns coarse-grained intervals of regions of memory that see activity. The size
   // of these regions are byte-powers-of-two depending on the current zoom level, but
@@ -91,56 +262,99 @@ private:
   void getActiveRegions(std::map<uint64_t, uint64_t>* regions,
     uint64_t* out_size) const;
 
-  // Return the minimum size a block needs to have to be visible on screen.
-  inline uint64_t getMinimumBlockSize() const;
-
-  // Dumps 6 vertices for 2 triangles for a block into the output vector.
-  // TODO(thomasdullien): Optimize this to only dump 4 vertices.
-  void HeapBlockToVertices(const HeapBlock &block,
-    std::vector<HeapVertex> *vertices) const;
-
-  // When a new block has been put into the vector, this function needs to be
-  // called to update the internal data structures for fast block search.
-  void updateCachedSortedIterators();
-
-  static bool hasMandatoryJSONElementFields(const nlohmann::json &json_element);
 
-  std::vector<std::vector<HeapBlock>::iterator>
-      cached_blocks_sorted_by_address_;
+  // Records parsed trace events in order. Writes index checkpoints if
+  // |index| is given.
+  void recordTraceEvents(const TraceEventChunk &chunk,
+                         TraceIndexWriter *index = nullptr);
+  // |tags| caches the interned tags of the strings of |chunk|.
+  void recordTraceEvent(const TraceEvent &event, const TraceEventChunk &chunk,
+                        std::vector<const std::string *> *tags,
+                        TraceIndexWriter *index = nullptr);
+  // Builds the caches and indices once all elements have been recorded.
+  void finishLoading();
 
   // Running counter to keep track of heap events.
-  uint32_t current_tick_;
+  uint64_t current_tick_;
 
   // The currently active (visible, to-be-displayed) part of the heap history.
   DisplayHeapWindow current_window_;
+  uint32_t window_generation_ = 0;
+  uint32_t data_generation_ = 0;
 
   // The global size of all heap events.
   HeapWindow global_area_;
 
-  // The vector of all heap blocks. This vector will be sorted by the minimum
-  // tick of their allocation.
-  std::vector<HeapBlock> heap_blocks_;
+  // A block in live_blocks_: its index in the block store, and the fields
+  // that the index checkpoints and the fragmentation samples need.
+  struct LiveBlock {
+    uint32_t index_;
+    uint32_t size_;
+    uint64_t start_tick_;
+    const std::string* allocation_tag_;
+  };
 
-  // A map to keep track of blocks that are "currently live".
-  std::map<std::pair<uint64_t, uint8_t>, size_t> live_blocks_;
+  // Maps to keep track of blocks that are "currently live", one per heap,
+  // keyed by address.
+  std::array<std::map<uint64_t, LiveBlock>, 256> live_blocks_;
+
+  // The number and the sum of the sizes of all blocks in live_blocks_.
+  size_t live_block_count_ = 0;
+  uint64_t live_bytes_ = 0;
+
+  // The IDs of all heaps that blocks were allocated on, in ascending order.
+  std::vector<uint8_t> heap_ids_;
 
   // A vector of ticks that records the conflicts in heap logic.
   std::vector<HeapConflict> conflicts_;
 
   // A tick-to-color/string mapping for events.
-  std::map<uint32_t, std::pair<uint32_t, std::string>> tick_to_event_strings_;
+  std::map<uint64_t, std::pair<uint32_t, std::string>> tick_to_event_strings_;
 
   // An address-to-color/string mapping for horizontal lines.
   std::map<uint64_t, std::pair<uint32_t, std::string>> address_to_address_strings_;
 
-  std::set<std::string> alloc_or_free_tags_;
+  // The allocation and free tags of all blocks.
+  TagTable tags_;
 
   // Ranges of addresses to consider. If empty, consider everything.
   std::vector<std::pair<uint64_t, uint64_t>> filter_ranges_;
 
+  // The pages of the block store, the live set checkpoints and the address
+  // reuse index. Declared before them, so that it outlives their pages.
+  PageFile page_file_;
+
   // Cache for keeping regions with heap activity at different zoom levels.
   ActiveRegionCache active_region_cache_;
 
+  // Snapshots of the live set at regular tick intervals.
+  LiveSetCheckpoints live_set_checkpoints_;
+
+  // Free interval sweep for queries about holes in the heap.
+  FreeGapIndex free_gap_index_;
+
+  // Heap metrics over time, streamed from recordMalloc / recordFree.
+  FragmentationTimeline fragmentation_timeline_;
+
+  // Bytes allocated and freed per allocation tag over time.
+  TagAggregateIndex tag_aggregate_index_;
+
+  // All blocks allocated at each address, in tick order.
+  AddressReuseIndex address_reuse_index_;
+
+  // All heap blocks, sorted by the tick of their allocation. They are
+  // appended and freed as the events are recorded, and decoded chunk by
+  // chunk by the culling, the queries and the index builds.
+  CompressedBlockStore compressed_blocks_;
+
+  // One bit per block, set if the block is highlighted.
+  std::vector<uint32_t> highlight_bits_;
+  uint32_t highlight_generation_ = 0;
+
+  // One bit per heap ID, set if the blocks of the heap are drawn.
+  std::array<uint32_t, 8> visible_heap_bits_ = { 0xFFFFFFFF, 0xFFFFFFFF,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
+
   static uint32_t ColorStringToUint32(const std::string &color);
 };
 
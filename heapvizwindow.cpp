@@ -21,7 +21,7 @@ HeapVizWindow::HeapVizWindow(const std::string* inputfile,
     std::ifstream ifs(input_filename.toUtf8().constData(), std::fstream::in);
     if (ifs.fail()) {
       input_filename = QFileDialog::getOpenFileName(this, tr("Open Heap Log JSON"), "",
-        tr("JSON Files (*.json)"));
+        tr("JSON Files (*.json *.ndjson *.gz *.zst)"));
     } else {
       can_file_be_opened = true;
     }
@@ -30,7 +30,49 @@ HeapVizWindow::HeapVizWindow(const std::string* inputfile,
   emit setFileToDisplay(input_filename);
 }
 
-void HeapVizWindow::update() { printf("Update called"); }
+void HeapVizWindow::setBlockPaging(const std::string& page_file,
+                                   size_t cache_budget) {
+  ui->heap_diagram->setBlockPaging(page_file, cache_budget);
+}
+
+void HeapVizWindow::setTraceShards(const std::vector<std::string>& shards) {
+  ui->heap_diagram->setTraceShards(shards);
+}
+
+void HeapVizWindow::setTraceIndex(const std::string& index_file,
+                                  uint64_t first_tick, uint64_t last_tick) {
+  ui->heap_diagram->setTraceIndex(index_file, first_tick, last_tick);
+}
+
+void HeapVizWindow::setAllowNative64BitShaders(bool allow) {
+  ui->heap_diagram->setAllowNative64BitShaders(allow);
+}
+
+void HeapVizWindow::setTileRelativeVertices(bool use) {
+  ui->heap_diagram->setTileRelativeVertices(use);
+}
+
+void HeapVizWindow::setUseTileCache(bool use) {
+  ui->heap_diagram->setUseTileCache(use);
+}
+
+void HeapVizWindow::setUseGPUPicking(bool use) {
+  ui->heap_diagram->setUseGPUPicking(use);
+}
+
+void HeapVizWindow::setBenchmarkFrames(uint32_t frames) {
+  ui->heap_diagram->setBenchmarkFrames(frames);
+}
+
+void HeapVizWindow::setShowFrameHUD(bool show) {
+  ui->heap_diagram->setShowFrameHUD(show);
+}
+
+void HeapVizWindow::setFrameTraceFile(const std::string& trace_file) {
+  ui->heap_diagram->setFrameTraceFile(trace_file);
+}
+
+void HeapVizWindow::update() { QMainWindow::update(); }
 
 HeapVizWindow::~HeapVizWindow() { delete ui; }
 
@@ -58,3 +100,77 @@ void HeapVizWindow::on_actionHighlight_blocks_with_size_triggered()
 
   emit setSizeToHighlight(size);
 }
+
+void HeapVizWindow::on_actionHighlight_blocks_matching_query_triggered()
+{
+  bool ok = false;
+  QString query = QInputDialog::getText(this, tr("Specify the highlight query"),
+    tr("Query (e.g. size=16-64 tag=foo lifetime=1000- address=0x1000-0x2000 "
+       "alive)"), QLineEdit::Normal, QString(), &ok);
+  if (!ok) {
+    return;
+  }
+
+  emit setHighlightQuery(query);
+}
+
+void HeapVizWindow::on_actionHighlight_blocks_changed_between_ticks_triggered()
+{
+  bool ok_from = false;
+  bool ok_to = false;
+  uint64_t from_tick = QInputDialog::getText(this, tr("Specify the first tick"),
+    tr("From tick")).toULongLong(&ok_from);
+  uint64_t to_tick = QInputDialog::getText(this, tr("Specify the second tick"),
+    tr("To tick")).toULongLong(&ok_to);
+  if (!ok_from || !ok_to) {
+    showMessage("Invalid tick range.");
+    return;
+  }
+
+  emit setTicksToDiff(from_tick, to_tick);
+}
+
+void HeapVizWindow::on_actionFind_free_gaps_at_tick_triggered()
+{
+  bool ok = false;
+  uint64_t tick = QInputDialog::getText(this, tr("Specify the tick"),
+    tr("Tick")).toULongLong(&ok);
+  if (!ok) {
+    showMessage("Invalid tick.");
+    return;
+  }
+  int size = QInputDialog::getInt(this, tr("Specify the minimum gap size"),
+    tr("Gap size"), 256, 1);
+
+  emit findFreeGaps(tick, size);
+}
+
+void HeapVizWindow::on_actionShow_bytes_held_by_tag_triggered()
+{
+  QString tag = QInputDialog::getText(this, tr("Specify the tag"), tr("Tag"));
+  bool ok_from = false;
+  bool ok_to = false;
+  uint64_t from_tick = QInputDialog::getText(this, tr("Specify the first tick"),
+    tr("From tick")).toULongLong(&ok_from);
+  uint64_t to_tick = QInputDialog::getText(this, tr("Specify the second tick"),
+    tr("To tick")).toULongLong(&ok_to);
+  if (!ok_from || !ok_to) {
+    showMessage("Invalid tick.");
+    return;
+  }
+
+  emit showBytesHeldByTag(tag, from_tick, to_tick);
+}
+
+void HeapVizWindow::on_actionShow_heaps_triggered()
+{
+  bool ok = false;
+  QString heaps = QInputDialog::getText(this, tr("Specify the heaps to show"),
+    tr("Heap IDs (e.g. 0,2-5, empty for all heaps)"), QLineEdit::Normal,
+    QString(), &ok);
+  if (!ok) {
+    return;
+  }
+
+  emit setVisibleHeaps(heaps);
+}
@@ -1,6 +1,9 @@
 #ifndef HEAPVIZWINDOW_H
 #define HEAPVIZWINDOW_H
 
+#include <string>
+#include <vector>
+
 #include <QMainWindow>
 #include <QKeyEvent>
 #include <QStatusBar>
@@ -19,12 +22,39 @@ public:
                          QWidget *parent = nullptr);
   ~HeapVizWindow() override;
 
+  // Pages the heap blocks out to a new file at |page_file| while the trace
+  // is loaded, see HeapHistory::setBlockPaging. Needs to be called before
+  // show().
+  void setBlockPaging(const std::string& page_file, size_t cache_budget);
+  // See GLHeapDiagram::setTraceShards. Needs to be called before show().
+  void setTraceShards(const std::vector<std::string>& shards);
+  // See GLHeapDiagram::setTraceIndex. Needs to be called before show().
+  void setTraceIndex(const std::string& index_file, uint64_t first_tick,
+                     uint64_t last_tick);
+  // See GLHeapDiagram::setAllowNative64BitShaders,
+  // GLHeapDiagram::setTileRelativeVertices, GLHeapDiagram::setUseTileCache,
+  // GLHeapDiagram::setUseGPUPicking, GLHeapDiagram::setBenchmarkFrames,
+  // GLHeapDiagram::setShowFrameHUD and GLHeapDiagram::setFrameTraceFile.
+  // Need to be called before show().
+  void setAllowNative64BitShaders(bool allow);
+  void setTileRelativeVertices(bool use);
+  void setUseTileCache(bool use);
+  void setUseGPUPicking(bool use);
+  void setBenchmarkFrames(uint32_t frames);
+  void setShowFrameHUD(bool show);
+  void setFrameTraceFile(const std::string& trace_file);
+
 protected:
   void keyPressEvent(QKeyEvent *e) override;
 
 signals:
   void setFileToDisplay(QString filename);
   void setSizeToHighlight(uint32_t size);
+  void setTicksToDiff(uint64_t from_tick, uint64_t to_tick);
+  void setHighlightQuery(QString query);
+  void findFreeGaps(uint64_t tick, uint32_t minimum_size);
+  void showBytesHeldByTag(QString tag, uint64_t from_tick, uint64_t to_tick);
+  void setVisibleHeaps(QString heaps);
 
 public slots:
   void blockClicked(bool, HeapBlock);
@@ -35,6 +65,11 @@ protected slots:
 
 private slots:
   void on_actionHighlight_blocks_with_size_triggered();
+  void on_actionHighlight_blocks_changed_between_ticks_triggered();
+  void on_actionHighlight_blocks_matching_query_triggered();
+  void on_actionFind_free_gaps_at_tick_triggered();
+  void on_actionShow_bytes_held_by_tag_triggered();
+  void on_actionShow_heaps_triggered();
 
 private :
   Ui::HeapVizWindow *ui;
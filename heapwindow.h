@@ -4,14 +4,14 @@
 
 class HeapWindow {
 public:
-  HeapWindow(uint64_t min, uint64_t max, uint32_t mintick, uint32_t maxtick);
+  HeapWindow(uint64_t min, uint64_t max, uint64_t mintick, uint64_t maxtick);
   uint64_t height() { return maximum_address_ - minimum_address_; }
-  uint32_t width() { return maximum_tick_ - minimum_tick_; }
+  uint64_t width() { return maximum_tick_ - minimum_tick_; }
   void reset(const HeapWindow &window) { *this = window; }
   uint64_t minimum_address_;
   uint64_t maximum_address_;
-  uint32_t minimum_tick_;
-  uint32_t maximum_tick_;
+  uint64_t minimum_tick_;
+  uint64_t maximum_tick_;
 };
 
 #endif // HEAPWINDOW_H
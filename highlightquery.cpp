@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <bitset>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+#include "highlightquery.h"
+
+// Ranges of blocks smaller than this are not worth a separate thread.
+static constexpr size_t minimum_blocks_per_thread = 1 << 16;
+
+bool HighlightQuery::parseNumber(const std::string& text, uint64_t* value) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  *value = strtoull(text.c_str(), &end, 0);
+  return *end == '\0';
+}
+
+// Parses "A", "A-B", "A-" or "-B". Omitted bounds are left unchanged.
+bool HighlightQuery::parseRange(const std::string& text, uint64_t* minimum,
+  uint64_t* maximum) {
+  size_t dash = text.find('-');
+  if (dash == std::string::npos) {
+    if (!parseNumber(text, minimum)) {
+      return false;
+    }
+    *maximum = *minimum;
+    return true;
+  }
+  std::string low = text.substr(0, dash);
+  std::string high = text.substr(dash + 1);
+  if (low.empty() && high.empty()) {
+    return false;
+  }
+  if (!low.empty() && !parseNumber(low, minimum)) {
+    return false;
+  }
+  if (!high.empty() && !parseNumber(high, maximum)) {
+    return false;
+  }
+  return *minimum <= *maximum;
+}
+
+bool HighlightQuery::compile(const std::string& text,
+  const TagAggregateIndex& tags, HighlightQuery* query, std::string* error) {
+  *query = HighlightQuery();
+  std::istringstream clauses(text);
+  std::string clause;
+  while (clauses >> clause) {
+    if (clause == "alive") {
+      query->alive_at_end_ = true;
+      continue;
+    }
+    size_t equals = clause.find('=');
+    std::string key = clause.substr(0, equals);
+    std::string value = (equals == std::string::npos) ? "" :
+      clause.substr(equals + 1);
+    bool ok = false;
+    if (key == "size") {
+      ok = parseRange(value, &query->minimum_size_, &query->maximum_size_);
+    } else if (key == "lifetime") {
+      ok = parseRange(value, &query->minimum_lifetime_,
+        &query->maximum_lifetime_);
+    } else if (key == "address") {
+      ok = parseRange(value, &query->minimum_address_,
+        &query->maximum_address_);
+    } else if (key == "tag") {
+      uint32_t tag;
+      ok = tags.getTagId(value, &tag);
+      if (ok) {
+        query->tags_.resize(tags.getNumberOfTags(), false);
+        query->tags_[tag] = true;
+      } else {
+        *error = "Unknown tag '" + value + "'";
+        return false;
+      }
+    }
+    if (!ok) {
+      *error = "Cannot parse '" + clause + "'";
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t HighlightQuery::evaluate(const CompressedBlockStore& blocks,
+  uint64_t maximum_tick, std::vector<uint32_t>* bits) const {
+  bits->assign((blocks.size() + 31) / 32, 0);
+
+  // Every chunk starts at a word boundary, so the threads never write to the
+  // same word.
+  size_t number_of_chunks = blocks.getNumberOfChunks();
+  size_t threads = std::max(std::min(
+    static_cast<size_t>(std::thread::hardware_concurrency()),
+    blocks.size() / minimum_blocks_per_thread), static_cast<size_t>(1));
+  size_t chunks_per_thread = (number_of_chunks + threads - 1) / threads;
+  std::vector<size_t> counts(threads, 0);
+  auto evaluateChunks = [&](size_t thread) {
+    CompressedBlockStore::DecodedChunk chunk;
+    size_t first_chunk = thread * chunks_per_thread;
+    size_t last_chunk = std::min(first_chunk + chunks_per_thread,
+      number_of_chunks);
+    for (size_t number = first_chunk; number < last_chunk; ++number) {
+      blocks.decodeChunk(number, &chunk);
+      uint32_t* words = bits->data() + chunk.first_index_ / 32;
+      for (uint32_t first = 0; first < chunk.number_of_blocks_; first += 32) {
+        uint32_t last = std::min(first + 32, chunk.number_of_blocks_);
+        uint32_t value = 0;
+        for (uint32_t offset = first; offset < last; ++offset) {
+          value |= static_cast<uint32_t>(matches(chunk, offset,
+            maximum_tick)) << (offset - first);
+        }
+        words[first / 32] = value;
+        counts[thread] += std::bitset<32>(value).count();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t thread = 1; thread < threads; ++thread) {
+    workers.emplace_back(evaluateChunks, thread);
+  }
+  evaluateChunks(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  size_t count = 0;
+  for (size_t thread_count : counts) {
+    count += thread_count;
+  }
+  return count;
+}
@@ -0,0 +1,80 @@
+#ifndef HIGHLIGHTQUERY_H
+#define HIGHLIGHTQUERY_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "tagaggregateindex.h"
+
+// A compiled predicate over heap blocks, used to decide which blocks get
+// highlighted. All conditions that are set have to hold for a block to match.
+//
+// Queries can be compiled from a string of space-separated clauses:
+//   size=64            blocks of exactly 64 bytes
+//   size=16-128        blocks of 16 to 128 bytes (inclusive)
+//   tag=name           blocks with the given allocation tag (repeat for "or")
+//   lifetime=1000-     blocks that lived at least 1000 ticks (either bound of
+//                      a range can be omitted)
+//   address=0x1000-0x2000
+//                      blocks that overlap the address range
+//   alive              blocks that were never freed
+// Numbers can be given in decimal or as hex with a 0x prefix.
+class HighlightQuery {
+public:
+  // Compiles |text| into |query|, resolving tag names through |tags|. Returns
+  // false and sets |error| if the text cannot be parsed.
+  static bool compile(const std::string& text, const TagAggregateIndex& tags,
+    HighlightQuery* query, std::string* error);
+
+  void setSizeRange(uint64_t minimum, uint64_t maximum) {
+    minimum_size_ = minimum;
+    maximum_size_ = maximum;
+  }
+
+  // Tests block |offset| of a decoded chunk.
+  bool matches(const CompressedBlockStore::DecodedChunk& chunk, size_t offset,
+    uint64_t maximum_tick) const {
+    uint64_t size = chunk.sizes_[offset];
+    uint64_t address = chunk.addresses_[offset];
+    uint64_t end_tick = chunk.end_ticks_[offset];
+    uint64_t tag = chunk.allocation_tags_[offset];
+    bool alive = (end_tick == std::numeric_limits<uint64_t>::max());
+    uint64_t lifetime = (alive ? maximum_tick : end_tick) -
+      chunk.start_ticks_[offset];
+    return (size >= minimum_size_) && (size <= maximum_size_) &&
+      (lifetime >= minimum_lifetime_) && (lifetime <= maximum_lifetime_) &&
+      (address <= maximum_address_) && (address + size > minimum_address_) &&
+      (alive || !alive_at_end_) &&
+      (tags_.empty() || ((tag < tags_.size()) && tags_[tag]));
+  }
+
+  // Evaluates the query for all blocks, and writes the result into |bits|
+  // (one bit per block, 32 blocks per word). The chunks of the store are
+  // decoded and evaluated on separate threads. Returns the number of
+  // matching blocks.
+  size_t evaluate(const CompressedBlockStore& blocks, uint64_t maximum_tick,
+    std::vector<uint32_t>* bits) const;
+
+private:
+  // Makes the test class a friend to permit testing private functions.
+  friend class TestHighlightQuery;
+
+  static bool parseNumber(const std::string& text, uint64_t* value);
+  static bool parseRange(const std::string& text, uint64_t* minimum,
+    uint64_t* maximum);
+
+  uint64_t minimum_size_ = 0;
+  uint64_t maximum_size_ = std::numeric_limits<uint64_t>::max();
+  uint64_t minimum_lifetime_ = 0;
+  uint64_t maximum_lifetime_ = std::numeric_limits<uint64_t>::max();
+  uint64_t minimum_address_ = 0;
+  uint64_t maximum_address_ = std::numeric_limits<uint64_t>::max();
+  bool alive_at_end_ = false;
+  // Indexed by tag ID, empty if any tag matches.
+  std::vector<bool> tags_;
+};
+
+#endif // HIGHLIGHTQUERY_H
@@ -0,0 +1,135 @@
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "heapblock.h"
+#include "hoverinspector.h"
+
+constexpr std::chrono::milliseconds HoverInspector::debounce_interval;
+
+HoverInspector::HoverInspector(const HeapHistory* history) :
+  history_(history) {
+  worker_ = std::thread(&HoverInspector::work, this);
+}
+
+HoverInspector::~HoverInspector() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    pending_ = false;
+  }
+  wake_worker_.notify_all();
+  worker_.join();
+}
+
+uint64_t HoverInspector::inspect(uint64_t tick, uint64_t address,
+  uint64_t minimum_size) {
+  uint64_t serial;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    serial = ++question_.serial_;
+    question_.tick_ = tick;
+    question_.address_ = address;
+    question_.minimum_size_ = minimum_size;
+    question_.picked_ = false;
+    pending_ = true;
+  }
+  wake_worker_.notify_all();
+  return serial;
+}
+
+uint64_t HoverInspector::inspectPicked(uint64_t tick, bool found,
+  uint32_t index) {
+  uint64_t serial;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    serial = ++question_.serial_;
+    question_.tick_ = tick;
+    question_.picked_ = true;
+    question_.found_ = found;
+    question_.index_ = index;
+    pending_ = true;
+  }
+  wake_worker_.notify_all();
+  return serial;
+}
+
+void HoverInspector::cancel() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_ = false;
+  wake_worker_.notify_all();
+  worker_idle_.wait(lock, [this]() { return !busy_; });
+}
+
+void HoverInspector::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_worker_.wait(lock, [this]() { return stop_ || pending_; });
+    // Wait until the mouse rested for the debounce interval.
+    uint64_t serial;
+    do {
+      serial = question_.serial_;
+      wake_worker_.wait_for(lock, debounce_interval, [this, serial]() {
+        return stop_ || !pending_ || (question_.serial_ != serial);
+      });
+    } while (!stop_ && pending_ && (question_.serial_ != serial));
+    if (stop_) {
+      return;
+    }
+    if (!pending_) {
+      continue;
+    }
+    Question question = question_;
+    pending_ = false;
+    busy_ = true;
+    lock.unlock();
+    std::string description = question.picked_ ?
+      describePicked(*history_, question.tick_, question.found_,
+        question.index_) :
+      describe(*history_, question.tick_, question.address_,
+        question.minimum_size_);
+    lock.lock();
+    busy_ = false;
+    worker_idle_.notify_all();
+    if (result_callback_) {
+      lock.unlock();
+      result_callback_(question.serial_, description);
+      lock.lock();
+    }
+  }
+}
+
+std::string HoverInspector::describe(const HeapHistory& history,
+  uint64_t tick, uint64_t address, uint64_t minimum_size) {
+  // Only the chunks of blocks around the point are decoded.
+  std::string description;
+  history.visitActiveBlocks(minimum_size, address, address, tick, tick,
+    [&](uint32_t, const HeapBlock& block) {
+      if (description.empty()) {
+        description = getBlockInformationAsString(block);
+      }
+    });
+  if (!description.empty()) {
+    return description;
+  }
+  return describeEvent(history, tick);
+}
+
+std::string HoverInspector::describePicked(const HeapHistory& history,
+  uint64_t tick, bool found, uint32_t index) {
+  if (found) {
+    return getBlockInformationAsString(history.getBlock(index));
+  }
+  return describeEvent(history, tick);
+}
+
+std::string HoverInspector::describeEvent(const HeapHistory& history,
+  uint64_t tick) {
+  std::string event;
+  if (history.getEventAtTick(tick, &event)) {
+    char buf[1024];
+    sprintf(buf, "Event at tick %16.16" PRIx64 ": ", tick);
+    return std::string(buf) + event;
+  }
+  return std::string();
+}
@@ -0,0 +1,87 @@
+#ifndef HOVERINSPECTOR_H
+#define HOVERINSPECTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "heaphistory.h"
+
+// Finds out what lies under the mouse for the hover tooltips, on a worker
+// thread, so that the search through the blocks never holds up drawing.
+//
+// Mouse moves come in much faster than anybody can read a tooltip, so only
+// the latest question is kept, and it is only answered once no newer one
+// arrived for debounce_interval. A question carries everything it needs from
+// the GUI thread (the point and the smallest drawn block size); the blocks
+// and events of the heap history do not change once a trace is loaded, and
+// cancel() keeps the worker away from them while a trace is loaded.
+class HoverInspector {
+public:
+  static constexpr std::chrono::milliseconds debounce_interval{ 40 };
+
+  explicit HoverInspector(const HeapHistory* history);
+  ~HoverInspector();
+
+  // Asks what lies at |tick| and |address|, replacing the question that is
+  // still pending. Blocks smaller than |minimum_size| are not drawn, so they
+  // are not found either. Returns the serial number of the question, which
+  // the result callback gets along with the answer.
+  uint64_t inspect(uint64_t tick, uint64_t address, uint64_t minimum_size);
+  // Like inspect, for a point at which the GPU picking found block |index|,
+  // or no block if |found| is false. The worker then only decodes that
+  // block, or only looks for an event.
+  uint64_t inspectPicked(uint64_t tick, bool found, uint32_t index);
+  // Drops the pending question and waits for the one that is being
+  // answered. Needs to be called before the heap history is loaded.
+  void cancel();
+  // Called on the worker thread with the serial number of the question and
+  // the description of what is there, which is empty if there is nothing.
+  void setResultCallback(
+    std::function<void(uint64_t, const std::string&)> callback) {
+    result_callback_ = std::move(callback);
+  }
+
+  // The hit test itself, on the calling thread: describes the block at
+  // |tick| and |address|, or else the event closest to |tick|.
+  static std::string describe(const HeapHistory& history, uint64_t tick,
+    uint64_t address, uint64_t minimum_size);
+  // Like describe, for the result of the GPU picking.
+  static std::string describePicked(const HeapHistory& history,
+    uint64_t tick, bool found, uint32_t index);
+
+private:
+  struct Question {
+    uint64_t serial_ = 0;
+    uint64_t tick_ = 0;
+    uint64_t address_ = 0;
+    uint64_t minimum_size_ = 0;
+    // Set if the GPU picking already found what is at the point.
+    bool picked_ = false;
+    bool found_ = false;
+    uint32_t index_ = 0;
+  };
+
+  static std::string describeEvent(const HeapHistory& history,
+    uint64_t tick);
+  void work();
+
+  const HeapHistory* history_;
+  std::function<void(uint64_t, const std::string&)> result_callback_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_worker_;
+  std::condition_variable worker_idle_;
+  Question question_;
+  bool pending_ = false;
+  bool busy_ = false;
+  bool stop_ = false;
+  std::thread worker_;
+};
+
+#endif // HOVERINSPECTOR_H
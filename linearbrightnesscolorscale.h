@@ -5,14 +5,14 @@
 
 class LinearBrightnessColorScale {
 public:
-  static std::pair<QVector3D, QVector3D> allocatedColorsFromTick(uint32_t allocation_tick, uint32_t maximum_tick);
-  static std::pair<QVector3D, QVector3D> freedColorsFromTick(uint32_t allocation_tick, uint32_t maximum_tick);
-  static std::pair<QVector3D, QVector3D> allocatedHighlightColorsFromTick(uint32_t allocation_tick, uint32_t maximum_tick);
-  static std::pair<QVector3D, QVector3D> freedHighlightColorsFromTick(uint32_t allocation_tick, uint32_t maximum_tick);
-  static std::pair<QVector3D, QVector3D> colorsFromTick(uint32_t allocation_tick, uint32_t end_tick, uint32_t maximum_tick);
-  static std::pair<QVector3D, QVector3D> highlightedColorsFromTick(uint32_t allocation_tick, uint32_t end_tick, uint32_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> allocatedColorsFromTick(uint64_t allocation_tick, uint64_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> freedColorsFromTick(uint64_t allocation_tick, uint64_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> allocatedHighlightColorsFromTick(uint64_t allocation_tick, uint64_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> freedHighlightColorsFromTick(uint64_t allocation_tick, uint64_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> colorsFromTick(uint64_t allocation_tick, uint64_t end_tick, uint64_t maximum_tick);
+  static std::pair<QVector3D, QVector3D> highlightedColorsFromTick(uint64_t allocation_tick, uint64_t end_tick, uint64_t maximum_tick);
 private:
-  static float colorHueScaled(uint32_t tick, uint32_t max_tick, float range_low, float range_high);
+  static float colorHueScaled(uint64_t tick, uint64_t max_tick, float range_low, float range_high);
 };
 
 #endif // LINEARBRIGHTNESSCOLORSCALE_H
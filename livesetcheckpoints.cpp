@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#include "livesetcheckpoints.h"
+#include "varint.h"
+
+// Aim for roughly this many checkpoints over the entire history; the interval
+// is never smaller than minimum_checkpoint_interval ticks so that small traces
+// do not end up with a checkpoint for every handful of events.
+static constexpr uint64_t desired_number_of_checkpoints = 1024;
+static constexpr uint64_t minimum_checkpoint_interval = 4096;
+// The checkpoints may store at most this many block indices per block in the
+// history. Packed entries take one or two bytes each, so this bounds their
+// memory use to roughly 8 to 16 bytes per block.
+static constexpr uint64_t checkpoint_entries_per_block = 8;
+
+LiveSetCheckpoints::LiveSetCheckpoints() = default;
+
+LiveSetCheckpoints::LiveSetCheckpoints(uint64_t maximum_tick,
+  const CompressedBlockStore* blocks) : blocks_(blocks),
+  checkpoints_(blocks->getPageFile()) {
+  printf("[!] Calculating live set checkpoints...\n");
+  fflush(stdout);
+
+  // Sum up the lifetimes of all blocks to obtain the average size of the
+  // live set.
+  uint64_t total_lifetime = 0;
+  blocks->forEachBlockBetween(0, static_cast<uint32_t>(blocks->size()),
+    [&total_lifetime, maximum_tick](uint32_t,
+      const CompressedBlockStore::DecodedChunk& chunk, uint32_t offset) {
+      total_lifetime += std::min(chunk.end_ticks_[offset], maximum_tick) -
+        std::min(chunk.start_ticks_[offset], maximum_tick);
+    });
+
+  // Every checkpoint is derived from its predecessor by replaying the events
+  // in between, so building all of them costs a single pass over the events
+  // plus the size of the stored live sets.
+  uint64_t average_live_blocks =
+    total_lifetime / std::max(maximum_tick, static_cast<uint64_t>(1));
+  checkpoint_interval_ = calculateCheckpointInterval(maximum_tick,
+    average_live_blocks, blocks->size());
+  uint64_t number_of_checkpoints = (maximum_tick / checkpoint_interval_) + 1;
+  std::vector<uint32_t> live, next_live;
+  std::vector<uint8_t> packed;
+  checkpoints_.append(packed);
+  for (uint64_t index = 1; index < number_of_checkpoints; ++index) {
+    uint64_t base_tick = (index - 1) * checkpoint_interval_;
+    replayFromLiveSet(live, base_tick, base_tick + checkpoint_interval_,
+      &next_live);
+    live.swap(next_live);
+    packAscending(live, &packed);
+    checkpoints_.append(packed);
+  }
+  printf("[!] Done calculating %zu live set checkpoints.\n",
+    checkpoints_.size());
+  fflush(stdout);
+}
+
+uint64_t LiveSetCheckpoints::calculateCheckpointInterval(
+  uint64_t maximum_tick, uint64_t average_live_blocks,
+  uint64_t number_of_blocks) {
+  uint64_t budget = checkpoint_entries_per_block * number_of_blocks;
+  uint64_t interval = minimum_checkpoint_interval;
+  while ((interval < maximum_tick) &&
+    (((maximum_tick / interval) > desired_number_of_checkpoints) ||
+     ((maximum_tick / interval) * average_live_blocks > budget))) {
+    interval <<= 1;
+  }
+  return interval;
+}
+
+void LiveSetCheckpoints::getBlocksAllocatedBetween(uint64_t low_tick,
+  uint64_t high_tick, uint32_t* first, uint32_t* last) const {
+  *first = blocks_->getFirstBlockAllocatedAfter(low_tick);
+  *last = std::max(*first, blocks_->getFirstBlockAllocatedAfter(high_tick));
+}
+
+void LiveSetCheckpoints::getBlocksFreedBetween(uint64_t low_tick,
+  uint64_t high_tick, std::vector<uint32_t>* freed) const {
+  blocks_->forEachFreeBetween(low_tick, high_tick,
+    [freed](uint32_t index, uint64_t) { freed->push_back(index); });
+}
+
+void LiveSetCheckpoints::replayEventsBetween(uint64_t low_tick,
+  uint64_t high_tick,
+  const std::function<void(uint32_t, const HeapBlock&)>& on_allocation,
+  const std::function<void(uint32_t, uint64_t)>& on_free) const {
+  // Both event lists are sorted by tick, and no two events share a tick, so
+  // a simple merge yields the original order. The frees are collected one
+  // checkpoint interval at a time, so that replaying the whole history does
+  // not need a copy of the free log.
+  std::vector<std::pair<uint64_t, uint32_t>> frees;
+  while (low_tick < high_tick) {
+    uint64_t window_end = std::min(high_tick,
+      (low_tick / checkpoint_interval_ + 1) * checkpoint_interval_);
+    frees.clear();
+    blocks_->forEachFreeBetween(low_tick, window_end,
+      [&frees](uint32_t index, uint64_t tick) {
+        frees.emplace_back(tick, index);
+      });
+    auto free = frees.begin();
+    uint32_t first, last;
+    getBlocksAllocatedBetween(low_tick, window_end, &first, &last);
+    blocks_->forEachBlockBetween(first, last, [&](uint32_t index,
+      const CompressedBlockStore::DecodedChunk& chunk, uint32_t offset) {
+      for (; (free != frees.end()) &&
+        (free->first <= chunk.start_ticks_[offset]); ++free) {
+        on_free(free->second, free->first);
+      }
+      on_allocation(index, chunk.getBlock(offset));
+    });
+    for (; free != frees.end(); ++free) {
+      on_free(free->second, free->first);
+    }
+    low_tick = window_end;
+  }
+}
+
+void LiveSetCheckpoints::replayFromLiveSet(
+  const std::vector<uint32_t>& base_live, uint64_t base_tick, uint64_t tick,
+  std::vector<uint32_t>* live) const {
+  live->clear();
+
+  // Remove everything that got freed since the base tick.
+  std::vector<uint32_t> freed;
+  getBlocksFreedBetween(base_tick, tick, &freed);
+  std::sort(freed.begin(), freed.end());
+  std::set_difference(base_live.begin(), base_live.end(), freed.begin(),
+    freed.end(), std::back_inserter(*live));
+
+  // Add everything that got allocated since the base tick and is still alive.
+  // These blocks come after all blocks in the base set in the block store,
+  // so the result stays sorted.
+  uint32_t first, last;
+  getBlocksAllocatedBetween(base_tick, tick, &first, &last);
+  blocks_->forEachBlockBetween(first, last, [live, tick](uint32_t index,
+    const CompressedBlockStore::DecodedChunk& chunk, uint32_t offset) {
+    if (chunk.end_ticks_[offset] > tick) {
+      live->push_back(index);
+    }
+  });
+}
+
+void LiveSetCheckpoints::getLiveBlocksAtTick(uint64_t tick,
+  std::vector<uint32_t>* live) const {
+  if (checkpoints_.size() == 0) {
+    live->clear();
+    return;
+  }
+  uint64_t checkpoint_index = std::min(tick / checkpoint_interval_,
+    static_cast<uint64_t>(checkpoints_.size() - 1));
+  uint64_t base_tick = checkpoint_index * checkpoint_interval_;
+  std::vector<uint32_t> base_live;
+  std::shared_ptr<const std::vector<uint8_t>> packed =
+    checkpoints_.read(checkpoint_index);
+  if (packed != nullptr) {
+    unpackAscending(*packed, &base_live);
+  }
+  replayFromLiveSet(base_live, base_tick, tick, live);
+}
@@ -0,0 +1,83 @@
+#ifndef LIVESETCHECKPOINTS_H
+#define LIVESETCHECKPOINTS_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "pagefile.h"
+
+// Periodic snapshots of the set of live heap blocks, used to answer "which
+// blocks were alive at tick T" without scanning the entire block vector.
+//
+// Every checkpoint_interval_ ticks, the indices (into the block store) of
+// all blocks that are alive are stored, delta- and varint-packed (see
+// varint.h), which takes about a byte per entry instead of four. A query for
+// tick T starts from the closest checkpoint at or below T and replays the
+// allocations and frees between the checkpoint and T, so the cost is
+// proportional to the checkpoint interval plus the size of the live set.
+//
+// A block is considered alive at tick T if start_tick_ <= T < end_tick_.
+//
+// The allocations are replayed from the blocks of the store, which are sorted
+// by start tick, and the frees from its free log. Every checkpoint is a page
+// in the page file of the store, so only the one that a query starts from
+// needs to be in memory. The store must outlive the checkpoints.
+class LiveSetCheckpoints {
+public:
+  LiveSetCheckpoints();
+  LiveSetCheckpoints(uint64_t maximum_tick,
+    const CompressedBlockStore* blocks);
+
+  // Fills |live| with the indices of all blocks alive at |tick|, sorted in
+  // ascending order (which is also ascending order of allocation).
+  void getLiveBlocksAtTick(uint64_t tick, std::vector<uint32_t>* live) const;
+
+  // Returns the range [first, last) of indices into the block store of all
+  // blocks that were allocated in the tick interval (low_tick, high_tick].
+  void getBlocksAllocatedBetween(uint64_t low_tick, uint64_t high_tick,
+    uint32_t* first, uint32_t* last) const;
+
+  // Appends the indices of all blocks that were freed in the tick interval
+  // (low_tick, high_tick] to |freed|, in order of their free tick.
+  void getBlocksFreedBetween(uint64_t low_tick, uint64_t high_tick,
+    std::vector<uint32_t>* freed) const;
+
+  // Calls |on_allocation| with the index and the block of every allocation,
+  // and |on_free| with the index and the tick of every free in the tick
+  // interval (low_tick, high_tick], in the order in which the events
+  // happened.
+  void replayEventsBetween(uint64_t low_tick, uint64_t high_tick,
+    const std::function<void(uint32_t, const HeapBlock&)>& on_allocation,
+    const std::function<void(uint32_t, uint64_t)>& on_free) const;
+
+  uint64_t getCheckpointInterval() const { return checkpoint_interval_; }
+  size_t getNumberOfCheckpoints() const { return checkpoints_.size(); }
+
+private:
+  // Makes the test class a friend to permit testing private functions.
+  friend class TestLiveSetCheckpoints;
+
+  // Picks the interval so that there are at most ~1024 checkpoints, and so
+  // that the checkpoints together hold no more than a small multiple of the
+  // number of blocks.
+  static uint64_t calculateCheckpointInterval(uint64_t maximum_tick,
+    uint64_t average_live_blocks, uint64_t number_of_blocks);
+
+  // Derives the live set at |tick| from the live set at |base_tick|
+  // (base_tick <= tick) by replaying the events in between.
+  void replayFromLiveSet(const std::vector<uint32_t>& base_live,
+    uint64_t base_tick, uint64_t tick, std::vector<uint32_t>* live) const;
+
+  const CompressedBlockStore* blocks_ = nullptr;
+
+  uint64_t checkpoint_interval_ = 1;
+
+  // Page i holds the packed, sorted indices of the blocks alive at tick
+  // i * checkpoint_interval_.
+  PageSet checkpoints_;
+};
+
+#endif // LIVESETCHECKPOINTS_H
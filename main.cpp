@@ -4,15 +4,65 @@
 #include <QDesktopWidget>
 #include <QSurfaceFormat>
 
+DEFINE_string(block_page_file, "",
+  "If set, the heap blocks and their indexes are paged out while loading, "
+  "for traces that do not fit into memory, to a new temporary file in this "
+  "directory (or with this prefix, if it is not a directory).");
+DEFINE_uint64(block_cache_megabytes, 512,
+  "The number of megabytes of paged-out heap blocks and indexes to keep "
+  "in memory.");
+DEFINE_string(trace_index, "",
+  "Index file for the trace. It is written while loading if it does not "
+  "exist yet, and used to load only --first_tick to --last_tick otherwise.");
+DEFINE_uint64(first_tick, 0, "The first tick to load with --trace_index.");
+DEFINE_uint64(last_tick, 0,
+  "The last tick to load with --trace_index, or 0 to load the whole trace.");
+DEFINE_bool(native_64bit_shaders, true,
+  "Use the vertex shaders with native 64-bit integers if the GPU supports "
+  "GL_ARB_gpu_shader_int64, instead of emulating 96-bit arithmetic.");
+DEFINE_bool(tile_relative_vertices, true,
+  "Upload the heap blocks as float offsets from tile origins, so that the "
+  "vertex shader needs no 64-bit arithmetic.");
+DEFINE_bool(tile_cache, false,
+  "Draw the heap blocks from tiles that are pre-rendered on a worker thread "
+  "and cached as textures, instead of drawing every block every frame.");
+DEFINE_bool(gpu_picking, false,
+  "Find the block under the mouse (for clicks and hover tooltips) by "
+  "drawing the block indices into an offscreen framebuffer and reading back "
+  "one pixel.");
+DEFINE_uint32(benchmark_frames, 0,
+  "If set, times the heap block shaders over this many frames and prints "
+  "the vertex throughput.");
+DEFINE_bool(frame_hud, false,
+  "Show the average CPU and GPU time of the parts of a frame (culling, "
+  "vertex generation, uploads and drawing of every layer) over the diagram.");
+DEFINE_string(frame_trace, "",
+  "If set, the timings of the last frames are written to this file as a "
+  "Chrome trace (for chrome://tracing or Perfetto) on exit.");
+
 int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
   QApplication a(argc, argv);
-  
+
   std::string inputfile = "/tmp/heap.json";
-  if (argc == 2) {
+  if (argc >= 2) {
     inputfile = std::string(argv[1]);
   }
+  // Several files are shards of one trace, to be merged by timestamp.
+  std::vector<std::string> shards(argv + 1, argv + argc);
 
   HeapVizWindow w(&inputfile);
+  w.setBlockPaging(FLAGS_block_page_file,
+    FLAGS_block_cache_megabytes * 1024 * 1024);
+  w.setTraceShards(shards);
+  w.setTraceIndex(FLAGS_trace_index, FLAGS_first_tick, FLAGS_last_tick);
+  w.setAllowNative64BitShaders(FLAGS_native_64bit_shaders);
+  w.setTileRelativeVertices(FLAGS_tile_relative_vertices);
+  w.setUseTileCache(FLAGS_tile_cache);
+  w.setUseGPUPicking(FLAGS_gpu_picking);
+  w.setBenchmarkFrames(FLAGS_benchmark_frames);
+  w.setShowFrameHUD(FLAGS_frame_hud);
+  w.setFrameTraceFile(FLAGS_frame_trace);
 
   w.setWindowTitle("Heap Visualisation in OpenGL");
   w.show();
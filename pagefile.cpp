@@ -0,0 +1,274 @@
+#include <limits>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pagefile.h"
+
+// Marks the released positions of a PageSet.
+static constexpr uint32_t no_page = std::numeric_limits<uint32_t>::max();
+
+PageFile::PageFile() = default;
+
+bool PageFile::open(const std::string& location, size_t cache_budget) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_budget_ = cache_budget;
+  if (file_ != nullptr) {
+    return true;
+  }
+  // Never touch an existing file: mkstemp only creates a new one, in
+  // |location| if it is a directory, or next to it with |location| as the
+  // prefix of its name otherwise.
+  struct stat status;
+  std::string path = location;
+  if ((stat(location.c_str(), &status) == 0) && S_ISDIR(status.st_mode)) {
+    path += "/heapvizgl";
+  }
+  path += ".pages.XXXXXX";
+  int descriptor = mkstemp(&path[0]);
+  if (descriptor < 0) {
+    printf("[!] Failed to create a page file at %s\n", location.c_str());
+    return false;
+  }
+  std::unique_ptr<FILE, int (*)(FILE*)> file(fdopen(descriptor, "w+b"),
+    &fclose);
+  if (file == nullptr) {
+    printf("[!] Failed to create page file %s\n", path.c_str());
+    close(descriptor);
+    unlink(path.c_str());
+    return false;
+  }
+  uint64_t size = 0;
+  for (const Page& page : pages_) {
+    if ((page.data_ != nullptr) && (fwrite(page.data_->data(), 1,
+      page.size_, file.get()) != page.size_)) {
+      break;
+    }
+    size += page.size_;
+  }
+  uint64_t expected = 0;
+  for (const Page& page : pages_) {
+    expected += page.size_;
+  }
+  if ((size != expected) || (fflush(file.get()) != 0)) {
+    printf("[!] Failed to write page file %s\n", path.c_str());
+    unlink(path.c_str());
+    return false;
+  }
+  // The file stays accessible through the open handle, and disappears when
+  // the viewer exits.
+  unlink(path.c_str());
+  file_ = std::move(file);
+  file_size_ = size;
+  uint64_t offset = 0;
+  for (Page& page : pages_) {
+    page.offset_ = offset;
+    page.capacity_ = page.size_;
+    page.data_.reset();
+    offset += page.size_;
+  }
+  resident_bytes_ = 0;
+  printf("[!] Paged out %llu bytes to %s.\n",
+    static_cast<unsigned long long>(size), path.c_str());
+  fflush(stdout);
+  return true;
+}
+
+bool PageFile::isOnDisk() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_ != nullptr;
+}
+
+uint32_t PageFile::write(const std::vector<uint8_t>& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t number;
+  if (!released_.empty()) {
+    number = released_.back();
+    released_.pop_back();
+  } else {
+    number = static_cast<uint32_t>(pages_.size());
+    pages_.emplace_back();
+  }
+  store(&pages_[number], data);
+  return number;
+}
+
+void PageFile::rewrite(uint32_t page, const std::vector<uint8_t>& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  store(&pages_[page], data);
+}
+
+void PageFile::release(uint32_t page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  dropFromCache(&pages_[page]);
+  if (pages_[page].data_ != nullptr) {
+    resident_bytes_ -= pages_[page].size_;
+    pages_[page].data_.reset();
+  }
+  pages_[page].size_ = 0;
+  ++pages_[page].version_;
+  released_.push_back(page);
+}
+
+void PageFile::store(Page* page, const std::vector<uint8_t>& data) {
+  dropFromCache(page);
+  ++page->version_;
+  if (page->data_ != nullptr) {
+    resident_bytes_ -= page->size_;
+    page->data_.reset();
+  }
+  page->size_ = data.size();
+  if (file_ != nullptr) {
+    if (data.size() > page->capacity_) {
+      page->offset_ = file_size_;
+      page->capacity_ = data.size();
+      file_size_ += data.size();
+    }
+    size_t done = 0;
+    while (done < data.size()) {
+      ssize_t result = pwrite(fileno(file_.get()), data.data() + done,
+        data.size() - done, static_cast<off_t>(page->offset_ + done));
+      if (result <= 0) {
+        break;
+      }
+      done += static_cast<size_t>(result);
+    }
+    if (done == data.size()) {
+      return;
+    }
+    printf("[!] Failed to write to the page file, keeping the page in "
+      "memory\n");
+  }
+  page->data_ = std::make_shared<const std::vector<uint8_t>>(data);
+  resident_bytes_ += data.size();
+}
+
+void PageFile::dropFromCache(Page* page) const {
+  if (page->cached_) {
+    lru_.erase(page->lru_);
+    resident_bytes_ -= page->size_;
+    page->data_.reset();
+    page->cached_ = false;
+  }
+}
+
+std::shared_ptr<const std::vector<uint8_t>> PageFile::read(
+  uint32_t page) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Page& entry = pages_[page];
+    if (entry.data_ != nullptr) {
+      if (entry.cached_) {
+        lru_.splice(lru_.begin(), lru_, entry.lru_);
+      }
+      return entry.data_;
+    }
+
+    // Read without holding the lock, so that threads that read other pages
+    // (or pages in memory) do not wait for the disk.
+    int descriptor = fileno(file_.get());
+    uint64_t offset = entry.offset_;
+    uint64_t size = entry.size_;
+    uint64_t version = entry.version_;
+    lock.unlock();
+    auto data = std::make_shared<std::vector<uint8_t>>(size);
+    size_t done = 0;
+    while (done < size) {
+      ssize_t result = pread(descriptor, data->data() + done, size - done,
+        static_cast<off_t>(offset + done));
+      if (result <= 0) {
+        printf("[!] Failed to read page %u from the page file\n", page);
+        return nullptr;
+      }
+      done += static_cast<size_t>(result);
+    }
+    lock.lock();
+    ++reads_;
+
+    // |pages_| may have grown in the meantime. If the page was rewritten or
+    // released while it was read, the bytes are stale, so read it again; if
+    // another thread read it as well, use its copy.
+    Page& current = pages_[page];
+    if (current.version_ != version) {
+      continue;
+    }
+    if (current.data_ != nullptr) {
+      if (current.cached_) {
+        lru_.splice(lru_.begin(), lru_, current.lru_);
+      }
+      return current.data_;
+    }
+
+    // Evict the least recently used pages, but never the one just read.
+    current.data_ = data;
+    current.cached_ = true;
+    lru_.push_front(page);
+    current.lru_ = lru_.begin();
+    resident_bytes_ += current.size_;
+    while ((resident_bytes_ > cache_budget_) && (lru_.size() > 1)) {
+      dropFromCache(&pages_[lru_.back()]);
+    }
+    return data;
+  }
+}
+
+size_t PageFile::getResidentBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resident_bytes_;
+}
+
+size_t PageFile::getCacheBudget() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_budget_;
+}
+
+size_t PageFile::getNumberOfReads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reads_;
+}
+
+PageSet::PageSet() = default;
+
+PageSet::PageSet(PageFile* file) : file_(file) {}
+
+PageSet::PageSet(PageSet&& other) : file_(other.file_),
+  pages_(std::move(other.pages_)) {
+  other.pages_.clear();
+}
+
+PageSet& PageSet::operator=(PageSet&& other) {
+  if (this != &other) {
+    releaseAll();
+    file_ = other.file_;
+    pages_ = std::move(other.pages_);
+    other.pages_.clear();
+  }
+  return *this;
+}
+
+PageSet::~PageSet() {
+  releaseAll();
+}
+
+size_t PageSet::append(const std::vector<uint8_t>& data) {
+  pages_.push_back(file_->write(data));
+  return pages_.size() - 1;
+}
+
+void PageSet::rewrite(size_t position, const std::vector<uint8_t>& data) {
+  file_->rewrite(pages_[position], data);
+}
+
+void PageSet::release(size_t position) {
+  if (pages_[position] != no_page) {
+    file_->release(pages_[position]);
+    pages_[position] = no_page;
+  }
+}
+
+void PageSet::releaseAll() {
+  for (size_t position = 0; position < pages_.size(); ++position) {
+    release(position);
+  }
+  pages_.clear();
+}
@@ -0,0 +1,125 @@
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Pages of bytes that a heap history and its indexes keep either in memory
+// or, for traces that do not fit into memory, in a temporary file on disk.
+//
+// Every page is written as a whole and read back by its number. In memory,
+// every page is a vector of its own. Once the file is opened, all pages move
+// into it, new pages are appended to it, and reads go through an LRU cache
+// that keeps at most cache_budget bytes of pages in memory (plus the page
+// that was read last, however large it is). The file is always a new one,
+// and is unlinked right away, so it disappears when the viewer exits.
+//
+// A page that is rewritten with more bytes than it had moves to the end of
+// the file; released pages leave holes that later pages of the same size or
+// smaller reuse. The file is never compacted.
+//
+// Can be used from several threads at once, and the file is read without
+// holding the lock, so reads from the disk do not wait for each other or
+// block reads of cached pages. A page that was read stays valid
+// for as long as its pointer is held, even if the page is evicted or
+// rewritten in the meantime.
+class PageFile {
+public:
+  PageFile();
+  PageFile(const PageFile&) = delete;
+  PageFile& operator=(const PageFile&) = delete;
+
+  // Moves all pages to a new file, and keeps at most |cache_budget| bytes of
+  // them in memory from then on. The file goes into |location| if that is a
+  // directory; otherwise |location| is the prefix of its name. Existing files
+  // are never overwritten. Returns false (and keeps the pages in memory) if
+  // the file cannot be created or written. If the file is open already, only
+  // the budget changes.
+  bool open(const std::string& location, size_t cache_budget);
+  bool isOnDisk() const;
+
+  // Stores |data| as a new page and returns its number.
+  uint32_t write(const std::vector<uint8_t>& data);
+  void rewrite(uint32_t page, const std::vector<uint8_t>& data);
+  // Frees the memory of the page, and its number for reuse.
+  void release(uint32_t page);
+  // Returns nullptr if the page cannot be read from the file.
+  std::shared_ptr<const std::vector<uint8_t>> read(uint32_t page) const;
+
+  // The bytes of all pages in memory, or of the cached pages once the file
+  // is open.
+  size_t getResidentBytes() const;
+  size_t getCacheBudget() const;
+  // The number of pages that were read from the file.
+  size_t getNumberOfReads() const;
+
+private:
+  struct Page {
+    uint64_t offset_ = 0;
+    uint64_t size_ = 0;
+    // The room for the page at offset_ in the file.
+    uint64_t capacity_ = 0;
+    // The bytes of the page if it is in memory or cached. A page that could
+    // not be written to the file stays in memory without being cached.
+    std::shared_ptr<const std::vector<uint8_t>> data_;
+    bool cached_ = false;
+    std::list<uint32_t>::iterator lru_;
+    // Changes whenever the page is rewritten or released, so that a read
+    // from the file that raced with it is not cached.
+    uint64_t version_ = 0;
+  };
+
+  // Puts |data| into the file at the place of |page|, or at the end of the
+  // file if it does not fit. Keeps it in memory if it cannot be written.
+  void store(Page* page, const std::vector<uint8_t>& data);
+  void dropFromCache(Page* page) const;
+
+  mutable std::mutex mutex_;
+  mutable std::vector<Page> pages_;
+  std::vector<uint32_t> released_;
+  std::unique_ptr<FILE, int (*)(FILE*)> file_{ nullptr, &fclose };
+  uint64_t file_size_ = 0;
+  size_t cache_budget_ = 0;
+  // Most recently used first.
+  mutable std::list<uint32_t> lru_;
+  mutable size_t resident_bytes_ = 0;
+  mutable size_t reads_ = 0;
+};
+
+// The pages of one index, numbered from 0 in the order in which they were
+// appended. They are released when the set is destroyed, so rebuilding an
+// index does not leave its old pages behind. The page file needs to outlive
+// the set.
+class PageSet {
+public:
+  PageSet();
+  explicit PageSet(PageFile* file);
+  PageSet(PageSet&& other);
+  PageSet& operator=(PageSet&& other);
+  ~PageSet();
+
+  PageFile* getFile() const { return file_; }
+  size_t size() const { return pages_.size(); }
+  // Stores |data| as a new page and returns its position in the set.
+  size_t append(const std::vector<uint8_t>& data);
+  void rewrite(size_t position, const std::vector<uint8_t>& data);
+  // Releases the page at |position|. Its position stays taken.
+  void release(size_t position);
+  std::shared_ptr<const std::vector<uint8_t>> read(size_t position) const {
+    return file_->read(pages_[position]);
+  }
+
+private:
+  void releaseAll();
+
+  PageFile* file_ = nullptr;
+  std::vector<uint32_t> pages_;
+};
+
+#endif // PAGEFILE_H
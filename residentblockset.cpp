@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <limits>
+
+#include "residentblockset.h"
+
+// Grows the inclusive range [minimum, maximum] by |margin| of its size on
+// both sides, without wrapping around.
+static void growRange(uint64_t minimum, uint64_t maximum, long double margin,
+  uint64_t* low, uint64_t* high) {
+  const uint64_t limit = std::numeric_limits<uint64_t>::max();
+  long double grow = (static_cast<long double>(maximum) - minimum) * margin;
+  auto delta = static_cast<uint64_t>(std::min(grow,
+    static_cast<long double>(limit)));
+  *low = (minimum > delta) ? minimum - delta : 0;
+  *high = (limit - maximum > delta) ? maximum + delta : limit;
+}
+
+static bool isInside(const ResidentBlockSet::Band& inner,
+  const ResidentBlockSet::Band& outer) {
+  return (inner.minimum_address_ >= outer.minimum_address_) &&
+    (inner.maximum_address_ <= outer.maximum_address_) &&
+    (inner.minimum_tick_ >= outer.minimum_tick_) &&
+    (inner.maximum_tick_ <= outer.maximum_tick_);
+}
+
+static bool overlaps(const ResidentBlockSet::Band& first,
+  const ResidentBlockSet::Band& second) {
+  return (first.minimum_address_ <= second.maximum_address_) &&
+    (second.minimum_address_ <= first.maximum_address_) &&
+    (first.minimum_tick_ <= second.maximum_tick_) &&
+    (second.minimum_tick_ <= first.maximum_tick_);
+}
+
+// Splits the part of |band| that |old_band| does not cover into at most four
+// strips: the ticks before and after the old band over all addresses, and
+// the addresses below and above it within the shared ticks. The bands need
+// to overlap.
+static void getUncoveredStrips(const ResidentBlockSet::Band& old_band,
+  const ResidentBlockSet::Band& band,
+  std::vector<ResidentBlockSet::Band>* strips) {
+  ResidentBlockSet::Band strip = band;
+  if (band.minimum_tick_ < old_band.minimum_tick_) {
+    strip.maximum_tick_ = old_band.minimum_tick_ - 1;
+    strips->push_back(strip);
+  }
+  strip = band;
+  if (band.maximum_tick_ > old_band.maximum_tick_) {
+    strip.minimum_tick_ = old_band.maximum_tick_ + 1;
+    strips->push_back(strip);
+  }
+  strip = band;
+  strip.minimum_tick_ = std::max(band.minimum_tick_, old_band.minimum_tick_);
+  strip.maximum_tick_ = std::min(band.maximum_tick_, old_band.maximum_tick_);
+  if (band.minimum_address_ < old_band.minimum_address_) {
+    strip.maximum_address_ = old_band.minimum_address_ - 1;
+    strips->push_back(strip);
+  }
+  strip.maximum_address_ = band.maximum_address_;
+  if (band.maximum_address_ > old_band.maximum_address_) {
+    strip.minimum_address_ = old_band.maximum_address_ + 1;
+    strips->push_back(strip);
+  }
+}
+
+ResidentBlockSet::Band ResidentBlockSet::getWindowBand(
+  const HeapHistory& history, long double margin) {
+  const DisplayHeapWindow& window = history.getCurrentWindow();
+  Band band;
+  band.minimum_size_ = history.getMinimumBlockSize();
+  growRange(window.getMinimumAddressUint64(),
+    window.getMaximumAddressUint64(), margin, &band.minimum_address_,
+    &band.maximum_address_);
+  growRange(window.getMinimumTickUint64(), window.getMaximumTickUint64(),
+    margin, &band.minimum_tick_, &band.maximum_tick_);
+  return band;
+}
+
+bool ResidentBlockSet::update(const HeapHistory& history,
+  std::vector<HeapVertex>* vertices, std::vector<uint32_t>* block_indices) {
+  changed_slots_.clear();
+  bool same_data = valid_ &&
+    (data_generation_ == history.getDataGeneration());
+  // Blocks that are larger than necessary do no harm, but missing small
+  // blocks do.
+  Band window = getWindowBand(history, 0.0);
+  if (same_data && (window.minimum_size_ >= band_.minimum_size_) &&
+    isInside(window, band_)) {
+    return false;
+  }
+  Band band = getWindowBand(history, guard_band);
+  if (!same_data || (band.minimum_size_ < band_.minimum_size_) ||
+    !overlaps(band, band_)) {
+    rebuild(history, band, vertices, block_indices);
+    return true;
+  }
+
+  std::vector<uint32_t> changed;
+  for (auto slot = slots_.begin(); slot != slots_.end();) {
+    if (history.isBlockActive(slot_blocks_[slot->second],
+      band.minimum_size_, band.minimum_address_, band.maximum_address_,
+      band.minimum_tick_, band.maximum_tick_)) {
+      ++slot;
+      continue;
+    }
+    // Collapse the quad onto its first vertex, which keeps it in its tile.
+    auto quad = vertices->begin() + slot->second * vertices_per_quad;
+    std::fill(quad + 1, quad + vertices_per_quad, *quad);
+    free_slots_.push_back(slot->second);
+    changed.push_back(slot->second);
+    slot = slots_.erase(slot);
+  }
+
+  std::vector<Band> strips;
+  getUncoveredStrips(band_, band, &strips);
+  band_ = band;
+  for (const Band& strip : strips) {
+    history.visitActiveBlocks(strip.minimum_size_, strip.minimum_address_,
+      strip.maximum_address_, strip.minimum_tick_, strip.maximum_tick_,
+      [&](uint32_t index, const HeapBlock& block) {
+        // Blocks that touch several strips are reported more than once.
+        if (!contains(index)) {
+          addBlock(history, index, block, vertices, block_indices, &changed);
+        }
+      });
+  }
+
+  if (free_slots_.size() * 2 > block_indices->size()) {
+    rebuild(history, band, vertices, block_indices);
+    return true;
+  }
+
+  std::sort(changed.begin(), changed.end());
+  changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+  for (uint32_t slot : changed) {
+    if (!changed_slots_.empty() && (changed_slots_.back().second == slot)) {
+      ++changed_slots_.back().second;
+    } else {
+      changed_slots_.emplace_back(slot, slot + 1);
+    }
+  }
+  return false;
+}
+
+void ResidentBlockSet::rebuild(const HeapHistory& history, const Band& band,
+  std::vector<HeapVertex>* vertices, std::vector<uint32_t>* block_indices) {
+  slots_.clear();
+  slot_blocks_.clear();
+  free_slots_.clear();
+  vertices->clear();
+  block_indices->clear();
+
+  history.visitActiveBlocks(band.minimum_size_, band.minimum_address_,
+    band.maximum_address_, band.minimum_tick_, band.maximum_tick_,
+    [&](uint32_t index, const HeapBlock& block) {
+      addBlock(history, index, block, vertices, block_indices, nullptr);
+    });
+  band_ = band;
+  valid_ = true;
+  data_generation_ = history.getDataGeneration();
+}
+
+// Puts the block into a hole if there is one, and into a new slot at the end
+// otherwise.
+void ResidentBlockSet::addBlock(const HeapHistory& history, uint32_t index,
+  const HeapBlock& block, std::vector<HeapVertex>* vertices,
+  std::vector<uint32_t>* block_indices, std::vector<uint32_t>* changed) {
+  block_vertices_.clear();
+  history.blockToVertices(block, &block_vertices_);
+  uint32_t slot;
+  if (free_slots_.empty()) {
+    slot = static_cast<uint32_t>(block_indices->size());
+    block_indices->push_back(index);
+    slot_blocks_.push_back(block);
+    vertices->insert(vertices->end(), block_vertices_.begin(),
+      block_vertices_.end());
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+    (*block_indices)[slot] = index;
+    slot_blocks_[slot] = block;
+    std::copy(block_vertices_.begin(), block_vertices_.end(),
+      vertices->begin() + slot * vertices_per_quad);
+  }
+  slots_[index] = slot;
+  if (changed != nullptr) {
+    changed->push_back(slot);
+  }
+}
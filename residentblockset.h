@@ -0,0 +1,91 @@
+#ifndef RESIDENTBLOCKSET_H
+#define RESIDENTBLOCKSET_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "heaphistory.h"
+#include "vertex.h"
+
+// The blocks that the block layer keeps in its vertex buffer while the
+// window is panned around.
+//
+// The set does not hold the blocks in the window, but the blocks in a guard
+// band around it: the window grown by guard_band of its size on every side.
+// As long as the window stays inside the band, nothing changes. Once it
+// leaves the band, the band is centered on the window again; blocks that no
+// longer touch the band are evicted, and only the strips of the new band
+// that the old band did not cover are scanned for new blocks.
+//
+// Every block has a slot: one quad in the vertex vector and one entry in the
+// block index vector. The set keeps a copy of the block of every slot, so
+// that evicting blocks does not need to decode them again, and so that the
+// block layer can look up their heap IDs. An evicted block leaves a hole (a
+// quad without area) that the next new block fills, so all other slots stay
+// where they are and only the changed slots need to be written to the GPU.
+// The set is rebuilt if the data changes, if zooming in lets smaller blocks
+// become visible, or if more than half of the slots are holes.
+class ResidentBlockSet {
+public:
+  static constexpr long double guard_band = 0.25;
+
+  // The blocks of at least minimum_size_ bytes that touch the (inclusive)
+  // ranges of addresses and ticks.
+  struct Band {
+    uint64_t minimum_size_ = 0;
+    uint64_t minimum_address_ = 0;
+    uint64_t maximum_address_ = 0;
+    uint64_t minimum_tick_ = 0;
+    uint64_t maximum_tick_ = 0;
+  };
+
+  // Forgets all blocks, so that the next update rebuilds the set.
+  void clear() { valid_ = false; }
+
+  // Brings |vertices| and |block_indices| up to date with the current window
+  // of |history|. Both need to stay untouched between updates. Returns true
+  // if the set was rebuilt, in which case all slots changed; otherwise,
+  // getChangedSlots tells which ones did.
+  bool update(const HeapHistory& history, std::vector<HeapVertex>* vertices,
+    std::vector<uint32_t>* block_indices);
+
+  size_t size() const { return slots_.size(); }
+  size_t getNumberOfHoles() const { return free_slots_.size(); }
+  bool contains(uint32_t index) const { return slots_.count(index) != 0; }
+  // The heap ID of the block in |slot|, or of the block that it last held if
+  // it is a hole.
+  uint8_t getHeapId(uint32_t slot) const {
+    return slot_blocks_[slot].heap_id_;
+  }
+  const Band& getBand() const { return band_; }
+  // The slots that the last update changed, as sorted and disjoint ranges
+  // [first, end).
+  const std::vector<std::pair<uint32_t, uint32_t>>& getChangedSlots() const {
+    return changed_slots_;
+  }
+
+  // The window of |history|, grown by |margin| of its size on every side.
+  static Band getWindowBand(const HeapHistory& history, long double margin);
+
+private:
+  void rebuild(const HeapHistory& history, const Band& band,
+    std::vector<HeapVertex>* vertices, std::vector<uint32_t>* block_indices);
+  void addBlock(const HeapHistory& history, uint32_t index,
+    const HeapBlock& block, std::vector<HeapVertex>* vertices,
+    std::vector<uint32_t>* block_indices, std::vector<uint32_t>* changed);
+
+  bool valid_ = false;
+  uint32_t data_generation_ = 0;
+  Band band_;
+  // Block index to slot.
+  std::unordered_map<uint32_t, uint32_t> slots_;
+  // The block in each slot.
+  std::vector<HeapBlock> slot_blocks_;
+  std::vector<uint32_t> free_slots_;
+  std::vector<std::pair<uint32_t, uint32_t>> changed_slots_;
+  std::vector<HeapVertex> block_vertices_;
+};
+
+#endif // RESIDENTBLOCKSET_H
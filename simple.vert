@@ -1,8 +1,10 @@
 #version 130
-in highp ivec3 position;
+in highp ivec4 position;
 in highp vec3 color;
 
 out vec4 vColor;
+// The index of the block plus one, for the ID pass (see block.frag).
+flat out uint vBlock;
 
 uniform mat2 scale_heap_to_screen;
 uniform int visible_heap_base_A;
@@ -10,6 +12,16 @@ uniform int visible_heap_base_B;
 uniform int visible_heap_base_C;
 uniform int visible_tick_base_A;
 uniform int visible_tick_base_B;
+uniform int visible_tick_base_C;
+
+// The index into the block vector for each block that has vertices, one
+// bit per block that is set if the block is highlighted, and the heap ID of
+// each block that has vertices. All are laid out in rows of 4096 texels.
+uniform usampler2D block_indices;
+uniform usampler2D highlight_bits;
+uniform usampler2D block_heaps;
+// One bit per heap ID, set if the blocks of the heap are visible.
+uniform uint visible_heaps[8];
 
 // =========================================================================
 // Everything below should be valid C++ and also valid GLSL! This code is
@@ -180,6 +192,20 @@ int FloatToInt(float argument) {
    return int(argument);
 }
 
+uint FetchTexel(usampler2D sampler, uint index) {
+  return texelFetch(sampler, ivec2(int(index % 4096u), int(index / 4096u)), 0).r;
+}
+
+// Maps the regular block colors to the highlight colors, approximating
+// LinearBrightnessColorScale: live blocks are green and turn yellow, freed
+// blocks are grey and turn red-orange.
+vec3 HighlightColor(vec3 block_color) {
+  if (block_color.r == 0.0) {
+    return vec3(block_color.g, block_color.g, 0.0);
+  }
+  return vec3(block_color.r + 0.3, block_color.g, 0.0);
+}
+
 void main(void)
 {
   // =========================================================================
@@ -189,8 +215,8 @@ void main(void)
   // =========================================================================
   //
   // Read the X (tick) and Y (address) coordinate of the current point.
-  ivec2 tick = Load32BitLeftShiftedBy4Into64Bit(position.x);
-  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.y, position.z);
+  ivec3 tick = Load64BitLeftShiftedBy4Into96Bit(position.x, position.y);
+  ivec3 address = Load64BitLeftShiftedBy4Into96Bit(position.z, position.w);
 
   // Get the base of the heap in the displayed window. This is a 96-bit number
   // where the lowest 4 bit represent a fractional component, the rest is a
@@ -203,10 +229,11 @@ void main(void)
   ivec3 address_coordinate_translated = Sub96(address, heap_base);
 
   // Lowest 4 bit represent fractional component, again.
-  ivec2 minimum_visible_tick = ivec2(visible_tick_base_A, visible_tick_base_B);
+  ivec3 minimum_visible_tick =
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C);
 
   // Translate the x / tick coordinate to be aligned with 0.
-  ivec2 tick_coordinate_translated = Sub64(tick, minimum_visible_tick);
+  ivec3 tick_coordinate_translated = Sub96(tick, minimum_visible_tick);
 
   // Multiply the y coordinate with the y entry of the transformation matrix.
   // To avoid a degenerate matrix, C++ code supplies a matrix containing the
@@ -216,7 +243,7 @@ void main(void)
                                         scale_heap_to_screen[1][1]);
   float final_y = temp_y * scale_heap_to_screen[1][1];
 
-  float temp_x = Multiply64BitWithFloat(tick_coordinate_translated,
+  float temp_x = Multiply96BitWithFloat(tick_coordinate_translated,
                                         scale_heap_to_screen[0][0]);
   float final_x = temp_x * scale_heap_to_screen[0][0];
 
@@ -235,5 +262,19 @@ void main(void)
   //} else {
   //    vColor = vec4(0.0, 1.0, 0.0, 1.0);
   //}
-  vColor = vec4(color, 0.6);
+  // Every block is drawn as a quad of 4 vertices, and gl_VertexID is the
+  // index of the vertex in the quad index buffer.
+  uint block = FetchTexel(block_indices, uint(gl_VertexID / 4));
+  vBlock = block + 1u;
+  uint highlight_word = FetchTexel(highlight_bits, block / 32u);
+  if (((highlight_word >> (block % 32u)) & 1u) != 0u) {
+    vColor = vec4(HighlightColor(color), 0.6);
+  } else {
+    vColor = vec4(color, 0.6);
+  }
+  // Blocks of hidden heaps are moved outside of the clip volume.
+  uint heap = FetchTexel(block_heaps, uint(gl_VertexID / 4)) & 0xFFu;
+  if (((visible_heaps[heap / 32u] >> (heap % 32u)) & 1u) == 0u) {
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+  }
 }
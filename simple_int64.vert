@@ -0,0 +1,124 @@
+#version 400
+#extension GL_ARB_gpu_shader_int64 : require
+// The variant of simple.vert for GPUs with native 64-bit integers. The
+// coordinates are subtracted with 64-bit integer arithmetic instead of the
+// emulated 96-bit arithmetic, which saves dozens of instructions per vertex.
+// The layer falls back to simple.vert if this shader does not compile.
+in highp ivec4 position;
+in highp vec3 color;
+
+out vec4 vColor;
+// The index of the block plus one, for the ID pass (see block.frag).
+flat out uint vBlock;
+
+uniform mat2 scale_heap_to_screen;
+uniform int visible_heap_base_A;
+uniform int visible_heap_base_B;
+uniform int visible_heap_base_C;
+uniform int visible_tick_base_A;
+uniform int visible_tick_base_B;
+uniform int visible_tick_base_C;
+
+// See simple.vert.
+uniform usampler2D block_indices;
+uniform usampler2D highlight_bits;
+uniform usampler2D block_heaps;
+uniform uint visible_heaps[8];
+
+// =========================================================================
+// Everything below should be valid C++ and also valid GLSL! This code is
+// shared with glsl_simulation_functions.cpp, so make sure it always stays in
+// synch!!
+// =========================================================================
+
+// Subtracts a 96-bit base with 4 fractional bits (see
+// Load64BitLeftShiftedBy4Into96Bit) from a 64-bit integer, and returns the
+// difference in sixteenths as a float. This replaces Sub96 followed by
+// Multiply96BitWithFloat, but needs native 64-bit integers, so in GLSL it is
+// only available with GL_ARB_gpu_shader_int64.
+// Function must be valid C++ and valid GLSL!
+float Sub96FromUint64(uint64_t value, ivec3 base) {
+  // Split the base into the low 64 bits of its integer part, the remaining
+  // 28 high bits (with the sign), and the fraction.
+  uint64_t mask_32 = 0xFFFFFFFFul;
+  uint64_t base_low = (uint64_t(base.z) << 60) |
+    ((uint64_t(base.y) & mask_32) << 28) | ((uint64_t(base.x) & mask_32) >> 4);
+  int base_high = base.z >> 4;
+  uint64_t low = value - base_low;
+  int borrow = 0;
+  if (value < base_low) {
+    borrow = 1;
+  }
+  int high = 0 - base_high - borrow;
+  // Differences that fit into 64 bits (all visible ones) are converted
+  // exactly; the others are far outside of the screen anyway.
+  float result;
+  if (((high == 0) && ((low >> 63) == 0ul)) ||
+      ((high == -1) && ((low >> 63) == 1ul))) {
+    result = float(int64_t(low));
+  } else {
+    result = float(high) * 18446744073709551616.0 + float(low);
+  }
+  return result * 16.0 - float(base.x & 0xF);
+}
+
+// =========================================================================
+// End of valid C++ and valid GLSL part.
+// =========================================================================
+
+// Reads a 64-bit coordinate from two 32-bit halves, lower half first.
+uint64_t LoadUint64(int low, int high) {
+  return packUint2x32(uvec2(uint(low), uint(high)));
+}
+
+uint FetchTexel(usampler2D sampler, uint index) {
+  return texelFetch(sampler, ivec2(int(index % 4096u), int(index / 4096u)), 0).r;
+}
+
+// See simple.vert.
+vec3 HighlightColor(vec3 block_color) {
+  if (block_color.r == 0.0) {
+    return vec3(block_color.g, block_color.g, 0.0);
+  }
+  return vec3(block_color.r + 0.3, block_color.g, 0.0);
+}
+
+void main(void)
+{
+  // Translate the x / tick coordinate so that the lowest visible tick aligns
+  // with 0, in sixteenths.
+  float tick_coordinate_translated = Sub96FromUint64(
+      LoadUint64(position.x, position.y),
+      ivec3(visible_tick_base_A, visible_tick_base_B, visible_tick_base_C));
+  // Like in simple.vert, the matrix holds the square roots of the scale,
+  // so apply it twice.
+  float final_x = tick_coordinate_translated * scale_heap_to_screen[0][0] *
+    scale_heap_to_screen[0][0];
+  final_x = 2 * final_x - 1;
+
+  // Translate the y / address coordinate so that the lowest visible address
+  // aligns with 0, in sixteenths.
+  float address_coordinate_translated = Sub96FromUint64(
+      LoadUint64(position.z, position.w),
+      ivec3(visible_heap_base_A, visible_heap_base_B, visible_heap_base_C));
+  float final_y = address_coordinate_translated *
+    scale_heap_to_screen[1][1] * scale_heap_to_screen[1][1];
+  final_y = 2 * final_y - 1;
+
+  gl_Position = vec4(final_x, final_y, 0.0, 1.0);
+  // Every block is drawn as a quad of 4 vertices, and gl_VertexID is the
+  // index of the vertex in the quad index buffer.
+  uint block = FetchTexel(block_indices, uint(gl_VertexID / 4));
+  vBlock = block + 1u;
+  uint highlight_word = FetchTexel(highlight_bits, block / 32u);
+  if (((highlight_word >> (block % 32u)) & 1u) != 0u) {
+    vColor = vec4(HighlightColor(color), 0.6);
+  } else {
+    vColor = vec4(color, 0.6);
+  }
+  // Blocks of hidden heaps are moved outside of the clip volume.
+  uint heap = FetchTexel(block_heaps, uint(gl_VertexID / 4)) & 0xFFu;
+  if (((visible_heaps[heap / 32u] >> (heap % 32u)) & 1u) == 0u) {
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+  }
+}
@@ -0,0 +1,96 @@
+#version 130
+// The variant of simple.vert for vertices relative to the origin of their
+// tile (see VertexTiles). The x and y components of the position are the
+// offsets in ticks and bytes, z is the index of the tile.
+in highp vec3 position;
+in highp vec3 color;
+
+out vec4 vColor;
+// The index of the block plus one, for the ID pass (see block.frag).
+flat out uint vBlock;
+
+uniform mat2 scale_heap_to_screen;
+// The origin of every tile relative to the minimum of the displayed window,
+// in sixteenths, laid out in rows of 4096 texels.
+uniform sampler2D tile_origins;
+
+// The index into the block vector for each block that has vertices, one
+// bit per block that is set if the block is highlighted, and the heap ID of
+// each block that has vertices. All are laid out in rows of 4096 texels.
+uniform usampler2D block_indices;
+uniform usampler2D highlight_bits;
+uniform usampler2D block_heaps;
+// One bit per heap ID, set if the blocks of the heap are visible.
+uniform uint visible_heaps[8];
+
+vec4 IntToColor(int argument) {
+  return vec4((argument & 0xFF) / 255.0,
+              ((argument & 0xFF00) >> 8) / 255.0,
+              ((argument & 0xFF0000) >> 16) / 255.0,
+              1.0);
+}
+
+int FloatToInt(float argument) {
+   argument = argument;// * 256.0;
+   return int(argument);
+}
+
+uint FetchTexel(usampler2D sampler, uint index) {
+  return texelFetch(sampler, ivec2(int(index % 4096u), int(index / 4096u)), 0).r;
+}
+
+// Maps the regular block colors to the highlight colors, approximating
+// LinearBrightnessColorScale: live blocks are green and turn yellow, freed
+// blocks are grey and turn red-orange.
+vec3 HighlightColor(vec3 block_color) {
+  if (block_color.r == 0.0) {
+    return vec3(block_color.g, block_color.g, 0.0);
+  }
+  return vec3(block_color.r + 0.3, block_color.g, 0.0);
+}
+
+void main(void)
+{
+  // The CPU has already translated the tile origin with 96-bit arithmetic,
+  // so only the offset of the vertex is left to add. Keep this in synch with
+  // HeapBlockDiagramLayer::tiledVertexShaderSimulator.
+  int tile = int(position.z);
+  vec2 tile_origin =
+      texelFetch(tile_origins, ivec2(tile % 4096, tile / 4096), 0).rg;
+
+  // See simple.vert for why the scale is applied twice.
+  float final_x = (tile_origin.x + position.x * 16.0) *
+                  scale_heap_to_screen[0][0];
+  final_x = final_x * scale_heap_to_screen[0][0];
+  float final_y = (tile_origin.y + position.y * 16.0) *
+                  scale_heap_to_screen[1][1];
+  final_y = final_y * scale_heap_to_screen[1][1];
+
+  final_y = 2 * final_y - 1;
+  final_x = 2 * final_x - 1;
+
+  gl_Position = vec4(final_x, final_y, 0.0, 1.0);
+  // For debugging, uncomment the following line.
+  //gl_Position = vec4(color.r, color.g, 0.0, 1.0);
+  //  vColor = IntToColor(FloatToInt(scale_heap_to_screen[1][1] * 255 * 255 * 255));
+  //if (scale_heap_to_screen[1][1] > 0.1051) {
+  //    vColor = vec4(1.0, 0.0, 0.0, 1.0);
+  //} else {
+  //    vColor = vec4(0.0, 1.0, 0.0, 1.0);
+  //}
+  // Every block is drawn as a quad of 4 vertices, and gl_VertexID is the
+  // index of the vertex in the quad index buffer.
+  uint block = FetchTexel(block_indices, uint(gl_VertexID / 4));
+  vBlock = block + 1u;
+  uint highlight_word = FetchTexel(highlight_bits, block / 32u);
+  if (((highlight_word >> (block % 32u)) & 1u) != 0u) {
+    vColor = vec4(HighlightColor(color), 0.6);
+  } else {
+    vColor = vec4(color, 0.6);
+  }
+  // Blocks of hidden heaps are moved outside of the clip volume.
+  uint heap = FetchTexel(block_heaps, uint(gl_VertexID / 4)) & 0xFFu;
+  if (((visible_heaps[heap / 32u] >> (heap % 32u)) & 1u) == 0u) {
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+  }
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+#include "tagaggregateindex.h"
+
+// The prefix sums hold at most this many entries per array.
+static constexpr uint64_t maximum_prefix_sum_entries = 1 << 22;
+static constexpr uint32_t maximum_buckets = 4096;
+static constexpr uint32_t minimum_buckets = 64;
+
+TagAggregateIndex::TagAggregateIndex() = default;
+
+uint32_t TagAggregateIndex::calculateNumberOfBuckets(uint64_t maximum_tick,
+  size_t number_of_tags) {
+  uint64_t buckets = maximum_prefix_sum_entries /
+    std::max(number_of_tags, static_cast<size_t>(1));
+  buckets = std::max(std::min(buckets, static_cast<uint64_t>(maximum_buckets)),
+    static_cast<uint64_t>(minimum_buckets));
+  return static_cast<uint32_t>(std::min(buckets,
+    maximum_tick + 1));
+}
+
+TagAggregateIndex::TagAggregateIndex(uint64_t maximum_tick,
+  const CompressedBlockStore& blocks, const TagTable& tags) {
+  printf("[!] Calculating per-tag prefix sums...\n");
+  fflush(stdout);
+  tag_names_.push_back("");
+  for (uint32_t tag = 1; tag < tags.size(); ++tag) {
+    tag_names_.push_back(*tags.getTag(tag));
+    tag_ids_.emplace(tag_names_.back(), tag);
+  }
+  // An interned "" wins over "no tag".
+  tag_ids_.emplace("", 0);
+
+  number_of_buckets_ = calculateNumberOfBuckets(maximum_tick,
+    tag_names_.size());
+  bucket_width_ = std::max((maximum_tick + number_of_buckets_ - 1) /
+    number_of_buckets_, static_cast<uint64_t>(1));
+  size_t entries = offset(static_cast<uint32_t>(tag_names_.size()), 0);
+  allocated_.assign(entries, 0);
+  freed_.assign(entries, 0);
+  live_integral_.assign(entries, 0);
+
+  // Bucket the events: an event at tick t counts for all boundaries at or
+  // above t.
+  auto boundaryAtOrAbove = [this](uint64_t tick) {
+    return (tick + bucket_width_ - 1) / bucket_width_;
+  };
+  CompressedBlockStore::DecodedChunk chunk;
+  for (size_t number = 0; number < blocks.getNumberOfChunks(); ++number) {
+    blocks.decodeChunk(number, &chunk);
+    for (uint32_t block = 0; block < chunk.number_of_blocks_; ++block) {
+      auto tag = static_cast<uint32_t>(chunk.allocation_tags_[block]);
+      uint64_t size = chunk.sizes_[block];
+      uint64_t end_tick = chunk.end_ticks_[block];
+      allocated_[offset(tag, boundaryAtOrAbove(chunk.start_ticks_[block]))] +=
+        size;
+      if ((end_tick != std::numeric_limits<uint64_t>::max()) &&
+        (boundaryAtOrAbove(end_tick) <= number_of_buckets_)) {
+        freed_[offset(tag, boundaryAtOrAbove(end_tick))] += size;
+      }
+    }
+  }
+
+  // Turn the per-bucket counts into prefix sums.
+  std::vector<std::pair<uint64_t, uint32_t>> totals;
+  for (uint32_t tag = 0; tag < tag_names_.size(); ++tag) {
+    for (size_t boundary = 1; boundary <= number_of_buckets_; ++boundary) {
+      allocated_[offset(tag, boundary)] += allocated_[offset(tag, boundary - 1)];
+      freed_[offset(tag, boundary)] += freed_[offset(tag, boundary - 1)];
+      live_integral_[offset(tag, boundary)] =
+        live_integral_[offset(tag, boundary - 1)] +
+        allocated_[offset(tag, boundary - 1)] -
+        freed_[offset(tag, boundary - 1)];
+    }
+    totals.emplace_back(live_integral_[offset(tag, number_of_buckets_)], tag);
+  }
+  std::sort(totals.begin(), totals.end(),
+    [](const std::pair<uint64_t, uint32_t>& left,
+       const std::pair<uint64_t, uint32_t>& right) {
+      return left.first > right.first;
+    });
+  for (const auto& total : totals) {
+    tags_by_size_.push_back(total.second);
+  }
+  printf("[!] Done calculating prefix sums for %zu tags, %u buckets.\n",
+    tag_names_.size(), number_of_buckets_);
+  fflush(stdout);
+}
+
+bool TagAggregateIndex::getTagId(const std::string& name,
+  uint32_t* tag) const {
+  auto iter = tag_ids_.find(name);
+  if (iter == tag_ids_.end()) {
+    return false;
+  }
+  *tag = iter->second;
+  return true;
+}
+
+uint64_t TagAggregateIndex::getBytesAllocatedBetween(uint32_t tag,
+  uint64_t low_tick, uint64_t high_tick) const {
+  return allocated_[offset(tag, boundaryAtOrBelow(high_tick))] -
+    allocated_[offset(tag, boundaryAtOrBelow(low_tick))];
+}
+
+uint64_t TagAggregateIndex::getBytesFreedBetween(uint32_t tag,
+  uint64_t low_tick, uint64_t high_tick) const {
+  return freed_[offset(tag, boundaryAtOrBelow(high_tick))] -
+    freed_[offset(tag, boundaryAtOrBelow(low_tick))];
+}
+
+uint64_t TagAggregateIndex::getLiveBytesAtTick(uint32_t tag,
+  uint64_t tick) const {
+  size_t boundary = boundaryAtOrBelow(tick);
+  return allocated_[offset(tag, boundary)] - freed_[offset(tag, boundary)];
+}
+
+uint64_t TagAggregateIndex::getAverageLiveBytesBetween(uint32_t tag,
+  uint64_t low_tick, uint64_t high_tick) const {
+  size_t low = boundaryAtOrBelow(low_tick);
+  size_t high = boundaryAtOrBelow(high_tick);
+  if (high <= low) {
+    return getLiveBytesAtTick(tag, low_tick);
+  }
+  return (live_integral_[offset(tag, high)] -
+    live_integral_[offset(tag, low)]) / (high - low);
+}
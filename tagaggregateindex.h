@@ -0,0 +1,88 @@
+#ifndef TAGAGGREGATEINDEX_H
+#define TAGAGGREGATEINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "compressedblockstore.h"
+#include "tagtable.h"
+
+// Per-tag prefix sums of allocated and freed bytes over buckets of ticks.
+//
+// Blocks are attributed to their allocation tag, both when they are
+// allocated and when they are freed, so that the difference of the two sums
+// is the number of bytes the tag holds. With the prefix sums (and a second
+// prefix sum over the live bytes) the following are O(1) per tag:
+//  - bytes allocated or freed between two ticks,
+//  - bytes live at a tick,
+//  - average bytes live between two ticks.
+//
+// All queries are exact at bucket boundaries (multiples of getBucketWidth());
+// other ticks are rounded down to the closest boundary.
+//
+// The tags are identified by their IDs in the TagTable of the blocks, which
+// the block store keeps for every block. Blocks without a tag count as tag 0,
+// named "".
+class TagAggregateIndex {
+public:
+  TagAggregateIndex();
+  TagAggregateIndex(uint64_t maximum_tick, const CompressedBlockStore& blocks,
+    const TagTable& tags);
+
+  size_t getNumberOfTags() const { return tag_names_.size(); }
+  const std::string& getTagName(uint32_t tag) const {
+    return tag_names_[tag];
+  }
+  // Returns false if the tag is unknown.
+  bool getTagId(const std::string& name, uint32_t* tag) const;
+
+  uint64_t getBucketWidth() const { return bucket_width_; }
+  uint32_t getNumberOfBuckets() const { return number_of_buckets_; }
+
+  uint64_t getBytesAllocatedBetween(uint32_t tag, uint64_t low_tick,
+    uint64_t high_tick) const;
+  uint64_t getBytesFreedBetween(uint32_t tag, uint64_t low_tick,
+    uint64_t high_tick) const;
+  uint64_t getLiveBytesAtTick(uint32_t tag, uint64_t tick) const;
+  uint64_t getAverageLiveBytesBetween(uint32_t tag, uint64_t low_tick,
+    uint64_t high_tick) const;
+
+  // Tags sorted by the total number of byte-ticks they held, largest first.
+  const std::vector<uint32_t>& getTagsBySize() const { return tags_by_size_; }
+
+private:
+  // Makes the test class a friend to permit testing private functions.
+  friend class TestTagAggregateIndex;
+
+  static uint32_t calculateNumberOfBuckets(uint64_t maximum_tick,
+    size_t number_of_tags);
+
+  // The index of the bucket boundary at or below |tick|.
+  size_t boundaryAtOrBelow(uint64_t tick) const {
+    return std::min(static_cast<size_t>(tick / bucket_width_),
+      static_cast<size_t>(number_of_buckets_));
+  }
+  size_t offset(uint32_t tag, size_t boundary) const {
+    return tag * (static_cast<size_t>(number_of_buckets_) + 1) + boundary;
+  }
+
+  uint64_t bucket_width_ = 1;
+  uint32_t number_of_buckets_ = 0;
+
+  std::vector<std::string> tag_names_;
+  std::map<std::string, uint32_t> tag_ids_;
+  std::vector<uint32_t> tags_by_size_;
+
+  // For every tag, number_of_buckets_ + 1 entries: the bytes allocated
+  // (freed) at ticks <= boundary * bucket_width_.
+  std::vector<uint64_t> allocated_;
+  std::vector<uint64_t> freed_;
+  // The sum of the live bytes at all boundaries below the given one. Stored
+  // in units of bytes, multiply by the bucket width for byte-ticks.
+  std::vector<uint64_t> live_integral_;
+};
+
+#endif // TAGAGGREGATEINDEX_H
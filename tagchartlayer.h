@@ -0,0 +1,16 @@
+#ifndef TAGCHARTLAYER_H
+#define TAGCHARTLAYER_H
+#include "glheapdiagramlayer.h"
+
+// Draws the live bytes of the largest allocation tags as a stacked area chart
+// at the bottom of the diagram.
+class TagChartLayer : public GLHeapDiagramLayer
+{
+public:
+  TagChartLayer();
+  virtual ~TagChartLayer() = default;
+  std::pair<vec4, vec4> vertexShaderSimulator(const HeapVertex& vertex) override;
+  void loadVerticesFromHeapHistory(const HeapHistory& history, bool all) override;
+};
+
+#endif // TAGCHARTLAYER_H
@@ -0,0 +1,33 @@
+#include "tagtable.h"
+
+TagTable::TagTable() : tags_(1, nullptr) {}
+
+const std::string* TagTable::intern(const std::string& tag) {
+  auto result = ids_.emplace(tag, static_cast<uint32_t>(tags_.size()));
+  const std::string* interned = &result.first->first;
+  if (result.second) {
+    tags_.push_back(interned);
+    interned_ids_.emplace(interned, result.first->second);
+  }
+  return interned;
+}
+
+uint32_t TagTable::getId(const std::string* tag) {
+  if (tag == nullptr) {
+    return 0;
+  }
+  auto interned = interned_ids_.find(tag);
+  if (interned != interned_ids_.end()) {
+    return interned->second;
+  }
+  return interned_ids_[intern(*tag)];
+}
+
+bool TagTable::findId(const std::string& tag, uint32_t* id) const {
+  auto iter = ids_.find(tag);
+  if (iter == ids_.end()) {
+    return false;
+  }
+  *id = iter->second;
+  return true;
+}
@@ -0,0 +1,42 @@
+#ifndef TAGTABLE_H
+#define TAGTABLE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The allocation and free tags of a heap history, numbered in the order in
+// which they are first seen. The blocks store the 32-bit IDs instead of the
+// strings; ID 0 stands for "no tag".
+//
+// Interned tags never move, so the pointers returned by intern() and getTag()
+// stay valid for the lifetime of the table.
+class TagTable {
+public:
+  TagTable();
+  TagTable(const TagTable&) = delete;
+  TagTable& operator=(const TagTable&) = delete;
+
+  // Returns the interned copy of |tag|, adding it to the table if necessary.
+  const std::string* intern(const std::string& tag);
+  // Returns the ID of |tag|, adding it to the table if necessary. Pointers
+  // returned by intern() are looked up without hashing the string.
+  uint32_t getId(const std::string* tag);
+  // Returns false if no tag of that name was interned.
+  bool findId(const std::string& tag, uint32_t* id) const;
+  // Returns nullptr for ID 0.
+  const std::string* getTag(uint32_t id) const { return tags_[id]; }
+
+  // The number of IDs, including 0.
+  size_t size() const { return tags_.size(); }
+
+private:
+  // The nodes of an unordered_map never move, so the keys are the interned
+  // strings.
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::unordered_map<const std::string*, uint32_t> interned_ids_;
+  std::vector<const std::string*> tags_;
+};
+
+#endif // TAGTABLE_H
@@ -1,6 +1,7 @@
 #include <QtTest/QtTest>
 
 #include "activeregioncache.h"
+#include "compressedblockstore.h"
 #include "glsl_simulation_functions.h"
 #include "heapwindow.h"
 #include "heapblock.h"
@@ -11,7 +12,7 @@ void TestActiveRegionCache::TestSizeCalculation() {
   HeapBlock h2(20, 250, 4000, 0xDEADBEEF+2000 );
 
   std::vector<HeapBlock> vec = {h1, h2};
-  ActiveRegionCache(6000, &vec);
+  ActiveRegionCache(6000, CompressedBlockStore(vec, nullptr));
   QCOMPARE(1.0, -1.0);
 }
 
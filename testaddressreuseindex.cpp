@@ -0,0 +1,45 @@
+#include <QtTest/QtTest>
+
+#include "addressreuseindex.h"
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "testaddressreuseindex.h"
+
+// Compares every chain against a brute-force scan of the block vector.
+void TestAddressReuseIndex::TestChainsMatchFullScan() {
+  std::vector<HeapBlock> blocks;
+  const uint64_t base = 0x10000;
+  const uint64_t number_of_slots = 97;
+  uint64_t tick = 0;
+  // Enough blocks for several partitions, each of several staged runs.
+  for (uint32_t index = 0; index < 3 * AddressReuseIndex::entries_per_partition;
+    ++index) {
+    tick += 3;
+    uint64_t address = base +
+      32 * ((index * 2654435761ULL) % number_of_slots);
+    blocks.emplace_back(tick, tick + 1 + (index % 17), 16, address);
+  }
+  // The index keeps its pages in the page file of the store.
+  CompressedBlockStore store(blocks, nullptr, 256);
+  AddressReuseIndex index(store);
+  QCOMPARE(index.getNumberOfAddresses(), size_t(number_of_slots));
+
+  for (uint64_t slot = 0; slot < number_of_slots; ++slot) {
+    uint64_t address = base + 32 * slot;
+    std::vector<uint32_t> expected;
+    for (uint32_t block = 0; block < blocks.size(); ++block) {
+      if (blocks[block].address_ == address) {
+        expected.push_back(block);
+      }
+    }
+    std::vector<uint32_t> chain;
+    QVERIFY(index.getChain(address, &chain));
+    QCOMPARE(chain, expected);
+  }
+
+  // Addresses at which nothing was allocated have no chain.
+  std::vector<uint32_t> chain = { 1 };
+  QVERIFY(!index.getChain(base + 8, &chain));
+  QVERIFY(chain.empty());
+  QVERIFY(!AddressReuseIndex().getChain(base, &chain));
+}
@@ -0,0 +1,19 @@
+#ifndef TESTADDRESSREUSEINDEX_H
+#define TESTADDRESSREUSEINDEX_H
+
+#include <QObject>
+
+class TestAddressReuseIndex : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestChainsMatchFullScan();
+};
+
+#endif // TESTADDRESSREUSEINDEX_H
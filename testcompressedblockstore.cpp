@@ -0,0 +1,300 @@
+#include <QtTest/QtTest>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "heaphistory.h"
+#include "pagefile.h"
+#include "testcompressedblockstore.h"
+
+static const std::string block_tags[7] = { "a", "b", "c", "d", "e", "f",
+  "g" };
+
+// Builds blocks with addresses that jump up and down across the whole 64-bit
+// range, live blocks and zero-length lifetimes.
+static std::vector<HeapBlock> makeBlocks(uint32_t number_of_blocks) {
+  std::vector<HeapBlock> blocks;
+  uint64_t tick = 0;
+  for (uint32_t index = 0; index < number_of_blocks; ++index) {
+    tick += 1 + (index * 7919) % ((index % 100 == 0) ? 100000 : 10);
+    uint64_t address = (index % 50 == 0) ?
+      std::numeric_limits<uint64_t>::max() - 4096 * index :
+      0x10000 + 64 * ((index * 2654435761ULL) % 100000);
+    uint64_t end_tick = (index % 9 == 0) ?
+      std::numeric_limits<uint64_t>::max() : tick + (index * 31) % 5000;
+    blocks.emplace_back(tick, end_tick, 8 + (index * 13) % 70000, address);
+    blocks.back().allocation_tag_ = (index % 3 == 0) ? nullptr :
+      &block_tags[index % 7];
+  }
+  return blocks;
+}
+
+void TestCompressedBlockStore::TestRoundTrip() {
+  std::vector<HeapBlock> blocks = makeBlocks(1000);
+  TagTable tags;
+  CompressedBlockStore store(blocks, &tags, 128);
+  QCOMPARE(store.size(), blocks.size());
+  QCOMPARE(store.getNumberOfChunks(), size_t(8));
+
+  CompressedBlockStore::DecodedChunk chunk;
+  size_t decoded_blocks = 0;
+  for (size_t number = 0; number < store.getNumberOfChunks(); ++number) {
+    store.decodeChunk(number, &chunk);
+    QCOMPARE(chunk.first_index_, uint32_t(number * 128));
+    for (uint32_t offset = 0; offset < chunk.number_of_blocks_; ++offset) {
+      const HeapBlock& block = blocks[chunk.first_index_ + offset];
+      QCOMPARE(chunk.start_ticks_[offset], block.start_tick_);
+      QCOMPARE(chunk.end_ticks_[offset], block.end_tick_);
+      QCOMPARE(chunk.addresses_[offset], block.address_);
+      QCOMPARE(chunk.sizes_[offset], uint64_t(block.size_));
+      QCOMPARE(tags.getTag(static_cast<uint32_t>(
+        chunk.allocation_tags_[offset])) == nullptr,
+        block.allocation_tag_ == nullptr);
+      if (block.allocation_tag_ != nullptr) {
+        QCOMPARE(*tags.getTag(static_cast<uint32_t>(
+          chunk.allocation_tags_[offset])), *block.allocation_tag_);
+      }
+      ++decoded_blocks;
+    }
+  }
+  QCOMPARE(decoded_blocks, blocks.size());
+  QVERIFY(store.getMemoryUsage() < blocks.size() * sizeof(HeapBlock) / 2);
+  QCOMPARE(CompressedBlockStore().getNumberOfChunks(), size_t(0));
+  // Chunks always start at a multiple of 32 blocks.
+  QCOMPARE(CompressedBlockStore(blocks, nullptr, 100).getNumberOfChunks(),
+    size_t(8));
+}
+
+// Every block that passes the culling filter must lie in a chunk that is not
+// skipped.
+void TestCompressedBlockStore::TestSkippedChunksHaveNoActiveBlocks() {
+  std::vector<HeapBlock> blocks = makeBlocks(2000);
+  CompressedBlockStore store(blocks, nullptr, 64);
+  const uint64_t windows[][5] = {
+    // min_size, min_address, max_address, min_tick, max_tick
+    { 0, 0, std::numeric_limits<uint64_t>::max(), 0,
+      std::numeric_limits<uint64_t>::max() },
+    { 1000, 0x20000, 0x40000, 100000, 200000 },
+    { 60000, 0, 0x100000, 0, 50000 },
+    { 0, 0x10000, 0x10040, 3000000, 4000000 },
+  };
+  size_t skipped_chunks = 0;
+  for (const auto& window : windows) {
+    for (size_t index = 0; index < blocks.size(); ++index) {
+      const HeapBlock& block = blocks[index];
+      bool active = (block.size_ >= window[0]) &&
+        (block.address_ <= window[2]) &&
+        (block.address_ + block.size_ >= window[1]) &&
+        (block.end_tick_ >= window[3]) && (block.start_tick_ <= window[4]);
+      if (active) {
+        QVERIFY(store.chunkMayBeActive(index / 64, window[0], window[1],
+          window[2], window[3], window[4]));
+      }
+    }
+    for (size_t number = 0; number < store.getNumberOfChunks(); ++number) {
+      if (!store.chunkMayBeActive(number, window[0], window[1], window[2],
+        window[3], window[4])) {
+        ++skipped_chunks;
+      }
+    }
+  }
+  // The narrow windows should allow skipping most chunks.
+  QVERIFY(skipped_chunks > store.getNumberOfChunks());
+}
+
+// Decodes the chunks of paged-out stores with and without room for caching
+// chunks, and compares them against the same store kept in memory.
+void TestCompressedBlockStore::TestPagedOutChunksMatchInMemory() {
+  std::vector<HeapBlock> blocks = makeBlocks(3000);
+  CompressedBlockStore in_memory(blocks, nullptr, 96);
+  std::string directory = QDir::tempPath().toStdString();
+  // The chunks of this store go to the file as they are encoded, and only
+  // the most recently used one fits into the budget.
+  PageFile uncached_pages;
+  QVERIFY(uncached_pages.open(directory, 0));
+  QVERIFY(uncached_pages.isOnDisk());
+  CompressedBlockStore uncached(blocks, nullptr, 96, &uncached_pages);
+  // The chunks of this store move to the file after they were encoded. The
+  // file is named after an existing file, which must not be overwritten.
+  std::string existing = directory + "/testcompressedblockstore.json";
+  {
+    std::ofstream file(existing, std::fstream::out | std::fstream::binary);
+    file << "[]\n";
+  }
+  PageFile cached_pages;
+  CompressedBlockStore cached(blocks, nullptr, 96, &cached_pages);
+  QVERIFY(cached_pages.open(existing, in_memory.getMemoryUsage()));
+  {
+    std::ifstream file(existing, std::fstream::in | std::fstream::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+    QCOMPARE(contents, std::string("[]\n"));
+  }
+  remove(existing.c_str());
+  QVERIFY(cached_pages.getResidentBytes() == 0);
+  // Building the first store read back chunks to patch them.
+  size_t uncached_reads = uncached_pages.getNumberOfReads();
+
+  CompressedBlockStore::DecodedChunk expected, decoded;
+  const size_t order[] = { 0, 1, 2, 0, 31, 15, 1, 2, 31, 0 };
+  for (size_t number : order) {
+    in_memory.decodeChunk(number, &expected);
+    for (CompressedBlockStore* paged : { &uncached, &cached }) {
+      paged->decodeChunk(number, &decoded);
+      QCOMPARE(decoded.first_index_, expected.first_index_);
+      QCOMPARE(decoded.number_of_blocks_, expected.number_of_blocks_);
+      QCOMPARE(decoded.start_ticks_, expected.start_ticks_);
+      QCOMPARE(decoded.end_ticks_, expected.end_ticks_);
+      QCOMPARE(decoded.addresses_, expected.addresses_);
+      QCOMPARE(decoded.sizes_, expected.sizes_);
+    }
+    QVERIFY(uncached.getMemoryUsage() < in_memory.getMemoryUsage() / 4);
+    QVERIFY(uncached_pages.getResidentBytes() <
+      in_memory.getMemoryUsage() / 4);
+  }
+  QCOMPARE(uncached_pages.getNumberOfReads() - uncached_reads, size_t(10));
+  QCOMPARE(cached_pages.getNumberOfReads(), size_t(5));
+}
+
+// Builds a store the way the heap history does, with frees interleaved with
+// the allocations, and compares the blocks, the free log and the start tick
+// search against the blocks it was built from.
+void TestCompressedBlockStore::TestIncrementalBuildMatchesBlocks() {
+  std::vector<HeapBlock> blocks = makeBlocks(3000);
+  for (size_t index = 0; index < blocks.size(); ++index) {
+    blocks[index].free_tag_ = (index % 5 == 0) ? nullptr :
+      &block_tags[index % 4];
+  }
+  // All events in tick order; allocations come before frees at the same
+  // tick, since some blocks are freed right away.
+  std::vector<std::pair<uint64_t, uint32_t>> events;
+  for (uint32_t index = 0; index < blocks.size(); ++index) {
+    events.emplace_back(2 * blocks[index].start_tick_, index);
+    if (blocks[index].wasFreed()) {
+      events.emplace_back(2 * blocks[index].end_tick_ + 1, index);
+    }
+  }
+  std::sort(events.begin(), events.end());
+
+  TagTable tags;
+  CompressedBlockStore store(&tags, 64);
+  for (const auto& event : events) {
+    const HeapBlock& block = blocks[event.second];
+    if (event.first % 2 == 0) {
+      QCOMPARE(store.append(block), event.second);
+    } else {
+      store.free(event.second, block.end_tick_, block.free_tag_);
+    }
+  }
+  store.finish();
+  QCOMPARE(store.size(), blocks.size());
+
+  store.forEachBlockBetween(0, static_cast<uint32_t>(blocks.size()),
+    [&](uint32_t index, const CompressedBlockStore::DecodedChunk& chunk,
+      uint32_t offset) {
+      HeapBlock block = chunk.getBlock(offset);
+      const HeapBlock& expected = blocks[index];
+      QCOMPARE(block.start_tick_, expected.start_tick_);
+      QCOMPARE(block.end_tick_, expected.end_tick_);
+      QCOMPARE(block.address_, expected.address_);
+      QCOMPARE(block.size_, expected.size_);
+      QCOMPARE(block.allocation_tag_ == nullptr,
+        expected.allocation_tag_ == nullptr);
+      QCOMPARE(block.free_tag_ == nullptr, (expected.free_tag_ == nullptr) ||
+        !expected.wasFreed());
+      if (block.free_tag_ != nullptr) {
+        QCOMPARE(*block.free_tag_, *expected.free_tag_);
+      }
+    });
+  QCOMPARE(store.getBlock(1234).address_, blocks[1234].address_);
+
+  const uint64_t ticks[] = { 0, 1, 1000, 123456, 2000000, 4000000,
+    std::numeric_limits<uint64_t>::max() - 1 };
+  for (uint64_t low : ticks) {
+    uint32_t first = 0;
+    while ((first < blocks.size()) && (blocks[first].start_tick_ <= low)) {
+      ++first;
+    }
+    QCOMPARE(store.getFirstBlockAllocatedAfter(low), first);
+    for (uint64_t high : ticks) {
+      std::vector<std::pair<uint64_t, uint32_t>> expected, frees;
+      for (uint32_t index = 0; index < blocks.size(); ++index) {
+        if (blocks[index].wasFreed() && (blocks[index].end_tick_ > low) &&
+          (blocks[index].end_tick_ <= high)) {
+          expected.emplace_back(blocks[index].end_tick_, index);
+        }
+      }
+      std::stable_sort(expected.begin(), expected.end(),
+        [](const std::pair<uint64_t, uint32_t>& left,
+          const std::pair<uint64_t, uint32_t>& right) {
+          return left.first < right.first;
+        });
+      store.forEachFreeBetween(low, high, [&frees](uint32_t index,
+        uint64_t tick) { frees.emplace_back(tick, index); });
+      QCOMPARE(frees, expected);
+    }
+  }
+}
+
+// Loads the same trace with and without paging. With paging, the pages of
+// the blocks and of the indexes never take more than the budget in memory,
+// and the queries give the same answers.
+void TestCompressedBlockStore::TestPagedHistoryStaysWithinBudget() {
+  std::ostringstream trace;
+  std::vector<bool> allocated(512, false);
+  uint32_t random = 4711;
+  trace << "[\n  {\"type\": \"event\", \"tag\": \"start\"}";
+  for (uint32_t event = 0; event < 100000; ++event) {
+    random = random * 1103515245 + 12345;
+    uint32_t slot = (random >> 16) % allocated.size();
+    uint64_t address = 0x100000 + 0x1000 * slot;
+    if (allocated[slot]) {
+      trace << ",\n  {\"type\": \"free\", \"address\": " << address << "}";
+    } else {
+      trace << ",\n  {\"type\": \"alloc\", \"address\": " << address
+        << ", \"size\": " << 64 * (1 + (random >> 8) % 64) << "}";
+    }
+    allocated[slot] = !allocated[slot];
+  }
+  trace << "\n]\n";
+
+  const size_t budget = 256 * 1024;
+  HeapHistory in_memory, paged;
+  paged.setBlockPaging(QDir::tempPath().toStdString(), budget);
+  QVERIFY(paged.getPageFile().isOnDisk());
+  std::istringstream input(trace.str()), paged_input(trace.str());
+  in_memory.LoadFromJSONStream(input);
+  paged.LoadFromJSONStream(paged_input);
+  // Without paging, the pages would not fit into the budget.
+  QVERIFY(in_memory.getPageFile().getResidentBytes() > 2 * budget);
+  QVERIFY(paged.getPageFile().getResidentBytes() <= budget);
+  QCOMPARE(paged.getNumberOfBlocks(), in_memory.getNumberOfBlocks());
+
+  uint64_t maximum_tick = in_memory.getMaximumTick();
+  for (uint64_t tick = 0; tick < maximum_tick; tick += maximum_tick / 7) {
+    std::vector<uint32_t> expected, live;
+    in_memory.getLiveBlocksAtTick(tick, &expected);
+    paged.getLiveBlocksAtTick(tick, &live);
+    QCOMPARE(live, expected);
+    expected.clear();
+    live.clear();
+    in_memory.getActiveBlockIndices(0, 0x140000, 0x180000, tick,
+      tick + maximum_tick / 20, &expected);
+    paged.getActiveBlockIndices(0, 0x140000, 0x180000, tick,
+      tick + maximum_tick / 20, &live);
+    QCOMPARE(live, expected);
+  }
+  for (uint64_t slot = 0; slot < allocated.size(); slot += 37) {
+    std::vector<uint32_t> expected, chain;
+    QVERIFY(in_memory.getReuseChain(0x100000 + 0x1000 * slot, &expected));
+    QVERIFY(paged.getReuseChain(0x100000 + 0x1000 * slot, &chain));
+    QCOMPARE(chain, expected);
+  }
+  QVERIFY(paged.getPageFile().getNumberOfReads() > 0);
+  QVERIFY(paged.getPageFile().getResidentBytes() <= budget);
+}
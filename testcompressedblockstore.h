@@ -0,0 +1,23 @@
+#ifndef TESTCOMPRESSEDBLOCKSTORE_H
+#define TESTCOMPRESSEDBLOCKSTORE_H
+
+#include <QObject>
+
+class TestCompressedBlockStore : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestRoundTrip();
+  void TestSkippedChunksHaveNoActiveBlocks();
+  void TestPagedOutChunksMatchInMemory();
+  void TestIncrementalBuildMatchesBlocks();
+  void TestPagedHistoryStaysWithinBudget();
+};
+
+#endif // TESTCOMPRESSEDBLOCKSTORE_H
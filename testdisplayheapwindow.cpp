@@ -5,6 +5,26 @@
 #include "heapwindow.h"
 #include "testdisplayheapwindow.h"
 #include "testactiveregioncache.h"
+#include "testaddressreuseindex.h"
+#include "testcompressedblockstore.h"
+#include "testfragmentationtimeline.h"
+#include "testframeprofiler.h"
+#include "testfreegapindex.h"
+#include "testheapdiff.h"
+#include "testhighlightquery.h"
+#include "testhoverinspector.h"
+#include "testlivesetcheckpoints.h"
+#include "testmultipleheaps.h"
+#include "testquadgeometry.h"
+#include "testresidentblockset.h"
+#include "testtagaggregateindex.h"
+#include "testtilerenderer.h"
+#include "testtraceevent.h"
+#include "testtraceindex.h"
+#include "testtraceinputstream.h"
+#include "testtraceshardmerger.h"
+#include "testvarint.h"
+#include "testvertextiles.h"
 
 void TestDisplayHeapWindow::TestLongDoubleTo96Bits() {
   long double test(2);
@@ -78,21 +98,61 @@ void TestDisplayHeapWindow::Test96BitAddition() {
   QCOMPARE(static_cast<uint32_t>(result2.x), 0xFFFFFFE8U);
 }
 
+// The native 64-bit path of the shaders has to agree with the emulated
+// 96-bit path, and be exact for differences that fit into a float.
+void TestDisplayHeapWindow::Test96BitSubtractionFromUint64() {
+  uint64_t state = 0x123456789ABCDEFULL;
+  auto next = [&state]() {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state;
+  };
+  for (uint32_t iteration = 0; iteration < 10000; ++iteration) {
+    uint64_t value = next() >> (next() % 64);
+    // Bases near the value, and anywhere in the 96-bit range.
+    ivec3 base;
+    if (iteration % 2 == 0) {
+      int64_t offset = static_cast<int64_t>(next() >> (40 + next() % 24)) -
+        static_cast<int64_t>(next() >> (40 + next() % 24));
+      base = Load64BitLeftShiftedBy4Into96Bit(
+        static_cast<int32_t>(value + offset),
+        static_cast<int32_t>((value + offset) >> 32));
+      base.x |= static_cast<int32_t>(next() & 0xF);
+    } else {
+      base = ivec3(static_cast<int32_t>(next()), static_cast<int32_t>(next()),
+        static_cast<int32_t>(next()));
+    }
+
+    long double exact = static_cast<long double>(value) * 16 -
+      base.getLongDouble();
+    float native = Sub96FromUint64(value, base);
+    float emulated = Multiply96BitWithFloat(Sub96(
+      Load64BitLeftShiftedBy4Into96Bit(static_cast<int32_t>(value),
+        static_cast<int32_t>(value >> 32)), base), 1.0);
+    if (fabsl(exact) < (1 << 24)) {
+      QCOMPARE(static_cast<long double>(native), exact);
+    }
+    long double tolerance = fabsl(exact) / (1 << 20);
+    QVERIFY(fabsl(native - exact) <= tolerance);
+    QVERIFY(fabsl(native - static_cast<long double>(emulated)) <=
+      2 * tolerance);
+  }
+}
+
 void TestDisplayHeapWindow::MapFromHeapToScreenMaximumPositiveSizes() {
   DisplayHeapWindow display_heap_window;
 
   ivec3 minimum_address(0, 0, 0);
   // Entire 64-bit address space, left-shifted by 4 bits.
   ivec3 maximum_address(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
-  ivec2 minimum_tick(0, 0);
-  // 32-bit tick space, left-shifted by 4 bits.
-  ivec2 maximum_tick(0xFFFFFFF0, 0xF);
+  ivec3 minimum_tick(0, 0, 0);
+  // Entire 64-bit tick space, left-shifted by 4 bits.
+  ivec3 maximum_tick(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
 
   display_heap_window.setMinAndMaxAddress(minimum_address, maximum_address);
   display_heap_window.setMinAndMaxTick(minimum_tick, maximum_tick);
 
   auto result = display_heap_window.mapHeapCoordinateToDisplay(
-      0xFFFFFFFF, 0xFFFFFFFFFFFFFFFFUL);
+      0xFFFFFFFFFFFFFFFFUL, 0xFFFFFFFFFFFFFFFFUL);
   QCOMPARE(result.first, 1.0);
   QCOMPARE(result.second, 1.0);
 
@@ -101,7 +161,7 @@ void TestDisplayHeapWindow::MapFromHeapToScreenMaximumPositiveSizes() {
   QCOMPARE(result2.second, -1.0);
 
   auto result3 = display_heap_window.mapHeapCoordinateToDisplay(
-      0xFFFFFFFF >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
+      0xFFFFFFFFFFFFFFFFUL >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
   QCOMPARE(result3.first, 0.0);
   QCOMPARE(result3.second, 0.0);
 }
@@ -115,18 +175,18 @@ void TestDisplayHeapWindow::MapFromHeapToScreenBottomLeftWindow() {
   ivec3 minimum_address(0, 0, 0);
   // Entire 64-bit address space, left-shifted by 4 bits.
   ivec3 maximum_address(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
-  ivec2 minimum_tick(0, 0);
-  // 32-bit tick space, left-shifted by 4 bits.
-  ivec2 maximum_tick(0xFFFFFFF0, 0xF);
+  ivec3 minimum_tick(0, 0, 0);
+  // Entire 64-bit tick space, left-shifted by 4 bits.
+  ivec3 maximum_tick(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
 
   // Now shift the coordinates left and down.
   ivec3 half_window_height(0xFFFFFFF8, 0xFFFFFFFF, 0x7);
-  ivec2 half_window_width(0xFFFFFFF8, 0x7);
+  ivec3 half_window_width(0xFFFFFFF8, 0xFFFFFFFF, 0x7);
 
   minimum_address = Sub96(minimum_address, half_window_height);
   maximum_address = Sub96(maximum_address, half_window_height);
-  minimum_tick = Sub64(minimum_tick, half_window_width);
-  maximum_tick = Sub64(maximum_tick, half_window_width);
+  minimum_tick = Sub96(minimum_tick, half_window_width);
+  maximum_tick = Sub96(maximum_tick, half_window_width);
 
   display_heap_window.setMinAndMaxAddress(minimum_address, maximum_address);
   display_heap_window.setMinAndMaxTick(minimum_tick, maximum_tick);
@@ -141,7 +201,7 @@ void TestDisplayHeapWindow::MapFromHeapToScreenBottomLeftWindow() {
   // The middle of the current window should now map to the upper right
   // corner of the screen.
   auto result3 = display_heap_window.mapHeapCoordinateToDisplay(
-      0xFFFFFFFF >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
+      0xFFFFFFFFFFFFFFFFUL >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
   // Shoud now map to the top-right corner.
   QCOMPARE(result3.first, 1.0);
   QCOMPARE(result3.second, 1.0);
@@ -156,18 +216,18 @@ void TestDisplayHeapWindow::MapFromHeapToScreenTopRightWindow() {
   ivec3 minimum_address(0, 0, 0);
   // Entire 64-bit address space, left-shifted by 4 bits.
   ivec3 maximum_address(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
-  ivec2 minimum_tick(0, 0);
-  // 32-bit tick space, left-shifted by 4 bits.
-  ivec2 maximum_tick(0xFFFFFFF0, 0xF);
+  ivec3 minimum_tick(0, 0, 0);
+  // Entire 64-bit tick space, left-shifted by 4 bits.
+  ivec3 maximum_tick(0xFFFFFFF0, 0xFFFFFFFF, 0xF);
 
   // Now shift the coordinates right and up.
   ivec3 half_window_height(0xFFFFFFF0, 0xFFFFFFFF, 0x7);
-  ivec2 half_window_width(0xFFFFFFF0, 0x7);
+  ivec3 half_window_width(0xFFFFFFF0, 0xFFFFFFFF, 0x7);
 
   minimum_address = Add96(minimum_address, half_window_height);
   maximum_address = Add96(maximum_address, half_window_height);
-  minimum_tick = Add64(minimum_tick, half_window_width);
-  maximum_tick = Add64(maximum_tick, half_window_width);
+  minimum_tick = Add96(minimum_tick, half_window_width);
+  maximum_tick = Add96(maximum_tick, half_window_width);
 
   display_heap_window.setMinAndMaxAddress(minimum_address, maximum_address);
   display_heap_window.setMinAndMaxTick(minimum_tick, maximum_tick);
@@ -175,7 +235,7 @@ void TestDisplayHeapWindow::MapFromHeapToScreenTopRightWindow() {
   // The origin of the heap coordinate system should now map to the center
   // of the screen.
   auto result2 = display_heap_window.mapHeapCoordinateToDisplay(
-      0xFFFFFFFF, 0xFFFFFFFFFFFFFFFF);
+      0xFFFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF);
   // Should now map to the center of the screen.
   QCOMPARE(result2.first, 0.0);
   QCOMPARE(result2.second, 0.0);
@@ -183,7 +243,7 @@ void TestDisplayHeapWindow::MapFromHeapToScreenTopRightWindow() {
   // The middle of the current window should now map to the lower left
   // corner of the screen.
   auto result3 = display_heap_window.mapHeapCoordinateToDisplay(
-      0xFFFFFFFF >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
+      0xFFFFFFFFFFFFFFFFUL >> 1, 0xFFFFFFFFFFFFFFFFUL >> 1);
   // Shoud now map to the top-right corner.
   QCOMPARE(result3.first, -1.0);
   QCOMPARE(result3.second, -1.0);
@@ -204,6 +264,26 @@ int main(int argc, char** argv)
    ASSERT_TEST(new TestActiveRegionCache());
    printf("What??\n");
    ASSERT_TEST(new TestDisplayHeapWindow());
+   ASSERT_TEST(new TestLiveSetCheckpoints());
+   ASSERT_TEST(new TestHeapDiff());
+   ASSERT_TEST(new TestFreeGapIndex());
+   ASSERT_TEST(new TestFragmentationTimeline());
+   ASSERT_TEST(new TestTagAggregateIndex());
+   ASSERT_TEST(new TestHighlightQuery());
+   ASSERT_TEST(new TestAddressReuseIndex());
+   ASSERT_TEST(new TestVarint());
+   ASSERT_TEST(new TestCompressedBlockStore());
+   ASSERT_TEST(new TestTraceIndex());
+   ASSERT_TEST(new TestTraceEvent());
+   ASSERT_TEST(new TestTraceInputStream());
+   ASSERT_TEST(new TestTraceShardMerger());
+   ASSERT_TEST(new TestMultipleHeaps());
+   ASSERT_TEST(new TestVertexTiles());
+   ASSERT_TEST(new TestQuadGeometry());
+   ASSERT_TEST(new TestResidentBlockSet());
+   ASSERT_TEST(new TestTileRenderer());
+   ASSERT_TEST(new TestHoverInspector());
+   ASSERT_TEST(new TestFrameProfiler());
    return status;
 }
 
@@ -0,0 +1,74 @@
+#include <QtTest/QtTest>
+
+#include "fragmentationtimeline.h"
+#include "testfragmentationtimeline.h"
+
+// Records a sequence of events with gaps between them into a timeline with
+// few buckets (so that buckets get merged several times), and compares every
+// bucket against the minimum and maximum of the per-tick values.
+void TestFragmentationTimeline::TestBucketsMatchFullScan() {
+  FragmentationTimeline timeline(64);
+  const uint64_t maximum_tick = 10000;
+  // The live bytes at every tick, starting with an empty heap at tick 0.
+  std::vector<uint64_t> live_bytes(maximum_tick + 1, 0);
+  uint64_t current = 0;
+  for (uint64_t tick = 1; tick <= maximum_tick; ++tick) {
+    // Only every third tick carries an event.
+    if (tick % 3 == 0) {
+      current = (tick * 7919) % 1000;
+      timeline.recordEvent(tick, current, current / 10, 2000);
+    }
+    live_bytes[tick] = current;
+  }
+  timeline.finish(maximum_tick);
+
+  uint64_t width = timeline.getBucketWidth();
+  QVERIFY(width > 1);
+  QVERIFY(timeline.getNumberOfBuckets() <= 64);
+  QCOMPARE(timeline.getNumberOfBuckets(), size_t(maximum_tick / width + 1));
+  const auto& minimum = timeline.getMinimum(FragmentationTimeline::LiveBytes);
+  const auto& maximum = timeline.getMaximum(FragmentationTimeline::LiveBytes);
+  for (size_t bucket = 0; bucket < timeline.getNumberOfBuckets(); ++bucket) {
+    uint64_t first = bucket * width;
+    uint64_t last = std::min(first + width - 1, maximum_tick);
+    uint64_t expected_minimum = *std::min_element(&live_bytes[first],
+      &live_bytes[last] + 1);
+    uint64_t expected_maximum = *std::max_element(&live_bytes[first],
+      &live_bytes[last] + 1);
+    QCOMPARE(minimum[bucket], expected_minimum);
+    QCOMPARE(maximum[bucket], expected_maximum);
+  }
+  QCOMPARE(timeline.getGlobalMaximum(FragmentationTimeline::LiveBytes),
+    *std::max_element(live_bytes.begin(), live_bytes.end()));
+
+  // With 2000 bytes of span, 500 live bytes means 75% fragmentation.
+  FragmentationTimeline ratio;
+  ratio.recordEvent(1, 500, 1, 2000);
+  QCOMPARE(ratio.getMaximum(FragmentationTimeline::Fragmentation)[1],
+    FragmentationTimeline::fragmentation_scale * 3 / 4);
+}
+
+void TestFragmentationTimeline::TestDecimation() {
+  FragmentationTimeline timeline;
+  for (uint64_t tick = 1; tick <= 1000; ++tick) {
+    timeline.recordEvent(tick, tick, 1, tick);
+  }
+  timeline.finish(1000);
+
+  std::vector<TimelineColumn> columns;
+  timeline.getDecimated(FragmentationTimeline::LiveBytes, 100, 500, 10,
+    &columns);
+  QCOMPARE(columns.size(), size_t(10));
+  for (size_t index = 0; index < columns.size(); ++index) {
+    QCOMPARE(columns[index].tick_, uint64_t(100 + 40 * index));
+    QCOMPARE(columns[index].minimum_, uint64_t(100 + 40 * index));
+    QCOMPARE(columns[index].maximum_, uint64_t(139 + 40 * index));
+  }
+
+  // Requests past the end of the recorded ticks are clipped.
+  columns.clear();
+  timeline.getDecimated(FragmentationTimeline::LiveBytes, 900, 5000, 1000,
+    &columns);
+  QCOMPARE(columns.size(), size_t(101));
+  QCOMPARE(columns.back().maximum_, uint64_t(1000));
+}
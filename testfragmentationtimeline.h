@@ -0,0 +1,20 @@
+#ifndef TESTFRAGMENTATIONTIMELINE_H
+#define TESTFRAGMENTATIONTIMELINE_H
+
+#include <QObject>
+
+class TestFragmentationTimeline : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestBucketsMatchFullScan();
+  void TestDecimation();
+};
+
+#endif // TESTFRAGMENTATIONTIMELINE_H
@@ -0,0 +1,145 @@
+#include <QtTest/QtTest>
+
+#include <cmath>
+#include <sstream>
+
+#include "frameprofiler.h"
+#include "testframeprofiler.h"
+
+void TestFrameProfiler::TestScopesRecordOnlyRunningFrames() {
+  FrameProfiler profiler;
+  // A disabled profiler records nothing.
+  QCOMPARE(profiler.beginFrame(), static_cast<uint64_t>(0));
+  {
+    FrameProfiler::Scope scope(&profiler, "ignored");
+  }
+  profiler.endFrame();
+  QVERIFY(profiler.getFrames().empty());
+  {
+    FrameProfiler::Scope scope(nullptr, "ignored");
+  }
+
+  profiler.setEnabled(true);
+  QCOMPARE(profiler.beginFrame(), static_cast<uint64_t>(1));
+  {
+    FrameProfiler::Scope outer(&profiler, "outer");
+    FrameProfiler::Scope inner(&profiler, "inner");
+  }
+  profiler.endFrame();
+  // Outside of a frame.
+  {
+    FrameProfiler::Scope scope(&profiler, "ignored");
+  }
+
+  QCOMPARE(profiler.getFrames().size(), static_cast<size_t>(1));
+  const FrameProfiler::Frame& frame = profiler.getFrames().front();
+  QCOMPARE(frame.number_, static_cast<uint64_t>(1));
+  QCOMPARE(frame.sections_.size(), static_cast<size_t>(2));
+  // The inner scope ends first, and lies within the outer one, which lies
+  // within the frame.
+  const FrameProfiler::Section& inner = frame.sections_[0];
+  const FrameProfiler::Section& outer = frame.sections_[1];
+  QCOMPARE(inner.name_, std::string("inner"));
+  QCOMPARE(outer.name_, std::string("outer"));
+  QVERIFY(!inner.gpu_ && !outer.gpu_);
+  QVERIFY(outer.start_ >= frame.start_);
+  QVERIFY(inner.start_ >= outer.start_);
+  QVERIFY(inner.start_ + inner.duration_ <= outer.start_ + outer.duration_);
+  QVERIFY(outer.start_ + outer.duration_ <= frame.start_ + frame.duration_);
+}
+
+void TestFrameProfiler::TestGPUSectionsJoinTheirFrame() {
+  FrameProfiler profiler;
+  profiler.setEnabled(true);
+  for (uint32_t frame = 0; frame < 3; ++frame) {
+    profiler.beginFrame();
+    profiler.endFrame();
+  }
+  // The result of a query from the first frame arrives during the fourth.
+  QCOMPARE(profiler.beginFrame(), static_cast<uint64_t>(4));
+  QCOMPARE(profiler.getCurrentFrame(), static_cast<uint64_t>(4));
+  profiler.addGpuSection(1, "blocks.paint", 100, 5000);
+  profiler.endFrame();
+  QCOMPARE(profiler.getCurrentFrame(), static_cast<uint64_t>(0));
+  const FrameProfiler::Frame& first = profiler.getFrames().front();
+  QCOMPARE(first.sections_.size(), static_cast<size_t>(1));
+  QVERIFY(first.sections_[0].gpu_);
+  QCOMPARE(first.sections_[0].duration_, static_cast<uint64_t>(5000));
+  QVERIFY(profiler.getFrames().back().sections_.empty());
+
+  // Only the last history_size frames are kept, and late results for the
+  // dropped ones are ignored.
+  for (size_t frame = 0; frame < FrameProfiler::history_size; ++frame) {
+    profiler.beginFrame();
+    profiler.endFrame();
+  }
+  QCOMPARE(profiler.getFrames().size(), FrameProfiler::history_size);
+  QCOMPARE(profiler.getFrames().front().number_, static_cast<uint64_t>(5));
+  profiler.addGpuSection(2, "blocks.paint", 100, 5000);
+  profiler.addGpuSection(1000, "blocks.paint", 100, 5000);
+  for (const FrameProfiler::Frame& frame : profiler.getFrames()) {
+    QVERIFY(frame.sections_.empty());
+  }
+}
+
+void TestFrameProfiler::TestAverages() {
+  FrameProfiler profiler;
+  profiler.setEnabled(true);
+  // Two frames: the first culls for 2ms, the second does not cull at all.
+  profiler.beginFrame();
+  profiler.addCpuSection("blocks.cull", 0, 2000000);
+  profiler.addCpuSection("blocks.paint", 0, 1000000);
+  profiler.endFrame();
+  profiler.beginFrame();
+  profiler.addCpuSection("blocks.paint", 0, 3000000);
+  profiler.addGpuSection(2, "blocks.paint", 0, 4000000);
+  profiler.endFrame();
+  // The running frame does not count yet.
+  profiler.beginFrame();
+  profiler.addCpuSection("blocks.cull", 0, 100000000);
+
+  std::vector<FrameProfiler::Average> averages = profiler.getAverages(60);
+  QCOMPARE(averages.size(), static_cast<size_t>(4));
+  QCOMPARE(averages[0].name_, std::string("frame"));
+  QCOMPARE(averages[1].name_, std::string("blocks.cull"));
+  QVERIFY(std::abs(averages[1].milliseconds_ - 1.0) < 1e-9);
+  QCOMPARE(averages[2].name_, std::string("blocks.paint"));
+  QVERIFY(!averages[2].gpu_);
+  QVERIFY(std::abs(averages[2].milliseconds_ - 2.0) < 1e-9);
+  QCOMPARE(averages[3].name_, std::string("blocks.paint"));
+  QVERIFY(averages[3].gpu_);
+  QVERIFY(std::abs(averages[3].milliseconds_ - 2.0) < 1e-9);
+
+  // Only the last frame.
+  averages = profiler.getAverages(1);
+  QCOMPARE(averages.size(), static_cast<size_t>(3));
+  QVERIFY(std::abs(averages[1].milliseconds_ - 3.0) < 1e-9);
+}
+
+void TestFrameProfiler::TestChromeTrace() {
+  FrameProfiler profiler;
+  profiler.setEnabled(true);
+  profiler.beginFrame();
+  profiler.addCpuSection("blocks.vertices", 1500, 2000250);
+  profiler.addGpuSection(1, "say \"cheese\"", 3000, 42);
+  profiler.endFrame();
+  // The running frame is left out.
+  profiler.beginFrame();
+  profiler.addCpuSection("unfinished", 0, 1);
+
+  std::ostringstream out;
+  profiler.writeChromeTrace(out);
+  std::string trace = out.str();
+  QVERIFY(trace.find("\"traceEvents\":[") != std::string::npos);
+  QVERIFY(trace.find("{\"name\":\"frame 1\",\"cat\":\"frame\",\"ph\":\"X\","
+    "\"pid\":1,\"tid\":1,") != std::string::npos);
+  // Microseconds, down to the nanosecond.
+  QVERIFY(trace.find("{\"name\":\"blocks.vertices\",\"cat\":\"cpu\","
+    "\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":1.500,\"dur\":2000.250}") !=
+    std::string::npos);
+  QVERIFY(trace.find("{\"name\":\"say \\\"cheese\\\"\",\"cat\":\"gpu\","
+    "\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":3.000,\"dur\":0.042}") !=
+    std::string::npos);
+  QVERIFY(trace.find("unfinished") == std::string::npos);
+  QCOMPARE(trace.substr(trace.size() - 4), std::string("\n]}\n"));
+}
@@ -0,0 +1,22 @@
+#ifndef TESTFRAMEPROFILER_H
+#define TESTFRAMEPROFILER_H
+
+#include <QObject>
+
+class TestFrameProfiler : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestScopesRecordOnlyRunningFrames();
+  void TestGPUSectionsJoinTheirFrame();
+  void TestAverages();
+  void TestChromeTrace();
+};
+
+#endif // TESTFRAMEPROFILER_H
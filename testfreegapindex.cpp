@@ -0,0 +1,140 @@
+#include <QtTest/QtTest>
+
+#include "compressedblockstore.h"
+#include "freegapindex.h"
+#include "heapblock.h"
+#include "livesetcheckpoints.h"
+#include "testfreegapindex.h"
+
+typedef std::vector<std::pair<uint64_t, uint64_t>> GapVector;
+
+void TestFreeGapIndex::TestFreeIntervalSet() {
+  FreeIntervalSet intervals(0x1000, 0x2000);
+  QCOMPARE(intervals.getLargestGap(), 0x1000ULL);
+
+  intervals.allocate(0x1100, 0x1200);
+  intervals.allocate(0x1800, 0x1900);
+  QCOMPARE(intervals.getNumberOfGaps(), size_t(3));
+  QCOMPARE(intervals.getLargestGap(), 0x700ULL);
+
+  GapVector gaps;
+  intervals.getGaps(0x100, 0x1000, 0x2000, &gaps);
+  GapVector expected = { { 0x1000, 0x1100 }, { 0x1200, 0x1800 },
+    { 0x1900, 0x2000 } };
+  QCOMPARE(gaps, expected);
+
+  // Clipping to the query range, and filtering by size.
+  gaps.clear();
+  intervals.getGaps(0x200, 0x1080, 0x1a00, &gaps);
+  expected = { { 0x1200, 0x1800 } };
+  QCOMPARE(gaps, expected);
+
+  // Releasing merges the adjacent free intervals again.
+  intervals.release(0x1100, 0x1200);
+  QCOMPARE(intervals.getNumberOfGaps(), size_t(2));
+  QCOMPARE(intervals.getLargestGap(), 0x800ULL);
+
+  // Releasing a block that overlaps a still-live block must not free the
+  // memory of the live block.
+  intervals.allocate(0x1000, 0x1400);
+  intervals.allocate(0x1300, 0x1500);
+  intervals.release(0x1000, 0x1400);
+  gaps.clear();
+  intervals.getGaps(1, 0x1000, 0x1800, &gaps);
+  expected = { { 0x1000, 0x1300 }, { 0x1500, 0x1800 } };
+  QCOMPARE(gaps, expected);
+}
+
+// Compares gap queries and the largest-gap curve against a brute-force
+// computation from the set of live blocks.
+void TestFreeGapIndex::TestFreeGapsMatchFullScan() {
+  std::vector<HeapBlock> blocks;
+  const uint64_t base = 0x10000;
+  const uint64_t number_of_slots = 512;
+  uint64_t tick = 0;
+  for (uint32_t index = 0; index < 4000; ++index) {
+    tick += 5;
+    uint32_t lifetime = (index * 7919) % 15000;
+    uint64_t end_tick = (index % 13 == 0) ?
+      std::numeric_limits<uint64_t>::max() : tick + 1 + lifetime;
+    uint64_t size = 16 * (1 + (index * 31) % 4);
+    uint64_t address = base +
+      64 * ((index * 2654435761ULL) % number_of_slots);
+    blocks.emplace_back(tick, end_tick, size, address);
+  }
+  uint64_t maximum_tick = tick + 15001;
+  uint64_t maximum_address = base + 64 * number_of_slots;
+  CompressedBlockStore store(blocks, nullptr, 256);
+  LiveSetCheckpoints checkpoints(maximum_tick, &store);
+  FreeGapIndex index(maximum_tick, base, maximum_address, &store,
+    &checkpoints);
+
+  // Marks every 16-byte granule that is covered by a live block at |query|.
+  auto bruteForceUsage = [&](uint64_t query) {
+    std::vector<bool> used(64 * number_of_slots / 16, false);
+    for (const HeapBlock& block : blocks) {
+      if ((block.start_tick_ <= query) && (block.end_tick_ > query)) {
+        for (uint64_t address = block.address_;
+          address < block.address_ + block.size_; address += 16) {
+          used[(address - base) / 16] = true;
+        }
+      }
+    }
+    return used;
+  };
+  auto bruteForceGaps = [&](const std::vector<bool>& used) {
+    GapVector gaps;
+    for (size_t granule = 0; granule < used.size(); ++granule) {
+      if (used[granule]) {
+        continue;
+      }
+      uint64_t start = base + 16 * granule;
+      while ((granule < used.size()) && !used[granule]) {
+        ++granule;
+      }
+      gaps.emplace_back(start, base + 16 * granule);
+    }
+    return gaps;
+  };
+
+  // Queries go both forward and backward in time, to exercise both reuse of
+  // the previous sweep and restarting from a checkpoint.
+  std::vector<uint32_t> queries;
+  for (uint64_t query = 0; query <= maximum_tick + 100; query += 1231) {
+    queries.push_back(query);
+  }
+  queries.push_back(7);
+  queries.push_back(maximum_tick / 2);
+  queries.push_back(maximum_tick / 2 + 1);
+  for (uint64_t query : queries) {
+    GapVector expected = bruteForceGaps(bruteForceUsage(query));
+    GapVector gaps;
+    index.getFreeGapsAtTick(query, 1, base, maximum_address - 1, &gaps);
+    QCOMPARE(gaps, expected);
+
+    // Only gaps of at least 128 bytes in the upper half of the range.
+    uint64_t middle = base + 32 * number_of_slots;
+    GapVector filtered;
+    for (const auto& gap : expected) {
+      uint64_t start = std::max(gap.first, middle);
+      if ((gap.second > start) && (gap.second - start >= 128)) {
+        filtered.emplace_back(start, gap.second);
+      }
+    }
+    gaps.clear();
+    index.getFreeGapsAtTick(query, 128, middle, maximum_address - 1, &gaps);
+    QCOMPARE(gaps, filtered);
+  }
+
+  const std::vector<uint64_t>& curve = index.getLargestGapCurve();
+  uint64_t width = index.getCurveBucketWidth();
+  QVERIFY(curve.size() > 1);
+  for (size_t bucket = 0; bucket < curve.size(); bucket += 97) {
+    uint64_t query = (bucket + 1) * width;
+    uint64_t largest = 0;
+    for (const auto& gap : bruteForceGaps(bruteForceUsage(query))) {
+      largest = std::max(largest, gap.second - gap.first);
+    }
+    QCOMPARE(curve[bucket], largest);
+  }
+}
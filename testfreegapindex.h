@@ -0,0 +1,20 @@
+#ifndef TESTFREEGAPINDEX_H
+#define TESTFREEGAPINDEX_H
+
+#include <QObject>
+
+class TestFreeGapIndex : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestFreeIntervalSet();
+  void TestFreeGapsMatchFullScan();
+};
+
+#endif // TESTFREEGAPINDEX_H
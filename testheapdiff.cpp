@@ -0,0 +1,126 @@
+#include <QtTest/QtTest>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "heapdiff.h"
+#include "livesetcheckpoints.h"
+#include "testheapdiff.h"
+
+// A history that spans several checkpoints, in which every tenth block is
+// never freed.
+static uint64_t buildBlocks(std::vector<HeapBlock>* blocks) {
+  uint64_t tick = 0;
+  for (uint32_t index = 0; index < 5000; ++index) {
+    tick += 3;
+    uint32_t lifetime = (index * 7919) % 20000;
+    uint64_t end_tick = (index % 10 == 0) ?
+      std::numeric_limits<uint64_t>::max() : tick + 1 + lifetime;
+    blocks->emplace_back(tick, end_tick, 16, 0x1000 + 16 * index);
+  }
+  return tick + 20001;
+}
+
+static bool isAlive(const HeapBlock& block, uint64_t tick) {
+  return (block.start_tick_ <= tick) && (block.end_tick_ > tick);
+}
+
+// Compares all four sets of the diff against a brute-force scan over all
+// blocks.
+static void compareWithFullScan(const std::vector<HeapBlock>& blocks,
+  const HeapDiff& diff) {
+  std::vector<uint32_t> allocated, freed, transient, survived;
+  for (uint32_t index = 0; index < blocks.size(); ++index) {
+    bool before = isAlive(blocks[index], diff.from_tick_);
+    bool after = isAlive(blocks[index], diff.to_tick_);
+    bool started = (blocks[index].start_tick_ > diff.from_tick_) &&
+      (blocks[index].start_tick_ <= diff.to_tick_);
+    if (started && after) {
+      allocated.push_back(index);
+    } else if (started) {
+      transient.push_back(index);
+    } else if (before && after) {
+      survived.push_back(index);
+    } else if (before) {
+      freed.push_back(index);
+    }
+  }
+  QCOMPARE(diff.allocated_, allocated);
+  QCOMPARE(diff.freed_, freed);
+  QCOMPARE(diff.transient_, transient);
+  QCOMPARE(diff.survived_, survived);
+}
+
+void TestHeapDiff::TestDiffMatchesFullScan() {
+  std::vector<HeapBlock> blocks;
+  uint64_t maximum_tick = buildBlocks(&blocks);
+  CompressedBlockStore store(blocks, nullptr, 256);
+  LiveSetCheckpoints checkpoints(maximum_tick, &store);
+  QVERIFY(checkpoints.getNumberOfCheckpoints() > 2);
+
+  const uint64_t ticks[] = { 0, 1, 2, 3, 997, 4096, 4097, 9000, 14999,
+    15001, 20000, maximum_tick, maximum_tick + 100 };
+  for (uint64_t from : ticks) {
+    for (uint64_t to : ticks) {
+      if (from > to) {
+        continue;
+      }
+      HeapDiff diff(checkpoints, &store, from, to, true);
+      QCOMPARE(diff.from_tick_, from);
+      QCOMPARE(diff.to_tick_, to);
+      compareWithFullScan(blocks, diff);
+      QCOMPARE(diff.numberOfChanges(), diff.allocated_.size() +
+        diff.freed_.size() + diff.transient_.size());
+    }
+  }
+
+  // Without survivors, the other sets stay the same.
+  HeapDiff with(checkpoints, &store, 997, 9000, true);
+  HeapDiff without(checkpoints, &store, 997, 9000);
+  QVERIFY(without.survived_.empty());
+  QCOMPARE(without.allocated_, with.allocated_);
+  QCOMPARE(without.freed_, with.freed_);
+  QCOMPARE(without.transient_, with.transient_);
+}
+
+// Nothing changes between a tick and itself, and everything alive survives.
+void TestHeapDiff::TestSameTick() {
+  std::vector<HeapBlock> blocks;
+  uint64_t maximum_tick = buildBlocks(&blocks);
+  CompressedBlockStore store(blocks, nullptr, 256);
+  LiveSetCheckpoints checkpoints(maximum_tick, &store);
+
+  for (uint64_t tick : { uint64_t(0), uint64_t(3), uint64_t(7000),
+    maximum_tick }) {
+    HeapDiff diff(checkpoints, &store, tick, tick, true);
+    QCOMPARE(diff.numberOfChanges(), size_t(0));
+    std::vector<uint32_t> live;
+    checkpoints.getLiveBlocksAtTick(tick, &live);
+    QCOMPARE(diff.survived_, live);
+    compareWithFullScan(blocks, diff);
+  }
+}
+
+// The ticks are put in order, so a reversed pair gives the same diff.
+void TestHeapDiff::TestReversedTicks() {
+  std::vector<HeapBlock> blocks;
+  uint64_t maximum_tick = buildBlocks(&blocks);
+  CompressedBlockStore store(blocks, nullptr, 256);
+  LiveSetCheckpoints checkpoints(maximum_tick, &store);
+
+  HeapDiff forward(checkpoints, &store, 2000, 11000, true);
+  HeapDiff reversed(checkpoints, &store, 11000, 2000, true);
+  QCOMPARE(reversed.from_tick_, uint64_t(2000));
+  QCOMPARE(reversed.to_tick_, uint64_t(11000));
+  QCOMPARE(reversed.allocated_, forward.allocated_);
+  QCOMPARE(reversed.freed_, forward.freed_);
+  QCOMPARE(reversed.transient_, forward.transient_);
+  QCOMPARE(reversed.survived_, forward.survived_);
+  compareWithFullScan(blocks, reversed);
+  // Blocks that are never freed only ever show up as allocated or survived.
+  for (uint32_t index : reversed.freed_) {
+    QVERIFY(blocks[index].wasFreed());
+  }
+  for (uint32_t index : reversed.transient_) {
+    QVERIFY(blocks[index].wasFreed());
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef TESTHEAPDIFF_H
+#define TESTHEAPDIFF_H
+
+#include <QObject>
+
+class TestHeapDiff : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestDiffMatchesFullScan();
+  void TestSameTick();
+  void TestReversedTicks();
+};
+
+#endif // TESTHEAPDIFF_H
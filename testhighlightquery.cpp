@@ -0,0 +1,97 @@
+#include <QtTest/QtTest>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "highlightquery.h"
+#include "tagaggregateindex.h"
+#include "tagtable.h"
+#include "testhighlightquery.h"
+
+void TestHighlightQuery::TestCompile() {
+  const std::string tag_names[2] = { "parser", "network" };
+  std::vector<HeapBlock> blocks;
+  blocks.emplace_back(1, 10, 16, 0x1000);
+  blocks.back().allocation_tag_ = &tag_names[0];
+  blocks.emplace_back(2, 10, 16, 0x2000);
+  blocks.back().allocation_tag_ = &tag_names[1];
+  TagTable table;
+  TagAggregateIndex tags(10, CompressedBlockStore(blocks, &table), table);
+
+  HighlightQuery query;
+  std::string error;
+  QVERIFY(HighlightQuery::compile("size=16-0x40 lifetime=100- "
+    "address=0x1000-0x2000 tag=network alive", tags, &query, &error));
+  QCOMPARE(query.minimum_size_, uint64_t(16));
+  QCOMPARE(query.maximum_size_, uint64_t(64));
+  QCOMPARE(query.minimum_lifetime_, uint64_t(100));
+  QCOMPARE(query.maximum_lifetime_, std::numeric_limits<uint64_t>::max());
+  QCOMPARE(query.minimum_address_, uint64_t(0x1000));
+  QCOMPARE(query.maximum_address_, uint64_t(0x2000));
+  QVERIFY(query.alive_at_end_);
+  uint32_t network;
+  QVERIFY(tags.getTagId("network", &network));
+  QVERIFY(query.tags_[network]);
+
+  QVERIFY(HighlightQuery::compile("size=32", tags, &query, &error));
+  QCOMPARE(query.minimum_size_, uint64_t(32));
+  QCOMPARE(query.maximum_size_, uint64_t(32));
+  QVERIFY(!query.alive_at_end_);
+
+  QVERIFY(!HighlightQuery::compile("size=abc", tags, &query, &error));
+  QVERIFY(!HighlightQuery::compile("size=64-16", tags, &query, &error));
+  QVERIFY(!HighlightQuery::compile("tag=unknown", tags, &query, &error));
+  QVERIFY(!HighlightQuery::compile("color=red", tags, &query, &error));
+}
+
+// Evaluates queries over enough blocks to use several threads, and compares
+// the bitset against a serial scan over the blocks.
+void TestHighlightQuery::TestEvaluateMatchesFullScan() {
+  const std::string tag_names[3] = { "a", "b", "c" };
+  std::vector<HeapBlock> blocks;
+  const uint32_t number_of_blocks = 300001;
+  for (uint32_t index = 0; index < number_of_blocks; ++index) {
+    uint64_t end_tick = (index % 5 == 0) ?
+      std::numeric_limits<uint64_t>::max() :
+      index + 1 + (index * 7919) % 5000;
+    blocks.emplace_back(index, end_tick, 8 * (1 + index % 64),
+      0x10000 + 64 * ((index * 2654435761ULL) % 100000));
+    blocks.back().allocation_tag_ = &tag_names[index % 3];
+  }
+  uint64_t maximum_tick = number_of_blocks + 5000;
+  TagTable table;
+  // Small chunks, so that the threads get several chunks each.
+  CompressedBlockStore store(blocks, &table, 4096);
+  TagAggregateIndex tags(maximum_tick, store, table);
+
+  uint32_t tag_b;
+  QVERIFY(tags.getTagId("b", &tag_b));
+  for (const char* text : { "size=64-128", "tag=b lifetime=-1000",
+    "alive address=0x20000-0x40000", "" }) {
+    HighlightQuery query;
+    std::string error;
+    QVERIFY(HighlightQuery::compile(text, tags, &query, &error));
+    std::vector<uint32_t> bits;
+    size_t count = query.evaluate(store, maximum_tick, &bits);
+    QCOMPARE(bits.size(), size_t((number_of_blocks + 31) / 32));
+
+    size_t expected_count = 0;
+    for (uint32_t index = 0; index < number_of_blocks; ++index) {
+      const HeapBlock& block = blocks[index];
+      bool alive = !block.wasFreed();
+      uint64_t lifetime = (alive ? maximum_tick : block.end_tick_) -
+        block.start_tick_;
+      bool expected = (query.minimum_size_ <= block.size_) &&
+        (block.size_ <= query.maximum_size_) &&
+        (query.minimum_lifetime_ <= lifetime) &&
+        (lifetime <= query.maximum_lifetime_) &&
+        (block.address_ <= query.maximum_address_) &&
+        (block.address_ + block.size_ > query.minimum_address_) &&
+        (alive || !query.alive_at_end_) &&
+        (query.tags_.empty() || (block.allocation_tag_ == &tag_names[1]));
+      bool actual = (bits[index / 32] >> (index % 32)) & 1;
+      QCOMPARE(actual, expected);
+      expected_count += expected;
+    }
+    QCOMPARE(count, expected_count);
+  }
+}
@@ -0,0 +1,20 @@
+#ifndef TESTHIGHLIGHTQUERY_H
+#define TESTHIGHLIGHTQUERY_H
+
+#include <QObject>
+
+class TestHighlightQuery : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestCompile();
+  void TestEvaluateMatchesFullScan();
+};
+
+#endif // TESTHIGHLIGHTQUERY_H
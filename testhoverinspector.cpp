@@ -0,0 +1,124 @@
+#include <QtTest/QtTest>
+
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+#include "heapblock.h"
+#include "heaphistory.h"
+#include "hoverinspector.h"
+#include "testhoverinspector.h"
+
+// Allocates and frees blocks in 32 address slots, with an event every 1000
+// ticks, so that some points are far away from any event.
+static std::string makeTrace(uint32_t number_of_events) {
+  std::ostringstream trace;
+  std::vector<bool> allocated(32, false);
+  uint32_t random = 2024;
+  trace << "[\n  {\"type\": \"event\", \"tag\": \"start\"}";
+  for (uint32_t event = 0; event < number_of_events; ++event) {
+    if (event % 1000 == 999) {
+      trace << ",\n  {\"type\": \"event\", \"tag\": \"event " << event
+        << "\"}";
+      continue;
+    }
+    random = random * 1103515245 + 12345;
+    uint32_t slot = (random >> 16) % allocated.size();
+    uint64_t address = 0x10000 + 0x1000 * slot;
+    if (allocated[slot]) {
+      trace << ",\n  {\"type\": \"free\", \"address\": " << address << "}";
+    } else {
+      trace << ",\n  {\"type\": \"alloc\", \"address\": " << address
+        << ", \"size\": " << 128 * (1 + (random >> 8) % 32) << "}";
+    }
+    allocated[slot] = !allocated[slot];
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+void TestHoverInspector::TestDescribeMatchesFullScan() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(3000));
+  history.LoadFromJSONStream(trace);
+
+  uint32_t random = 99;
+  size_t blocks = 0;
+  size_t events = 0;
+  size_t nothing = 0;
+  for (uint32_t point = 0; point < 500; ++point) {
+    random = random * 1103515245 + 12345;
+    uint64_t tick = history.getMinimumTick() + (random >> 8) %
+      (history.getMaximumTick() - history.getMinimumTick() + 1);
+    random = random * 1103515245 + 12345;
+    uint64_t address = 0x10000 + (random >> 8) % 0x21000;
+
+    HeapBlock block;
+    uint32_t index = 0;
+    std::string expected;
+    bool found = history.getBlockAtSlow(address, tick, &block, &index);
+    if (found) {
+      expected = getBlockInformationAsString(block);
+      ++blocks;
+    } else if (history.getEventAtTick(tick, &expected)) {
+      ++events;
+    } else {
+      ++nothing;
+    }
+    std::string description = HoverInspector::describe(history, tick,
+      address, 0);
+    QVERIFY(description.size() >= expected.size());
+    QCOMPARE(description.substr(description.size() - expected.size()),
+      expected);
+    QCOMPARE(description.empty(), expected.empty());
+    // The answer when the GPU picking finds the same block (or none).
+    QCOMPARE(HoverInspector::describePicked(history, tick, found, index),
+      found ? expected : description);
+  }
+  QVERIFY(blocks > 0);
+  QVERIFY(events > 0);
+  QVERIFY(nothing > 0);
+}
+
+void TestHoverInspector::TestOnlyLatestQuestionIsAnswered() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(1000));
+  history.LoadFromJSONStream(trace);
+
+  std::mutex mutex;
+  std::condition_variable answered;
+  std::vector<std::pair<uint64_t, std::string>> answers;
+  HoverInspector inspector(&history);
+  inspector.setResultCallback(
+    [&](uint64_t serial, const std::string& description) {
+      std::lock_guard<std::mutex> lock(mutex);
+      answers.emplace_back(serial, description);
+      answered.notify_all();
+    });
+
+  // A quick burst of mouse moves gets one answer, for the last one.
+  uint64_t serial = 0;
+  for (uint64_t tick = 10; tick < 30; ++tick) {
+    serial = inspector.inspect(tick, 0x10000, 0);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    QVERIFY(answered.wait_for(lock, std::chrono::seconds(10),
+      [&answers]() { return !answers.empty(); }));
+  }
+  std::this_thread::sleep_for(HoverInspector::debounce_interval * 3);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    QCOMPARE(answers.size(), size_t(1));
+    QCOMPARE(answers[0].first, serial);
+    QCOMPARE(answers[0].second,
+      HoverInspector::describe(history, 29, 0x10000, 0));
+  }
+
+  // A cancelled question is not answered.
+  inspector.inspect(100, 0x10000, 0);
+  inspector.cancel();
+  std::this_thread::sleep_for(HoverInspector::debounce_interval * 3);
+  std::lock_guard<std::mutex> lock(mutex);
+  QCOMPARE(answers.size(), size_t(1));
+}
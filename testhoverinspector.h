@@ -0,0 +1,20 @@
+#ifndef TESTHOVERINSPECTOR_H
+#define TESTHOVERINSPECTOR_H
+
+#include <QObject>
+
+class TestHoverInspector : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestDescribeMatchesFullScan();
+  void TestOnlyLatestQuestionIsAnswered();
+};
+
+#endif // TESTHOVERINSPECTOR_H
@@ -0,0 +1,74 @@
+#include <QtTest/QtTest>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "livesetcheckpoints.h"
+#include "testlivesetcheckpoints.h"
+
+void TestLiveSetCheckpoints::TestCheckpointInterval() {
+  QCOMPARE(LiveSetCheckpoints::calculateCheckpointInterval(100, 10, 100),
+    uint64_t(4096));
+  QCOMPARE(LiveSetCheckpoints::calculateCheckpointInterval(4096 * 1024, 10,
+    10000), uint64_t(4096));
+  QCOMPARE(LiveSetCheckpoints::calculateCheckpointInterval(4096 * 1025, 10,
+    10000), uint64_t(8192));
+  // A large live set forces the checkpoints further apart: 1024 checkpoints
+  // of 1000 live blocks each exceed the budget of 8 entries for each of the
+  // 100000 blocks.
+  QCOMPARE(LiveSetCheckpoints::calculateCheckpointInterval(4096 * 1024, 1000,
+    100000), uint64_t(8192));
+}
+
+// Builds a history that spans several checkpoints and compares the result of
+// every query against a brute-force scan over all blocks.
+void TestLiveSetCheckpoints::TestLiveSetMatchesFullScan() {
+  std::vector<HeapBlock> blocks;
+  uint64_t tick = 0;
+  for (uint32_t index = 0; index < 5000; ++index) {
+    tick += 3;
+    uint32_t lifetime = (index * 7919) % 20000;
+    // Every tenth block stays alive until the end.
+    uint64_t end_tick = (index % 10 == 0) ?
+      std::numeric_limits<uint64_t>::max() : tick + 1 + lifetime;
+    blocks.emplace_back(tick, end_tick, 16, 0x1000 + 16 * index);
+  }
+  uint64_t maximum_tick = tick + 20001;
+  // Small chunks, so that the replays cross chunk boundaries.
+  CompressedBlockStore store(blocks, nullptr, 256);
+  LiveSetCheckpoints checkpoints(maximum_tick, &store);
+  QVERIFY(checkpoints.getNumberOfCheckpoints() > 2);
+
+  for (uint64_t query = 0; query <= maximum_tick + 100; query += 997) {
+    std::vector<uint32_t> expected;
+    for (uint32_t index = 0; index < blocks.size(); ++index) {
+      if ((blocks[index].start_tick_ <= query) &&
+          (blocks[index].end_tick_ > query)) {
+        expected.push_back(index);
+      }
+    }
+    std::vector<uint32_t> live;
+    checkpoints.getLiveBlocksAtTick(query, &live);
+    QCOMPARE(live, expected);
+  }
+}
+
+// Ticks above 2^32 must neither wrap around nor alias with small ticks.
+void TestLiveSetCheckpoints::TestTicksBeyond32Bits() {
+  const uint64_t base = static_cast<uint64_t>(1) << 40;
+  std::vector<HeapBlock> blocks;
+  blocks.emplace_back(base + 1, base + 3, 16, 0x1000);
+  blocks.emplace_back(base + 2, std::numeric_limits<uint64_t>::max(), 16,
+    0x1010);
+  CompressedBlockStore store(blocks, nullptr);
+  LiveSetCheckpoints checkpoints(base + 10, &store);
+
+  std::vector<uint32_t> live;
+  checkpoints.getLiveBlocksAtTick(base + 2, &live);
+  QCOMPARE(live, std::vector<uint32_t>({ 0, 1 }));
+  live.clear();
+  checkpoints.getLiveBlocksAtTick(base + 3, &live);
+  QCOMPARE(live, std::vector<uint32_t>({ 1 }));
+  live.clear();
+  checkpoints.getLiveBlocksAtTick(2, &live);
+  QVERIFY(live.empty());
+}
@@ -0,0 +1,21 @@
+#ifndef TESTLIVESETCHECKPOINTS_H
+#define TESTLIVESETCHECKPOINTS_H
+
+#include <QObject>
+
+class TestLiveSetCheckpoints : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestCheckpointInterval();
+  void TestLiveSetMatchesFullScan();
+  void TestTicksBeyond32Bits();
+};
+
+#endif // TESTLIVESETCHECKPOINTS_H
@@ -0,0 +1,211 @@
+#include <QtTest/QtTest>
+
+#include <sstream>
+#include <tuple>
+
+#include "heaphistory.h"
+#include "traceevent.h"
+#include "traceindex.h"
+#include "testmultipleheaps.h"
+
+// Builds a trace that allocates at the same addresses on three heaps, and
+// frees the blocks of each heap in a different order.
+static std::string makeTrace(uint32_t number_of_allocations) {
+  std::ostringstream trace;
+  trace << "[\n  {\"type\": \"event\", \"tag\": \"start\"}";
+  for (uint32_t index = 0; index < number_of_allocations; ++index) {
+    uint32_t heap = index % 3;
+    trace << ",\n  {\"type\": \"alloc\", \"heap\": " << heap * 2
+      << ", \"address\": " << 0x10000 + 0x100 * ((index * 7) % 31)
+      << ", \"size\": " << 16 + (index % 13) * 8 << "}";
+    trace << ",\n  {\"type\": \"free\", \"heap\": " << heap * 2
+      << ", \"address\": " << 0x10000 + 0x100 * (((index + 12 + heap) * 7) % 31)
+      << "}";
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+typedef std::tuple<uint64_t, uint64_t, uint64_t, uint32_t> BlockKey;
+
+static std::vector<BlockKey> getLiveSet(const HeapHistory& history,
+  uint64_t tick) {
+  std::vector<uint32_t> live;
+  history.getLiveBlocksAtTick(tick, &live);
+  std::vector<BlockKey> result;
+  for (uint32_t index : live) {
+    const HeapBlock& block = history.getBlock(index);
+    result.emplace_back(block.address_, block.size_, block.start_tick_,
+      block.heap_id_);
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+void TestMultipleHeaps::TestParseHeapIds() {
+  TraceEventChunk chunk;
+  parseTraceEvent("{\"type\": \"alloc\", \"address\": 16, \"size\": 8}", 0,
+    &chunk);
+  parseTraceEvent("{\"type\": \"alloc\", \"heap\": 255, \"address\": 16, "
+    "\"size\": 8}", 1, &chunk);
+  parseTraceEvent("{\"type\": \"free\", \"heap\": 256, \"address\": 16}", 2,
+    &chunk);
+  parseTraceEvent("{\"type\": \"rangefree\", \"heap\": 7, \"low\": 0, "
+    "\"high\": 64}", 3, &chunk);
+  QCOMPARE(chunk.events_.size(), size_t(4));
+  QCOMPARE(chunk.events_[0].type_, TraceEvent::ALLOC);
+  QCOMPARE(chunk.events_[0].heap_id_, uint8_t(0));
+  QCOMPARE(chunk.events_[1].type_, TraceEvent::ALLOC);
+  QCOMPARE(chunk.events_[1].heap_id_, uint8_t(255));
+  QCOMPARE(chunk.events_[2].type_, TraceEvent::INVALID);
+  QCOMPARE(chunk.events_[3].type_, TraceEvent::RANGEFREE);
+  QCOMPARE(chunk.events_[3].heap_id_, uint8_t(7));
+}
+
+void TestMultipleHeaps::TestHeapsHaveSeparateLiveSets() {
+  std::istringstream input("["
+    "{\"type\": \"alloc\", \"address\": 4096, \"size\": 32},"
+    "{\"type\": \"alloc\", \"heap\": 3, \"address\": 4096, \"size\": 64},"
+    "{\"type\": \"alloc\", \"heap\": 3, \"address\": 8192, \"size\": 16},"
+    "{\"type\": \"alloc\", \"heap\": 1, \"address\": 8192, \"size\": 16},"
+    "{\"type\": \"free\", \"heap\": 3, \"address\": 4096},"
+    "{\"type\": \"rangefree\", \"heap\": 1, \"low\": 0, \"high\": 65536},"
+    "{\"type\": \"free\", \"heap\": 1, \"address\": 4096}"
+    "]");
+  HeapHistory history;
+  history.LoadFromJSONStream(input);
+
+  // The same address can be live on several heaps without a conflict.
+  QCOMPARE(history.getNumberOfBlocks(), size_t(4));
+  const uint8_t heap_ids[] = { 0, 3, 3, 1 };
+  for (uint32_t index = 0; index < 4; ++index) {
+    QCOMPARE(history.getBlock(index).heap_id_, heap_ids[index]);
+  }
+  QCOMPARE(history.getHeapIds(), std::vector<uint8_t>({ 0, 1, 3 }));
+  // The block layer gets the heap ID of every block along with its quad.
+  std::vector<HeapVertex> vertices;
+  std::vector<uint32_t> block_indices, block_heaps;
+  history.heapBlockVerticesForActiveWindow(&vertices, true, &block_indices,
+    &block_heaps);
+  QCOMPARE(block_indices.size(), size_t(4));
+  QCOMPARE(block_heaps.size(), block_indices.size());
+  for (size_t block = 0; block < block_indices.size(); ++block) {
+    QCOMPARE(block_heaps[block], uint32_t(heap_ids[block_indices[block]]));
+  }
+
+  // Frees and range frees only touch their own heap; the last free has no
+  // block on heap 1 and is a conflict.
+  QVERIFY(!history.getBlock(0).wasFreed());
+  QCOMPARE(history.getBlock(1).end_tick_, uint64_t(5));
+  QVERIFY(!history.getBlock(2).wasFreed());
+  QCOMPARE(history.getBlock(3).end_tick_, uint64_t(6));
+  std::vector<uint32_t> live;
+  history.getLiveBlocksAtTick(7, &live);
+  QCOMPARE(live, std::vector<uint32_t>({ 0, 2 }));
+  const FragmentationTimeline& timeline = history.getFragmentationTimeline();
+  QCOMPARE(timeline.getGlobalMaximum(FragmentationTimeline::LiveBlocks),
+    uint64_t(4));
+  QCOMPARE(timeline.getMaximum(FragmentationTimeline::LiveBlocks).back(),
+    uint64_t(2));
+  QCOMPARE(timeline.getMaximum(FragmentationTimeline::AddressSpan).back(),
+    uint64_t(8192 + 16 - 4096));
+}
+
+// The index checkpoints keep the heap of every live block, so a tick range
+// load sees the same heaps as a full load.
+void TestMultipleHeaps::TestTickRangeLoadKeepsHeapIds() {
+  std::string trace = makeTrace(300);
+  std::stringstream index_data;
+  HeapHistory full;
+  {
+    std::istringstream input(trace);
+    TraceIndexWriter writer(&index_data, 50);
+    full.LoadFromJSONStream(input, &writer);
+  }
+  QCOMPARE(full.getHeapIds(), std::vector<uint8_t>({ 0, 2, 4 }));
+
+  for (uint64_t first_tick : { 120, 377 }) {
+    std::istringstream input(trace);
+    HeapHistory partial;
+    QVERIFY(partial.LoadTickRangeFromJSONStream(input, index_data, first_tick,
+      first_tick + 100));
+    QCOMPARE(partial.getHeapIds(), full.getHeapIds());
+    for (uint64_t tick = partial.getMinimumTick(); tick <= first_tick + 100;
+      ++tick) {
+      QCOMPARE(getLiveSet(partial, tick), getLiveSet(full, tick));
+    }
+  }
+}
+
+void TestMultipleHeaps::TestVisibleHeaps() {
+  HeapHistory history;
+  std::string error;
+  for (uint32_t heap_id = 0; heap_id < 256; ++heap_id) {
+    QVERIFY(history.isHeapVisible(static_cast<uint8_t>(heap_id)));
+  }
+
+  QVERIFY(history.setVisibleHeaps("1, 40-42 ,255", &error));
+  for (uint32_t heap_id = 0; heap_id < 256; ++heap_id) {
+    bool expected = (heap_id == 1) || ((heap_id >= 40) && (heap_id <= 42)) ||
+      (heap_id == 255);
+    QCOMPARE(history.isHeapVisible(static_cast<uint8_t>(heap_id)), expected);
+  }
+  QCOMPARE(history.getVisibleHeapBits()[1], uint32_t(0x700));
+
+  // Invalid lists leave the visible heaps unchanged.
+  for (const char* invalid : { "256", "1,", "3-1", "a", "1 2", "0-" }) {
+    QVERIFY(!history.setVisibleHeaps(invalid, &error));
+    QVERIFY(!error.empty());
+    QVERIFY(history.isHeapVisible(1));
+    QVERIFY(!history.isHeapVisible(2));
+  }
+
+  QVERIFY(history.setVisibleHeaps(" ", &error));
+  QVERIFY(history.isHeapVisible(2));
+  QCOMPARE(history.getVisibleHeapBits()[7], uint32_t(0xFFFFFFFF));
+}
+
+// Every input of the diagram advances the view generation, but only moving
+// the window or loading advances the generations the vertices depend on.
+void TestMultipleHeaps::TestViewGeneration() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(300));
+  history.LoadFromJSONStream(trace);
+  uint32_t data = history.getDataGeneration();
+  QVERIFY(data > 0);
+
+  uint64_t view = history.getViewGeneration();
+  uint32_t window = history.getWindowGeneration();
+  history.setCurrentWindowToGlobal();
+  QVERIFY(history.getWindowGeneration() > window);
+  QVERIFY(history.getViewGeneration() > view);
+
+  view = history.getViewGeneration();
+  window = history.getWindowGeneration();
+  history.panCurrentWindow(0.25, 0.0);
+  QVERIFY(history.getWindowGeneration() > window);
+  window = history.getWindowGeneration();
+  history.zoomToPoint(0.5, 0.5, 0.5, 0.5, 1e30, 1e30);
+  QVERIFY(history.getWindowGeneration() > window);
+  QVERIFY(history.getViewGeneration() > view);
+
+  view = history.getViewGeneration();
+  window = history.getWindowGeneration();
+  history.highlightBySize(16);
+  QVERIFY(history.getViewGeneration() > view);
+  view = history.getViewGeneration();
+  std::string error;
+  QVERIFY(history.setVisibleHeaps("2", &error));
+  QVERIFY(history.getViewGeneration() > view);
+  QCOMPARE(history.getWindowGeneration(), window);
+  QCOMPARE(history.getDataGeneration(), data);
+
+  // A failed change changes nothing.
+  view = history.getViewGeneration();
+  QVERIFY(!history.setVisibleHeaps("x", &error));
+  QCOMPARE(history.getViewGeneration(), view);
+
+  std::istringstream reload(makeTrace(10));
+  history.LoadFromJSONStream(reload);
+  QVERIFY(history.getDataGeneration() > data);
+}
@@ -0,0 +1,23 @@
+#ifndef TESTMULTIPLEHEAPS_H
+#define TESTMULTIPLEHEAPS_H
+
+#include <QObject>
+
+class TestMultipleHeaps : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestParseHeapIds();
+  void TestHeapsHaveSeparateLiveSets();
+  void TestTickRangeLoadKeepsHeapIds();
+  void TestVisibleHeaps();
+  void TestViewGeneration();
+};
+
+#endif // TESTMULTIPLEHEAPS_H
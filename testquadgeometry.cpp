@@ -0,0 +1,94 @@
+#include <QtTest/QtTest>
+
+#include <sstream>
+
+#include "heapblockdiagramlayer.h"
+#include "heaphistory.h"
+#include "testquadgeometry.h"
+#include "vertex.h"
+
+void TestQuadGeometry::TestQuadIndices() {
+  std::vector<uint32_t> indices;
+  appendQuadIndices(0, 1, &indices);
+  QCOMPARE(indices, std::vector<uint32_t>({ 0, 1, 3, 1, 2, 3 }));
+  appendQuadIndices(2, 4, &indices);
+  QCOMPARE(indices, std::vector<uint32_t>({ 0, 1, 3, 1, 2, 3,
+    8, 9, 11, 9, 10, 11, 12, 13, 15, 13, 14, 15 }));
+  appendQuadIndices(4, 4, &indices);
+  QCOMPARE(indices.size(), static_cast<size_t>(3 * indices_per_quad));
+}
+
+// Resolving the quad indices gives the two triangles that blocks used to be
+// drawn with.
+void TestQuadGeometry::TestBlockQuadMatchesTriangles() {
+  HeapBlock block(100, 250, 48, 0x7FFFFFFFFFF0ULL);
+  std::vector<HeapVertex> quad;
+  block.toVertices(1000, &quad);
+  QCOMPARE(quad.size(), static_cast<size_t>(vertices_per_quad));
+
+  std::vector<uint32_t> indices;
+  appendQuadIndices(0, 1, &indices);
+  const uint64_t expected[6][2] = {
+    { 100, 0x7FFFFFFFFFF0ULL }, { 250, 0x7FFFFFFFFFF0ULL },
+    { 100, 0x800000000020ULL }, { 250, 0x7FFFFFFFFFF0ULL },
+    { 250, 0x800000000020ULL }, { 100, 0x800000000020ULL } };
+  for (size_t index = 0; index < indices.size(); ++index) {
+    const HeapVertex& vertex = quad[indices[index]];
+    QCOMPARE(vertex.getX(), expected[index][0]);
+    QCOMPARE(vertex.getY(), expected[index][1]);
+  }
+  // The lower and the upper edge have their own colors.
+  QCOMPARE(quad[0].getColor(), quad[1].getColor());
+  QCOMPARE(quad[2].getColor(), quad[3].getColor());
+}
+
+void TestQuadGeometry::TestOneQuadPerVisibleBlock() {
+  std::ostringstream trace;
+  trace << "[";
+  for (uint32_t index = 0; index < 100; ++index) {
+    trace << ((index == 0) ? "" : ",") << "{\"type\": \"alloc\", "
+      "\"address\": " << 0x1000 + 0x40 * index << ", \"size\": 32}";
+    if (index % 3 == 0) {
+      trace << ",{\"type\": \"free\", \"address\": " << 0x1000 + 0x40 * index
+        << "}";
+    }
+  }
+  trace << "]";
+  std::istringstream input(trace.str());
+  HeapHistory history;
+  history.LoadFromJSONStream(input);
+
+  std::vector<HeapVertex> vertices;
+  std::vector<uint32_t> block_indices;
+  size_t blocks = history.heapBlockVerticesForActiveWindow(&vertices, true,
+    &block_indices);
+  QCOMPARE(blocks, static_cast<size_t>(100));
+  QCOMPARE(block_indices.size(), blocks);
+  QCOMPARE(vertices.size(), blocks * vertices_per_quad);
+  for (size_t quad = 0; quad < blocks; ++quad) {
+    const HeapBlock& block = history.getBlock(block_indices[quad]);
+    const HeapVertex* corners = &vertices[quad * vertices_per_quad];
+    QCOMPARE(corners[0].getX(), block.start_tick_);
+    QCOMPARE(corners[0].getY(), block.address_);
+    QCOMPARE(corners[2].getX(), block.end_tick_);
+    QCOMPARE(corners[2].getY(), block.address_ + block.size_);
+  }
+}
+
+// The ID pass writes the block index plus one into the bytes of a pixel,
+// like block.frag does.
+void TestQuadGeometry::TestBlockIdEncoding() {
+  uint32_t index = 12345;
+  const uint8_t empty[4] = { 0, 0, 0, 0 };
+  QVERIFY(!HeapBlockDiagramLayer::decodeBlockId(empty, &index));
+  QCOMPARE(index, 12345u);
+  for (uint32_t block : { 0u, 1u, 255u, 256u, 0x123456u, 0xFFFFFFFEu }) {
+    uint32_t id = block + 1;
+    const uint8_t rgba[4] = { static_cast<uint8_t>(id & 0xFF),
+      static_cast<uint8_t>((id >> 8) & 0xFF),
+      static_cast<uint8_t>((id >> 16) & 0xFF),
+      static_cast<uint8_t>(id >> 24) };
+    QVERIFY(HeapBlockDiagramLayer::decodeBlockId(rgba, &index));
+    QCOMPARE(index, block);
+  }
+}
@@ -0,0 +1,22 @@
+#ifndef TESTQUADGEOMETRY_H
+#define TESTQUADGEOMETRY_H
+
+#include <QObject>
+
+class TestQuadGeometry : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestQuadIndices();
+  void TestBlockQuadMatchesTriangles();
+  void TestOneQuadPerVisibleBlock();
+  void TestBlockIdEncoding();
+};
+
+#endif // TESTQUADGEOMETRY_H
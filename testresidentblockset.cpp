@@ -0,0 +1,151 @@
+#include <QtTest/QtTest>
+
+#include <sstream>
+
+#include "heaphistory.h"
+#include "residentblockset.h"
+#include "testresidentblockset.h"
+
+// Allocates and frees blocks of different sizes in 256 address slots, so
+// that the blocks are spread over the whole range of ticks and addresses.
+static std::string makeTrace(uint32_t number_of_events) {
+  std::ostringstream trace;
+  std::vector<bool> allocated(256, false);
+  uint32_t random = 12345;
+  trace << "[\n  {\"type\": \"event\", \"tag\": \"start\"}";
+  for (uint32_t event = 0; event < number_of_events; ++event) {
+    random = random * 1103515245 + 12345;
+    uint32_t slot = (random >> 16) % allocated.size();
+    uint64_t address = 0x100000 + 0x1000 * slot;
+    if (allocated[slot]) {
+      trace << ",\n  {\"type\": \"free\", \"address\": " << address << "}";
+    } else {
+      trace << ",\n  {\"type\": \"alloc\", \"address\": " << address
+        << ", \"size\": " << 64 * (1 + (random >> 8) % 64) << "}";
+    }
+    allocated[slot] = !allocated[slot];
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+// Checks that the slots hold exactly the blocks of the band, and that every
+// other slot is a hole without area.
+static bool isConsistent(const HeapHistory& history,
+  const ResidentBlockSet& resident, const std::vector<HeapVertex>& vertices,
+  const std::vector<uint32_t>& block_indices) {
+  const ResidentBlockSet::Band& band = resident.getBand();
+  std::vector<uint32_t> expected;
+  history.getActiveBlockIndices(band.minimum_size_, band.minimum_address_,
+    band.maximum_address_, band.minimum_tick_, band.maximum_tick_, &expected);
+  if ((resident.size() != expected.size()) ||
+    (vertices.size() != block_indices.size() * vertices_per_quad) ||
+    (resident.size() + resident.getNumberOfHoles() != block_indices.size())) {
+    return false;
+  }
+  for (uint32_t index : expected) {
+    if (!resident.contains(index)) {
+      return false;
+    }
+  }
+
+  size_t blocks = 0;
+  std::vector<HeapVertex> quad;
+  for (size_t slot = 0; slot < block_indices.size(); ++slot) {
+    const HeapVertex* slot_vertices = &vertices[slot * vertices_per_quad];
+    bool hole = true;
+    for (uint32_t corner = 1; corner < vertices_per_quad; ++corner) {
+      hole = hole && (slot_vertices[corner].getX() == slot_vertices[0].getX()) &&
+        (slot_vertices[corner].getY() == slot_vertices[0].getY());
+    }
+    if (hole) {
+      continue;
+    }
+    ++blocks;
+    quad.clear();
+    history.blockToVertices(block_indices[slot], &quad);
+    for (uint32_t corner = 0; corner < vertices_per_quad; ++corner) {
+      if ((quad[corner].getX() != slot_vertices[corner].getX()) ||
+        (quad[corner].getY() != slot_vertices[corner].getY())) {
+        return false;
+      }
+    }
+  }
+  return blocks == resident.size();
+}
+
+void TestResidentBlockSet::TestPanningKeepsBandResident() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(20000));
+  history.LoadFromJSONStream(trace);
+  history.setCurrentWindow(HeapWindow(0x140000, 0x180000, 5000, 9000));
+
+  ResidentBlockSet resident;
+  std::vector<HeapVertex> vertices;
+  std::vector<uint32_t> block_indices;
+  QVERIFY(resident.update(history, &vertices, &block_indices));
+  QVERIFY(resident.size() > 0);
+  QVERIFY(isConsistent(history, resident, vertices, block_indices));
+
+  // Pan around in small steps; every step that leaves the band only touches
+  // the slots of the blocks that entered or left it.
+  const double steps[][2] = { { 0.05, 0.0 }, { 0.0, 0.05 },
+    { -0.07, 0.03 }, { 0.02, -0.09 }, { -0.04, -0.04 } };
+  size_t incremental_updates = 0;
+  for (uint32_t step = 0; step < 60; ++step) {
+    history.panCurrentWindow(steps[step % 5][0], steps[step % 5][1]);
+    bool rebuilt = resident.update(history, &vertices, &block_indices);
+    QVERIFY(isConsistent(history, resident, vertices, block_indices));
+
+    // The visible blocks are always resident.
+    const DisplayHeapWindow& window = history.getCurrentWindow();
+    std::vector<uint32_t> visible;
+    history.getActiveBlockIndices(history.getMinimumBlockSize(),
+      window.getMinimumAddressUint64(), window.getMaximumAddressUint64(),
+      window.getMinimumTickUint64(), window.getMaximumTickUint64(), &visible);
+    for (uint32_t index : visible) {
+      QVERIFY(resident.contains(index));
+    }
+
+    size_t changed = 0;
+    for (const auto& range : resident.getChangedSlots()) {
+      QVERIFY(range.first < range.second);
+      QVERIFY(range.second <= block_indices.size());
+      changed += range.second - range.first;
+    }
+    if (!rebuilt && (changed > 0)) {
+      QVERIFY(changed < block_indices.size());
+      ++incremental_updates;
+    }
+  }
+  QVERIFY(incremental_updates > 0);
+
+  // Loading new data starts over.
+  std::istringstream reload(makeTrace(3000));
+  history.LoadFromJSONStream(reload);
+  history.setCurrentWindowToGlobal();
+  QVERIFY(resident.update(history, &vertices, &block_indices));
+  QVERIFY(isConsistent(history, resident, vertices, block_indices));
+}
+
+void TestResidentBlockSet::TestZoomingInRebuilds() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(5000));
+  history.LoadFromJSONStream(trace);
+  history.setCurrentWindowToGlobal();
+
+  ResidentBlockSet resident;
+  std::vector<HeapVertex> vertices;
+  std::vector<uint32_t> block_indices;
+  QVERIFY(resident.update(history, &vertices, &block_indices));
+  // Nothing changes while the window stays inside the band.
+  QVERIFY(!resident.update(history, &vertices, &block_indices));
+  QVERIFY(resident.getChangedSlots().empty());
+
+  // Smaller blocks become visible, which the band does not have.
+  uint64_t minimum_size = history.getMinimumBlockSize();
+  history.zoomToPoint(0.5, 0.5, 0.5, 0.5, 1e30, 1e30);
+  QVERIFY(history.getMinimumBlockSize() < minimum_size);
+  QVERIFY(resident.update(history, &vertices, &block_indices));
+  QVERIFY(isConsistent(history, resident, vertices, block_indices));
+}
@@ -0,0 +1,20 @@
+#ifndef TESTRESIDENTBLOCKSET_H
+#define TESTRESIDENTBLOCKSET_H
+
+#include <QObject>
+
+class TestResidentBlockSet : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestPanningKeepsBandResident();
+  void TestZoomingInRebuilds();
+};
+
+#endif // TESTRESIDENTBLOCKSET_H
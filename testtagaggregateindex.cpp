@@ -0,0 +1,111 @@
+#include <QtTest/QtTest>
+
+#include "compressedblockstore.h"
+#include "heapblock.h"
+#include "tagaggregateindex.h"
+#include "tagtable.h"
+#include "testtagaggregateindex.h"
+
+void TestTagAggregateIndex::TestNumberOfBuckets() {
+  QCOMPARE(TagAggregateIndex::calculateNumberOfBuckets(100, 1), 101U);
+  QCOMPARE(TagAggregateIndex::calculateNumberOfBuckets(1000000, 1), 4096U);
+  QCOMPARE(TagAggregateIndex::calculateNumberOfBuckets(1000000, 4096), 1024U);
+  // Many tags never push the number of buckets below the minimum.
+  QCOMPARE(TagAggregateIndex::calculateNumberOfBuckets(1000000, 1000000),
+    64U);
+}
+
+// Compares the queries at bucket boundaries against a brute-force scan.
+void TestTagAggregateIndex::TestPrefixSumsMatchFullScan() {
+  const std::string tags[3] = { "alpha", "beta", "gamma" };
+  std::vector<HeapBlock> blocks;
+  uint64_t tick = 0;
+  for (uint32_t index = 0; index < 3000; ++index) {
+    tick += 2;
+    uint32_t lifetime = (index * 7919) % 3000;
+    uint64_t end_tick = (index % 7 == 0) ?
+      std::numeric_limits<uint64_t>::max() : tick + 1 + lifetime;
+    uint32_t size = 8 + (index * 31) % 100;
+    blocks.emplace_back(tick, end_tick, size, 0x1000 + 128 * index);
+    blocks.back().allocation_tag_ = &tags[index % 3];
+  }
+  uint64_t maximum_tick = tick + 3001;
+  TagTable table;
+  TagAggregateIndex index(maximum_tick, CompressedBlockStore(blocks, &table),
+    table);
+  // The three tags and "no tag".
+  QCOMPARE(index.getNumberOfTags(), size_t(4));
+  uint32_t beta;
+  QVERIFY(index.getTagId("beta", &beta));
+  QCOMPARE(index.getTagName(beta), tags[1]);
+  uint32_t unused;
+  QVERIFY(!index.getTagId("delta", &unused));
+
+  uint64_t width = index.getBucketWidth();
+  auto liveBytes = [&](uint64_t query) {
+    uint64_t bytes = 0;
+    for (const HeapBlock& block : blocks) {
+      if ((block.allocation_tag_ == &tags[1]) &&
+          (block.start_tick_ <= query) && (block.end_tick_ > query)) {
+        bytes += block.size_;
+      }
+    }
+    return bytes;
+  };
+  for (uint32_t boundary = 0; boundary < index.getNumberOfBuckets();
+    boundary += 7) {
+    uint64_t low = boundary * width;
+    uint64_t high = (boundary + 5) * width;
+    QCOMPARE(index.getLiveBytesAtTick(beta, low), liveBytes(low));
+    // Ticks between boundaries are rounded down.
+    QCOMPARE(index.getLiveBytesAtTick(beta, low + width - 1), liveBytes(low));
+
+    uint64_t allocated = 0;
+    uint64_t freed = 0;
+    for (const HeapBlock& block : blocks) {
+      if (block.allocation_tag_ != &tags[1]) {
+        continue;
+      }
+      if ((block.start_tick_ > low) && (block.start_tick_ <= high)) {
+        allocated += block.size_;
+      }
+      if ((block.end_tick_ > low) && (block.end_tick_ <= high)) {
+        freed += block.size_;
+      }
+    }
+    if (boundary + 5 <= index.getNumberOfBuckets()) {
+      QCOMPARE(index.getBytesAllocatedBetween(beta, low, high), allocated);
+      QCOMPARE(index.getBytesFreedBetween(beta, low, high), freed);
+      uint64_t sum = 0;
+      for (uint32_t step = 0; step < 5; ++step) {
+        sum += liveBytes(low + step * width);
+      }
+      QCOMPARE(index.getAverageLiveBytesBetween(beta, low, high), sum / 5);
+    }
+  }
+}
+
+// Tags get consecutive IDs by first use, whether they are looked up through
+// an interned pointer or through a copy of the string.
+void TestTagAggregateIndex::TestTagTableIds() {
+  TagTable table;
+  QCOMPARE(table.size(), size_t(1));
+  QCOMPARE(table.getId(nullptr), 0U);
+  QVERIFY(table.getTag(0) == nullptr);
+
+  const std::string* alpha = table.intern("alpha");
+  QVERIFY(table.intern("alpha") == alpha);
+  std::string copy = "alpha";
+  QCOMPARE(table.getId(alpha), 1U);
+  QCOMPARE(table.getId(&copy), 1U);
+  std::string beta = "beta";
+  QCOMPARE(table.getId(&beta), 2U);
+  QVERIFY(table.getTag(2) != &beta);
+  QCOMPARE(*table.getTag(2), beta);
+
+  uint32_t id;
+  QVERIFY(table.findId("beta", &id));
+  QCOMPARE(id, 2U);
+  QVERIFY(!table.findId("gamma", &id));
+  QCOMPARE(table.size(), size_t(3));
+}
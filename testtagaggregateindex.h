@@ -0,0 +1,21 @@
+#ifndef TESTTAGAGGREGATEINDEX_H
+#define TESTTAGAGGREGATEINDEX_H
+
+#include <QObject>
+
+class TestTagAggregateIndex : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestNumberOfBuckets();
+  void TestPrefixSumsMatchFullScan();
+  void TestTagTableIds();
+};
+
+#endif // TESTTAGAGGREGATEINDEX_H
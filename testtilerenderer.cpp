@@ -0,0 +1,189 @@
+#include <QtTest/QtTest>
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "heaphistory.h"
+#include "testtilerenderer.h"
+#include "tilerenderer.h"
+
+// Allocates and frees blocks of different sizes in 64 address slots.
+static std::string makeTrace(uint32_t number_of_events) {
+  std::ostringstream trace;
+  std::vector<bool> allocated(64, false);
+  uint32_t random = 4711;
+  trace << "[\n  {\"type\": \"event\", \"tag\": \"start\"}";
+  for (uint32_t event = 0; event < number_of_events; ++event) {
+    random = random * 1103515245 + 12345;
+    uint32_t slot = (random >> 16) % allocated.size();
+    uint64_t address = 0x100000 + 0x1000 * slot;
+    if (allocated[slot]) {
+      trace << ",\n  {\"type\": \"free\", \"address\": " << address << "}";
+    } else {
+      trace << ",\n  {\"type\": \"alloc\", \"address\": " << address
+        << ", \"size\": " << 256 * (1 + (random >> 8) % 16) << "}";
+    }
+    allocated[slot] = !allocated[slot];
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+void TestTileRenderer::TestTileLevels() {
+  QCOMPARE(TileRenderer::getTileSpan(0, 1023, 0), uint64_t(1024));
+  QCOMPARE(TileRenderer::getTileSpan(0, 1023, 2), uint64_t(256));
+  QCOMPARE(TileRenderer::getTileSpan(0, 1023, 40), uint64_t(1));
+
+  uint64_t low = 0;
+  uint64_t high = 0;
+  QVERIFY(TileRenderer::getTileRange(0, 1023, 2, 3, &low, &high));
+  QCOMPARE(low, uint64_t(768));
+  QCOMPARE(high, uint64_t(1023));
+  QVERIFY(!TileRenderer::getTileRange(0, 1023, 2, 4, &low, &high));
+  // The last tile is cut short if the axis does not split evenly.
+  QVERIFY(TileRenderer::getTileRange(10, 1000, 1, 0, &low, &high));
+  QCOMPARE(low, uint64_t(10));
+  QCOMPARE(high, uint64_t(505));
+  QVERIFY(TileRenderer::getTileRange(10, 1000, 1, 1, &low, &high));
+  QCOMPARE(low, uint64_t(506));
+  QCOMPARE(high, uint64_t(1000));
+  // Axes that span all 64 bits do not overflow.
+  uint64_t maximum = std::numeric_limits<uint64_t>::max();
+  QVERIFY(TileRenderer::getTileRange(0, maximum, 1, 1, &low, &high));
+  QCOMPARE(low, uint64_t(1) << 63);
+  QCOMPARE(high, maximum);
+
+  // A window of the whole axis on 1024 pixels needs tiles of 256 units.
+  QCOMPARE(TileRenderer::chooseLevel(0, 1023, 1024, 1024), uint8_t(2));
+  QCOMPARE(TileRenderer::chooseLevel(0, 1023, 1024, 256), uint8_t(0));
+  QCOMPARE(TileRenderer::chooseLevel(0, 1023, 128, 1024), uint8_t(5));
+}
+
+void TestTileRenderer::TestTileCoversBlocks() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(2000));
+  history.LoadFromJSONStream(trace);
+
+  TileRenderer::Snapshot snapshot;
+  snapshot.highlight_bits_ = history.getHighlightBits();
+  snapshot.visible_heap_bits_ = history.getVisibleHeapBits();
+  DiagramTileKey key;
+  key.level_x_ = 1;
+  key.level_y_ = 1;
+  key.x_ = 1;
+  key.y_ = 0;
+  std::vector<uint8_t> pixels;
+  TileRenderer::renderTile(history, snapshot, key, &pixels);
+  const uint32_t size = TileRenderer::tile_size;
+  QCOMPARE(pixels.size(), size_t(4 * size * size));
+
+  // Mark the pixels whose centers lie inside a block.
+  uint64_t minimum_tick, maximum_tick, minimum_address, maximum_address;
+  QVERIFY(TileRenderer::getTileRange(history.getMinimumTick(),
+    history.getMaximumTick(), key.level_x_, key.x_, &minimum_tick,
+    &maximum_tick));
+  QVERIFY(TileRenderer::getTileRange(history.getMinimumAddress(),
+    history.getMaximumAddress(), key.level_y_, key.y_, &minimum_address,
+    &maximum_address));
+  long double pixel_width = TileRenderer::getTileSpan(
+    history.getMinimumTick(), history.getMaximumTick(), key.level_x_) /
+    static_cast<long double>(size);
+  long double pixel_height = TileRenderer::getTileSpan(
+    history.getMinimumAddress(), history.getMaximumAddress(), key.level_y_) /
+    static_cast<long double>(size);
+  std::vector<uint32_t> indices;
+  history.getActiveBlockIndices(0, minimum_address, maximum_address,
+    minimum_tick, maximum_tick, &indices);
+  QVERIFY(!indices.empty());
+  std::vector<bool> covered(size * size, false);
+  std::vector<HeapVertex> quad;
+  for (uint32_t index : indices) {
+    quad.clear();
+    history.blockToVertices(index, &quad);
+    for (uint32_t row = 0; row < size; ++row) {
+      long double y = minimum_address + (row + 0.5L) * pixel_height;
+      if ((y < quad[0].getY()) || (y >= quad[2].getY())) {
+        continue;
+      }
+      for (uint32_t column = 0; column < size; ++column) {
+        long double x = minimum_tick + (column + 0.5L) * pixel_width;
+        if ((x >= quad[0].getX()) && (x < quad[2].getX())) {
+          covered[row * size + column] = true;
+        }
+      }
+    }
+  }
+  size_t covered_pixels = 0;
+  for (uint32_t pixel = 0; pixel < size * size; ++pixel) {
+    QCOMPARE(pixels[4 * pixel + 3] != 0, bool(covered[pixel]));
+    covered_pixels += covered[pixel] ? 1 : 0;
+  }
+  QVERIFY(covered_pixels > 0);
+
+  // Highlighting changes the colors, but not the coverage.
+  history.highlightBySize(4096);
+  snapshot.highlight_bits_ = history.getHighlightBits();
+  std::vector<uint8_t> highlighted;
+  TileRenderer::renderTile(history, snapshot, key, &highlighted);
+  QVERIFY(highlighted != pixels);
+  for (uint32_t pixel = 0; pixel < size * size; ++pixel) {
+    QCOMPARE(highlighted[4 * pixel + 3], pixels[4 * pixel + 3]);
+  }
+
+  // Blocks of hidden heaps are not drawn.
+  snapshot.visible_heap_bits_.fill(0);
+  TileRenderer::renderTile(history, snapshot, key, &pixels);
+  QVERIFY(std::all_of(pixels.begin(), pixels.end(),
+    [](uint8_t value) { return value == 0; }));
+}
+
+void TestTileRenderer::TestWorkerDeliversTiles() {
+  HeapHistory history;
+  std::istringstream trace(makeTrace(1000));
+  history.LoadFromJSONStream(trace);
+
+  TileRenderer renderer(&history);
+  std::atomic<uint32_t> ready(0);
+  renderer.setTileReadyCallback([&ready]() { ++ready; });
+  renderer.reset();
+
+  std::vector<DiagramTileKey> keys;
+  for (uint64_t index = 0; index < 4; ++index) {
+    DiagramTileKey key;
+    key.level_x_ = 1;
+    key.level_y_ = 1;
+    key.x_ = index % 2;
+    key.y_ = index / 2;
+    keys.push_back(key);
+  }
+  renderer.request(keys);
+  std::vector<TileRenderer::Tile> tiles;
+  for (uint32_t wait = 0; (tiles.size() < keys.size()) && (wait < 10000);
+    ++wait) {
+    renderer.takeRenderedTiles(&tiles);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  QCOMPARE(tiles.size(), keys.size());
+  QCOMPARE(ready.load(), uint32_t(keys.size()));
+
+  TileRenderer::Snapshot snapshot;
+  snapshot.highlight_bits_ = history.getHighlightBits();
+  snapshot.visible_heap_bits_ = history.getVisibleHeapBits();
+  for (uint32_t tile = 0; tile < tiles.size(); ++tile) {
+    // The tiles are rendered in the order they were requested.
+    QVERIFY(tiles[tile].key_ == keys[tile]);
+    std::vector<uint8_t> pixels;
+    TileRenderer::renderTile(history, snapshot, keys[tile], &pixels);
+    QVERIFY(tiles[tile].pixels_ == pixels);
+  }
+
+  // Cancelled requests are not rendered.
+  renderer.request(keys);
+  renderer.cancel();
+  renderer.reset();
+  tiles.clear();
+  renderer.takeRenderedTiles(&tiles);
+  QVERIFY(tiles.empty());
+}
@@ -0,0 +1,21 @@
+#ifndef TESTTILERENDERER_H
+#define TESTTILERENDERER_H
+
+#include <QObject>
+
+class TestTileRenderer : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestTileLevels();
+  void TestTileCoversBlocks();
+  void TestWorkerDeliversTiles();
+};
+
+#endif // TESTTILERENDERER_H
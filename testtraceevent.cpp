@@ -0,0 +1,179 @@
+#include <QtTest/QtTest>
+
+#include <sstream>
+
+#include "heaphistory.h"
+#include "traceevent.h"
+#include "testtraceevent.h"
+
+// Returns the elements of a trace with allocations, frees, range frees,
+// events and address labels, one JSON object each.
+static std::vector<std::string> makeElements(uint32_t number_of_allocations) {
+  std::vector<std::string> elements;
+  elements.push_back("{\"type\": \"filterrange\", \"low\": 4096, "
+    "\"high\": 1099511627776}");
+  for (uint32_t index = 0; index < number_of_allocations; ++index) {
+    std::ostringstream element;
+    element << "{\"type\": \"alloc\", \"address\": "
+      << 0x10000 + 0x100 * ((index * 7) % 97) << ", \"size\": "
+      << 16 + (index % 13) * 8 << ", \"tag\": \"tag " << index % 5 << "\"}";
+    elements.push_back(element.str());
+    element.str("");
+    element << "{\"type\": \"free\", \"address\": "
+      << 0x10000 + 0x100 * (((index + 40) * 7) % 97) << "}";
+    elements.push_back(element.str());
+    if (index % 50 == 0) {
+      elements.push_back("{\"type\": \"event\", \"tag\": \"event\\n\", "
+        "\"color\": \"#FF0000\"}");
+    }
+    if (index % 150 == 0) {
+      elements.push_back("{\"type\": \"rangefree\", \"low\": 65536, "
+        "\"high\": 66560}");
+      elements.push_back("{\"type\": \"address\", \"address\": 69632, "
+        "\"tag\": \"label\"}");
+    }
+  }
+  return elements;
+}
+
+static std::string joinElements(const std::vector<std::string>& elements,
+  const std::string& separator) {
+  std::string result;
+  for (const std::string& element : elements) {
+    result += element + separator;
+  }
+  return result;
+}
+
+void TestTraceEvent::TestParallelParseMatchesSerial() {
+  std::vector<std::string> elements = makeElements(300);
+  elements.push_back("{\"type\": \"alloc\", \"address\": 17}");
+  elements.push_back("{\"type\": \"alloc\", \"address\": ");
+  std::string data = "\n" + joinElements(elements, "\r\n\n  ");
+
+  std::vector<TraceEventChunk> serial;
+  parseNDJSON(data, 100, 1, &serial);
+  QCOMPARE(serial.size(), size_t(1));
+  QCOMPARE(serial[0].events_.size(), elements.size());
+  QCOMPARE(serial[0].events_.back().type_, TraceEvent::INVALID);
+  QCOMPARE(serial[0].events_[elements.size() - 2].type_, TraceEvent::INVALID);
+
+  for (size_t threads : { size_t(2), size_t(7), size_t(64) }) {
+    std::vector<TraceEventChunk> chunks;
+    parseNDJSON(data, 100, threads, &chunks);
+    QCOMPARE(chunks.size(), threads);
+    size_t index = 0;
+    for (const TraceEventChunk& chunk : chunks) {
+      for (const TraceEvent& event : chunk.events_) {
+        const TraceEvent& expected = serial[0].events_[index++];
+        QCOMPARE(event.type_, expected.type_);
+        QCOMPARE(event.address_, expected.address_);
+        QCOMPARE(event.size_or_high_, expected.size_or_high_);
+        QCOMPARE(event.offset_, expected.offset_);
+        if (event.type_ == TraceEvent::INVALID) {
+          continue;
+        }
+        QCOMPARE(chunk.strings_[event.tag_],
+          serial[0].strings_[expected.tag_]);
+        QCOMPARE(chunk.strings_[event.color_],
+          serial[0].strings_[expected.color_]);
+      }
+    }
+    QCOMPARE(index, elements.size());
+  }
+
+  // The offsets point at the elements in the trace.
+  const TraceEvent& first = serial[0].events_[0];
+  QCOMPARE(data.substr(first.offset_ - 100, elements[0].size()), elements[0]);
+  QCOMPARE(serial[0].strings_[first.text_], elements[0]);
+}
+
+// Loading the same trace as an array and as newline-delimited JSON must
+// yield the same history, tick for tick.
+void TestTraceEvent::TestNDJSONLoadMatchesArrayLoad() {
+  std::vector<std::string> elements = makeElements(500);
+  std::string array = "[\n" + joinElements(elements, ",\n");
+  array.resize(array.size() - 2);
+  array += "\n]\n";
+  std::string ndjson = joinElements(elements, "\n");
+
+  HeapHistory from_array;
+  std::istringstream array_input(array);
+  from_array.LoadFromJSONStream(array_input);
+
+  HeapHistory from_ndjson;
+  std::stringstream index_data;
+  {
+    std::istringstream ndjson_input(ndjson);
+    TraceIndexWriter writer(&index_data, 100);
+    from_ndjson.LoadFromJSONStream(ndjson_input, &writer);
+  }
+
+  QCOMPARE(from_ndjson.getNumberOfBlocks(), from_array.getNumberOfBlocks());
+  QCOMPARE(from_ndjson.getMaximumTick(), from_array.getMaximumTick());
+  QCOMPARE(from_ndjson.getMinimumAddress(), from_array.getMinimumAddress());
+  QCOMPARE(from_ndjson.getMaximumAddress(), from_array.getMaximumAddress());
+  for (uint32_t index = 0; index < from_array.getNumberOfBlocks(); ++index) {
+    const HeapBlock& expected = from_array.getBlock(index);
+    const HeapBlock& block = from_ndjson.getBlock(index);
+    QCOMPARE(block.start_tick_, expected.start_tick_);
+    QCOMPARE(block.end_tick_, expected.end_tick_);
+    QCOMPARE(block.address_, expected.address_);
+    QCOMPARE(block.size_, expected.size_);
+    QCOMPARE(*block.allocation_tag_, *expected.allocation_tag_);
+  }
+  std::string event, expected_event;
+  for (uint64_t tick = 0; tick < from_array.getMaximumTick(); tick += 37) {
+    QCOMPARE(from_ndjson.getEventAtTick(tick, &event),
+      from_array.getEventAtTick(tick, &expected_event));
+    QCOMPARE(event, expected_event);
+  }
+
+  // The index written from the newline-delimited trace can be used to load
+  // a tick range of it.
+  HeapHistory partial;
+  std::istringstream ndjson_input(ndjson);
+  QVERIFY(partial.LoadTickRangeFromJSONStream(ndjson_input, index_data, 450,
+    600));
+  QVERIFY(partial.getMinimumTick() <= 450);
+  std::vector<uint32_t> live, expected_live;
+  partial.getLiveBlocksAtTick(600, &live);
+  from_array.getLiveBlocksAtTick(600, &expected_live);
+  QCOMPARE(live.size(), expected_live.size());
+  QVERIFY(!live.empty());
+}
+
+// The windows put back together give the input, every window but the last
+// ends at a line break, and a line longer than a window is not split.
+void TestTraceEvent::TestNDJSONWindowsEndAtLines() {
+  std::string data;
+  for (size_t line = 0; line < 200; ++line) {
+    data += std::string(line % 37, 'a' + line % 26) + "\n";
+  }
+  data += std::string(300, 'x') + "\n" + "last line without a break";
+
+  for (size_t window_size : { size_t(1), size_t(16), size_t(100),
+    size_t(1 << 20) }) {
+    std::istringstream input(data);
+    NDJSONWindowReader reader(&input, 5, window_size);
+    std::string window;
+    std::string joined;
+    uint64_t offset;
+    size_t windows = 0;
+    while (reader.next(&window, &offset)) {
+      QCOMPARE(offset, uint64_t(5 + joined.size()));
+      joined += window;
+      if (joined.size() < data.size()) {
+        QCOMPARE(window.back(), '\n');
+        QVERIFY(window.find('\n') != std::string::npos);
+      }
+      ++windows;
+    }
+    QCOMPARE(joined, data);
+    if (window_size == (1 << 20)) {
+      QCOMPARE(windows, size_t(1));
+    } else {
+      QVERIFY(windows > 1);
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#ifndef TESTTRACEEVENT_H
+#define TESTTRACEEVENT_H
+
+#include <QObject>
+
+class TestTraceEvent : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestParallelParseMatchesSerial();
+  void TestNDJSONLoadMatchesArrayLoad();
+  void TestNDJSONWindowsEndAtLines();
+};
+
+#endif // TESTTRACEEVENT_H
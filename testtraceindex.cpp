@@ -0,0 +1,178 @@
+#include <QtTest/QtTest>
+
+#include <sstream>
+#include <tuple>
+
+#include "heaphistory.h"
+#include "traceindex.h"
+#include "testtraceindex.h"
+
+// Builds a JSON trace with a filter range, tagged allocations and frees, and
+// events and address labels in between.
+static std::string makeTrace(uint32_t number_of_allocations) {
+  std::ostringstream trace;
+  trace << "[\n  {\"type\": \"filterrange\", \"low\": 4096, \"high\": "
+    "1099511627776}";
+  for (uint32_t index = 0; index < number_of_allocations; ++index) {
+    uint64_t address = 0x10000 + 0x100 * ((index * 7) % 97);
+    trace << ",\n  {\"type\": \"alloc\", \"address\": " << address
+      << ", \"size\": " << 16 + (index % 13) * 8 << ", \"tag\": \"tag {"
+      << index % 3 << "}\"}";
+    trace << ",\n  {\"type\": \"free\", \"address\": "
+      << 0x10000 + 0x100 * (((index + 40) * 7) % 97) << "}";
+    if (index % 50 == 0) {
+      trace << ",\n  {\"type\": \"event\", \"tag\": \"event \\\"" << index
+        << "\\\"\"}";
+    }
+    if (index == 120) {
+      trace << ",\n  {\"type\": \"address\", \"address\": 69632, "
+        "\"tag\": \"label\"}";
+    }
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+typedef std::tuple<uint64_t, uint64_t, uint64_t, std::string> BlockKey;
+
+static std::vector<BlockKey> getLiveSet(const HeapHistory& history,
+  uint64_t tick) {
+  std::vector<uint32_t> live;
+  history.getLiveBlocksAtTick(tick, &live);
+  std::vector<BlockKey> result;
+  for (uint32_t index : live) {
+    const HeapBlock& block = history.getBlock(index);
+    result.emplace_back(block.address_, block.size_, block.start_tick_,
+      block.allocation_tag_ ? *block.allocation_tag_ : "");
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+void TestTraceIndex::TestElementReaderOffsets() {
+  std::string trace = " [ {\"a\": \"}],{\\\"\"}, {\"b\": [1, {}]} ,{} ]";
+  std::istringstream input(trace);
+  JSONElementReader reader(&input);
+  std::string element;
+  uint64_t offset;
+  std::vector<std::string> elements;
+  while (reader.next(&element, &offset)) {
+    QCOMPARE(trace.substr(offset, element.size()), element);
+    elements.push_back(element);
+  }
+  QCOMPARE(elements.size(), size_t(3));
+  QCOMPARE(elements[0], std::string("{\"a\": \"}],{\\\"\"}"));
+  QCOMPARE(elements[2], std::string("{}"));
+
+  // Resume in the middle of the array.
+  std::istringstream resumed(trace.substr(19));
+  JSONElementReader resumed_reader(&resumed, 19);
+  QVERIFY(resumed_reader.next(&element, &offset));
+  QCOMPARE(offset, uint64_t(20));
+  QCOMPARE(element, elements[1]);
+}
+
+void TestTraceIndex::TestCheckpointRoundTrip() {
+  std::string tag = "some tag";
+  std::vector<HeapBlock> blocks;
+  blocks.emplace_back(5, 0x20, 0x1000, &tag);
+  blocks.emplace_back(3, 0x10, 0x2000, nullptr);
+  blocks.emplace_back(1, 0xFFFFFFFF, 0xFFFFFFFFFFFF0000ULL, &tag);
+
+  std::stringstream index_data;
+  TraceIndexWriter writer(&index_data, 100);
+  QVERIFY(writer.isCheckpointDue(0));
+  writer.writeCheckpoint(0, 1, {});
+  QVERIFY(!writer.isCheckpointDue(99));
+  QVERIFY(writer.isCheckpointDue(100));
+  writer.writeCheckpoint(130, 4000, blocks);
+  QVERIFY(!writer.isCheckpointDue(199));
+  writer.recordVerbatimElement(2, "{\"type\": \"address\"}");
+  QVERIFY(writer.finish());
+
+  TraceIndexReader reader;
+  QVERIFY(reader.open(&index_data));
+  QCOMPARE(reader.getNumberOfCheckpoints(), size_t(2));
+  QCOMPARE(reader.getVerbatimElements().size(), size_t(1));
+  QCOMPARE(reader.getVerbatimElements()[0].first, uint64_t(2));
+
+  TraceIndexCheckpoint checkpoint;
+  QVERIFY(reader.readCheckpoint(129, &checkpoint));
+  QCOMPARE(checkpoint.tick_, uint64_t(0));
+  QCOMPARE(checkpoint.trace_offset_, uint64_t(1));
+  QVERIFY(checkpoint.live_.empty());
+
+  QVERIFY(reader.readCheckpoint(1000, &checkpoint));
+  QCOMPARE(checkpoint.tick_, uint64_t(130));
+  QCOMPARE(checkpoint.trace_offset_, uint64_t(4000));
+  QCOMPARE(checkpoint.live_.size(), blocks.size());
+  for (size_t index = 0; index < blocks.size(); ++index) {
+    const HeapBlock& block = checkpoint.live_[index];
+    QCOMPARE(block.address_, blocks[index].address_);
+    QCOMPARE(block.size_, blocks[index].size_);
+    QCOMPARE(block.start_tick_, blocks[index].start_tick_);
+    QVERIFY(!block.wasFreed());
+    QCOMPARE(block.allocation_tag_ == nullptr,
+      blocks[index].allocation_tag_ == nullptr);
+    if (block.allocation_tag_ != nullptr) {
+      QCOMPARE(*block.allocation_tag_, tag);
+    }
+  }
+}
+
+// Loading a tick range from a checkpoint must yield the same live sets as
+// loading the whole trace, at every tick in the range.
+void TestTraceIndex::TestTickRangeLoadMatchesFullLoad() {
+  std::string trace = makeTrace(400);
+  std::stringstream index_data;
+  HeapHistory full;
+  {
+    std::istringstream input(trace);
+    TraceIndexWriter writer(&index_data, 64);
+    full.LoadFromJSONStream(input, &writer);
+  }
+
+  const uint64_t ranges[][2] = { { 0, 40 }, { 300, 420 }, { 513, 700 },
+    { 790, 10000 } };
+  for (const auto& range : ranges) {
+    std::istringstream input(trace);
+    HeapHistory partial;
+    QVERIFY(partial.LoadTickRangeFromJSONStream(input, index_data, range[0],
+      range[1]));
+    QVERIFY(partial.getMinimumTick() <= range[0]);
+    QVERIFY(partial.getMinimumTick() + 64 > range[0]);
+    QVERIFY(partial.getNumberOfBlocks() <= full.getNumberOfBlocks());
+    uint64_t last = std::min(range[1], uint64_t(800));
+    for (uint64_t tick = partial.getMinimumTick(); tick <= last; ++tick) {
+      QCOMPARE(getLiveSet(partial, tick), getLiveSet(full, tick));
+    }
+  }
+}
+
+void TestTraceIndex::TestRejectsCorruptIndex() {
+  std::string trace = makeTrace(100);
+  std::stringstream index_data;
+  {
+    HeapHistory history;
+    std::istringstream input(trace);
+    TraceIndexWriter writer(&index_data, 32);
+    history.LoadFromJSONStream(input, &writer);
+  }
+  std::string index = index_data.str();
+  TraceIndexReader reader;
+  for (size_t length : { size_t(0), size_t(7), index.size() / 2,
+    index.size() - 1 }) {
+    std::istringstream truncated(index.substr(0, length));
+    QVERIFY(!reader.open(&truncated));
+  }
+  std::string corrupt = index;
+  corrupt[0] = 'X';
+  std::istringstream corrupt_input(corrupt);
+  QVERIFY(!reader.open(&corrupt_input));
+
+  HeapHistory history;
+  std::istringstream input(trace);
+  std::istringstream bad_index(corrupt);
+  QVERIFY(!history.LoadTickRangeFromJSONStream(input, bad_index, 0, 100));
+  QCOMPARE(history.getNumberOfBlocks(), size_t(0));
+}
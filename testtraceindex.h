@@ -0,0 +1,22 @@
+#ifndef TESTTRACEINDEX_H
+#define TESTTRACEINDEX_H
+
+#include <QObject>
+
+class TestTraceIndex : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestElementReaderOffsets();
+  void TestCheckpointRoundTrip();
+  void TestTickRangeLoadMatchesFullLoad();
+  void TestRejectsCorruptIndex();
+};
+
+#endif // TESTTRACEINDEX_H
@@ -0,0 +1,156 @@
+#include <QtTest/QtTest>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include "heaphistory.h"
+#include "traceinputstream.h"
+#include "testtraceinputstream.h"
+
+static std::string makeTrace(uint32_t number_of_allocations) {
+  std::ostringstream trace;
+  trace << "[";
+  for (uint32_t index = 0; index < number_of_allocations; ++index) {
+    trace << ((index == 0) ? "\n" : ",\n") << "  {\"type\": \"alloc\", "
+      "\"address\": " << 0x10000 + 0x40 * index << ", \"size\": "
+      << 16 + index % 48 << "}";
+  }
+  trace << "\n]\n";
+  return trace.str();
+}
+
+// Compresses |data| into a single gzip member.
+static std::string gzipCompress(const std::string& data) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // 15 window bits, plus 16 for a gzip header.
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+    Z_DEFAULT_STRATEGY);
+  std::string result(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = static_cast<uInt>(result.size());
+  deflate(&stream, Z_FINISH);
+  result.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+static std::string zstdCompress(const std::string& data) {
+  std::string result(ZSTD_compressBound(data.size()), '\0');
+  result.resize(ZSTD_compress(&result[0], result.size(), data.data(),
+    data.size(), 3));
+  return result;
+}
+
+static std::string readAll(std::streambuf* buffer) {
+  std::istream input(buffer);
+  return std::string((std::istreambuf_iterator<char>(input)),
+    std::istreambuf_iterator<char>());
+}
+
+void TestTraceInputStream::TestGzipRoundTrip() {
+  std::string first = makeTrace(2000);
+  std::string second = makeTrace(10);
+  // Two concatenated gzip members, as written by parallel compressors.
+  std::istringstream compressed(gzipCompress(first) + gzipCompress(second));
+  QCOMPARE(DecompressingStreamBuffer::detectFormat(&compressed),
+    DecompressingStreamBuffer::GZIP);
+  // Small buffers and a short queue, so that the decompression thread has
+  // to wait for the reader.
+  DecompressingStreamBuffer buffer(&compressed,
+    DecompressingStreamBuffer::GZIP, 333, 2);
+  QCOMPARE(readAll(&buffer), first + second);
+  QVERIFY(!buffer.failed());
+}
+
+void TestTraceInputStream::TestZstdRoundTrip() {
+  std::string trace = makeTrace(5000);
+  std::istringstream compressed(zstdCompress(trace) + zstdCompress(trace));
+  QCOMPARE(DecompressingStreamBuffer::detectFormat(&compressed),
+    DecompressingStreamBuffer::ZSTD);
+  DecompressingStreamBuffer buffer(&compressed,
+    DecompressingStreamBuffer::ZSTD, 1000, 3);
+  QCOMPARE(readAll(&buffer), trace + trace);
+  QVERIFY(!buffer.failed());
+
+  std::istringstream uncompressed(trace);
+  QCOMPARE(DecompressingStreamBuffer::detectFormat(&uncompressed),
+    DecompressingStreamBuffer::UNCOMPRESSED);
+  QCOMPARE(uncompressed.tellg(), std::streampos(0));
+}
+
+void TestTraceInputStream::TestSeekForward() {
+  std::string trace = makeTrace(1000);
+  std::istringstream compressed(zstdCompress(trace));
+  DecompressingStreamBuffer buffer(&compressed,
+    DecompressingStreamBuffer::ZSTD, 100, 2);
+  std::istream input(&buffer);
+  char character;
+  for (std::streampos position : { std::streampos(1), std::streampos(99),
+    std::streampos(100), std::streampos(12345),
+    std::streampos(trace.size() - 1) }) {
+    QVERIFY(static_cast<bool>(input.seekg(position)));
+    QCOMPARE(input.tellg(), position);
+    QVERIFY(static_cast<bool>(input.get(character)));
+    QCOMPARE(character, trace[static_cast<size_t>(position)]);
+  }
+  // Seeking backwards or past the end fails.
+  QVERIFY(!input.seekg(5));
+  input.clear();
+  QVERIFY(!input.seekg(trace.size() + 1));
+}
+
+void TestTraceInputStream::TestTruncatedInputFails() {
+  std::string trace = makeTrace(1000);
+  std::string gzip = gzipCompress(trace);
+  std::istringstream truncated_gzip(gzip.substr(0, gzip.size() / 2));
+  DecompressingStreamBuffer gzip_buffer(&truncated_gzip,
+    DecompressingStreamBuffer::GZIP, 100, 2);
+  QVERIFY(readAll(&gzip_buffer).size() < trace.size());
+  QVERIFY(gzip_buffer.failed());
+
+  std::string zstd = zstdCompress(trace);
+  std::istringstream truncated_zstd(zstd.substr(0, zstd.size() - 3));
+  DecompressingStreamBuffer zstd_buffer(&truncated_zstd,
+    DecompressingStreamBuffer::ZSTD, 100, 2);
+  readAll(&zstd_buffer);
+  QVERIFY(zstd_buffer.failed());
+
+  // Destroying the buffer without reading stops the decompression thread.
+  std::istringstream unread(zstd);
+  DecompressingStreamBuffer unread_buffer(&unread,
+    DecompressingStreamBuffer::ZSTD, 10, 1);
+}
+
+void TestTraceInputStream::TestLoadsCompressedTraceFile() {
+  std::string trace = makeTrace(3000);
+  std::string path = QDir::tempPath().toStdString() +
+    "/testtraceinputstream.json.gz";
+  {
+    std::ofstream file(path, std::fstream::out | std::fstream::binary);
+    file << gzipCompress(trace);
+  }
+
+  HeapHistory expected;
+  std::istringstream uncompressed(trace);
+  expected.LoadFromJSONStream(uncompressed);
+
+  TraceInputStream input(path);
+  QVERIFY(input.good());
+  QVERIFY(input.isCompressed());
+  HeapHistory history;
+  history.LoadFromJSONStream(input);
+  QCOMPARE(history.getNumberOfBlocks(), expected.getNumberOfBlocks());
+  QCOMPARE(history.getMaximumAddress(), expected.getMaximumAddress());
+  remove(path.c_str());
+
+  TraceInputStream missing(path);
+  QVERIFY(missing.fail());
+}
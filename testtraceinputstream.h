@@ -0,0 +1,23 @@
+#ifndef TESTTRACEINPUTSTREAM_H
+#define TESTTRACEINPUTSTREAM_H
+
+#include <QObject>
+
+class TestTraceInputStream : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestGzipRoundTrip();
+  void TestZstdRoundTrip();
+  void TestSeekForward();
+  void TestTruncatedInputFails();
+  void TestLoadsCompressedTraceFile();
+};
+
+#endif // TESTTRACEINPUTSTREAM_H
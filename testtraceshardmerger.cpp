@@ -0,0 +1,124 @@
+#include <QtTest/QtTest>
+
+#include <map>
+#include <memory>
+#include <sstream>
+
+#include "heaphistory.h"
+#include "traceshardmerger.h"
+#include "testtraceshardmerger.h"
+
+void TestTraceShardMerger::TestMergeOrdersByTimestamp() {
+  std::istringstream first("[{\"type\": \"event\", \"tag\": \"a\", "
+    "\"timestamp\": 1}, {\"type\": \"event\", \"tag\": \"d\", "
+    "\"timestamp\": 5}, {\"type\": \"event\", \"tag\": \"e\"}]");
+  std::istringstream empty("[]");
+  std::istringstream second("{\"type\": \"event\", \"tag\": \"b\", "
+    "\"timestamp\": 3}\n{\"type\": \"event\", \"tag\": \"f\", "
+    "\"timestamp\": 5}\n{\"type\": \"event\", \"tag\": \"g\", "
+    "\"timestamp\": 9}\n");
+  std::istringstream third("[{\"type\": \"event\", \"tag\": \"c\", "
+    "\"timestamp\": 3}]");
+  TraceShardMerger merger({ &first, &empty, &second, &third });
+
+  std::string tags;
+  std::vector<uint64_t> timestamps;
+  const TraceEvent* event;
+  const TraceEventChunk* chunk;
+  while (merger.next(&event, &chunk)) {
+    tags += chunk->strings_[event->tag_];
+    timestamps.push_back(event->timestamp_);
+  }
+  // Ties go to the shard that comes first, and "e" inherits timestamp 5.
+  QCOMPARE(tags, std::string("abcdefg"));
+  QCOMPARE(timestamps, std::vector<uint64_t>({ 1, 3, 3, 5, 5, 5, 9 }));
+  QVERIFY(!merger.next(&event, &chunk));
+}
+
+// Splits a trace into shards by thread, and checks that merging the shards
+// reproduces the history of the whole trace.
+void TestTraceShardMerger::TestShardedLoadMatchesSingleTrace() {
+  const size_t number_of_shards = 64;
+  std::ostringstream trace;
+  std::vector<std::ostringstream> shard_traces(number_of_shards);
+  trace << "[";
+  for (uint32_t index = 0; index < 20000; ++index) {
+    std::ostringstream element;
+    uint64_t address = 0x10000 + 0x100 * ((index / 2) % 997);
+    if (index % 2 == 0) {
+      element << "{\"type\": \"alloc\", \"address\": " << address
+        << ", \"size\": " << 16 + index % 200 << ", \"tag\": \"thread "
+        << (index * 7) % number_of_shards << "\"";
+    } else {
+      element << "{\"type\": \"free\", \"address\": " << address;
+    }
+    trace << ((index == 0) ? "" : ",\n") << element.str() << "}";
+    shard_traces[(index * 7) % number_of_shards] << element.str()
+      << ", \"timestamp\": " << 1000 + index * 3 << "}\n";
+  }
+  trace << "]";
+
+  HeapHistory expected;
+  std::istringstream input(trace.str());
+  expected.LoadFromJSONStream(input);
+
+  std::vector<std::unique_ptr<std::istringstream>> inputs;
+  std::vector<std::istream*> shards;
+  for (const std::ostringstream& shard_trace : shard_traces) {
+    inputs.emplace_back(new std::istringstream(shard_trace.str()));
+    shards.push_back(inputs.back().get());
+  }
+  HeapHistory merged;
+  merged.LoadFromTraceShards(shards);
+
+  QCOMPARE(merged.getNumberOfBlocks(), expected.getNumberOfBlocks());
+  QCOMPARE(merged.getMaximumTick(), expected.getMaximumTick());
+  for (uint32_t index = 0; index < expected.getNumberOfBlocks(); ++index) {
+    const HeapBlock& block = merged.getBlock(index);
+    const HeapBlock& expected_block = expected.getBlock(index);
+    QCOMPARE(block.start_tick_, expected_block.start_tick_);
+    QCOMPARE(block.end_tick_, expected_block.end_tick_);
+    QCOMPARE(block.address_, expected_block.address_);
+    QCOMPARE(block.size_, expected_block.size_);
+    QCOMPARE(*block.allocation_tag_, *expected_block.allocation_tag_);
+  }
+}
+
+// Every shard has its own string cache, which starts out empty for every new
+// batch of the shard, and keeps its entries while the batch lasts.
+void TestTraceShardMerger::TestStringCachePerShardAndBatch() {
+  const size_t events = PrefetchingTraceReader::default_events_per_batch * 2 +
+    10;
+  std::ostringstream first, second;
+  for (size_t index = 0; index < events; ++index) {
+    first << "{\"type\": \"event\", \"tag\": \"first\", \"timestamp\": "
+      << 2 * index << "}\n";
+    second << "{\"type\": \"event\", \"tag\": \"second\", "
+      "\"timestamp\": " << 2 * index + 1 << "}\n";
+  }
+  std::istringstream first_input(first.str());
+  std::istringstream second_input(second.str());
+  TraceShardMerger merger({ &first_input, &second_input });
+
+  const std::string first_tag = "first";
+  const std::string second_tag = "second";
+  std::map<const TraceEventChunk*, size_t> events_per_batch;
+  size_t batches = 0;
+  const TraceEvent* event;
+  const TraceEventChunk* chunk;
+  while (merger.next(&event, &chunk)) {
+    std::vector<const std::string*>* cache = merger.getStringCache();
+    QCOMPARE(cache->size(), chunk->strings_.size());
+    const std::string& tag = chunk->strings_[event->tag_];
+    const std::string* expected = (tag == first_tag) ? &first_tag :
+      &second_tag;
+    if (event == &chunk->events_[0]) {
+      ++batches;
+      QVERIFY((*cache)[event->tag_] == nullptr);
+      (*cache)[event->tag_] = expected;
+    }
+    // The other shard never overwrites the entry.
+    QVERIFY((*cache)[event->tag_] == expected);
+  }
+  QCOMPARE(batches, size_t(6));
+}
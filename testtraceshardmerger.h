@@ -0,0 +1,21 @@
+#ifndef TESTTRACESHARDMERGER_H
+#define TESTTRACESHARDMERGER_H
+
+#include <QObject>
+
+class TestTraceShardMerger : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestMergeOrdersByTimestamp();
+  void TestShardedLoadMatchesSingleTrace();
+  void TestStringCachePerShardAndBatch();
+};
+
+#endif // TESTTRACESHARDMERGER_H
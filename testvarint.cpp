@@ -0,0 +1,49 @@
+#include <QtTest/QtTest>
+
+#include <limits>
+
+#include "testvarint.h"
+#include "varint.h"
+
+void TestVarint::TestVarintRoundTrip() {
+  const uint64_t values[] = { 0, 1, 127, 128, 16383, 16384,
+    static_cast<uint64_t>(1) << 32, std::numeric_limits<uint64_t>::max() };
+  const size_t lengths[] = { 1, 1, 1, 2, 2, 3, 5, 10 };
+  std::vector<uint8_t> encoded;
+  for (size_t index = 0; index < 8; ++index) {
+    size_t before = encoded.size();
+    appendVarint(values[index], &encoded);
+    QCOMPARE(encoded.size() - before, lengths[index]);
+  }
+  const uint8_t* current = encoded.data();
+  for (uint64_t value : values) {
+    QCOMPARE(readVarint(&current), value);
+  }
+  QVERIFY(current == encoded.data() + encoded.size());
+}
+
+// Dense ascending sequences take one byte per value, and sparse ones survive
+// the round trip unchanged.
+void TestVarint::TestPackAscendingRoundTrip() {
+  std::vector<uint32_t> dense;
+  for (uint32_t value = 1000; value < 2000; value += 3) {
+    dense.push_back(value);
+  }
+  std::vector<uint8_t> packed;
+  packAscending(dense, &packed);
+  // Only the first value needs two bytes.
+  QCOMPARE(packed.size(), dense.size() + 1);
+  std::vector<uint32_t> unpacked;
+  unpackAscending(packed, &unpacked);
+  QCOMPARE(unpacked, dense);
+
+  std::vector<uint32_t> sparse = { 0, 5, 70000,
+    std::numeric_limits<uint32_t>::max() };
+  packAscending(sparse, &packed);
+  unpacked.clear();
+  unpackAscending(packed, &unpacked);
+  QCOMPARE(unpacked, sparse);
+
+  packAscending(std::vector<uint32_t>(), &packed);
+  QVERIFY(packed.empty());
+}
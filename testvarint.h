@@ -0,0 +1,20 @@
+#ifndef TESTVARINT_H
+#define TESTVARINT_H
+
+#include <QObject>
+
+class TestVarint : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestVarintRoundTrip();
+  void TestPackAscendingRoundTrip();
+};
+
+#endif // TESTVARINT_H
@@ -0,0 +1,110 @@
+#include <QtTest/QtTest>
+
+#include <cmath>
+
+#include "testvertextiles.h"
+#include "vertextiles.h"
+
+void TestVertexTiles::TestTileAssignment() {
+  const uint64_t tile = static_cast<uint64_t>(1) << VertexTiles::tile_bits;
+  VertexTiles tiles;
+  QVector3D color(0.5, 0.5, 0.5);
+  TileVertex first = tiles.toTileVertex(HeapVertex(3, 5 * tile + 7, color));
+  TileVertex second = tiles.toTileVertex(HeapVertex(tile - 1, 5 * tile,
+    color));
+  TileVertex third = tiles.toTileVertex(HeapVertex(tile, 5 * tile, color));
+  TileVertex fourth = tiles.toTileVertex(HeapVertex(0,
+    std::numeric_limits<uint64_t>::max(), color));
+  // Going back to a known tile does not add it again.
+  TileVertex fifth = tiles.toTileVertex(HeapVertex(1, 5 * tile + 1, color));
+
+  QCOMPARE(tiles.size(), static_cast<size_t>(3));
+  QCOMPARE(first.getTile(), 0u);
+  QCOMPARE(first.getX(), 3.0f);
+  QCOMPARE(first.getY(), 7.0f);
+  QCOMPARE(second.getTile(), 0u);
+  QCOMPARE(second.getX(), static_cast<float>(tile - 1));
+  QCOMPARE(third.getTile(), 1u);
+  QCOMPARE(third.getX(), 0.0f);
+  QCOMPARE(fourth.getTile(), 2u);
+  QCOMPARE(fourth.getY(), static_cast<float>(tile - 1));
+  QCOMPARE(fifth.getTile(), 0u);
+
+  std::vector<float> origins;
+  tiles.getTileOrigins(ivec3(0, 0, 0), Load64BitLeftShiftedBy4Into96Bit(
+    static_cast<int32_t>(5 * tile), 0), &origins);
+  QCOMPARE(origins.size(), static_cast<size_t>(6));
+  QCOMPARE(origins[0], 0.0f);
+  QCOMPARE(origins[1], 0.0f);
+  QCOMPARE(origins[2], 16.0f * tile);
+
+  tiles.clear();
+  QCOMPARE(tiles.size(), static_cast<size_t>(0));
+  QCOMPARE(tiles.toTileVertex(HeapVertex(tile, 0, color)).getTile(), 0u);
+}
+
+// Compares the tile-relative coordinates with the exact translated
+// coordinates for windows of all sizes: they are exact in zoomed-in windows,
+// and always off by far less than a pixel.
+void TestVertexTiles::TestTileRelativePrecision() {
+  uint64_t state = 0xFEDCBA9876543210ULL;
+  auto next = [&state]() {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state;
+  };
+  for (uint32_t iteration = 0; iteration < 10000; ++iteration) {
+    // The window size in sixteenths, between 2^4 and 2^63.
+    uint32_t window_bits = 4 + next() % 60;
+    long double window = ldexpl(1.0L, static_cast<int>(window_bits));
+    uint64_t minimum = next() >> (next() % 64);
+    ivec3 base = Load64BitLeftShiftedBy4Into96Bit(
+      static_cast<int32_t>(minimum), static_cast<int32_t>(minimum >> 32));
+    base.x |= static_cast<int32_t>(next() & 0xF);
+    if (iteration % 8 == 0) {
+      // A window that starts below 0.
+      base = Sub96(ivec3(0, 0, 0), ivec3(static_cast<int32_t>(
+        next() >> (64 - window_bits / 2)), 0, 0));
+      minimum = 0;
+    }
+    uint64_t delta = (next() >> 4) >> (64 - window_bits);
+    uint64_t value = (minimum + delta < minimum) ? minimum : minimum + delta;
+
+    VertexTiles tiles;
+    TileVertex vertex = tiles.toTileVertex(HeapVertex(value, value,
+      QVector3D()));
+    std::vector<float> origins;
+    tiles.getTileOrigins(base, base, &origins);
+    long double exact = Sub96(Load64BitLeftShiftedBy4Into96Bit(
+      static_cast<int32_t>(value), static_cast<int32_t>(value >> 32)),
+      base).getLongDouble();
+    long double x = VertexTiles::getTranslatedCoordinate(origins[0],
+      vertex.getX());
+    long double y = VertexTiles::getTranslatedCoordinate(origins[1],
+      vertex.getY());
+    if (window_bits <= 22) {
+      QCOMPARE(x, exact);
+      QCOMPARE(y, exact);
+    }
+    QVERIFY(fabsl(x - exact) <= window / (1 << 20));
+    QVERIFY(fabsl(y - exact) <= window / (1 << 20));
+  }
+}
+
+void TestVertexTiles::TestPackedVertexFormat() {
+  QCOMPARE(sizeof(TileVertex), static_cast<size_t>(16));
+  QCOMPARE(sizeof(HeapVertex), static_cast<size_t>(20));
+  QCOMPARE(TileVertex::colorOffset(), 12);
+
+  // Colors survive within half a step of 8 bits, out-of-range values are
+  // clamped, and 8-bit colors (like the event colors) are exact.
+  HeapVertex vertex(1, 2, QVector3D(0.25f, 1.3f, -0.2f));
+  QVERIFY(fabs(vertex.getColor().x() - 0.25f) <= 0.5f / 255.0f);
+  QCOMPARE(vertex.getColor().y(), 1.0f);
+  QCOMPARE(vertex.getColor().z(), 0.0f);
+  for (uint32_t value = 0; value < 256; ++value) {
+    QVector3D color(value / 255.0f, 0.0f, 1.0f);
+    QCOMPARE(PackedColor(color).toVector3D(), color);
+  }
+  VertexTiles tiles;
+  QCOMPARE(tiles.toTileVertex(vertex).getColor(), vertex.getColor());
+}
@@ -0,0 +1,21 @@
+#ifndef TESTVERTEXTILES_H
+#define TESTVERTEXTILES_H
+
+#include <QObject>
+
+class TestVertexTiles : public QObject
+{
+  Q_OBJECT
+public:
+
+signals:
+
+public slots:
+
+private slots:
+  void TestTileAssignment();
+  void TestTileRelativePrecision();
+  void TestPackedVertexFormat();
+};
+
+#endif // TESTVERTEXTILES_H
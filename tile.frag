@@ -0,0 +1,11 @@
+#version 130
+in vec2 vTexcoord;
+out vec4 fColor;
+
+// The tile, with premultiplied colors.
+uniform sampler2D tile;
+
+void main(void)
+{
+  fColor = texture(tile, vTexcoord);
+}
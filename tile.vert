@@ -0,0 +1,12 @@
+#version 130
+// Draws a pre-rendered tile of the block diagram (see TileCacheLayer). The
+// positions are already in screen space.
+in highp vec2 position;
+in highp vec2 texcoord;
+out vec2 vTexcoord;
+
+void main(void)
+{
+  gl_Position = vec4(position, 0.0, 1.0);
+  vTexcoord = texcoord;
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cmath>
+
+#include "tilecachelayer.h"
+
+// The tiles of one axis that a window shows.
+struct VisibleTiles {
+  uint8_t level_ = 0;
+  uint64_t span_ = 1;
+  uint64_t first_ = 1;
+  uint64_t last_ = 0;
+};
+
+// Finds the tiles at |level| that the part of the axis from |window_minimum|
+// to |window_minimum| + |window_span| touches. Leaves first_ > last_ if the
+// window lies outside of the axis.
+static VisibleTiles getVisibleTiles(uint64_t minimum, uint64_t maximum,
+  uint8_t level, long double window_minimum, long double window_span) {
+  VisibleTiles tiles;
+  tiles.level_ = level;
+  tiles.span_ = TileRenderer::getTileSpan(minimum, maximum, level);
+  uint64_t last_tile = (maximum - minimum) / tiles.span_;
+  if (level < 63) {
+    last_tile = std::min(last_tile, (static_cast<uint64_t>(1) << level) - 1);
+  }
+  long double from = std::floor((window_minimum - minimum) / tiles.span_);
+  long double to = std::floor((window_minimum + window_span - minimum) /
+    tiles.span_);
+  if ((to < 0) || (from > last_tile)) {
+    return tiles;
+  }
+  tiles.first_ = (from < 0) ? 0 : static_cast<uint64_t>(from);
+  tiles.last_ = std::min(static_cast<uint64_t>(to), last_tile);
+  return tiles;
+}
+
+TileCacheLayer::TileCacheLayer(TileRenderer* renderer) :
+  renderer_(renderer), shader_program_(new QOpenGLShaderProgram()) {}
+
+TileCacheLayer::~TileCacheLayer() {
+  clear();
+  if (is_initialized_) {
+    vao_.destroy();
+    vertex_buffer_.destroy();
+  }
+}
+
+void TileCacheLayer::initializeGLStructures() {
+  if (is_initialized_) {
+    return;
+  }
+  shader_program_->bindAttributeLocation("position", 0);
+  shader_program_->bindAttributeLocation("texcoord", 1);
+  shader_program_->addShaderFromSourceFile(QOpenGLShader::Vertex,
+    ":/tile.vert");
+  shader_program_->addShaderFromSourceFile(QOpenGLShader::Fragment,
+    ":/tile.frag");
+  shader_program_->link();
+  shader_program_->bind();
+  uniform_tile_ = shader_program_->uniformLocation("tile");
+
+  vertex_buffer_.create();
+  vertex_buffer_.bind();
+  vertex_buffer_.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
+  vao_.create();
+  vao_.bind();
+  shader_program_->enableAttributeArray(0);
+  shader_program_->enableAttributeArray(1);
+  shader_program_->setAttributeBuffer(0, GL_FLOAT, 0, 2, 4 * sizeof(float));
+  shader_program_->setAttributeBuffer(1, GL_FLOAT, 2 * sizeof(float), 2,
+    4 * sizeof(float));
+
+  vao_.release();
+  vertex_buffer_.release();
+  shader_program_->release();
+  is_initialized_ = true;
+}
+
+void TileCacheLayer::clear() {
+  for (auto& tile : tiles_) {
+    tile.second.texture_->destroy();
+  }
+  tiles_.clear();
+  lru_.clear();
+  rendered_.clear();
+}
+
+void TileCacheLayer::uploadRenderedTiles() {
+  rendered_.clear();
+  renderer_->takeRenderedTiles(&rendered_);
+  for (const TileRenderer::Tile& tile : rendered_) {
+    if (tiles_.count(tile.key_) != 0) {
+      continue;
+    }
+    if (tiles_.size() >= maximum_cached_tiles) {
+      auto oldest = tiles_.find(lru_.back());
+      oldest->second.texture_->destroy();
+      tiles_.erase(oldest);
+      lru_.pop_back();
+    }
+    CachedTile& cached = tiles_[tile.key_];
+    cached.texture_.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+    cached.texture_->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    cached.texture_->setSize(TileRenderer::tile_size, TileRenderer::tile_size);
+    cached.texture_->setMinMagFilters(QOpenGLTexture::Linear,
+      QOpenGLTexture::Linear);
+    // Keep the neighbouring tiles from bleeding into the edges.
+    cached.texture_->setWrapMode(QOpenGLTexture::ClampToEdge);
+    cached.texture_->allocateStorage(QOpenGLTexture::RGBA,
+      QOpenGLTexture::UInt8);
+    cached.texture_->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8,
+      tile.pixels_.data());
+    lru_.push_front(tile.key_);
+    cached.lru_position_ = lru_.begin();
+  }
+  rendered_.clear();
+}
+
+QOpenGLTexture* TileCacheLayer::findTile(const DiagramTileKey& key) {
+  auto tile = tiles_.find(key);
+  if (tile == tiles_.end()) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, tile->second.lru_position_);
+  return tile->second.texture_.get();
+}
+
+void TileCacheLayer::requestTile(const DiagramTileKey& key,
+  std::vector<DiagramTileKey>* requests) {
+  if (tiles_.count(key) == 0) {
+    requests->push_back(key);
+  }
+}
+
+bool TileCacheLayer::paintLayer(const HeapHistory& history, int width,
+  int height) {
+  uploadRenderedTiles();
+  if ((width <= 0) || (height <= 0)) {
+    return false;
+  }
+
+  // The window in ticks and bytes; the window keeps 4 fractional bits.
+  const DisplayHeapWindow& window = history.getCurrentWindow();
+  long double window_tick = window.getMinimumTick().getLongDouble() / 16;
+  long double window_width = window.getWidthAsLongDouble() / 16;
+  long double window_address = window.getMinimumAddress().getLongDouble() / 16;
+  long double window_height = window.getHeightAsLongDouble() / 16;
+  uint8_t level_x = TileRenderer::chooseLevel(history.getMinimumTick(),
+    history.getMaximumTick(), window_width, width);
+  uint8_t level_y = TileRenderer::chooseLevel(history.getMinimumAddress(),
+    history.getMaximumAddress(), window_height, height);
+  VisibleTiles columns = getVisibleTiles(history.getMinimumTick(),
+    history.getMaximumTick(), level_x, window_tick, window_width);
+  VisibleTiles rows = getVisibleTiles(history.getMinimumAddress(),
+    history.getMaximumAddress(), level_y, window_address, window_height);
+  // Zoomed in so far that even the finest tiles would look blurry.
+  if ((columns.span_ * static_cast<long double>(width) >
+      window_width * TileRenderer::tile_size) ||
+    (rows.span_ * static_cast<long double>(height) >
+      window_height * TileRenderer::tile_size)) {
+    return false;
+  }
+  bool empty = (columns.first_ > columns.last_) || (rows.first_ > rows.last_);
+  if (!empty && ((columns.last_ - columns.first_ + 1) *
+    (rows.last_ - rows.first_ + 1) > maximum_cached_tiles / 2)) {
+    return false;
+  }
+
+  std::vector<DiagramTileKey> requests;
+  visible_textures_.clear();
+  vertices_.clear();
+  DiagramTileKey key;
+  key.level_x_ = level_x;
+  key.level_y_ = level_y;
+  for (uint64_t row = rows.first_; !empty && (row <= rows.last_); ++row) {
+    for (uint64_t column = columns.first_; column <= columns.last_;
+      ++column) {
+      key.x_ = column;
+      key.y_ = row;
+      QOpenGLTexture* texture = findTile(key);
+      if (texture == nullptr) {
+        requests.push_back(key);
+        continue;
+      }
+      visible_textures_.push_back(texture);
+      uint64_t minimum_tick, maximum_tick, minimum_address, maximum_address;
+      TileRenderer::getTileRange(history.getMinimumTick(),
+        history.getMaximumTick(), level_x, column, &minimum_tick,
+        &maximum_tick);
+      TileRenderer::getTileRange(history.getMinimumAddress(),
+        history.getMaximumAddress(), level_y, row, &minimum_address,
+        &maximum_address);
+      // The last tile of an axis can be cut short.
+      auto left = static_cast<float>((minimum_tick - window_tick) /
+        window_width * 2 - 1);
+      auto right = static_cast<float>((maximum_tick + 1.0L - window_tick) /
+        window_width * 2 - 1);
+      auto bottom = static_cast<float>((minimum_address - window_address) /
+        window_height * 2 - 1);
+      auto top = static_cast<float>((maximum_address + 1.0L - window_address) /
+        window_height * 2 - 1);
+      auto s = static_cast<float>((maximum_tick - minimum_tick + 1.0L) /
+        columns.span_);
+      auto t = static_cast<float>((maximum_address - minimum_address + 1.0L) /
+        rows.span_);
+      // Counter-clockwise, starting at the lower left corner.
+      vertices_.insert(vertices_.end(), { left, bottom, 0.0f, 0.0f,
+        right, bottom, s, 0.0f, right, top, s, t, left, top, 0.0f, t });
+    }
+  }
+  bool complete = requests.empty();
+
+  // Prefetch the ring around the window, then the coarser level.
+  if (!empty) {
+    uint64_t first_column = (columns.first_ > 0) ? columns.first_ - 1 : 0;
+    uint64_t first_row = (rows.first_ > 0) ? rows.first_ - 1 : 0;
+    for (uint64_t row = first_row; row <= rows.last_ + 1; ++row) {
+      for (uint64_t column = first_column; column <= columns.last_ + 1;
+        ++column) {
+        bool inside = (row >= rows.first_) && (row <= rows.last_) &&
+          (column >= columns.first_) && (column <= columns.last_);
+        uint64_t unused;
+        if (!inside && TileRenderer::getTileRange(history.getMinimumTick(),
+            history.getMaximumTick(), level_x, column, &unused, &unused) &&
+          TileRenderer::getTileRange(history.getMinimumAddress(),
+            history.getMaximumAddress(), level_y, row, &unused, &unused)) {
+          key.x_ = column;
+          key.y_ = row;
+          requestTile(key, &requests);
+        }
+      }
+    }
+  }
+  if ((level_x > 0) || (level_y > 0)) {
+    VisibleTiles parent_columns = getVisibleTiles(history.getMinimumTick(),
+      history.getMaximumTick(), (level_x > 0) ? level_x - 1 : 0, window_tick,
+      window_width);
+    VisibleTiles parent_rows = getVisibleTiles(history.getMinimumAddress(),
+      history.getMaximumAddress(), (level_y > 0) ? level_y - 1 : 0,
+      window_address, window_height);
+    key.level_x_ = parent_columns.level_;
+    key.level_y_ = parent_rows.level_;
+    for (uint64_t row = parent_rows.first_; row <= parent_rows.last_; ++row) {
+      for (uint64_t column = parent_columns.first_;
+        column <= parent_columns.last_; ++column) {
+        key.x_ = column;
+        key.y_ = row;
+        requestTile(key, &requests);
+      }
+    }
+  }
+  renderer_->request(requests);
+  if (!complete) {
+    return false;
+  }
+
+  // The tiles hold premultiplied colors.
+  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  shader_program_->bind();
+  shader_program_->setUniformValue(uniform_tile_, 0);
+  vao_.bind();
+  vertex_buffer_.bind();
+  auto size = static_cast<int>(vertices_.size() * sizeof(float));
+  if (vertex_buffer_.size() < size) {
+    vertex_buffer_.allocate(size);
+  }
+  vertex_buffer_.write(0, vertices_.data(), size);
+  for (size_t tile = 0; tile < visible_textures_.size(); ++tile) {
+    visible_textures_[tile]->bind(0);
+    glDrawArrays(GL_TRIANGLE_FAN, static_cast<GLint>(tile * 4), 4);
+    visible_textures_[tile]->release(0);
+  }
+  vertex_buffer_.release();
+  vao_.release();
+  shader_program_->release();
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  return true;
+}
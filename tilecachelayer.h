@@ -0,0 +1,70 @@
+#ifndef TILECACHELAYER_H
+#define TILECACHELAYER_H
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QOpenGLBuffer>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLVertexArrayObject>
+
+#include "heaphistory.h"
+#include "tilerenderer.h"
+
+// Draws the heap blocks from the pre-rendered tiles of a TileRenderer,
+// which keeps the cost of a frame independent of the number of blocks.
+//
+// The most recently used tiles are kept as textures. Every frame requests
+// the visible tiles that are missing, then the ring of tiles around them and
+// the tiles of the next coarser level, so that panning and zooming out find
+// their tiles already rendered.
+class TileCacheLayer {
+public:
+  static constexpr size_t maximum_cached_tiles = 256;
+
+  explicit TileCacheLayer(TileRenderer* renderer);
+  ~TileCacheLayer();
+  void initializeGLStructures();
+
+  // Draws the current window of |history| on a |width| by |height| widget.
+  // Returns false, and draws nothing, if a visible tile is not rendered yet
+  // or the tiles would be coarser than the screen; the blocks need to be
+  // drawn instead then.
+  bool paintLayer(const HeapHistory& history, int width, int height);
+  // Drops all tiles, e.g. after the highlights changed.
+  void clear();
+
+private:
+  struct CachedTile {
+    std::unique_ptr<QOpenGLTexture> texture_;
+    std::list<DiagramTileKey>::iterator lru_position_;
+  };
+
+  void uploadRenderedTiles();
+  // Returns the texture of the tile and marks it as recently used, or
+  // nullptr if the tile is not cached.
+  QOpenGLTexture* findTile(const DiagramTileKey& key);
+  void requestTile(const DiagramTileKey& key,
+    std::vector<DiagramTileKey>* requests);
+
+  TileRenderer* renderer_;
+  std::unordered_map<DiagramTileKey, CachedTile, DiagramTileKeyHash> tiles_;
+  // The most recently used tile first.
+  std::list<DiagramTileKey> lru_;
+  std::vector<TileRenderer::Tile> rendered_;
+
+  // Four vertices per visible tile: x and y on the screen, and the texture
+  // coordinates.
+  std::vector<float> vertices_;
+  std::vector<QOpenGLTexture*> visible_textures_;
+  QOpenGLBuffer vertex_buffer_;
+  QOpenGLVertexArrayObject vao_;
+  std::unique_ptr<QOpenGLShaderProgram> shader_program_;
+  int uniform_tile_ = 0;
+  bool is_initialized_ = false;
+};
+
+#endif // TILECACHELAYER_H
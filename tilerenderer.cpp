@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+
+#include "tilerenderer.h"
+
+// The block shader draws every block with this opacity.
+static constexpr float block_alpha = 0.6f;
+
+TileRenderer::TileRenderer(const HeapHistory* history) : history_(history) {
+  worker_ = std::thread(&TileRenderer::work, this);
+}
+
+TileRenderer::~TileRenderer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    requests_.clear();
+  }
+  wake_worker_.notify_all();
+  worker_.join();
+}
+
+uint8_t TileRenderer::chooseLevel(uint64_t minimum, uint64_t maximum,
+  long double window_span, uint32_t screen_pixels) {
+  for (uint8_t level = 0; level < 63; ++level) {
+    if (static_cast<long double>(getTileSpan(minimum, maximum, level)) *
+      screen_pixels <= window_span * tile_size) {
+      return level;
+    }
+  }
+  return 63;
+}
+
+bool TileRenderer::getTileRange(uint64_t minimum, uint64_t maximum,
+  uint8_t level, uint64_t index, uint64_t* low, uint64_t* high) {
+  uint64_t span = getTileSpan(minimum, maximum, level);
+  if ((index >= (static_cast<uint64_t>(1) << level)) ||
+    (index > (maximum - minimum) / span)) {
+    return false;
+  }
+  *low = minimum + index * span;
+  *high = (maximum - *low < span - 1) ? maximum : *low + span - 1;
+  return true;
+}
+
+void TileRenderer::cancel() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  requests_.clear();
+  worker_idle_.wait(lock, [this]() { return !busy_; });
+}
+
+void TileRenderer::reset() {
+  cancel();
+  std::lock_guard<std::mutex> lock(mutex_);
+  rendered_.clear();
+  snapshot_.highlight_bits_ = history_->getHighlightBits();
+  snapshot_.visible_heap_bits_ = history_->getVisibleHeapBits();
+}
+
+void TileRenderer::request(const std::vector<DiagramTileKey>& keys) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.clear();
+    for (const DiagramTileKey& key : keys) {
+      if (!busy_ || !(key == rendering_)) {
+        requests_.push_back(key);
+      }
+    }
+  }
+  wake_worker_.notify_one();
+}
+
+void TileRenderer::takeRenderedTiles(std::vector<Tile>* tiles) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Tile& tile : rendered_) {
+    tiles->push_back(std::move(tile));
+  }
+  rendered_.clear();
+}
+
+void TileRenderer::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_worker_.wait(lock, [this]() { return stop_ || !requests_.empty(); });
+    if (stop_) {
+      return;
+    }
+    Tile tile;
+    tile.key_ = requests_.front();
+    requests_.pop_front();
+    busy_ = true;
+    rendering_ = tile.key_;
+    lock.unlock();
+    // Nobody changes the snapshot or the blocks while the worker is busy.
+    renderTile(*history_, snapshot_, tile.key_, &tile.pixels_);
+    lock.lock();
+    busy_ = false;
+    rendered_.push_back(std::move(tile));
+    worker_idle_.notify_all();
+    if (tile_ready_callback_) {
+      tile_ready_callback_();
+    }
+  }
+}
+
+// Keep in synch with HighlightColor in simple.vert.
+static QVector3D highlightColor(const QVector3D& color) {
+  if (color.x() == 0.0f) {
+    return QVector3D(color.y(), color.y(), 0.0f);
+  }
+  return QVector3D(std::min(color.x() + 0.3f, 1.0f), color.y(), 0.0f);
+}
+
+// The pixels whose centers lie in [low, high), for an axis that starts at
+// |origin| and has |pixel| units per pixel.
+static void getCoveredPixels(uint64_t low, uint64_t high, uint64_t origin,
+  long double pixel, uint32_t* first, uint32_t* end) {
+  long double tile_size = TileRenderer::tile_size;
+  long double from = std::ceil((static_cast<long double>(low) - origin) /
+    pixel - 0.5L);
+  long double to = std::ceil((static_cast<long double>(high) - origin) /
+    pixel - 0.5L);
+  *first = static_cast<uint32_t>(std::min(std::max(from, 0.0L), tile_size));
+  *end = static_cast<uint32_t>(std::min(std::max(to, 0.0L), tile_size));
+}
+
+void TileRenderer::renderTile(const HeapHistory& history,
+  const Snapshot& snapshot, const DiagramTileKey& key,
+  std::vector<uint8_t>* pixels) {
+  // Premultiplied colors and the alpha of every pixel.
+  std::vector<float> accumulated(4 * tile_size * tile_size, 0.0f);
+  uint64_t minimum_tick, maximum_tick, minimum_address, maximum_address;
+  if (TileRenderer::getTileRange(history.getMinimumTick(),
+      history.getMaximumTick(), key.level_x_, key.x_, &minimum_tick,
+      &maximum_tick) &&
+    TileRenderer::getTileRange(history.getMinimumAddress(),
+      history.getMaximumAddress(), key.level_y_, key.y_, &minimum_address,
+      &maximum_address)) {
+    long double pixel_width = static_cast<long double>(getTileSpan(
+      history.getMinimumTick(), history.getMaximumTick(), key.level_x_)) /
+      tile_size;
+    long double pixel_height = static_cast<long double>(getTileSpan(
+      history.getMinimumAddress(), history.getMaximumAddress(),
+      key.level_y_)) / tile_size;
+    // Like the block layer, skip blocks that are much smaller than a pixel.
+    auto minimum_size = static_cast<uint64_t>(pixel_height / 4);
+
+    std::vector<HeapVertex> quad;
+    history.visitActiveBlocks(minimum_size, minimum_address, maximum_address,
+      minimum_tick, maximum_tick, [&](uint32_t index, const HeapBlock& block) {
+      uint32_t heap = block.heap_id_;
+      if (((snapshot.visible_heap_bits_[heap / 32] >> (heap % 32)) & 1) == 0) {
+        return;
+      }
+      quad.clear();
+      history.blockToVertices(block, &quad);
+      // The quads start at the lower left corner, see vertex.h.
+      const HeapVertex& lower_left = quad[0];
+      const HeapVertex& upper_right = quad[2];
+      QVector3D bottom = lower_left.getColor();
+      QVector3D top = upper_right.getColor();
+      if ((index / 32 < snapshot.highlight_bits_.size()) &&
+        ((snapshot.highlight_bits_[index / 32] >> (index % 32)) & 1)) {
+        bottom = highlightColor(bottom);
+        top = highlightColor(top);
+      }
+
+      uint32_t first_column, end_column, first_row, end_row;
+      getCoveredPixels(lower_left.getX(), upper_right.getX(), minimum_tick,
+        pixel_width, &first_column, &end_column);
+      getCoveredPixels(lower_left.getY(), upper_right.getY(), minimum_address,
+        pixel_height, &first_row, &end_row);
+      long double height = static_cast<long double>(upper_right.getY()) -
+        lower_left.getY();
+      for (uint32_t row = first_row; row < end_row; ++row) {
+        // Interpolate the colors across the quad, like the rasterizer.
+        auto t = static_cast<float>(((row + 0.5L) * pixel_height +
+          minimum_address - lower_left.getY()) / height);
+        float red = bottom.x() + (top.x() - bottom.x()) * t;
+        float green = bottom.y() + (top.y() - bottom.y()) * t;
+        float blue = bottom.z() + (top.z() - bottom.z()) * t;
+        float* pixel = &accumulated[4 * (row * tile_size + first_column)];
+        for (uint32_t column = first_column; column < end_column; ++column) {
+          pixel[0] = block_alpha * red + (1 - block_alpha) * pixel[0];
+          pixel[1] = block_alpha * green + (1 - block_alpha) * pixel[1];
+          pixel[2] = block_alpha * blue + (1 - block_alpha) * pixel[2];
+          pixel[3] = block_alpha + (1 - block_alpha) * pixel[3];
+          pixel += 4;
+        }
+      }
+    });
+  }
+
+  pixels->resize(accumulated.size());
+  for (size_t index = 0; index < accumulated.size(); ++index) {
+    float value = std::min(std::max(accumulated[index], 0.0f), 1.0f);
+    (*pixels)[index] = static_cast<uint8_t>(std::lround(value * 255.0f));
+  }
+}
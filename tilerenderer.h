@@ -0,0 +1,125 @@
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "heaphistory.h"
+
+// A tile of the block diagram, like the tiles of a web map. At level l, the
+// ticks between the minimum and the maximum tick of the trace are split into
+// 2^l columns, and the addresses into 2^l rows. The levels of the two axes
+// are separate, since the diagram zooms in both directions separately.
+struct DiagramTileKey {
+  uint8_t level_x_ = 0;
+  uint8_t level_y_ = 0;
+  uint64_t x_ = 0;
+  uint64_t y_ = 0;
+
+  bool operator==(const DiagramTileKey& other) const {
+    return (level_x_ == other.level_x_) && (level_y_ == other.level_y_) &&
+      (x_ == other.x_) && (y_ == other.y_);
+  }
+};
+
+struct DiagramTileKeyHash {
+  size_t operator()(const DiagramTileKey& key) const {
+    uint64_t hash = (static_cast<uint64_t>(key.level_x_) << 8) | key.level_y_;
+    hash = hash * 0x9E3779B97F4A7C15ull + key.x_;
+    hash = hash * 0x9E3779B97F4A7C15ull + key.y_;
+    return static_cast<size_t>(hash ^ (hash >> 29));
+  }
+};
+
+// Renders the heap blocks into tile images on the CPU, on a worker thread,
+// so that the diagram can be drawn from a few textures instead of millions
+// of quads (see TileCacheLayer).
+//
+// A tile is tile_size by tile_size pixels of premultiplied RGBA, with the
+// lowest addresses in the first row. The blocks are blended like the block
+// shader draws them, so compositing a tile with (GL_ONE,
+// GL_ONE_MINUS_SRC_ALPHA) gives the same picture as drawing its blocks.
+//
+// The worker reads the blocks of the heap history, which do not change once
+// a trace is loaded, and a snapshot of the highlights and the visible heaps,
+// which the GUI thread changes at any time.
+class TileRenderer {
+public:
+  static constexpr uint32_t tile_size = 256;
+
+  struct Snapshot {
+    std::vector<uint32_t> highlight_bits_;
+    std::array<uint32_t, 8> visible_heap_bits_ = {};
+  };
+
+  struct Tile {
+    DiagramTileKey key_;
+    // Four bytes (RGBA) per pixel.
+    std::vector<uint8_t> pixels_;
+  };
+
+  explicit TileRenderer(const HeapHistory* history);
+  ~TileRenderer();
+
+  // The number of ticks or bytes that one tile spans at |level|, for an
+  // axis from |minimum| to |maximum|.
+  static uint64_t getTileSpan(uint64_t minimum, uint64_t maximum,
+    uint8_t level) {
+    return ((maximum - minimum) >> level) + 1;
+  }
+  // The coarsest level at which a tile pixel is at most as large as a
+  // screen pixel, if |window_span| is shown on |screen_pixels| pixels.
+  static uint8_t chooseLevel(uint64_t minimum, uint64_t maximum,
+    long double window_span, uint32_t screen_pixels);
+  // Sets [*low, *high] to what tile |index| at |level| covers. Returns false
+  // if the tile lies beyond the end of the axis.
+  static bool getTileRange(uint64_t minimum, uint64_t maximum, uint8_t level,
+    uint64_t index, uint64_t* low, uint64_t* high);
+
+  // Drops the pending requests and waits for the tile that is being
+  // rendered. Needs to be called before the heap history is loaded.
+  void cancel();
+  // Cancels, drops the rendered tiles that were not taken yet, and takes a
+  // new snapshot of the highlights and visible heaps.
+  void reset();
+
+  // Replaces the pending requests. The tiles are rendered in order; the tile
+  // that is being rendered is not rendered again.
+  void request(const std::vector<DiagramTileKey>& keys);
+  // Moves the tiles that were rendered since the last call into |tiles|.
+  void takeRenderedTiles(std::vector<Tile>* tiles);
+  // Called on the worker thread whenever a tile is done.
+  void setTileReadyCallback(std::function<void()> callback) {
+    tile_ready_callback_ = std::move(callback);
+  }
+
+  // Renders a single tile on the calling thread.
+  static void renderTile(const HeapHistory& history, const Snapshot& snapshot,
+    const DiagramTileKey& key, std::vector<uint8_t>* pixels);
+
+private:
+  void work();
+
+  const HeapHistory* history_;
+  Snapshot snapshot_;
+  std::function<void()> tile_ready_callback_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_worker_;
+  std::condition_variable worker_idle_;
+  std::deque<DiagramTileKey> requests_;
+  std::vector<Tile> rendered_;
+  bool busy_ = false;
+  DiagramTileKey rendering_;
+  bool stop_ = false;
+  std::thread worker_;
+};
+
+#endif // TILERENDERER_H
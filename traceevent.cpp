@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <thread>
+
+#include "json.hpp"
+
+#include "traceevent.h"
+
+// Ranges below this size are not worth a thread of their own.
+static constexpr size_t minimum_bytes_per_thread = 1 << 20;
+
+uint32_t TraceEventChunk::addString(const std::string& value) {
+  auto result = string_ids_.emplace(value,
+    static_cast<uint32_t>(strings_.size()));
+  if (result.second) {
+    strings_.push_back(value);
+  }
+  return result.first->second;
+}
+
+void TraceEventChunk::clear() {
+  events_.clear();
+  strings_.clear();
+  string_ids_.clear();
+}
+
+static bool hasMandatoryJSONElementFields(const nlohmann::json &json_element,
+  TraceEvent::Type* type) {
+  static const std::map<std::string, std::pair<TraceEvent::Type,
+    std::vector<std::string>>> mandatory_fields = {
+      {"alloc", {TraceEvent::ALLOC, {"address", "size"}}},
+      {"free", {TraceEvent::FREE, {"address"}}},
+      {"filterrange", {TraceEvent::FILTERRANGE, {"low", "high"}}},
+      {"event", {TraceEvent::EVENT, {}}},
+      {"rangefree", {TraceEvent::RANGEFREE, {"low", "high"}}},
+      {"address", {TraceEvent::ADDRESS, {"address"}}}};
+  if (json_element.find("type") == json_element.end()) {
+    printf("[E] Failed to find type field\n");
+    return false;
+  }
+  std::string type_name = json_element["type"].get<std::string>();
+  auto mandatory = mandatory_fields.find(type_name);
+  if (mandatory == mandatory_fields.end()) {
+    // Unknown types are ignored.
+    *type = TraceEvent::INVALID;
+    return true;
+  }
+  for (const std::string &field : mandatory->second.second) {
+    if (json_element.find(field) == json_element.end()) {
+      printf("[E] Failed to find mandatory field %s for type %s\n",
+        field.c_str(), type_name.c_str());
+      return false;
+    }
+  }
+  *type = mandatory->second.first;
+  return true;
+}
+
+void parseTraceEvent(const std::string& element, uint64_t offset,
+  TraceEventChunk* chunk) {
+  TraceEvent event;
+  event.offset_ = offset;
+  try {
+    nlohmann::json json_element = nlohmann::json::parse(element);
+    if (!hasMandatoryJSONElementFields(json_element, &event.type_)) {
+      printf("OH NOES MANDATORY ELEMENT MISSING\n");
+      event.type_ = TraceEvent::INVALID;
+    }
+    std::string tag;
+    if (json_element.find("tag") != json_element.end()) {
+      tag = json_element["tag"].get<std::string>();
+    }
+    // A not-too-intrusive gray by default.
+    std::string color = "#B0B0B0";
+    if (json_element.find("color") != json_element.end()) {
+      color = json_element["color"].get<std::string>();
+    }
+
+    if (json_element.find("timestamp") != json_element.end()) {
+      event.timestamp_ = json_element["timestamp"].get<uint64_t>();
+    }
+    if (json_element.find("heap") != json_element.end()) {
+      uint64_t heap_id = json_element["heap"].get<uint64_t>();
+      if (heap_id > std::numeric_limits<uint8_t>::max()) {
+        printf("[E] Heap id %llu at offset %llu is out of range\n",
+          static_cast<unsigned long long>(heap_id),
+          static_cast<unsigned long long>(offset));
+        event.type_ = TraceEvent::INVALID;
+      }
+      event.heap_id_ = static_cast<uint8_t>(heap_id);
+    }
+
+    switch (event.type_) {
+      case TraceEvent::ALLOC:
+        event.address_ = json_element["address"].get<uint64_t>();
+        event.size_or_high_ = json_element["size"].get<uint32_t>();
+        break;
+      case TraceEvent::FREE:
+      case TraceEvent::ADDRESS:
+        event.address_ = json_element["address"].get<uint64_t>();
+        break;
+      case TraceEvent::RANGEFREE:
+      case TraceEvent::FILTERRANGE:
+        event.address_ = json_element["low"].get<uint64_t>();
+        event.size_or_high_ = json_element["high"].get<uint64_t>();
+        break;
+      default:
+        break;
+    }
+    event.tag_ = chunk->addString(tag);
+    event.color_ = chunk->addString(color);
+    if ((event.type_ == TraceEvent::ADDRESS) ||
+      (event.type_ == TraceEvent::FILTERRANGE)) {
+      event.text_ = chunk->addString(element);
+    }
+  } catch (const std::exception& exception) {
+    printf("[E] Failed to parse trace element at offset %llu: %s\n",
+      static_cast<unsigned long long>(offset), exception.what());
+    event.type_ = TraceEvent::INVALID;
+  }
+  chunk->events_.push_back(event);
+}
+
+// Parses the lines in data[begin, end), which starts at a line boundary.
+static void parseNDJSONRange(const std::string& data, size_t begin,
+  size_t end, uint64_t first_offset, TraceEventChunk* chunk) {
+  std::string line;
+  while (begin < end) {
+    size_t line_end = std::min(data.find('\n', begin), end);
+    size_t first = data.find_first_not_of(" \t\r", begin);
+    if ((first != std::string::npos) && (first < line_end)) {
+      size_t last = data.find_last_not_of(" \t\r", line_end - 1);
+      line.assign(data, first, last + 1 - first);
+      parseTraceEvent(line, first_offset + first, chunk);
+    }
+    begin = line_end + 1;
+  }
+}
+
+void parseNDJSON(const std::string& data, uint64_t first_offset,
+  size_t threads, std::vector<TraceEventChunk>* chunks) {
+  if (threads == 0) {
+    threads = std::min(static_cast<size_t>(std::thread::hardware_concurrency()),
+      data.size() / minimum_bytes_per_thread);
+  }
+  threads = std::max(threads, static_cast<size_t>(1));
+
+  // Move every split point forward to the start of the next line.
+  std::vector<size_t> boundaries = { 0 };
+  for (size_t thread = 1; thread < threads; ++thread) {
+    size_t boundary = std::max(data.size() * thread / threads,
+      boundaries.back());
+    boundary = std::min(data.find('\n', boundary), data.size());
+    boundaries.push_back(std::min(boundary + 1, data.size()));
+  }
+  boundaries.push_back(data.size());
+
+  chunks->clear();
+  chunks->resize(threads);
+  auto parseRange = [&](size_t thread) {
+    parseNDJSONRange(data, boundaries[thread], boundaries[thread + 1],
+      first_offset, &(*chunks)[thread]);
+  };
+  std::vector<std::thread> workers;
+  for (size_t thread = 1; thread < threads; ++thread) {
+    workers.emplace_back(parseRange, thread);
+  }
+  parseRange(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+//============================================================================
+// NDJSONWindowReader
+
+constexpr size_t NDJSONWindowReader::default_window_size;
+
+NDJSONWindowReader::NDJSONWindowReader(std::istream* input, uint64_t offset,
+  size_t window_size) : input_(input), offset_(offset),
+  window_size_(std::max(window_size, static_cast<size_t>(1))) {}
+
+bool NDJSONWindowReader::next(std::string* window, uint64_t* offset) {
+  window->swap(rest_);
+  rest_.clear();
+  while (!at_end_) {
+    // Fill the window up, or grow it by another window if a single line
+    // does not fit.
+    size_t filled = window->size();
+    size_t wanted = (filled < window_size_) ? window_size_ - filled :
+      window_size_;
+    window->resize(filled + wanted);
+    size_t read = static_cast<size_t>(input_->rdbuf()->sgetn(
+      &(*window)[filled], static_cast<std::streamsize>(wanted)));
+    window->resize(filled + read);
+    if (read < wanted) {
+      at_end_ = true;
+      break;
+    }
+    // The carried-over start of a line has no line break, so any that is
+    // found ends a complete line.
+    size_t newline = window->rfind('\n');
+    if (newline != std::string::npos) {
+      rest_.assign(*window, newline + 1, std::string::npos);
+      window->resize(newline + 1);
+      break;
+    }
+  }
+  *offset = offset_;
+  offset_ += window->size();
+  return !window->empty();
+}
@@ -0,0 +1,88 @@
+#ifndef TRACEEVENT_H
+#define TRACEEVENT_H
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A trace element parsed into a fixed layout. Parsing the JSON is the slow
+// part of loading a trace and can happen on many threads, while recording
+// the events has to happen on one thread, in trace order.
+struct TraceEvent {
+  enum Type : uint8_t {
+    INVALID, ALLOC, FREE, EVENT, RANGEFREE, ADDRESS, FILTERRANGE
+  };
+  static constexpr uint64_t no_timestamp =
+    std::numeric_limits<uint64_t>::max();
+
+  Type type_ = INVALID;
+  // The optional "heap" field of allocations and frees.
+  uint8_t heap_id_ = 0;
+  // The address, or the low end of a range.
+  uint64_t address_ = 0;
+  // The size of an allocation, or the high end of a range.
+  uint64_t size_or_high_ = 0;
+  // The byte offset of the element in the trace.
+  uint64_t offset_ = 0;
+  // The optional "timestamp" field, used to merge per-thread trace shards.
+  uint64_t timestamp_ = no_timestamp;
+  // Indices into the strings of the chunk. The text of the element is only
+  // kept for addresses and filter ranges, for the trace index.
+  uint32_t tag_ = 0;
+  uint32_t color_ = 0;
+  uint32_t text_ = 0;
+};
+
+// A run of consecutive trace events, with the strings they refer to.
+struct TraceEventChunk {
+  std::vector<TraceEvent> events_;
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, uint32_t> string_ids_;
+
+  uint32_t addString(const std::string& value);
+  void clear();
+};
+
+// Parses one JSON object and appends it to |chunk|. Elements that are not
+// valid JSON or lack a mandatory field are appended as INVALID.
+void parseTraceEvent(const std::string& element, uint64_t offset,
+  TraceEventChunk* chunk);
+
+// Parses newline-delimited JSON (one element per line). The data is split
+// into byte ranges at line boundaries, one per thread, and every range is
+// parsed into its own chunk. |first_offset| is the offset of data[0] in the
+// trace. |threads| = 0 picks the number of threads by the size of the data
+// and the number of cores.
+void parseNDJSON(const std::string& data, uint64_t first_offset,
+  size_t threads, std::vector<TraceEventChunk>* chunks);
+
+// Reads newline-delimited JSON in windows of about window_size bytes that end
+// at a line boundary, so that a large trace can be parsed (with parseNDJSON)
+// and recorded one window at a time. A line that is longer than a window
+// gets a window of its own.
+class NDJSONWindowReader {
+public:
+  static constexpr size_t default_window_size = 16 << 20;
+
+  // |offset| is the position of |input| in the file, for the reported
+  // offsets.
+  explicit NDJSONWindowReader(std::istream* input, uint64_t offset = 0,
+    size_t window_size = default_window_size);
+
+  // Sets |window| to the next lines and |offset| to the position of the
+  // first one. Returns false at the end of the stream.
+  bool next(std::string* window, uint64_t* offset);
+
+private:
+  std::istream* input_;
+  uint64_t offset_;
+  size_t window_size_;
+  // The start of a line that did not fit into the last window.
+  std::string rest_;
+  bool at_end_ = false;
+};
+
+#endif // TRACEEVENT_H
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "traceindex.h"
+#include "varint.h"
+
+static const char trace_index_magic[8] = { 'H', 'V', 'T', 'I', 'D', 'X',
+  '0', '2' };
+
+//============================================================================
+// JSONElementReader
+
+JSONElementReader::JSONElementReader(std::istream* input, uint64_t offset)
+  : input_(input), offset_(offset) {}
+
+bool JSONElementReader::next(std::string* element, uint64_t* offset) {
+  std::streambuf* buffer = input_->rdbuf();
+  element->clear();
+  // Skip the opening bracket, the separators and whitespace.
+  int character = buffer->sbumpc();
+  while ((character == '[') || (character == ',') || isspace(character)) {
+    ++offset_;
+    character = buffer->sbumpc();
+  }
+  if ((character == std::char_traits<char>::eof()) || (character == ']')) {
+    return false;
+  }
+
+  *offset = offset_;
+  int depth = 0;
+  bool in_string = false;
+  bool escaped = false;
+  while (character != std::char_traits<char>::eof()) {
+    element->push_back(static_cast<char>(character));
+    ++offset_;
+    if (escaped) {
+      escaped = false;
+    } else if (in_string) {
+      escaped = (character == '\\');
+      in_string = (character != '"');
+    } else if (character == '"') {
+      in_string = true;
+    } else if ((character == '{') || (character == '[')) {
+      ++depth;
+    } else if ((character == '}') || (character == ']')) {
+      --depth;
+    }
+    if ((depth == 0) && !in_string) {
+      return true;
+    }
+    character = buffer->sbumpc();
+  }
+  printf("[!] Trace ends in the middle of an element\n");
+  return false;
+}
+
+//============================================================================
+// TraceIndexWriter
+
+TraceIndexWriter::TraceIndexWriter(std::ostream* output,
+  uint64_t ticks_per_checkpoint) : output_(output),
+  ticks_per_checkpoint_(std::max(ticks_per_checkpoint,
+    static_cast<uint64_t>(1))) {
+  write(std::vector<uint8_t>(trace_index_magic, trace_index_magic +
+    sizeof(trace_index_magic)));
+}
+
+void TraceIndexWriter::write(const std::vector<uint8_t>& bytes) {
+  output_->write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  bytes_written_ += bytes.size();
+}
+
+uint32_t TraceIndexWriter::getTagId(const std::string* tag) {
+  if (tag == nullptr) {
+    return 0;
+  }
+  auto result = tag_ids_.emplace(*tag,
+    static_cast<uint32_t>(tags_.size() + 1));
+  if (result.second) {
+    tags_.push_back(*tag);
+  }
+  return result.first->second;
+}
+
+void TraceIndexWriter::writeCheckpoint(uint64_t tick, uint64_t trace_offset,
+  const std::vector<HeapBlock>& live) {
+  std::vector<uint8_t> record;
+  appendVarint(live.size(), &record);
+  uint64_t previous_address = 0;
+  for (const HeapBlock& block : live) {
+    appendVarint(block.address_ - previous_address, &record);
+    appendVarint(block.size_, &record);
+    appendVarint(tick - block.start_tick_, &record);
+    appendVarint(getTagId(block.allocation_tag_), &record);
+    appendVarint(block.heap_id_, &record);
+    previous_address = block.address_;
+  }
+  checkpoints_.push_back({ tick, trace_offset, bytes_written_ });
+  write(record);
+  next_checkpoint_tick_ = ((tick / ticks_per_checkpoint_) + 1) *
+    ticks_per_checkpoint_;
+}
+
+void TraceIndexWriter::recordVerbatimElement(uint64_t trace_offset,
+  const std::string& element) {
+  verbatim_elements_.emplace_back(trace_offset, element);
+}
+
+static void appendString(const std::string& value,
+  std::vector<uint8_t>* output) {
+  appendVarint(value.size(), output);
+  output->insert(output->end(), value.begin(), value.end());
+}
+
+bool TraceIndexWriter::finish() {
+  uint64_t tables_offset = bytes_written_;
+  std::vector<uint8_t> tables;
+  appendVarint(tags_.size(), &tables);
+  for (const std::string& tag : tags_) {
+    appendString(tag, &tables);
+  }
+  appendVarint(verbatim_elements_.size(), &tables);
+  for (const auto& element : verbatim_elements_) {
+    appendVarint(element.first, &tables);
+    appendString(element.second, &tables);
+  }
+  appendVarint(checkpoints_.size(), &tables);
+  for (const TraceIndexEntry& entry : checkpoints_) {
+    appendVarint(entry.tick_, &tables);
+    appendVarint(entry.trace_offset_, &tables);
+    appendVarint(entry.index_offset_, &tables);
+  }
+  for (uint32_t byte = 0; byte < sizeof(tables_offset); ++byte) {
+    tables.push_back(static_cast<uint8_t>(tables_offset >> (8 * byte)));
+  }
+  write(tables);
+  output_->flush();
+  printf("[!] Wrote trace index with %zu checkpoints.\n", checkpoints_.size());
+  return output_->good();
+}
+
+//============================================================================
+// TraceIndexReader
+
+// Reads |size| bytes at |offset|. The result is padded with zeroes, so that
+// a varint that runs past the end stops in the padding.
+static bool readBytes(std::istream* input, uint64_t offset, uint64_t size,
+  std::vector<uint8_t>* bytes) {
+  input->clear();
+  input->seekg(static_cast<std::streamoff>(offset));
+  bytes->assign(size + 10, 0);
+  return static_cast<bool>(input->read(reinterpret_cast<char*>(bytes->data()),
+    static_cast<std::streamsize>(size)));
+}
+
+// Reads a varint from [*current, end), and fails instead of running past
+// the end.
+static bool readBoundedVarint(const uint8_t** current, const uint8_t* end,
+  uint64_t* value) {
+  if (*current >= end) {
+    return false;
+  }
+  *value = readVarint(current);
+  return *current <= end;
+}
+
+static bool readBoundedString(const uint8_t** current, const uint8_t* end,
+  std::string* value) {
+  uint64_t length;
+  if (!readBoundedVarint(current, end, &length) ||
+    (length > static_cast<uint64_t>(end - *current))) {
+    return false;
+  }
+  value->assign(reinterpret_cast<const char*>(*current), length);
+  *current += length;
+  return true;
+}
+
+TraceIndexReader::TraceIndexReader() = default;
+
+bool TraceIndexReader::open(std::istream* input) {
+  input_ = input;
+  std::vector<uint8_t> bytes;
+  if (!readBytes(input, 0, sizeof(trace_index_magic), &bytes) ||
+    (memcmp(bytes.data(), trace_index_magic, sizeof(trace_index_magic)) !=
+      0)) {
+    printf("[!] Not a trace index\n");
+    return false;
+  }
+  input->seekg(0, std::ios::end);
+  auto size = static_cast<uint64_t>(input->tellg());
+  if ((size < 2 * sizeof(uint64_t)) ||
+    !readBytes(input, size - sizeof(uint64_t), sizeof(uint64_t), &bytes)) {
+    return false;
+  }
+  tables_offset_ = 0;
+  for (uint32_t byte = 0; byte < sizeof(uint64_t); ++byte) {
+    tables_offset_ |= static_cast<uint64_t>(bytes[byte]) << (8 * byte);
+  }
+  if ((tables_offset_ < sizeof(trace_index_magic)) ||
+    (tables_offset_ > size - sizeof(uint64_t)) ||
+    !readBytes(input, tables_offset_, size - sizeof(uint64_t) - tables_offset_,
+      &bytes)) {
+    return false;
+  }
+
+  const uint8_t* current = bytes.data();
+  const uint8_t* end = bytes.data() + bytes.size() - 10;
+  uint64_t count;
+  tags_.clear();
+  if (!readBoundedVarint(&current, end, &count)) {
+    return false;
+  }
+  for (uint64_t index = 0; index < count; ++index) {
+    tags_.emplace_back();
+    if (!readBoundedString(&current, end, &tags_.back())) {
+      return false;
+    }
+  }
+  verbatim_elements_.clear();
+  if (!readBoundedVarint(&current, end, &count)) {
+    return false;
+  }
+  for (uint64_t index = 0; index < count; ++index) {
+    verbatim_elements_.emplace_back();
+    if (!readBoundedVarint(&current, end, &verbatim_elements_.back().first) ||
+      !readBoundedString(&current, end, &verbatim_elements_.back().second)) {
+      return false;
+    }
+  }
+  checkpoints_.clear();
+  if (!readBoundedVarint(&current, end, &count)) {
+    return false;
+  }
+  for (uint64_t index = 0; index < count; ++index) {
+    TraceIndexEntry entry;
+    if (!readBoundedVarint(&current, end, &entry.tick_) ||
+      !readBoundedVarint(&current, end, &entry.trace_offset_) ||
+      !readBoundedVarint(&current, end, &entry.index_offset_) ||
+      (entry.index_offset_ > tables_offset_)) {
+      return false;
+    }
+    checkpoints_.push_back(entry);
+  }
+  return true;
+}
+
+bool TraceIndexReader::readCheckpoint(uint64_t tick,
+  TraceIndexCheckpoint* checkpoint) {
+  auto entry = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), tick,
+    [](uint64_t tick, const TraceIndexEntry& entry) {
+      return tick < entry.tick_;
+    });
+  if (entry == checkpoints_.begin()) {
+    return false;
+  }
+  --entry;
+  uint64_t end_offset = (entry + 1 == checkpoints_.end()) ? tables_offset_ :
+    (entry + 1)->index_offset_;
+  std::vector<uint8_t> bytes;
+  if ((end_offset < entry->index_offset_) || !readBytes(input_,
+    entry->index_offset_, end_offset - entry->index_offset_, &bytes)) {
+    return false;
+  }
+
+  const uint8_t* current = bytes.data();
+  const uint8_t* end = bytes.data() + bytes.size() - 10;
+  uint64_t count;
+  if (!readBoundedVarint(&current, end, &count)) {
+    return false;
+  }
+  checkpoint->tick_ = entry->tick_;
+  checkpoint->trace_offset_ = entry->trace_offset_;
+  checkpoint->live_.clear();
+  uint64_t address = 0;
+  for (uint64_t index = 0; index < count; ++index) {
+    uint64_t address_delta, size, age, tag, heap_id;
+    if (!readBoundedVarint(&current, end, &address_delta) ||
+      !readBoundedVarint(&current, end, &size) || !readBoundedVarint(&current, end, &age) ||
+      !readBoundedVarint(&current, end, &tag) ||
+      !readBoundedVarint(&current, end, &heap_id) ||
+      (size > std::numeric_limits<uint32_t>::max()) ||
+      (age > entry->tick_) || (tag > tags_.size()) ||
+      (heap_id > std::numeric_limits<uint8_t>::max())) {
+      return false;
+    }
+    address += address_delta;
+    checkpoint->live_.emplace_back(entry->tick_ - age,
+      static_cast<uint32_t>(size), address,
+      (tag == 0) ? nullptr : &tags_[tag - 1]);
+    checkpoint->live_.back().heap_id_ = static_cast<uint8_t>(heap_id);
+  }
+  return true;
+}
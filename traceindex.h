@@ -0,0 +1,116 @@
+#ifndef TRACEINDEX_H
+#define TRACEINDEX_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "heapblock.h"
+
+// Splits a JSON array into the text of its elements without parsing them,
+// and reports the byte offset at which each element starts, so that reading
+// can later resume from such an offset.
+class JSONElementReader {
+public:
+  // |offset| is the position of |input| in the file, for the reported
+  // offsets.
+  explicit JSONElementReader(std::istream* input, uint64_t offset = 0);
+
+  // Returns false at the end of the array or the stream.
+  bool next(std::string* element, uint64_t* offset);
+
+private:
+  std::istream* input_;
+  uint64_t offset_;
+};
+
+// Where to find a checkpoint, in the trace and in the index.
+struct TraceIndexEntry {
+  uint64_t tick_;
+  uint64_t trace_offset_;
+  uint64_t index_offset_;
+};
+
+// A sparse, seekable index for a JSON heap trace, stored in a separate file.
+//
+// Every ticks_per_checkpoint ticks, the index records the byte offset of the
+// next element in the trace together with the set of live blocks of all
+// heaps at that point (delta- and varint-packed, sorted by address). To load
+// only a range of ticks, a viewer seeks to the closest checkpoint before the
+// range, materializes the live set, and replays the trace from there.
+//
+// Elements that are not tied to a tick (filter ranges and address labels)
+// are stored verbatim with their offset, so that the ones preceding a
+// checkpoint can be applied before replaying.
+//
+// File layout: the magic, the checkpoint records back to back, the tables
+// (tags, verbatim elements, checkpoint offsets), and finally the offset of
+// the tables as 8 little-endian bytes.
+class TraceIndexWriter {
+public:
+  static constexpr uint64_t default_ticks_per_checkpoint = 1 << 20;
+
+  explicit TraceIndexWriter(std::ostream* output,
+    uint64_t ticks_per_checkpoint = default_ticks_per_checkpoint);
+
+  bool isCheckpointDue(uint64_t tick) const {
+    return tick >= next_checkpoint_tick_;
+  }
+  // |live| needs to be sorted by address.
+  void writeCheckpoint(uint64_t tick, uint64_t trace_offset,
+    const std::vector<HeapBlock>& live);
+  void recordVerbatimElement(uint64_t trace_offset, const std::string& element);
+  // Writes the tables. Returns false if any write failed.
+  bool finish();
+
+private:
+  void write(const std::vector<uint8_t>& bytes);
+  uint32_t getTagId(const std::string* tag);
+
+  std::ostream* output_;
+  uint64_t bytes_written_ = 0;
+  uint64_t ticks_per_checkpoint_;
+  uint64_t next_checkpoint_tick_ = 0;
+
+  // Tag ID 0 stands for "no tag", the IDs of the tag strings start at 1.
+  std::unordered_map<std::string, uint32_t> tag_ids_;
+  std::vector<std::string> tags_;
+  std::vector<std::pair<uint64_t, std::string>> verbatim_elements_;
+  std::vector<TraceIndexEntry> checkpoints_;
+};
+
+struct TraceIndexCheckpoint {
+  uint64_t tick_ = 0;
+  uint64_t trace_offset_ = 0;
+  // The blocks alive at tick_, sorted by address. The allocation tags point
+  // into the reader.
+  std::vector<HeapBlock> live_;
+};
+
+class TraceIndexReader {
+public:
+  TraceIndexReader();
+
+  // Reads the tables. Returns false if |input| is not a valid index.
+  bool open(std::istream* input);
+
+  size_t getNumberOfCheckpoints() const { return checkpoints_.size(); }
+  // Reads the last checkpoint at or before |tick|.
+  bool readCheckpoint(uint64_t tick, TraceIndexCheckpoint* checkpoint);
+  const std::vector<std::pair<uint64_t, std::string>>&
+    getVerbatimElements() const {
+    return verbatim_elements_;
+  }
+
+private:
+  std::istream* input_ = nullptr;
+  uint64_t tables_offset_ = 0;
+  std::vector<std::string> tags_;
+  std::vector<std::pair<uint64_t, std::string>> verbatim_elements_;
+  std::vector<TraceIndexEntry> checkpoints_;
+};
+
+#endif // TRACEINDEX_H
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include "traceinputstream.h"
+
+//============================================================================
+// DecompressingStreamBuffer
+
+DecompressingStreamBuffer::Format DecompressingStreamBuffer::detectFormat(
+  std::istream* input) {
+  static const unsigned char gzip_magic[] = { 0x1F, 0x8B };
+  static const unsigned char zstd_magic[] = { 0x28, 0xB5, 0x2F, 0xFD };
+  unsigned char magic[4] = {};
+  input->read(reinterpret_cast<char*>(magic), sizeof(magic));
+  std::streamsize length = input->gcount();
+  input->clear();
+  input->seekg(0);
+  if ((length >= 2) && (memcmp(magic, gzip_magic, sizeof(gzip_magic)) == 0)) {
+    return GZIP;
+  }
+  if ((length >= 4) && (memcmp(magic, zstd_magic, sizeof(zstd_magic)) == 0)) {
+    return ZSTD;
+  }
+  return UNCOMPRESSED;
+}
+
+DecompressingStreamBuffer::DecompressingStreamBuffer(std::istream* compressed,
+  Format format, size_t buffer_size, size_t queue_length)
+  : input_(compressed), format_(format),
+    buffer_size_(std::max(buffer_size, static_cast<size_t>(1))),
+    queue_(queue_length),
+    thread_(&DecompressingStreamBuffer::decompress, this) {}
+
+DecompressingStreamBuffer::~DecompressingStreamBuffer() {
+  queue_.close();
+  thread_.join();
+}
+
+void DecompressingStreamBuffer::decompress() {
+  bool ok = (format_ == GZIP) ? decompressGzip() : decompressZstd();
+  failed_ = !ok;
+  queue_.finish();
+}
+
+bool DecompressingStreamBuffer::push(std::vector<char>* buffer, size_t size) {
+  if (size == 0) {
+    return true;
+  }
+  buffer->resize(size);
+  if (!queue_.push(std::move(*buffer))) {
+    return false;
+  }
+  buffer->assign(buffer_size_, 0);
+  return true;
+}
+
+bool DecompressingStreamBuffer::decompressGzip() {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // 15 window bits, plus 32 to accept both gzip and zlib headers.
+  if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+    return false;
+  }
+  std::vector<char> input(buffer_size_);
+  std::vector<char> output(buffer_size_);
+  bool at_end_of_member = false;
+  bool ok = true;
+  bool stopped = false;
+  while (ok) {
+    if (stream.avail_in == 0) {
+      input_->read(input.data(), static_cast<std::streamsize>(input.size()));
+      stream.next_in = reinterpret_cast<Bytef*>(input.data());
+      stream.avail_in = static_cast<uInt>(input_->gcount());
+      if (stream.avail_in == 0) {
+        break;
+      }
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());
+    stream.avail_out = static_cast<uInt>(output.size());
+    int result = inflate(&stream, Z_NO_FLUSH);
+    if ((result != Z_OK) && (result != Z_STREAM_END) &&
+      (result != Z_BUF_ERROR)) {
+      printf("[!] Failed to decompress gzip trace: %s\n",
+        (stream.msg != nullptr) ? stream.msg : "corrupt data");
+      ok = false;
+      break;
+    }
+    if (!push(&output, output.size() - stream.avail_out)) {
+      stopped = true;
+      break;
+    }
+    if (result == Z_STREAM_END) {
+      // Traces may consist of several concatenated gzip members.
+      at_end_of_member = true;
+      inflateReset(&stream);
+    } else if (result == Z_OK) {
+      at_end_of_member = false;
+    }
+  }
+  inflateEnd(&stream);
+  if (ok && !stopped && !at_end_of_member) {
+    printf("[!] Gzip trace is truncated\n");
+    ok = false;
+  }
+  return ok;
+}
+
+bool DecompressingStreamBuffer::decompressZstd() {
+  ZSTD_DStream* stream = ZSTD_createDStream();
+  if ((stream == nullptr) || ZSTD_isError(ZSTD_initDStream(stream))) {
+    ZSTD_freeDStream(stream);
+    return false;
+  }
+  std::vector<char> input(ZSTD_DStreamInSize());
+  std::vector<char> output(buffer_size_);
+  // 0 once a frame has been decoded and flushed completely.
+  size_t result = 1;
+  bool ok = true;
+  bool reading = true;
+  while (ok && reading) {
+    input_->read(input.data(), static_cast<std::streamsize>(input.size()));
+    ZSTD_inBuffer in = { input.data(), static_cast<size_t>(input_->gcount()),
+      0 };
+    if (in.size == 0) {
+      break;
+    }
+    // zstd does not consume the last byte of a frame before all of its
+    // output has been flushed, so consuming the input is enough.
+    while (in.pos < in.size) {
+      ZSTD_outBuffer out = { output.data(), output.size(), 0 };
+      result = ZSTD_decompressStream(stream, &out, &in);
+      if (ZSTD_isError(result)) {
+        printf("[!] Failed to decompress zstd trace: %s\n",
+          ZSTD_getErrorName(result));
+        ok = false;
+        break;
+      }
+      if (!push(&output, out.pos)) {
+        reading = false;
+        break;
+      }
+    }
+  }
+  ZSTD_freeDStream(stream);
+  if (ok && reading && (result != 0)) {
+    printf("[!] Zstd trace is truncated\n");
+    ok = false;
+  }
+  return ok;
+}
+
+DecompressingStreamBuffer::int_type DecompressingStreamBuffer::underflow() {
+  if (gptr() < egptr()) {
+    return traits_type::to_int_type(*gptr());
+  }
+  position_of_current_ += current_.size();
+  current_.clear();
+  if (!queue_.pop(&current_)) {
+    setg(nullptr, nullptr, nullptr);
+    return traits_type::eof();
+  }
+  setg(current_.data(), current_.data(), current_.data() + current_.size());
+  return traits_type::to_int_type(*gptr());
+}
+
+DecompressingStreamBuffer::pos_type DecompressingStreamBuffer::seekoff(
+  off_type offset, std::ios_base::seekdir direction,
+  std::ios_base::openmode which) {
+  off_type position = static_cast<off_type>(position_of_current_ +
+    (gptr() - eback()));
+  if (direction == std::ios_base::cur) {
+    return (offset == 0) ? pos_type(position) :
+      seekpos(pos_type(position + offset), which);
+  }
+  if (direction == std::ios_base::beg) {
+    return seekpos(pos_type(offset), which);
+  }
+  return pos_type(off_type(-1));
+}
+
+DecompressingStreamBuffer::pos_type DecompressingStreamBuffer::seekpos(
+  pos_type position, std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  uint64_t target = static_cast<uint64_t>(off_type(position));
+  uint64_t current = position_of_current_ + (gptr() - eback());
+  if ((off_type(position) < 0) || (target < current)) {
+    return pos_type(off_type(-1));
+  }
+  while (current < target) {
+    if ((gptr() == egptr()) &&
+      (underflow() == traits_type::eof())) {
+      return pos_type(off_type(-1));
+    }
+    auto skip = std::min(static_cast<uint64_t>(egptr() - gptr()),
+      target - current);
+    gbump(static_cast<int>(skip));
+    current += skip;
+  }
+  return position;
+}
+
+//============================================================================
+// TraceInputStream
+
+TraceInputStream::TraceInputStream(const std::string& path)
+  : std::istream(nullptr),
+    file_(path, std::fstream::in | std::fstream::binary) {
+  if (!file_.is_open()) {
+    setstate(std::ios::failbit);
+    return;
+  }
+  DecompressingStreamBuffer::Format format =
+    DecompressingStreamBuffer::detectFormat(&file_);
+  if (format == DecompressingStreamBuffer::UNCOMPRESSED) {
+    rdbuf(file_.rdbuf());
+  } else {
+    decompressor_.reset(new DecompressingStreamBuffer(&file_, format));
+    rdbuf(decompressor_.get());
+  }
+}
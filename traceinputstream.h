@@ -0,0 +1,84 @@
+#ifndef TRACEINPUTSTREAM_H
+#define TRACEINPUTSTREAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boundedqueue.h"
+
+// A stream buffer that decompresses a gzip or zstd stream on a separate
+// thread. The decompressed data is handed over in buffers through a bounded
+// queue, so decompression overlaps with parsing, and at most queue_length
+// buffers are held in memory.
+//
+// The stream cannot seek backwards. Seeking forwards skips over the
+// decompressed data, which is enough to start reading at a trace index
+// checkpoint.
+class DecompressingStreamBuffer : public std::streambuf {
+public:
+  enum Format { UNCOMPRESSED, GZIP, ZSTD };
+
+  static constexpr size_t default_buffer_size = 1 << 20;
+  static constexpr size_t default_queue_length = 8;
+
+  // Tells the format from the magic bytes, and leaves |input| at the start.
+  static Format detectFormat(std::istream* input);
+
+  DecompressingStreamBuffer(std::istream* compressed, Format format,
+    size_t buffer_size = default_buffer_size,
+    size_t queue_length = default_queue_length);
+  ~DecompressingStreamBuffer() override;
+
+  // True if the end of the stream was reached because the compressed data
+  // was corrupt or truncated.
+  bool failed() const { return failed_; }
+
+protected:
+  int_type underflow() override;
+  pos_type seekoff(off_type offset, std::ios_base::seekdir direction,
+    std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+private:
+  void decompress();
+  bool decompressGzip();
+  bool decompressZstd();
+  // Blocks while the queue is full. Returns false if the reader is gone.
+  bool push(std::vector<char>* buffer, size_t size);
+
+  std::istream* input_;
+  Format format_;
+  size_t buffer_size_;
+
+  BoundedQueue<std::vector<char>> queue_;
+  std::atomic<bool> failed_{ false };
+
+  // The buffer being read, and the number of bytes in the buffers before it.
+  std::vector<char> current_;
+  uint64_t position_of_current_ = 0;
+
+  std::thread thread_;
+};
+
+// An input stream over a trace file that may be gzip or zstd compressed.
+class TraceInputStream : public std::istream {
+public:
+  explicit TraceInputStream(const std::string& path);
+
+  bool isCompressed() const { return decompressor_ != nullptr; }
+
+private:
+  std::ifstream file_;
+  // Declared after file_, so that the decompression thread stops before the
+  // file is closed.
+  std::unique_ptr<DecompressingStreamBuffer> decompressor_;
+};
+
+#endif // TRACEINPUTSTREAM_H
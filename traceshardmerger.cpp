@@ -0,0 +1,94 @@
+#include "traceindex.h"
+#include "traceshardmerger.h"
+
+//============================================================================
+// PrefetchingTraceReader
+
+PrefetchingTraceReader::PrefetchingTraceReader(std::istream* input,
+  size_t events_per_batch, size_t queue_length)
+  : input_(input),
+    events_per_batch_((events_per_batch == 0) ? 1 : events_per_batch),
+    queue_(queue_length), thread_(&PrefetchingTraceReader::read, this) {}
+
+PrefetchingTraceReader::~PrefetchingTraceReader() {
+  queue_.close();
+  thread_.join();
+}
+
+void PrefetchingTraceReader::read() {
+  JSONElementReader reader(input_);
+  TraceEventChunk batch;
+  std::string element;
+  uint64_t offset;
+  uint64_t timestamp = 0;
+  while (reader.next(&element, &offset)) {
+    parseTraceEvent(element, offset, &batch);
+    TraceEvent& event = batch.events_.back();
+    if (event.timestamp_ == TraceEvent::no_timestamp) {
+      event.timestamp_ = timestamp;
+    }
+    timestamp = event.timestamp_;
+    if (batch.events_.size() == events_per_batch_) {
+      if (!queue_.push(std::move(batch))) {
+        return;
+      }
+      batch.clear();
+    }
+  }
+  if (!batch.events_.empty()) {
+    queue_.push(std::move(batch));
+  }
+  queue_.finish();
+}
+
+//============================================================================
+// TraceShardMerger
+
+TraceShardMerger::TraceShardMerger(const std::vector<std::istream*>& shards)
+  : shards_(shards.size()) {
+  for (size_t shard = 0; shard < shards.size(); ++shard) {
+    shards_[shard].reader_.reset(new PrefetchingTraceReader(shards[shard]));
+  }
+  for (size_t shard = 0; shard < shards.size(); ++shard) {
+    if (nextBatch(&shards_[shard])) {
+      heap_.emplace(shards_[shard].batch_.events_[0].timestamp_, shard);
+    }
+  }
+}
+
+bool TraceShardMerger::nextBatch(Shard* shard) {
+  shard->batch_.clear();
+  shard->position_ = 0;
+  if (!shard->reader_->nextBatch(&shard->batch_)) {
+    shard->string_cache_.clear();
+    return false;
+  }
+  shard->string_cache_.assign(shard->batch_.strings_.size(), nullptr);
+  return true;
+}
+
+void TraceShardMerger::advance(size_t number) {
+  Shard& shard = shards_[number];
+  if ((++shard.position_ == shard.batch_.events_.size()) &&
+    !nextBatch(&shard)) {
+    return;
+  }
+  heap_.emplace(shard.batch_.events_[shard.position_].timestamp_, number);
+}
+
+bool TraceShardMerger::next(const TraceEvent** event,
+  const TraceEventChunk** chunk) {
+  if (has_current_) {
+    advance(current_);
+    has_current_ = false;
+  }
+  if (heap_.empty()) {
+    return false;
+  }
+  current_ = heap_.top().second;
+  has_current_ = true;
+  heap_.pop();
+  *event = &shards_[current_].batch_.events_[shards_[current_].position_];
+  *chunk = &shards_[current_].batch_;
+  return true;
+}
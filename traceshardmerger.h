@@ -0,0 +1,93 @@
+#ifndef TRACESHARDMERGER_H
+#define TRACESHARDMERGER_H
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boundedqueue.h"
+#include "traceevent.h"
+
+// Reads and parses a trace (a JSON array or one element per line) on a
+// separate thread, a few batches of events ahead of the consumer.
+//
+// Events without a timestamp get the timestamp of the event before them, so
+// the timestamps of a shard only depend on the elements that carry one.
+class PrefetchingTraceReader {
+public:
+  static constexpr size_t default_events_per_batch = 2048;
+  static constexpr size_t default_queue_length = 4;
+
+  explicit PrefetchingTraceReader(std::istream* input,
+    size_t events_per_batch = default_events_per_batch,
+    size_t queue_length = default_queue_length);
+  ~PrefetchingTraceReader();
+
+  // Returns false at the end of the trace.
+  bool nextBatch(TraceEventChunk* batch) { return queue_.pop(batch); }
+
+private:
+  void read();
+
+  std::istream* input_;
+  size_t events_per_batch_;
+  BoundedQueue<TraceEventChunk> queue_;
+  std::thread thread_;
+};
+
+// Merges trace shards (for example one per thread of the traced program)
+// into a single stream of events, in the order of their timestamps. Every
+// shard has to be sorted by timestamp already; events with equal
+// timestamps are taken from the shard that comes first.
+//
+// This is a k-way merge with a binary heap that holds the next event of
+// every shard, so the cost per event is O(log shards), and all shards are
+// read and parsed in parallel by prefetching readers.
+class TraceShardMerger {
+public:
+  explicit TraceShardMerger(const std::vector<std::istream*>& shards);
+
+  // Sets |event| and the |chunk| holding its strings to the next event.
+  // Both stay valid until the next call. Returns false when all shards are
+  // exhausted.
+  bool next(const TraceEvent** event, const TraceEventChunk** chunk);
+
+  // One entry per string of the batch that the last event came from, for
+  // the caller to cache what it derives from the strings (such as the
+  // de-duplicated tags). Every shard has its own cache, which is reset to
+  // null entries whenever the shard moves on to a new batch.
+  std::vector<const std::string*>* getStringCache() {
+    return &shards_[current_].string_cache_;
+  }
+
+private:
+  struct Shard {
+    std::unique_ptr<PrefetchingTraceReader> reader_;
+    TraceEventChunk batch_;
+    size_t position_ = 0;
+    std::vector<const std::string*> string_cache_;
+  };
+
+  // Reads the next batch of the shard. Returns false if it is exhausted.
+  bool nextBatch(Shard* shard);
+  // Moves the shard to its next event and puts it back on the heap, unless
+  // it is exhausted.
+  void advance(size_t shard);
+
+  std::vector<Shard> shards_;
+  // The timestamp of the next event of every non-empty shard.
+  std::priority_queue<std::pair<uint64_t, size_t>,
+    std::vector<std::pair<uint64_t, size_t>>,
+    std::greater<std::pair<uint64_t, size_t>>> heap_;
+  // The shard whose event was returned last, to advance on the next call.
+  size_t current_ = 0;
+  bool has_current_ = false;
+};
+
+#endif // TRACESHARDMERGER_H
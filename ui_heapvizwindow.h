@@ -29,6 +29,14 @@ class Ui_HeapVizWindow
 {
 public:
     QAction *actionHighlight_blocks_with_size;
+    QAction *actionHighlight_blocks_matching_query;
+    QAction *actionHighlight_blocks_changed_between_ticks;
+    QAction *actionHighlight_address_reuse_on_click;
+    QAction *actionFind_free_gaps_at_tick;
+    QAction *actionShow_fragmentation_chart;
+    QAction *actionShow_per_tag_memory_chart;
+    QAction *actionShow_bytes_held_by_tag;
+    QAction *actionShow_heaps;
     QWidget *centralWidget;
     QGridLayout *gridLayout;
     GLHeapDiagram *heap_diagram;
@@ -46,6 +54,25 @@ public:
         HeapVizWindow->resize(1070, 418);
         actionHighlight_blocks_with_size = new QAction(HeapVizWindow);
         actionHighlight_blocks_with_size->setObjectName(QStringLiteral("actionHighlight_blocks_with_size"));
+        actionHighlight_blocks_matching_query = new QAction(HeapVizWindow);
+        actionHighlight_blocks_matching_query->setObjectName(QStringLiteral("actionHighlight_blocks_matching_query"));
+        actionHighlight_blocks_changed_between_ticks = new QAction(HeapVizWindow);
+        actionHighlight_blocks_changed_between_ticks->setObjectName(QStringLiteral("actionHighlight_blocks_changed_between_ticks"));
+        actionHighlight_address_reuse_on_click = new QAction(HeapVizWindow);
+        actionHighlight_address_reuse_on_click->setObjectName(QStringLiteral("actionHighlight_address_reuse_on_click"));
+        actionHighlight_address_reuse_on_click->setCheckable(true);
+        actionFind_free_gaps_at_tick = new QAction(HeapVizWindow);
+        actionFind_free_gaps_at_tick->setObjectName(QStringLiteral("actionFind_free_gaps_at_tick"));
+        actionShow_fragmentation_chart = new QAction(HeapVizWindow);
+        actionShow_fragmentation_chart->setObjectName(QStringLiteral("actionShow_fragmentation_chart"));
+        actionShow_fragmentation_chart->setCheckable(true);
+        actionShow_per_tag_memory_chart = new QAction(HeapVizWindow);
+        actionShow_per_tag_memory_chart->setObjectName(QStringLiteral("actionShow_per_tag_memory_chart"));
+        actionShow_per_tag_memory_chart->setCheckable(true);
+        actionShow_bytes_held_by_tag = new QAction(HeapVizWindow);
+        actionShow_bytes_held_by_tag->setObjectName(QStringLiteral("actionShow_bytes_held_by_tag"));
+        actionShow_heaps = new QAction(HeapVizWindow);
+        actionShow_heaps->setObjectName(QStringLiteral("actionShow_heaps"));
         centralWidget = new QWidget(HeapVizWindow);
         centralWidget->setObjectName(QStringLiteral("centralWidget"));
         gridLayout = new QGridLayout(centralWidget);
@@ -80,12 +107,28 @@ public:
         menuBar->addAction(menuHeapViz_GL->menuAction());
         menuBar->addAction(menuTest->menuAction());
         menuTest->addAction(actionHighlight_blocks_with_size);
+        menuTest->addAction(actionHighlight_blocks_matching_query);
+        menuTest->addAction(actionHighlight_blocks_changed_between_ticks);
+        menuTest->addAction(actionHighlight_address_reuse_on_click);
+        menuTest->addAction(actionFind_free_gaps_at_tick);
+        menuTest->addAction(actionShow_fragmentation_chart);
+        menuTest->addAction(actionShow_per_tag_memory_chart);
+        menuTest->addAction(actionShow_bytes_held_by_tag);
+        menuTest->addAction(actionShow_heaps);
 
         retranslateUi(HeapVizWindow);
         QObject::connect(heap_diagram, SIGNAL(blockClicked(bool,HeapBlock)), HeapVizWindow, SLOT(blockClicked(bool,HeapBlock)));
         QObject::connect(heap_diagram, SIGNAL(showMessage(std::string)), HeapVizWindow, SLOT(showMessage(std::string)));
         QObject::connect(HeapVizWindow, SIGNAL(setFileToDisplay(QString)), heap_diagram, SLOT(setFileToDisplay(QString)));
         QObject::connect(HeapVizWindow, SIGNAL(setSizeToHighlight(uint32_t)), heap_diagram, SLOT(setSizeToHighlight(uint32_t)));
+        QObject::connect(HeapVizWindow, SIGNAL(setTicksToDiff(uint64_t,uint64_t)), heap_diagram, SLOT(setTicksToDiff(uint64_t,uint64_t)));
+        QObject::connect(HeapVizWindow, SIGNAL(findFreeGaps(uint64_t,uint32_t)), heap_diagram, SLOT(findFreeGaps(uint64_t,uint32_t)));
+        QObject::connect(actionShow_fragmentation_chart, SIGNAL(toggled(bool)), heap_diagram, SLOT(setShowFragmentationChart(bool)));
+        QObject::connect(actionShow_per_tag_memory_chart, SIGNAL(toggled(bool)), heap_diagram, SLOT(setShowTagChart(bool)));
+        QObject::connect(HeapVizWindow, SIGNAL(showBytesHeldByTag(QString,uint64_t,uint64_t)), heap_diagram, SLOT(showBytesHeldByTag(QString,uint64_t,uint64_t)));
+        QObject::connect(HeapVizWindow, SIGNAL(setHighlightQuery(QString)), heap_diagram, SLOT(setHighlightQuery(QString)));
+        QObject::connect(HeapVizWindow, SIGNAL(setVisibleHeaps(QString)), heap_diagram, SLOT(setVisibleHeaps(QString)));
+        QObject::connect(actionHighlight_address_reuse_on_click, SIGNAL(toggled(bool)), heap_diagram, SLOT(setHighlightReuseOnClick(bool)));
 
         QMetaObject::connectSlotsByName(HeapVizWindow);
     } // setupUi
@@ -94,6 +137,14 @@ public:
     {
         HeapVizWindow->setWindowTitle(QApplication::translate("HeapVizWindow", "HeapVizWindow", Q_NULLPTR));
         actionHighlight_blocks_with_size->setText(QApplication::translate("HeapVizWindow", "Highlight blocks in size range", Q_NULLPTR));
+        actionHighlight_blocks_matching_query->setText(QApplication::translate("HeapVizWindow", "Highlight blocks matching query", Q_NULLPTR));
+        actionHighlight_blocks_changed_between_ticks->setText(QApplication::translate("HeapVizWindow", "Highlight blocks changed between ticks", Q_NULLPTR));
+        actionHighlight_address_reuse_on_click->setText(QApplication::translate("HeapVizWindow", "Highlight address reuse on click", Q_NULLPTR));
+        actionFind_free_gaps_at_tick->setText(QApplication::translate("HeapVizWindow", "Find free gaps at tick", Q_NULLPTR));
+        actionShow_fragmentation_chart->setText(QApplication::translate("HeapVizWindow", "Show fragmentation chart", Q_NULLPTR));
+        actionShow_per_tag_memory_chart->setText(QApplication::translate("HeapVizWindow", "Show per-tag memory chart", Q_NULLPTR));
+        actionShow_bytes_held_by_tag->setText(QApplication::translate("HeapVizWindow", "Show bytes held by tag between ticks", Q_NULLPTR));
+        actionShow_heaps->setText(QApplication::translate("HeapVizWindow", "Show only some heaps", Q_NULLPTR));
         menuHeapViz_GL->setTitle(QApplication::translate("HeapVizWindow", "HeapViz GL", Q_NULLPTR));
         menuTest->setTitle(QApplication::translate("HeapVizWindow", "Edit", Q_NULLPTR));
         toolBar->setWindowTitle(QApplication::translate("HeapVizWindow", "toolBar", Q_NULLPTR));
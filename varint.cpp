@@ -0,0 +1,45 @@
+#include "varint.h"
+
+void appendVarint(uint64_t value, std::vector<uint8_t>* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t readVarint(const uint8_t** input) {
+  uint64_t value = 0;
+  uint32_t shift = 0;
+  const uint8_t* current = *input;
+  while (*current & 0x80) {
+    value |= static_cast<uint64_t>(*current & 0x7F) << shift;
+    shift += 7;
+    ++current;
+  }
+  value |= static_cast<uint64_t>(*current) << shift;
+  *input = current + 1;
+  return value;
+}
+
+void packAscending(const std::vector<uint32_t>& values,
+  std::vector<uint8_t>* packed) {
+  packed->clear();
+  uint32_t previous = 0;
+  for (uint32_t value : values) {
+    appendVarint(value - previous, packed);
+    previous = value;
+  }
+  packed->shrink_to_fit();
+}
+
+void unpackAscending(const std::vector<uint8_t>& packed,
+  std::vector<uint32_t>* values) {
+  const uint8_t* current = packed.data();
+  const uint8_t* end = current + packed.size();
+  uint32_t value = 0;
+  while (current < end) {
+    value += static_cast<uint32_t>(readVarint(&current));
+    values->push_back(value);
+  }
+}
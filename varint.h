@@ -0,0 +1,23 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstdint>
+#include <vector>
+
+// Variable-length integers: 7 bits per byte, least significant group first,
+// with the high bit set on every byte except the last. Small values take a
+// single byte, a full uint64_t takes ten.
+void appendVarint(uint64_t value, std::vector<uint8_t>* output);
+// Decodes the varint at |*input| and advances |*input| past it.
+uint64_t readVarint(const uint8_t** input);
+
+// Packs an ascending sequence of integers as the varint-encoded differences
+// between consecutive values. Dense sequences (e.g. sets of block indices)
+// shrink to about one byte per value.
+void packAscending(const std::vector<uint32_t>& values,
+  std::vector<uint8_t>* packed);
+// Appends the values of a packed sequence to |values|.
+void unpackAscending(const std::vector<uint8_t>& packed,
+  std::vector<uint32_t>* values);
+
+#endif // VARINT_H
@@ -1,4 +1,31 @@
+#include <algorithm>
+
 #include "vertex.h"
 
-HeapVertex::HeapVertex(uint32_t x, uint64_t y, const QVector3D &color) :
-    x_(x), y1_(y), y2_(y >> 32u), color_(color) {};
+static uint8_t toUnorm8(float value) {
+  return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f +
+    0.5f);
+}
+
+PackedColor::PackedColor(const QVector3D &color) :
+  rgba_{ toUnorm8(color.x()), toUnorm8(color.y()), toUnorm8(color.z()),
+    255 } {}
+
+QVector3D PackedColor::toVector3D() const {
+  return QVector3D(rgba_[0] / 255.0f, rgba_[1] / 255.0f, rgba_[2] / 255.0f);
+}
+
+HeapVertex::HeapVertex(uint64_t x, uint64_t y, const QVector3D &color) :
+    x1_(x), x2_(x >> 32u), y1_(y), y2_(y >> 32u), color_(color) {};
+
+void appendQuadIndices(uint32_t first_quad, uint32_t end_quad,
+  std::vector<uint32_t> *indices) {
+  static const uint32_t quad_indices[indices_per_quad] = { 0, 1, 3, 1, 2, 3 };
+  indices->reserve(indices->size() +
+    static_cast<size_t>(end_quad - first_quad) * indices_per_quad);
+  for (uint32_t quad = first_quad; quad < end_quad; ++quad) {
+    for (uint32_t index : quad_indices) {
+      indices->push_back(quad * vertices_per_quad + index);
+    }
+  }
+}
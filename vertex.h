@@ -3,34 +3,93 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 
 #include <QVector3D>
 
+// A color as normalized RGBA8. The attribute setup passes it to the shaders
+// as a vec3 of floats in [0, 1], so it takes 4 bytes per vertex instead of 12.
+class PackedColor {
+public:
+  PackedColor() = default;
+  explicit PackedColor(const QVector3D &color);
+
+  QVector3D toVector3D() const;
+
+  static const int TupleSize = 4;
+
+private:
+  uint8_t rgba_[4] = { 0, 0, 0, 255 };
+};
+
 // A vertex for the purposes of the heap visualizer. The requirements
 // are a bit different than for a "normal" vertex -- because the heap
 // can be 2^64 values high, just using normal floats for y will not
 // work. Unfortunately, the GSLS standard 1.3 does not support doubles,
-// so using a double is not an option, either.
+// so using a double is not an option, either. Ticks are 64-bit as well, so
+// the position is passed to the shaders as four 32-bit integers. The color
+// is packed, which makes the vertex 20 bytes.
 class HeapVertex {
 public:
-  HeapVertex(uint32_t x, uint64_t y, const QVector3D &color);
+  HeapVertex(uint64_t x, uint64_t y, const QVector3D &color);
 
-  static inline int positionOffset() { return offsetof(HeapVertex, x_); }
+  static inline int positionOffset() { return offsetof(HeapVertex, x1_); }
   static inline int colorOffset() { return offsetof(HeapVertex, color_); }
   static inline int stride() { return sizeof(HeapVertex); }
 
-  uint32_t getX() const { return x_; }
+  uint64_t getX() const { return (static_cast<uint64_t>(x2_) << 32u) + x1_; }
   uint64_t getY() const { return (static_cast<uint64_t>(y2_) << 32u) + y1_; }
-  const QVector3D &getColor() const { return color_; }
+  QVector3D getColor() const { return color_.toVector3D(); }
+  const PackedColor &getPackedColor() const { return color_; }
 
-  static const int PositionTupleSize = 3;
-  static const int ColorTupleSize = 3;
+  static const int PositionTupleSize = 4;
+  static const int ColorTupleSize = PackedColor::TupleSize;
 
 private:
-  uint32_t x_;
+  uint32_t x1_;
+  uint32_t x2_;
   uint32_t y1_;
   uint32_t y2_;
-  QVector3D color_;
+  PackedColor color_;
+};
+
+// Rectangles are drawn as quads of four vertices: lower left, lower right,
+// upper right and upper left. An index buffer splits every quad into the two
+// triangles (lower left, lower right, upper left) and (lower right, upper
+// right, upper left).
+static const uint32_t vertices_per_quad = 4;
+static const uint32_t indices_per_quad = 6;
+
+// Appends the indices of the triangles of quads [first_quad, end_quad).
+void appendQuadIndices(uint32_t first_quad, uint32_t end_quad,
+  std::vector<uint32_t> *indices);
+
+// A HeapVertex relative to the origin of its tile (see VertexTiles). The
+// offsets are below 2^19, so they are exact as floats, and the tile index is
+// exact as a float for up to 2^24 tiles. With the packed color, the vertex
+// is 16 bytes.
+class TileVertex {
+public:
+  TileVertex(float x, float y, uint32_t tile, const PackedColor &color) :
+    x_(x), y_(y), tile_(static_cast<float>(tile)), color_(color) {}
+
+  static inline int positionOffset() { return offsetof(TileVertex, x_); }
+  static inline int colorOffset() { return offsetof(TileVertex, color_); }
+  static inline int stride() { return sizeof(TileVertex); }
+
+  float getX() const { return x_; }
+  float getY() const { return y_; }
+  uint32_t getTile() const { return static_cast<uint32_t>(tile_); }
+  QVector3D getColor() const { return color_.toVector3D(); }
+
+  static const int PositionTupleSize = 3;
+  static const int ColorTupleSize = PackedColor::TupleSize;
+
+private:
+  float x_;
+  float y_;
+  float tile_;
+  PackedColor color_;
 };
 
 #endif // VERTEX_H
@@ -0,0 +1,45 @@
+#include "vertextiles.h"
+
+static constexpr uint64_t tile_mask =
+  (static_cast<uint64_t>(1) << VertexTiles::tile_bits) - 1;
+
+void VertexTiles::clear() {
+  origins_.clear();
+  tile_indices_.clear();
+  // No tile origin has the low bits set.
+  last_origin_ = { 1, 1 };
+}
+
+TileVertex VertexTiles::toTileVertex(const HeapVertex& vertex) {
+  std::pair<uint64_t, uint64_t> origin(vertex.getX() & ~tile_mask,
+    vertex.getY() & ~tile_mask);
+  if (origin != last_origin_) {
+    auto inserted = tile_indices_.emplace(origin,
+      static_cast<uint32_t>(origins_.size()));
+    if (inserted.second) {
+      origins_.push_back(origin);
+    }
+    last_origin_ = origin;
+    last_tile_ = inserted.first->second;
+  }
+  return TileVertex(static_cast<float>(vertex.getX() & tile_mask),
+    static_cast<float>(vertex.getY() & tile_mask), last_tile_,
+    vertex.getPackedColor());
+}
+
+void VertexTiles::getTileOrigins(ivec3 tick_base, ivec3 address_base,
+  std::vector<float>* origins) const {
+  origins->resize(2 * origins_.size());
+  for (size_t tile = 0; tile < origins_.size(); ++tile) {
+    uint64_t tick = origins_[tile].first;
+    uint64_t address = origins_[tile].second;
+    ivec3 tick96 = Load64BitLeftShiftedBy4Into96Bit(
+      static_cast<int32_t>(tick), static_cast<int32_t>(tick >> 32));
+    ivec3 address96 = Load64BitLeftShiftedBy4Into96Bit(
+      static_cast<int32_t>(address), static_cast<int32_t>(address >> 32));
+    (*origins)[2 * tile] =
+      Multiply96BitWithFloat(Sub96(tick96, tick_base), 1.0f);
+    (*origins)[2 * tile + 1] =
+      Multiply96BitWithFloat(Sub96(address96, address_base), 1.0f);
+  }
+}
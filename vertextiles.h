@@ -0,0 +1,65 @@
+#ifndef VERTEXTILES_H
+#define VERTEXTILES_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glsl_simulation_functions.h"
+#include "vertex.h"
+
+// Splits heap space into tiles of 2^tile_bits ticks by 2^tile_bits bytes, so
+// that vertices can be stored as small float offsets from the origin of their
+// tile instead of as 64-bit integers.
+//
+// Once per frame, the CPU translates every tile origin by the minimum of the
+// displayed window with the 96-bit arithmetic of the shaders, and converts the
+// result to float. The vertex shader then only adds the offset of the vertex
+// and scales, which replaces the emulated 96-bit arithmetic per vertex.
+//
+// This is as precise as the 96-bit arithmetic: the offsets (in sixteenths,
+// like the translated coordinates) are below 2^23 and therefore exact, and an
+// origin that is not exact is at least 2^24 sixteenths away from the window
+// base. A vertex of such a tile can only be on screen if the window is about
+// as large, so the rounding error stays far below a pixel.
+class VertexTiles {
+public:
+  static constexpr uint32_t tile_bits = 19;
+
+  void clear();
+  size_t size() const { return origins_.size(); }
+
+  // Returns |vertex| relative to its tile, adding the tile if necessary.
+  TileVertex toTileVertex(const HeapVertex& vertex);
+
+  // Calculates the origin of every tile relative to the given bases (as
+  // passed to the shaders), in sixteenths, as two floats (tick, address) per
+  // tile.
+  void getTileOrigins(ivec3 tick_base, ivec3 address_base,
+    std::vector<float>* origins) const;
+
+  // The coordinate of a vertex in sixteenths relative to the window base,
+  // from the translated origin of its tile. Does the same as the shader.
+  static float getTranslatedCoordinate(float origin, float offset) {
+    return origin + offset * 16.0f;
+  }
+
+private:
+  struct TileHash {
+    size_t operator()(const std::pair<uint64_t, uint64_t>& tile) const {
+      return std::hash<uint64_t>()(tile.first * 0x9E3779B97F4A7C15ull ^
+        tile.second);
+    }
+  };
+
+  // The tick and address of the origin of every tile.
+  std::vector<std::pair<uint64_t, uint64_t>> origins_;
+  std::unordered_map<std::pair<uint64_t, uint64_t>, uint32_t, TileHash>
+    tile_indices_;
+  // Consecutive vertices are mostly in the same tile.
+  std::pair<uint64_t, uint64_t> last_origin_ = { 1, 1 };
+  uint32_t last_tile_ = 0;
+};
+
+#endif // VERTEXTILES_H